@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace UniLang {
+namespace Bench {
+
+/**
+ * @brief Minimal helpers for the benchmarks in bench/
+ *
+ * Each benchmark is one executable that prints its measurements as a
+ * table. Inputs are generated from fixed seeds, so runs on the same
+ * machine compare, and times are the best of a few runs. Numbers only
+ * mean something in an optimized build (-DCMAKE_BUILD_TYPE=Release).
+ */
+
+/**
+ * @brief Deterministic pseudo-random numbers (LCG)
+ */
+class Random {
+public:
+    explicit Random(uint32_t seed) : m_state(seed) {}
+
+    uint32_t Next() {
+        m_state = m_state * 1664525u + 1013904223u;
+        return m_state >> 8;
+    }
+
+    size_t Below(size_t bound) { return Next() % bound; }
+
+    /**
+     * @brief Lowercase ASCII word with a length in [min_length, max_length]
+     */
+    std::string Word(size_t min_length, size_t max_length) {
+        std::string word(min_length + Below(max_length - min_length + 1), 'a');
+        for (char& ch : word) {
+            ch = static_cast<char>('a' + Below(26));
+        }
+        return word;
+    }
+
+private:
+    uint32_t m_state;
+};
+
+/**
+ * @brief Best wall time of `runs` calls of fn, in seconds
+ */
+template <typename Fn>
+double BestOf(int runs, Fn&& fn) {
+    double best = 0;
+    for (int i = 0; i < runs; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0 || seconds < best) {
+            best = seconds;
+        }
+    }
+    return best;
+}
+
+/**
+ * @brief Keep a result observable so the work producing it isn't optimized away
+ */
+inline void Consume(uint64_t value) {
+    static volatile uint64_t sink = 0;
+    sink = sink + value;
+}
+
+/**
+ * @brief About `size` bytes of lines of random words, one of `phrases` in place of every n-th word
+ */
+inline std::string MakeText(size_t size, const std::vector<std::string>& phrases, size_t every_nth, uint32_t seed) {
+    Random random(seed);
+    std::string text;
+    text.reserve(size + 64);
+    for (size_t words = 1; text.size() < size; ++words) {
+        if (!phrases.empty() && every_nth > 0 && words % every_nth == 0) {
+            text += phrases[random.Below(phrases.size())];
+        } else {
+            text += random.Word(1, 9);
+        }
+        text += words % 12 == 0 ? '\n' : ' ';
+    }
+    return text;
+}
+
+inline double MegabytesPerSecond(size_t bytes, double seconds) {
+    return static_cast<double>(bytes) / 1e6 / seconds;
+}
+
+inline double NanosecondsEach(size_t count, double seconds) {
+    return seconds * 1e9 / static_cast<double>(count);
+}
+
+} // namespace Bench
+} // namespace UniLang
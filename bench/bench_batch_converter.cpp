@@ -0,0 +1,116 @@
+#include "bench.h"
+#include "batch_converter.h"
+#include "shortcuts_dict.h"
+#include "task_pool.h"
+#include <atomic>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Tree conversion (user-033): BatchConverter throughput over a generated
+// tree of many small files and a few large ones (split into chunks) at
+// 1..N threads, and the cost of a TaskPool task on its own
+
+using namespace UniLang;
+namespace fs = std::filesystem;
+
+namespace {
+
+const size_t SMALL_FILES = 3000;
+const size_t SMALL_SIZE = 24 << 10;
+const size_t LARGE_FILES = 2;
+const size_t LARGE_SIZE = 24 << 20;
+const size_t TASKS = 1 << 20;
+
+void WriteFile(const fs::path& path, const std::string& data) {
+    std::ofstream file(path, std::ios::binary);
+    file << data;
+}
+
+// 100 directories of small files plus the large ones at the top
+uint64_t MakeTree(const fs::path& root, const std::vector<std::string>& shortcuts) {
+    fs::remove_all(root);
+    uint64_t bytes = 0;
+    for (size_t i = 0; i < SMALL_FILES; ++i) {
+        const fs::path dir = root / ("d" + std::to_string(i % 100));
+        fs::create_directories(dir);
+        const std::string text = Bench::MakeText(SMALL_SIZE, shortcuts, 40, static_cast<uint32_t>(i));
+        WriteFile(dir / ("f" + std::to_string(i) + ".md"), text);
+        bytes += text.size();
+    }
+    for (size_t i = 0; i < LARGE_FILES; ++i) {
+        const std::string text = Bench::MakeText(LARGE_SIZE, shortcuts, 40, static_cast<uint32_t>(SMALL_FILES + i));
+        WriteFile(root / ("large" + std::to_string(i) + ".md"), text);
+        bytes += text.size();
+    }
+    return bytes;
+}
+
+} // namespace
+
+int main() {
+    ShortcutsDict dict;
+    if (!dict.LoadFromFile(UNILANG_BENCH_SHORTCUTS)) {
+        std::fprintf(stderr, "Failed to load %s\n", UNILANG_BENCH_SHORTCUTS);
+        return 1;
+    }
+    std::vector<std::string> shortcuts;
+    for (const auto& [shortcut, replacement] : dict.GetAllShortcuts()) {
+        shortcuts.push_back(shortcut);
+    }
+
+    const fs::path root = "bench_tree";
+    const uint64_t bytes = MakeTree(root, shortcuts);
+    std::printf("%zu files, %llu MiB; %u hardware threads\n", SMALL_FILES + LARGE_FILES,
+                static_cast<unsigned long long>(bytes >> 20), std::thread::hardware_concurrency());
+
+    std::vector<size_t> thread_counts = {1, 2, 4};
+    if (std::thread::hardware_concurrency() > 4) {
+        thread_counts.push_back(std::thread::hardware_concurrency());
+    }
+
+    // Dry run: the files stay as generated, so every run does the same work
+    for (size_t threads : thread_counts) {
+        BatchConverter::Options options;
+        options.threads = threads;
+        options.split_size = 4 << 20;
+        options.dry_run = true;
+        BatchConverter converter(dict, options);
+        BatchConverter::Summary summary;
+        bool ok = true;
+        const double seconds = Bench::BestOf(3, [&] {
+            summary = BatchConverter::Summary();
+            ok = converter.ConvertTree(root.string(), summary) && ok;
+        });
+        if (!ok) {
+            std::fprintf(stderr, "%s\n", converter.GetLastError().c_str());
+            fs::remove_all(root);
+            return 1;
+        }
+        std::printf("-j%-3zu %7.0f MB/s  %8llu replacements  %5llu steals\n", threads,
+                    Bench::MegabytesPerSecond(bytes, seconds), static_cast<unsigned long long>(summary.replacements),
+                    static_cast<unsigned long long>(summary.steals));
+    }
+    fs::remove_all(root);
+
+    // Scheduling overhead: tasks that do nothing, submitted from one task so they spread by stealing
+    for (size_t threads : thread_counts) {
+        TaskPool pool(threads);
+        std::atomic<uint64_t> ran{0};
+        const double seconds = Bench::BestOf(3, [&] {
+            pool.Submit([&pool, &ran] {
+                for (size_t i = 0; i < TASKS; ++i) {
+                    pool.Submit([&ran] { ran.fetch_add(1, std::memory_order_relaxed); });
+                }
+            });
+            pool.Wait();
+        });
+        Bench::Consume(ran.load());
+        std::printf("TaskPool -j%-3zu %6.0f ns per task  %8llu steals in 3 runs\n", threads,
+                    Bench::NanosecondsEach(TASKS, seconds), static_cast<unsigned long long>(pool.GetStealCount()));
+    }
+    return 0;
+}
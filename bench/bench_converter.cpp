@@ -0,0 +1,87 @@
+#include "bench.h"
+#include "shortcuts_dict.h"
+#include "text_converter.h"
+#include "trigger_scan.h"
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Streaming conversion (user-032): TextConverter in 1 MiB chunks, as
+// unilang-convert reads a pipe, and the trigger byte scan that lets it skip
+// plain text, against a byte-at-a-time scan
+
+using namespace UniLang;
+
+namespace {
+
+const size_t TEXT_SIZE = 128 << 20;
+const size_t CHUNK_SIZE = 1 << 20;
+
+double ConvertChunked(const ShortcutsDict& dict, const std::string& text, uint64_t& replacements) {
+    std::string out;
+    out.reserve(CHUNK_SIZE * 2);
+    return Bench::BestOf(3, [&] {
+        TextConverter converter(dict);
+        uint64_t written = 0;
+        for (size_t pos = 0; pos < text.size(); pos += CHUNK_SIZE) {
+            out.clear();
+            converter.Convert(std::string_view(text).substr(pos, CHUNK_SIZE), out);
+            written += out.size();
+        }
+        out.clear();
+        converter.Finish(out);
+        Bench::Consume(written + out.size());
+        replacements = converter.GetReplacementCount();
+    });
+}
+
+size_t FindTriggerByteScalar(const char* data, size_t size, std::string_view bytes) {
+    for (size_t i = 0; i < size; ++i) {
+        if (bytes.find(data[i]) != std::string_view::npos) {
+            return i;
+        }
+    }
+    return size;
+}
+
+template <typename Find>
+double ScanAll(const std::string& text, std::string_view bytes, Find find) {
+    return Bench::BestOf(5, [&] {
+        uint64_t found = 0;
+        for (size_t pos = 0; pos < text.size(); ++pos) {
+            pos += find(text.data() + pos, text.size() - pos, bytes);
+            found += pos < text.size();
+        }
+        Bench::Consume(found);
+    });
+}
+
+} // namespace
+
+int main() {
+    ShortcutsDict dict;
+    if (!dict.LoadFromFile(UNILANG_BENCH_SHORTCUTS)) {
+        std::fprintf(stderr, "Failed to load %s\n", UNILANG_BENCH_SHORTCUTS);
+        return 1;
+    }
+    std::vector<std::string> shortcuts;
+    for (const auto& [shortcut, replacement] : dict.GetAllShortcuts()) {
+        shortcuts.push_back(shortcut);
+    }
+
+    // ASCII prose with a shortcut about every 40 words
+    const std::string text = Bench::MakeText(TEXT_SIZE, shortcuts, 40, 1);
+    uint64_t replacements = 0;
+    const double convert = ConvertChunked(dict, text, replacements);
+    std::printf("%zu MiB, %llu replacements\n", text.size() >> 20, static_cast<unsigned long long>(replacements));
+    std::printf("TextConverter, 1 MiB chunks: %.0f MB/s\n", Bench::MegabytesPerSecond(text.size(), convert));
+
+    // Scan for every trigger byte the shipped grammars use
+    const std::string_view bytes = dict.GetGrammars().GetTriggerBytes();
+    const double simd = ScanAll(text, bytes, FindTriggerByte);
+    const double scalar = ScanAll(text, bytes, FindTriggerByteScalar);
+    std::printf("FindTriggerByte (%zu bytes): %.0f MB/s, byte loop %.0f MB/s\n", bytes.size(),
+                Bench::MegabytesPerSecond(text.size(), simd), Bench::MegabytesPerSecond(text.size(), scalar));
+    return 0;
+}
@@ -0,0 +1,92 @@
+#include "bench.h"
+#include "pattern_matcher.h"
+#include "shortcuts_dict.h"
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Batch matching (user-031): PatternMatcher::Feed over a span vs one
+// AddChar + FindReplacement call per character, on text where every third
+// word is a shortcut from config/shortcuts.json
+
+using namespace UniLang;
+
+namespace {
+
+const size_t TEXT_SIZE = 16 << 20;
+
+struct Result {
+    double seconds = 0;
+    uint64_t matches = 0;
+};
+
+Result FeedSpan(const ShortcutsDict& dict, const std::string& text) {
+    Result result;
+    result.seconds = Bench::BestOf(3, [&] {
+        PatternMatcher matcher;
+        PatternMatcher::FeedMatch out[256];
+        std::string_view rest = text;
+        result.matches = 0;
+        while (!rest.empty()) {
+            const PatternMatcher::FeedResult fed = matcher.Feed(rest, dict, out, 256, ShortcutsDict::ALL_CATEGORIES);
+            result.matches += fed.match_count;
+            rest.remove_prefix(fed.consumed);
+        }
+    });
+    return result;
+}
+
+// The only way to convert text before Feed: one owned Match per pattern
+Result AddCharEach(const ShortcutsDict& dict, const std::string& text) {
+    Result result;
+    result.seconds = Bench::BestOf(3, [&] {
+        PatternMatcher matcher;
+        result.matches = 0;
+        for (char ch : text) {
+            if (ch == '\n') {
+                matcher.Reset();
+                continue;
+            }
+            const std::optional<PatternMatcher::Match> match = matcher.AddChar(ch);
+            if (match && dict.FindReplacement(match->pattern)) {
+                ++result.matches;
+                matcher.ResetPattern();
+            }
+        }
+    });
+    return result;
+}
+
+void Print(const char* name, const Result& result, size_t bytes) {
+    std::printf("%-26s %7.1f MB/s  %8llu matches\n", name, Bench::MegabytesPerSecond(bytes, result.seconds),
+                static_cast<unsigned long long>(result.matches));
+}
+
+} // namespace
+
+int main() {
+    ShortcutsDict dict;
+    if (!dict.LoadFromFile(UNILANG_BENCH_SHORTCUTS)) {
+        std::fprintf(stderr, "Failed to load %s\n", UNILANG_BENCH_SHORTCUTS);
+        return 1;
+    }
+
+    // Backslash shortcuts only: the grammar AddChar(char) knows
+    std::vector<std::string> shortcuts;
+    for (const auto& [shortcut, replacement] : dict.GetAllShortcuts()) {
+        if (shortcut.size() > 1 && shortcut[0] == '\\') {
+            shortcuts.push_back(shortcut);
+        }
+    }
+    const std::string dense = Bench::MakeText(TEXT_SIZE, shortcuts, 3, 1);
+    const std::string prose = Bench::MakeText(TEXT_SIZE, shortcuts, 200, 2);
+
+    std::printf("%zu MiB each, %zu shortcuts\n", TEXT_SIZE >> 20, shortcuts.size());
+    Print("Feed, dense", FeedSpan(dict, dense), dense.size());
+    Print("AddChar per byte, dense", AddCharEach(dict, dense), dense.size());
+    Print("Feed, prose", FeedSpan(dict, prose), prose.size());
+    Print("AddChar per byte, prose", AddCharEach(dict, prose), prose.size());
+    return 0;
+}
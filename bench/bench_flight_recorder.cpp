@@ -0,0 +1,81 @@
+#include "bench.h"
+#include "flight_recorder.h"
+#include "metrics.h"
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Flight recorder (user-048): the cost of Add() on the hook thread, and of
+// Snapshot, Serialize and Parse on a full ring, idle and with a writer
+// adding records at full speed on another thread
+
+using namespace UniLang;
+
+namespace {
+
+const size_t RECORDS = 50 << 20;
+const int DUMPS = 200;
+
+FlightRecorder::Record MakeRecord(uint64_t i) {
+    FlightRecorder::Record record;
+    record.ticks = i * 1000;
+    record.event = static_cast<FlightRecorder::Event>(i % 8);
+    record.decision = static_cast<FlightRecorder::Decision>(i % 9);
+    record.flags = static_cast<uint8_t>(i);
+    record.buffer_length = static_cast<uint8_t>(i % 32);
+    record.output_length = static_cast<uint16_t>(i % 5);
+    record.latency_bucket = static_cast<uint16_t>(i % LatencyHistogram::BUCKET_COUNT);
+    return record;
+}
+
+} // namespace
+
+int main() {
+    FlightRecorder recorder;
+    const double add = Bench::BestOf(5, [&recorder] {
+        FlightRecorder::Record record = MakeRecord(0);
+        for (size_t i = 0; i < RECORDS; ++i) {
+            record.ticks = i;
+            recorder.Add(record);
+        }
+    });
+    std::printf("Add: %.2f ns per record\n", Bench::NanosecondsEach(RECORDS, add));
+
+    for (size_t i = 0; i < FlightRecorder::CAPACITY; ++i) {
+        recorder.Add(MakeRecord(i));
+    }
+    size_t kept = 0;
+    const double snapshot = Bench::BestOf(DUMPS, [&] { kept = recorder.Snapshot().size(); });
+    std::string dump;
+    const double serialize = Bench::BestOf(DUMPS, [&] { dump = recorder.Serialize(); });
+    FlightRecorder::Dump parsed;
+    bool ok = true;
+    const double parse = Bench::BestOf(DUMPS, [&] { ok = FlightRecorder::Parse(dump, parsed) && ok; });
+    if (!ok || parsed.records.size() != kept) {
+        std::fprintf(stderr, "The dump did not decode\n");
+        return 1;
+    }
+    std::printf("Idle ring:    Snapshot %6.1f us (%zu records), Serialize %6.1f us (%zu KB), Parse %6.1f us\n",
+                snapshot * 1e6, kept, serialize * 1e6, dump.size() >> 10, parse * 1e6);
+
+    // Dumps taken while the hook thread keeps adding: overwritten records are left out
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        for (uint64_t i = 0; !stop.load(std::memory_order_relaxed); ++i) {
+            recorder.Add(MakeRecord(i));
+        }
+    });
+    uint64_t snapshots = 0;
+    uint64_t records = 0;
+    const double busy = Bench::BestOf(DUMPS, [&] {
+        records += recorder.Snapshot().size();
+        ++snapshots;
+    });
+    stop.store(true);
+    writer.join();
+    std::printf("Busy ring:    Snapshot %6.1f us, %.0f of %zu records kept on average\n", busy * 1e6,
+                static_cast<double>(records) / static_cast<double>(snapshots), FlightRecorder::CAPACITY);
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "bench.h"
+#include "math_converter.h"
+#include "shortcuts_dict.h"
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// LaTeX math (user-034): MathConverter throughput on arXiv-style documents
+// (prose with inline formulas, delimited mode) and on formulas alone
+
+using namespace UniLang;
+
+namespace {
+
+const size_t TEXT_SIZE = 64 << 20;
+const size_t CHUNK_SIZE = 1 << 20;
+
+const char* const FORMULAS[] = {
+    "\\sum_{i=1}^{n} \\alpha_i^2",
+    "\\frac{1}{2}",
+    "\\frac{a+b}{c}",
+    "\\sqrt[3]{x}",
+    "\\int_0^\\infty e^{-x^2} \\, dx",
+    "\\mathbb{R}^n",
+    "\\hat{x} + \\vec{v}",
+    "\\lim_{n \\to \\infty} a_n = 0",
+    "\\left( \\frac{p}{q} \\right)^{2}",
+    "x_{ij}^{(k)}",
+    "f(x) = 0 \\text{ if } x \\in A",
+    "\\forall \\epsilon > 0 \\, \\exists \\delta",
+    "\\|x\\|_2 \\leq \\sqrt{n} \\|x\\|_\\infty",
+    "\\prod_{k=1}^{N} (1 - q^k)",
+    "\\nabla \\cdot \\mathbf{E} = \\frac{\\rho}{\\epsilon_0}",
+};
+
+double ConvertChunked(const ShortcutsDict& dict, bool delimited, const std::string& text, uint64_t& spans) {
+    MathConverter::Options options;
+    options.delimited = delimited;
+    std::string out;
+    out.reserve(CHUNK_SIZE * 2);
+    return Bench::BestOf(3, [&] {
+        MathConverter converter(dict, options);
+        uint64_t written = 0;
+        for (size_t pos = 0; pos < text.size(); pos += CHUNK_SIZE) {
+            out.clear();
+            converter.Convert(std::string_view(text).substr(pos, CHUNK_SIZE), out);
+            written += out.size();
+        }
+        out.clear();
+        converter.Finish(out);
+        Bench::Consume(written + out.size());
+        spans = converter.GetSpanCount();
+    });
+}
+
+} // namespace
+
+int main() {
+    ShortcutsDict dict;
+    if (!dict.LoadFromFile(UNILANG_BENCH_SHORTCUTS)) {
+        std::fprintf(stderr, "Failed to load %s\n", UNILANG_BENCH_SHORTCUTS);
+        return 1;
+    }
+
+    // A formula in $...$ about every 12 words; the generator breaks lines every 12
+    std::vector<std::string> inline_formulas;
+    for (const char* formula : FORMULAS) {
+        inline_formulas.push_back(std::string("$") + formula + "$");
+    }
+    const std::string document = Bench::MakeText(TEXT_SIZE, inline_formulas, 12, 1);
+
+    // Formulas only, one per line
+    Bench::Random random(2);
+    std::string math;
+    math.reserve(TEXT_SIZE + 64);
+    while (math.size() < TEXT_SIZE) {
+        math += FORMULAS[random.Below(sizeof(FORMULAS) / sizeof(FORMULAS[0]))];
+        math += '\n';
+    }
+
+    uint64_t spans = 0;
+    const double documents = ConvertChunked(dict, true, document, spans);
+    std::printf("Documents (%zu MiB, %llu formulas): %.0f MB/s\n", document.size() >> 20,
+                static_cast<unsigned long long>(spans), Bench::MegabytesPerSecond(document.size(), documents));
+    const double formulas = ConvertChunked(dict, false, math, spans);
+    std::printf("Formulas only (%zu MiB): %.0f MB/s\n", math.size() >> 20,
+                Bench::MegabytesPerSecond(math.size(), formulas));
+    return 0;
+}
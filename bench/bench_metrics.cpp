@@ -0,0 +1,112 @@
+#include "bench.h"
+#include "input_engine.h"
+#include "metrics.h"
+#include "shortcuts_dict.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Instrumentation overhead (user-047): the cost of a TickClock read, a
+// Counter::Add and a LatencyHistogram::Record against the 20 ns per event
+// budget, and InputEngine::OnKeyEvent per hook event with all of it on,
+// fed typed prose at human pace with the shipped dictionary
+
+using namespace UniLang;
+
+namespace {
+
+const size_t OPERATIONS = 50 << 20;
+const size_t TEXT_SIZE = 4 << 20;
+
+// Key-down and key-up of every character, 150 ms apart so no burst is detected
+void TypeText(InputEngine& engine, const std::string& text, uint32_t& time_ms) {
+    KeyEvent event;
+    for (char ch : text) {
+        event.vk = ch >= 'a' && ch <= 'z' ? static_cast<uint32_t>(ch - 'a' + 'A') : static_cast<uint32_t>(ch);
+        event.ch = static_cast<char16_t>(static_cast<unsigned char>(ch));
+        event.is_key_down = true;
+        event.time_ms = time_ms += 150;
+        Bench::Consume(engine.OnKeyEvent(event));
+        event.is_key_down = false;
+        engine.OnKeyEvent(event);
+    }
+}
+
+} // namespace
+
+int main() {
+    ShortcutsDict dict;
+    if (!dict.LoadFromFile(UNILANG_BENCH_SHORTCUTS)) {
+        std::fprintf(stderr, "Failed to load %s\n", UNILANG_BENCH_SHORTCUTS);
+        return 1;
+    }
+
+    std::printf("TickClock: %.3f ns per tick\n", TickClock::GetNanosecondsPerTick());
+
+    const double now = Bench::BestOf(5, [] {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < OPERATIONS; ++i) {
+            sum += TickClock::Now();
+        }
+        Bench::Consume(sum);
+    });
+
+    Counter counter;
+    const double add = Bench::BestOf(5, [&counter] {
+        for (size_t i = 0; i < OPERATIONS; ++i) {
+            counter.Add();
+        }
+    });
+    Bench::Consume(counter.Get());
+
+    // Spread over the buckets like decision times of 100 ns to 100 us
+    std::vector<uint64_t> values(1 << 16);
+    Bench::Random random(1);
+    for (uint64_t& value : values) {
+        value = 100 + random.Below(1000) * random.Below(100);
+    }
+    LatencyHistogram histogram;
+    const double record = Bench::BestOf(5, [&] {
+        for (size_t i = 0; i < OPERATIONS; ++i) {
+            histogram.Record(values[i & (values.size() - 1)]);
+        }
+    });
+    Bench::Consume(histogram.GetCount());
+
+    // A timed decision: two clock reads and a Record, as OnKeyEvent does
+    const double timed = Bench::BestOf(5, [&] {
+        for (size_t i = 0; i < OPERATIONS; ++i) {
+            const uint64_t start = TickClock::Now();
+            histogram.Record(TickClock::Now() - start);
+        }
+    });
+
+    std::printf("%-28s %6.2f ns\n", "TickClock::Now", Bench::NanosecondsEach(OPERATIONS, now));
+    std::printf("%-28s %6.2f ns\n", "Counter::Add", Bench::NanosecondsEach(OPERATIONS, add));
+    std::printf("%-28s %6.2f ns\n", "LatencyHistogram::Record", Bench::NanosecondsEach(OPERATIONS, record));
+    std::printf("%-28s %6.2f ns  (budget 20 ns)\n", "Now + Now + Record", Bench::NanosecondsEach(OPERATIONS, timed));
+
+    std::vector<std::string> shortcuts;
+    for (const auto& [shortcut, replacement] : dict.GetAllShortcuts()) {
+        shortcuts.push_back(shortcut);
+    }
+    const std::string text = Bench::MakeText(TEXT_SIZE, shortcuts, 40, 2);
+
+    InputEngine engine;
+    engine.SetDictionary(&dict);
+    if (!engine.Start([](const EngineAction&) {})) {
+        std::fprintf(stderr, "Failed to start the engine\n");
+        return 1;
+    }
+    uint32_t time_ms = 0;
+    const double typed = Bench::BestOf(3, [&] { TypeText(engine, text, time_ms); });
+    std::string metrics;
+    const double dump = Bench::BestOf(100, [&] { metrics = engine.GetMetricsJson(); });
+    engine.Stop();
+
+    const InputEngine::Stats stats = engine.GetStats();
+    std::printf("\nOnKeyEvent over %zu MiB of prose: %.1f ns per hook event, %llu replacements in 3 runs\n", text.size() >> 20,
+                Bench::NanosecondsEach(text.size() * 2, typed), static_cast<unsigned long long>(stats.replacements));
+    std::printf("GetMetricsJson: %.1f us, %zu bytes\n", dump * 1e6, metrics.size());
+    return 0;
+}
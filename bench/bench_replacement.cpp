@@ -0,0 +1,100 @@
+#include "bench.h"
+#include "shortcuts_dict.h"
+#include "unicode_utils.h"
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Pre-encoded replacements (user-026): cost of one replacement from the
+// typed shortcut to a filled input event buffer, transcoding the UTF-8
+// replacement on every call vs copying the UTF-16 stored in the entry.
+// SendInput itself is left out; both paths hand it the same buffer.
+
+using namespace UniLang;
+
+namespace {
+
+const size_t REPLACEMENTS = 1 << 20;
+
+// Stand-in for INPUT/KEYBDINPUT, laid out like it on x64 (40 bytes)
+struct InputEvent {
+    uint32_t type;
+    uint16_t vk;
+    uint16_t scan;
+    uint32_t flags;
+    uint32_t time;
+    uintptr_t extra;
+    uint64_t padding;
+};
+
+const uint32_t KEYEVENTF_KEYUP = 0x0002;
+const uint32_t KEYEVENTF_UNICODE = 0x0004;
+
+// What TextReplacer does for the text: key down + key up per code unit
+void AppendEvents(const std::u16string& utf16, std::vector<InputEvent>& events) {
+    for (char16_t ch : utf16) {
+        InputEvent down = {};
+        down.type = 1;
+        down.scan = static_cast<uint16_t>(ch);
+        down.flags = KEYEVENTF_UNICODE;
+        events.push_back(down);
+        InputEvent up = down;
+        up.flags = KEYEVENTF_UNICODE | KEYEVENTF_KEYUP;
+        events.push_back(up);
+    }
+}
+
+} // namespace
+
+int main() {
+    ShortcutsDict dict;
+    if (!dict.LoadFromFile(UNILANG_BENCH_SHORTCUTS)) {
+        std::fprintf(stderr, "Failed to load %s\n", UNILANG_BENCH_SHORTCUTS);
+        return 1;
+    }
+
+    // Shortcuts as the hook sees them, in random order
+    std::vector<std::string> shortcuts;
+    for (const auto& [shortcut, replacement] : dict.GetAllShortcuts()) {
+        shortcuts.push_back(shortcut);
+    }
+    Bench::Random random(1);
+    std::vector<const std::string*> typed;
+    typed.reserve(REPLACEMENTS);
+    for (size_t i = 0; i < REPLACEMENTS; ++i) {
+        typed.push_back(&shortcuts[random.Below(shortcuts.size())]);
+    }
+
+    std::vector<InputEvent> events;
+    events.reserve(64);
+
+    // Before: look up the UTF-8 replacement, transcode, build the events
+    const double transcoding = Bench::BestOf(5, [&] {
+        uint64_t sent = 0;
+        for (const std::string* shortcut : typed) {
+            const std::optional<std::string> replacement = dict.FindReplacement(*shortcut);
+            events.clear();
+            AppendEvents(Utf8ToUtf16(*replacement), events);
+            sent += events.size();
+        }
+        Bench::Consume(sent);
+    });
+
+    // After: look up the entry and copy its UTF-16
+    const double precomputed = Bench::BestOf(5, [&] {
+        uint64_t sent = 0;
+        for (const std::string* shortcut : typed) {
+            const ShortcutsDict::Entry* entry = dict.FindEntry(*shortcut);
+            events.clear();
+            AppendEvents(entry->utf16, events);
+            sent += events.size();
+        }
+        Bench::Consume(sent);
+    });
+
+    std::printf("%zu shortcuts, %zu replacements\n", shortcuts.size(), typed.size());
+    std::printf("Transcoding per replacement: %.1f ns\n", Bench::NanosecondsEach(typed.size(), transcoding));
+    std::printf("Pre-encoded entry:           %.1f ns\n", Bench::NanosecondsEach(typed.size(), precomputed));
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include "bench.h"
+#include "reverse_converter.h"
+#include "shortcuts_dict.h"
+#include "text_converter.h"
+#include "trigger_scan.h"
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Reverse conversion (user-035): index build time, ReverseConverter
+// throughput on converted prose and on symbol-dense text, and the ASCII
+// skip against a byte loop
+
+using namespace UniLang;
+
+namespace {
+
+const size_t TEXT_SIZE = 128 << 20;
+const size_t CHUNK_SIZE = 1 << 20;
+
+double ReverseChunked(const ShortcutsDict& dict, const ReverseIndex& index, const std::string& text,
+                      uint64_t& replacements) {
+    std::string out;
+    out.reserve(CHUNK_SIZE * 2);
+    return Bench::BestOf(3, [&] {
+        ReverseConverter converter(dict, index);
+        uint64_t written = 0;
+        for (size_t pos = 0; pos < text.size(); pos += CHUNK_SIZE) {
+            out.clear();
+            converter.Convert(std::string_view(text).substr(pos, CHUNK_SIZE), out);
+            written += out.size();
+        }
+        out.clear();
+        converter.Finish(out);
+        Bench::Consume(written + out.size());
+        replacements = converter.GetReplacementCount();
+    });
+}
+
+size_t FindNonAsciiByteScalar(const char* data, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        if (static_cast<unsigned char>(data[i]) >= 0x80) {
+            return i;
+        }
+    }
+    return size;
+}
+
+template <typename Find>
+double ScanAll(const std::string& text, Find find) {
+    return Bench::BestOf(5, [&] {
+        uint64_t found = 0;
+        for (size_t pos = 0; pos < text.size(); ++pos) {
+            pos += find(text.data() + pos, text.size() - pos);
+            found += pos < text.size();
+        }
+        Bench::Consume(found);
+    });
+}
+
+void Print(const char* name, const std::string& text, double seconds, uint64_t replacements) {
+    std::printf("%-20s %4zu MiB  %8llu symbols  %6.0f MB/s\n", name, text.size() >> 20,
+                static_cast<unsigned long long>(replacements), Bench::MegabytesPerSecond(text.size(), seconds));
+}
+
+} // namespace
+
+int main() {
+    ShortcutsDict dict;
+    if (!dict.LoadFromFile(UNILANG_BENCH_SHORTCUTS)) {
+        std::fprintf(stderr, "Failed to load %s\n", UNILANG_BENCH_SHORTCUTS);
+        return 1;
+    }
+
+    ReverseIndex index;
+    size_t indexed = 0;
+    const double build = Bench::BestOf(5, [&] { indexed = index.Build(dict); });
+    std::printf("Index: %zu replacements, build %.1f us\n", indexed, build * 1e6);
+
+    // Prose as unilang-convert leaves it: a symbol about every 40 words
+    std::vector<std::string> shortcuts;
+    std::vector<std::string> symbols;
+    for (const auto& [shortcut, replacement] : dict.GetAllShortcuts()) {
+        shortcuts.push_back(shortcut);
+        if (!replacement.empty() && static_cast<unsigned char>(replacement[0]) >= 0x80) {
+            symbols.push_back(replacement);
+        }
+    }
+    std::string prose;
+    {
+        TextConverter converter(dict);
+        converter.Convert(Bench::MakeText(TEXT_SIZE, shortcuts, 40, 1), prose);
+        converter.Finish(prose);
+    }
+
+    // Symbol-dense: a symbol for every other word
+    const std::string dense = Bench::MakeText(TEXT_SIZE, symbols, 2, 2);
+
+    uint64_t replacements = 0;
+    double seconds = ReverseChunked(dict, index, prose, replacements);
+    Print("Converted prose", prose, seconds, replacements);
+    seconds = ReverseChunked(dict, index, dense, replacements);
+    Print("Symbol-dense", dense, seconds, replacements);
+
+    const double simd = ScanAll(prose, FindNonAsciiByte);
+    const double scalar = ScanAll(prose, FindNonAsciiByteScalar);
+    std::printf("FindNonAsciiByte: %.0f MB/s, byte loop %.0f MB/s\n", Bench::MegabytesPerSecond(prose.size(), simd),
+                Bench::MegabytesPerSecond(prose.size(), scalar));
+    return 0;
+}
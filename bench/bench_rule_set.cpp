@@ -0,0 +1,117 @@
+#include "bench.h"
+#include "rule_set.h"
+#include "shortcuts_dict.h"
+#include "text_converter.h"
+#include <nlohmann/json.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Context rules (user-037): compile time, DFA size and per-character step
+// cost for 10 to 4000 random rules, and converter throughput with the
+// shipped dictionary plus those rules. The step cost should not grow with
+// the rule count.
+
+using namespace UniLang;
+using json = nlohmann::json;
+
+namespace {
+
+const size_t TEXT_SIZE = 32 << 20;
+const size_t RULE_COUNTS[] = {10, 100, 1000, 4000};
+
+// Mixed contexts and triggers, like hand-written rules
+std::vector<RuleSet::Rule> MakeRules(size_t count, uint32_t seed) {
+    static const char* const BEFORE[] = {"[0-9]", "\\s", "^|\\s", "", "\\w", "(\\d|\\))\\s*"};
+    static const char* const AFTER[] = {"", "\\s", "[.,;]"};
+    Bench::Random random(seed);
+    std::vector<RuleSet::Rule> rules(count);
+    for (RuleSet::Rule& rule : rules) {
+        rule.before = BEFORE[random.Below(sizeof(BEFORE) / sizeof(BEFORE[0]))];
+        rule.match = random.Word(3, 7);
+        rule.after = AFTER[random.Below(sizeof(AFTER) / sizeof(AFTER[0]))];
+        rule.replacement = "→";
+        rule.context = random.Below(3) == 0 ? RuleSet::Context::Text : RuleSet::Context::Any;
+    }
+    return rules;
+}
+
+json RulesToJson(const std::vector<RuleSet::Rule>& rules) {
+    json array = json::array();
+    for (const RuleSet::Rule& rule : rules) {
+        array.push_back({{"before", rule.before}, {"match", rule.match}, {"after", rule.after},
+                         {"replace", rule.replacement},
+                         {"context", rule.context == RuleSet::Context::Text ? "text" : ""}});
+    }
+    return array;
+}
+
+double ConverterMegabytesPerSecond(const ShortcutsDict& dict, const std::string& text) {
+    std::string out;
+    out.reserve(text.size() + text.size() / 4);
+    const double seconds = Bench::BestOf(3, [&] {
+        out.clear();
+        TextConverter converter(dict);
+        converter.Convert(text, out);
+        converter.Finish(out);
+    });
+    Bench::Consume(out.size());
+    return Bench::MegabytesPerSecond(text.size(), seconds);
+}
+
+} // namespace
+
+int main() {
+    std::ifstream file(UNILANG_BENCH_SHORTCUTS, std::ios::binary);
+    json shipped = json::parse(file, nullptr, false);
+    ShortcutsDict dict;
+    if (shipped.is_discarded() || !dict.LoadFromString(shipped.dump())) {
+        std::fprintf(stderr, "Failed to load %s\n", UNILANG_BENCH_SHORTCUTS);
+        return 1;
+    }
+    std::vector<std::string> shortcuts;
+    for (const auto& [shortcut, replacement] : dict.GetAllShortcuts()) {
+        shortcuts.push_back(shortcut);
+    }
+    const std::string text = Bench::MakeText(TEXT_SIZE, shortcuts, 40, 1);
+    std::printf("Converter without rules: %.0f MB/s\n\n", ConverterMegabytesPerSecond(dict, text));
+
+    std::printf("%6s %10s %8s %10s %12s %10s\n", "rules", "compile", "states", "table", "step", "converter");
+    for (size_t count : RULE_COUNTS) {
+        const std::vector<RuleSet::Rule> list = MakeRules(count, static_cast<uint32_t>(count));
+        RuleSet rules;
+        bool compiled = false;
+        const double compile = Bench::BestOf(count >= 1000 ? 1 : 3, [&] { compiled = rules.Compile(list); });
+        if (!compiled) {
+            std::fprintf(stderr, "%zu rules: %s\n", count, rules.GetLastError().c_str());
+            return 1;
+        }
+
+        // The matcher's inner loop: one table lookup and an accept check per byte
+        const double step = Bench::BestOf(3, [&] {
+            uint32_t state = RuleSet::START_STATE;
+            uint64_t fired = 0;
+            for (char ch : text) {
+                state = rules.Step(state, static_cast<unsigned char>(ch));
+                if (rules.GetFiringRule(state) != RuleSet::NO_RULE) {
+                    ++fired;
+                    state = RuleSet::GetResumeState(state);
+                }
+            }
+            Bench::Consume(fired + state);
+        });
+
+        json document = shipped;
+        document["rules"] = RulesToJson(list);
+        ShortcutsDict with_rules;
+        if (!with_rules.LoadFromString(document.dump())) {
+            std::fprintf(stderr, "%zu rules: dictionary did not load\n", count);
+            return 1;
+        }
+        std::printf("%6zu %8.1f ms %8zu %7.0f KB %7.2f ns/ch %5.0f MB/s\n", count, compile * 1e3,
+                    rules.GetStateCount(), static_cast<double>(rules.GetTableBytes()) / 1024,
+                    Bench::NanosecondsEach(text.size(), step), ConverterMegabytesPerSecond(with_rules, text));
+    }
+    return 0;
+}
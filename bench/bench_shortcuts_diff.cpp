@@ -0,0 +1,100 @@
+#include "bench.h"
+#include "shortcuts_dict.h"
+#include <nlohmann/json.hpp>
+#include <cstdio>
+#include <string>
+
+// Dictionary updates as diffs (user-045): a full parse of the new version
+// against ComputeDiff, DiffToJson/ParseDiff and LoadFromDiff, at 200 and
+// 200k entries. Eight plain categories plus one with a grammar; the update
+// removes about 1%, changes 3% and adds 2%.
+
+using namespace UniLang;
+using json = nlohmann::json;
+
+namespace {
+
+const size_t ENTRY_COUNTS[] = {200, 200000};
+const size_t CATEGORIES = 9;
+
+std::string Replacement(size_t i, size_t version) {
+    return "R" + std::to_string(i) + "." + std::to_string(version) + "→";
+}
+
+// Category 8 is an emoji-style ":name:" grammar, the rest are backslash shortcuts
+void AddEntry(json& shortcuts, size_t i, const std::string& replacement) {
+    const size_t category = i % CATEGORIES;
+    const std::string name = "cat" + std::to_string(category);
+    const std::string key = category == 8 ? "k" + std::to_string(i) : "\\k" + std::to_string(i);
+    shortcuts[name][key] = replacement;
+}
+
+void MakeVersions(size_t count, std::string& old_json, std::string& new_json) {
+    json old_shortcuts;
+    json new_shortcuts;
+    old_shortcuts["cat8"]["_grammar"] = {{"opener", ":"}, {"terminator", ":"}};
+    new_shortcuts["cat8"]["_grammar"] = {{"opener", ":"}, {"terminator", ":"}};
+    Bench::Random random(static_cast<uint32_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        AddEntry(old_shortcuts, i, Replacement(i, 1));
+        const size_t roll = random.Below(100);
+        if (roll == 0) {
+            continue;                                           // Removed
+        }
+        AddEntry(new_shortcuts, i, Replacement(i, roll <= 3 ? 2 : 1));    // Changed or kept
+    }
+    for (size_t i = count; i < count + count / 50; ++i) {
+        AddEntry(new_shortcuts, i, Replacement(i, 2));          // Added
+    }
+    old_json = json({{"shortcuts", old_shortcuts}}).dump();
+    new_json = json({{"shortcuts", new_shortcuts}}).dump();
+}
+
+} // namespace
+
+int main() {
+    std::printf("%8s %11s %12s %11s %13s %10s\n", "entries", "full parse", "ComputeDiff", "ParseDiff",
+                "LoadFromDiff", "diff size");
+    for (size_t count : ENTRY_COUNTS) {
+        std::string old_json;
+        std::string new_json;
+        MakeVersions(count, old_json, new_json);
+        const int runs = count > 1000 ? 3 : 200;
+
+        ShortcutsDict base;
+        ShortcutsDict target;
+        if (!base.LoadFromString(old_json) || !target.LoadFromString(new_json)) {
+            std::fprintf(stderr, "Failed to load the generated dictionaries\n");
+            return 1;
+        }
+
+        const double parse = Bench::BestOf(runs, [&] {
+            ShortcutsDict dict;
+            dict.LoadFromString(new_json);
+            Bench::Consume(dict.GetEntryCount());
+        });
+
+        ShortcutsDict::Diff diff;
+        const double compute = Bench::BestOf(runs, [&] { diff = ShortcutsDict::ComputeDiff(base, target); });
+        const std::string diff_json = ShortcutsDict::DiffToJson(diff);
+
+        ShortcutsDict::Diff parsed;
+        const double parse_diff = Bench::BestOf(runs, [&] { ShortcutsDict::ParseDiff(diff_json, parsed); });
+
+        bool applied = true;
+        const double apply = Bench::BestOf(runs, [&] {
+            ShortcutsDict updated;
+            applied = updated.LoadFromDiff(base, parsed) && applied;
+            Bench::Consume(updated.GetEntryCount());
+        });
+        ShortcutsDict updated;
+        if (!applied || !updated.LoadFromDiff(base, parsed) || updated.GetContentHash() != target.GetContentHash()) {
+            std::fprintf(stderr, "%zu entries: the diff did not apply\n", count);
+            return 1;
+        }
+
+        std::printf("%8zu %8.3f ms %9.3f ms %8.3f ms %10.3f ms %7.0f KB\n", count, parse * 1e3, compute * 1e3,
+                    parse_diff * 1e3, apply * 1e3, static_cast<double>(diff_json.size()) / 1024);
+    }
+    return 0;
+}
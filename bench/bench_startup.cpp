@@ -0,0 +1,117 @@
+#include "bench.h"
+#include "input_engine.h"
+#include "reverse_converter.h"
+#include "shortcuts_dict.h"
+#include "word_automaton.h"
+#include <nlohmann/json.hpp>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Cold start (user-050): the portable startup phases by dictionary size.
+// The shipped dictionary, then the same with synthetic shortcuts and a
+// word list of as many autocorrect pairs up to 200k entries: JSON parse,
+// full dictionary load (parse, matcher and index), word list parse and
+// automaton build, reverse index build, and the engine ready to take keys.
+
+using namespace UniLang;
+using json = nlohmann::json;
+
+namespace {
+
+const size_t ENTRY_COUNTS[] = {0, 2000, 20000, 200000};     // 0: the shipped dictionary alone
+
+std::string MakeDictionary(const json& shipped, size_t count) {
+    json document = shipped;
+    for (size_t i = 0; i < count; ++i) {
+        document["shortcuts"]["bench"]["\\b" + std::to_string(i)] = "B" + std::to_string(i) + "→";
+    }
+    return document.dump();
+}
+
+// "typo->correction" lines, the typo being the word with two letters swapped
+std::string MakeWordList(size_t count) {
+    Bench::Random random(static_cast<uint32_t>(count));
+    std::string text;
+    for (size_t i = 0; i < count; ++i) {
+        const std::string word = random.Word(4, 10);
+        std::string typo = word;
+        const size_t at = random.Below(word.size() - 1);
+        std::swap(typo[at], typo[at + 1]);
+        text += typo + "->" + word + "\n";
+    }
+    return text;
+}
+
+} // namespace
+
+int main() {
+    std::ifstream file(UNILANG_BENCH_SHORTCUTS, std::ios::binary);
+    const json shipped = json::parse(file, nullptr, false);
+    if (shipped.is_discarded()) {
+        std::fprintf(stderr, "Failed to load %s\n", UNILANG_BENCH_SHORTCUTS);
+        return 1;
+    }
+
+    std::printf("%8s %8s %10s %10s %11s %11s %10s %10s\n", "entries", "words", "JSON", "load", "word list",
+                "automaton", "reverse", "engine");
+    for (size_t count : ENTRY_COUNTS) {
+        const std::string text = MakeDictionary(shipped, count);
+        const std::string word_list = MakeWordList(count);
+        const int runs = count >= 20000 ? 3 : 20;
+
+        const double parse = Bench::BestOf(runs, [&] { Bench::Consume(json::parse(text).size()); });
+
+        ShortcutsDict dict;
+        bool loaded = true;
+        const double load = Bench::BestOf(runs, [&] {
+            ShortcutsDict fresh;
+            loaded = fresh.LoadFromString(text) && loaded;
+            Bench::Consume(fresh.GetEntryCount());
+        });
+        if (!loaded || !dict.LoadFromString(text)) {
+            std::fprintf(stderr, "%zu entries: the dictionary did not load\n", count);
+            return 1;
+        }
+
+        std::vector<WordAutomaton::Pair> pairs;
+        const double parse_words = Bench::BestOf(runs, [&] {
+            pairs.clear();
+            WordAutomaton::ParseWordList(word_list, pairs);
+        });
+        bool built = true;
+        const double build_words = Bench::BestOf(runs, [&] {
+            WordAutomaton words;
+            built = words.Build(pairs) && built;
+            Bench::Consume(words.GetWordCount());
+        });
+        if (!built) {
+            std::fprintf(stderr, "%zu entries: the word list did not build\n", count);
+            return 1;
+        }
+
+        const double reverse = Bench::BestOf(runs, [&] {
+            ReverseIndex index;
+            Bench::Consume(index.Build(dict));
+        });
+
+        // What WinMain does before the hook goes in
+        bool started = true;
+        const double engine = Bench::BestOf(runs, [&] {
+            InputEngine input_engine;
+            input_engine.SetDictionary(&dict);
+            started = input_engine.Start([](const EngineAction&) {}) && started;
+            input_engine.Stop();
+        });
+        if (!started) {
+            std::fprintf(stderr, "%zu entries: the engine did not start\n", count);
+            return 1;
+        }
+
+        std::printf("%8zu %8zu %7.2f ms %7.2f ms %8.2f ms %8.2f ms %7.2f ms %7.2f ms\n", dict.GetEntryCount(),
+                    pairs.size(), parse * 1e3, load * 1e3, parse_words * 1e3, build_words * 1e3, reverse * 1e3,
+                    engine * 1e3);
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+#include "bench.h"
+#include "shortcuts_dict.h"
+#include "text_converter.h"
+#include "word_automaton.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// Autocorrect word lists (user-039): build time and size of the automaton for
+// a large synthetic list, lookups per typed letter, and converter throughput
+// with and without the list
+
+using namespace UniLang;
+
+namespace {
+
+const size_t TYPOS = 55000;
+
+// Typo = the correct word with two neighbouring letters swapped
+std::vector<WordAutomaton::Pair> MakePairs(size_t count, uint32_t seed) {
+    Bench::Random random(seed);
+    std::unordered_set<std::string> typos;
+    std::vector<WordAutomaton::Pair> pairs;
+    while (pairs.size() < count) {
+        const std::string word = random.Word(4, 12);
+        std::string typo = word;
+        const size_t at = random.Below(word.size() - 1);
+        std::swap(typo[at], typo[at + 1]);
+        if (typo != word && typos.insert(typo).second) {
+            pairs.emplace_back(typo, word);
+        }
+    }
+    return pairs;
+}
+
+double ConverterMegabytesPerSecond(const ShortcutsDict& dict, const std::string& text) {
+    std::string out;
+    out.reserve(text.size() + text.size() / 4);
+    const double seconds = Bench::BestOf(3, [&] {
+        out.clear();
+        TextConverter converter(dict);
+        converter.Convert(text, out);
+        converter.Finish(out);
+    });
+    Bench::Consume(out.size());
+    return Bench::MegabytesPerSecond(text.size(), seconds);
+}
+
+} // namespace
+
+int main() {
+    const std::vector<WordAutomaton::Pair> pairs = MakePairs(TYPOS, 1);
+
+    WordAutomaton words;
+    const double build = Bench::BestOf(3, [&] { words.Build(pairs); });
+    std::printf("%zu typos: build %.1f ms, %zu states, %zu transitions, %.2f MiB\n",
+                words.GetWordCount(), build * 1e3, words.GetStateCount(), words.GetTransitionCount(),
+                static_cast<double>(words.GetMemoryBytes()) / (1 << 20));
+
+    // Every typo (hits) and as many random words (almost all misses)
+    Bench::Random random(2);
+    std::vector<std::string> lookups;
+    size_t letters = 0;
+    for (const WordAutomaton::Pair& pair : pairs) {
+        lookups.push_back(pair.first);
+        lookups.push_back(random.Word(2, 12));
+        letters += pair.first.size() + lookups.back().size();
+    }
+    const double find = Bench::BestOf(5, [&] {
+        uint64_t found = 0;
+        for (const std::string& word : lookups) {
+            found += words.Find(word) != WordAutomaton::NO_WORD;
+        }
+        Bench::Consume(found);
+    });
+    std::printf("Find: %.1f ns per word, %.1f ns per letter\n",
+                Bench::NanosecondsEach(lookups.size(), find), Bench::NanosecondsEach(letters, find));
+
+    // Prose with a typo every 20 words, through the shipped dictionary
+    ShortcutsDict dict;
+    if (!dict.LoadFromFile(UNILANG_BENCH_SHORTCUTS)) {
+        std::fprintf(stderr, "Failed to load %s\n", UNILANG_BENCH_SHORTCUTS);
+        return 1;
+    }
+    std::vector<std::string> typos;
+    for (size_t i = 0; i < pairs.size(); i += 97) {
+        typos.push_back(pairs[i].first);
+    }
+    const std::string text = Bench::MakeText(32 << 20, typos, 20, 3);
+    const double without_list = ConverterMegabytesPerSecond(dict, text);
+
+    const std::string list_path = "bench_word_list.txt";
+    {
+        std::ofstream list(list_path, std::ios::binary);
+        for (const WordAutomaton::Pair& pair : pairs) {
+            list << pair.first << "->" << pair.second << '\n';
+        }
+    }
+    const bool loaded = dict.LoadWordList(list_path);
+    std::remove(list_path.c_str());
+    if (!loaded) {
+        std::fprintf(stderr, "Failed to load the word list\n");
+        return 1;
+    }
+    std::printf("Converter: %.0f MB/s without the list, %.0f MB/s with it\n",
+                without_list, ConverterMegabytesPerSecond(dict, text));
+    return 0;
+}
@@ -1,64 +1,14 @@
 #include "auto_updater.h"
-#include <urlmon.h>
+#include "shortcuts_dict.h"
+#include "trace.h"
 #include <shlwapi.h>
 #include <fstream>
 #include <sstream>
 
-#pragma comment(lib, "urlmon.lib")
 #pragma comment(lib, "shlwapi.lib")
 
 namespace UniLang {
 
-// Callback for download progress
-class DownloadCallback : public IBindStatusCallback {
-public:
-    DownloadCallback(AutoUpdater::ProgressCallback callback)
-        : m_callback(callback), m_ref_count(1) {}
-
-    // IUnknown methods
-    STDMETHOD(QueryInterface)(REFIID riid, void** ppv) {
-        if (riid == IID_IUnknown || riid == IID_IBindStatusCallback) {
-            *ppv = static_cast<IBindStatusCallback*>(this);
-            AddRef();
-            return S_OK;
-        }
-        *ppv = nullptr;
-        return E_NOINTERFACE;
-    }
-
-    STDMETHOD_(ULONG, AddRef)() {
-        return ++m_ref_count;
-    }
-
-    STDMETHOD_(ULONG, Release)() {
-        ULONG count = --m_ref_count;
-        if (count == 0) {
-            delete this;
-        }
-        return count;
-    }
-
-    // IBindStatusCallback methods
-    STDMETHOD(OnStartBinding)(DWORD, IBinding*) { return S_OK; }
-    STDMETHOD(GetPriority)(LONG*) { return E_NOTIMPL; }
-    STDMETHOD(OnLowResource)(DWORD) { return S_OK; }
-    STDMETHOD(OnProgress)(ULONG ulProgress, ULONG ulProgressMax, ULONG, LPCWSTR) {
-        if (m_callback && ulProgressMax > 0) {
-            int percentage = (int)((ulProgress * 100) / ulProgressMax);
-            m_callback(percentage, "Downloading...");
-        }
-        return S_OK;
-    }
-    STDMETHOD(OnStopBinding)(HRESULT, LPCWSTR) { return S_OK; }
-    STDMETHOD(GetBindInfo)(DWORD*, BINDINFO*) { return S_OK; }
-    STDMETHOD(OnDataAvailable)(DWORD, DWORD, FORMATETC*, STGMEDIUM*) { return S_OK; }
-    STDMETHOD(OnObjectAvailable)(REFIID, IUnknown*) { return S_OK; }
-
-private:
-    AutoUpdater::ProgressCallback m_callback;
-    ULONG m_ref_count;
-};
-
 AutoUpdater::AutoUpdater() {
 }
 
@@ -71,44 +21,65 @@ std::string AutoUpdater::GetCurrentExePath() {
     return std::string(buffer);
 }
 
-std::string AutoUpdater::GetAppDirectory() {
-    std::string exe_path = GetCurrentExePath();
-    size_t last_slash = exe_path.find_last_of("\\/");
-    if (last_slash != std::string::npos) {
-        return exe_path.substr(0, last_slash);
+std::vector<Downloader::File> AutoUpdater::GetReleaseFiles(const UpdateManager::VersionInfo& release) {
+    std::vector<Downloader::File> files;
+
+    Downloader::File exe;
+    exe.url = release.download_url;
+    exe.path = GetStagedExePath();
+    exe.sha256 = release.download_sha256;
+    exe.delta_url = release.delta_url;     // Falls back to url if the delta fails
+    exe.delta_base = GetCurrentExePath();
+    exe.size = release.download_size;     // The delta rebuilds the same file
+    files.push_back(exe);
+
+    if (!release.shortcuts_url.empty()) {
+        // Non-critical, continue anyway
+        Downloader::File shortcuts;
+        shortcuts.url = release.shortcuts_url;
+        shortcuts.path = GetShortcutsPath();
+        shortcuts.sha256 = release.shortcuts_sha256;
+        shortcuts.required = false;
+        shortcuts.size = release.shortcuts_size;
+        files.push_back(shortcuts);
     }
-    return "";
+    return files;
 }
 
-bool AutoUpdater::DownloadFile(
-    const std::string& url,
-    const std::string& destination,
-    ProgressCallback callback
-) {
-    m_last_error.clear();
+std::string AutoUpdater::GetStagedExePath() {
+    return GetAppDirectory() + "\\UniLang_new.exe";
+}
 
-    // Convert to wide strings
-    std::wstring url_w(url.begin(), url.end());
-    std::wstring dest_w(destination.begin(), destination.end());
+std::string AutoUpdater::GetShortcutsPath() {
+    return GetAppDirectory() + "\\config\\shortcuts.json";
+}
 
-    // Create callback object
-    DownloadCallback* dl_callback = new DownloadCallback(callback);
+std::string AutoUpdater::GetShortcutsDiffPath() {
+    return GetAppDirectory() + "\\config\\shortcuts.diff.json";
+}
 
-    // Download file
-    HRESULT hr = URLDownloadToFileW(
-        nullptr,
-        url_w.c_str(),
-        dest_w.c_str(),
-        0,
-        dl_callback
-    );
+std::string AutoUpdater::GetShortcutsDiffDownloadPath() {
+    return GetAppDirectory() + "\\config\\shortcuts.diff.new.json";
+}
 
-    if (FAILED(hr)) {
-        m_last_error = "Failed to download file from: " + url;
-        return false;
+Downloader::File AutoUpdater::GetShortcutsDiffFile(const UpdateManager::VersionInfo& release, uint64_t content_hash) {
+    Downloader::File file;
+    auto it = release.shortcuts_diffs.find(ShortcutsDict::FormatHash(content_hash));
+    if (it != release.shortcuts_diffs.end()) {
+        file.url = it->second;
+        file.path = GetShortcutsDiffDownloadPath();
+        file.required = false;
     }
+    return file;
+}
 
-    return true;
+std::string AutoUpdater::GetAppDirectory() {
+    std::string exe_path = GetCurrentExePath();
+    size_t last_slash = exe_path.find_last_of("\\/");
+    if (last_slash != std::string::npos) {
+        return exe_path.substr(0, last_slash);
+    }
+    return "";
 }
 
 std::string AutoUpdater::CreateUpdateBatchScript(
@@ -164,44 +135,39 @@ bool AutoUpdater::ExecuteUpdateAndExit(const std::string& batch_script_path) {
 }
 
 bool AutoUpdater::DownloadAndInstall(
-    const std::string& exe_url,
-    const std::string& shortcuts_url,
+    const UpdateManager::VersionInfo& release,
     ProgressCallback callback
 ) {
+    UNILANG_TRACE_SCOPE("update", "AutoUpdater::DownloadAndInstall");
     m_last_error.clear();
     m_progress_callback = callback;
 
-    std::string app_dir = GetAppDirectory();
-    std::string current_exe = GetCurrentExePath();
-
-    // Download new executable
     if (callback) {
         callback(0, "Downloading new version...");
     }
 
-    std::string new_exe_path = app_dir + "\\UniLang_new.exe";
-    if (!DownloadFile(exe_url, new_exe_path, callback)) {
+    // Executable and shortcuts.json are fetched together
+    Downloader::Options options;
+    options.progress = callback;
+    Downloader downloader(options);
+    if (!downloader.Download(GetReleaseFiles(release))) {
+        m_last_error = downloader.GetLastError();
         return false;
     }
 
-    // Download shortcuts.json if provided
-    if (!shortcuts_url.empty()) {
-        if (callback) {
-            callback(50, "Downloading shortcuts...");
-        }
-
-        std::string shortcuts_path = app_dir + "\\config\\shortcuts.json";
-        if (!DownloadFile(shortcuts_url, shortcuts_path, nullptr)) {
-            // Non-critical, continue anyway
-        }
-    }
-
     if (callback) {
         callback(100, "Preparing to restart...");
     }
 
+    return Install(GetStagedExePath());
+}
+
+bool AutoUpdater::Install(const std::string& new_exe_path) {
+    UNILANG_TRACE_SCOPE("update", "AutoUpdater::Install");
+    m_last_error.clear();
+
     // Create update batch script
-    std::string batch_path = CreateUpdateBatchScript(new_exe_path, current_exe);
+    std::string batch_path = CreateUpdateBatchScript(new_exe_path, GetCurrentExePath());
     if (batch_path.empty()) {
         return false;
     }
@@ -1,6 +1,9 @@
 #pragma once
 
+#include "downloader.h"
+#include "update_manager.h"
 #include <string>
+#include <vector>
 #include <functional>
 #include <Windows.h>
 
@@ -10,49 +13,84 @@ namespace UniLang {
  * @brief Handles automatic downloading and installation of updates
  *
  * Responsibilities:
- * - Download executable and config files from URLs
+ * - Download executable and config files from URLs (resumed and
+ *   SHA-256 verified by Downloader)
  * - Replace current executable with new version
  * - Restart application after update
  */
 class AutoUpdater {
 public:
-    using ProgressCallback = std::function<void(int percentage, const std::string& status)>;
+    using ProgressCallback = Downloader::ProgressCallback;
 
     AutoUpdater();
     ~AutoUpdater();
 
     /**
      * @brief Download and install update
-     * @param exe_url URL to new .exe file
-     * @param shortcuts_url URL to new shortcuts.json (optional)
-     * @param callback Progress callback (optional)
+     * @param release Release from UpdateManager (URLs and digests; shortcuts optional)
+     * @param callback Progress over both downloads (optional)
      * @return true if update initiated successfully
      */
     bool DownloadAndInstall(
-        const std::string& exe_url,
-        const std::string& shortcuts_url = "",
+        const UpdateManager::VersionInfo& release,
         ProgressCallback callback = nullptr
     );
 
     /**
-     * @brief Get last error message
+     * @brief Replace the running executable with a downloaded one and restart
+     *
+     * Used after UpdateWorker downloaded the update to GetStagedExePath().
+     * Does not return on success.
+     *
+     * @param new_exe_path Path to the downloaded executable
+     * @return false if the update script could not be started
      */
-    std::string GetLastError() const { return m_last_error; }
+    bool Install(const std::string& new_exe_path);
 
-private:
     /**
-     * @brief Download file from URL
-     * @param url Source URL
-     * @param destination Destination file path
-     * @param callback Progress callback
-     * @return true if successful
+     * @brief Where a new executable is downloaded to before Install
      */
-    bool DownloadFile(
-        const std::string& url,
-        const std::string& destination,
-        ProgressCallback callback
-    );
+    std::string GetStagedExePath();
+
+    /**
+     * @brief Path of the shortcuts.json an update replaces
+     */
+    std::string GetShortcutsPath();
+
+    /**
+     * @brief Where the diff from the embedded dictionary to the current one is kept;
+     * it is applied again at startup
+     */
+    std::string GetShortcutsDiffPath();
+
+    /**
+     * @brief Where a downloaded shortcuts diff waits until it has been applied
+     */
+    std::string GetShortcutsDiffDownloadPath();
+
+    /**
+     * @brief Download of the release's shortcuts diff from a dictionary, if it has one
+     * @param content_hash ShortcutsDict::GetContentHash of the running dictionary
+     * @return File with an empty url if the release has no diff from that dictionary
+     */
+    Downloader::File GetShortcutsDiffFile(const UpdateManager::VersionInfo& release, uint64_t content_hash);
 
+    /**
+     * @brief Path of the running executable (the base of binary deltas)
+     */
+    std::string GetCurrentExePath();
+
+    /**
+     * @brief Download list for a release: the exe (from its delta when offered) and shortcuts.json
+     */
+    std::vector<Downloader::File> GetReleaseFiles(const UpdateManager::VersionInfo& release);
+
+    /**
+     * @brief Get last error message
+     */
+    std::string GetLastError() const { return m_last_error; }
+
+private:
     /**
      * @brief Create batch script to replace executable and restart
      * @param new_exe_path Path to new executable
@@ -71,11 +109,6 @@ private:
      */
     bool ExecuteUpdateAndExit(const std::string& batch_script_path);
 
-    /**
-     * @brief Get current executable path
-     */
-    std::string GetCurrentExePath();
-
     /**
      * @brief Get application directory
      */
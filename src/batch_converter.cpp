@@ -0,0 +1,335 @@
+#include "batch_converter.h"
+#include "shortcuts_dict.h"
+#include "task_pool.h"
+#include "text_converter.h"
+#include "trace.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+
+namespace fs = std::filesystem;
+
+namespace UniLang {
+
+namespace {
+
+const char* const TEMP_SUFFIX = ".unilang-tmp";
+const size_t BINARY_PROBE_SIZE = 8192;  // A NUL byte in this prefix marks a binary file
+
+bool ReadFile(const std::string& path, std::string& data, std::string& error) {
+    std::ifstream file(fs::u8path(path), std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        error = "cannot open file";
+        return false;
+    }
+
+    const std::streamoff size = file.tellg();
+    data.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    if (size > 0 && !file.read(&data[0], size)) {
+        error = "read failed";
+        return false;
+    }
+    return true;
+}
+
+bool WriteFileAtomic(const std::string& path, const std::string& data, std::string& error) {
+    const fs::path target = fs::u8path(path);
+    const fs::path temp = fs::u8path(path + TEMP_SUFFIX);
+
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            error = "cannot create temporary file";
+            return false;
+        }
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file.close();
+        if (!file) {
+            error = "write failed";
+            std::error_code ignored;
+            fs::remove(temp, ignored);
+            return false;
+        }
+    }
+
+    // Keep the original file's permissions on the replacement
+    std::error_code ec;
+    const fs::perms perms = fs::status(target, ec).permissions();
+    if (!ec) {
+        fs::permissions(temp, perms, ec);
+    }
+
+    fs::rename(temp, target, ec);
+    if (ec) {
+        error = "rename failed: " + ec.message();
+        std::error_code ignored;
+        fs::remove(temp, ignored);
+        return false;
+    }
+    return true;
+}
+
+bool EndsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() &&
+           text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+struct BatchConverter::FileJob {
+    FileResult result;
+    std::string input;
+    std::vector<size_t> bounds;             // Chunk i is [bounds[i], bounds[i + 1])
+    std::vector<std::string> outputs;
+    std::vector<uint64_t> replacements;
+    std::atomic<size_t> remaining{0};
+};
+
+BatchConverter::BatchConverter(const ShortcutsDict& dict, const Options& options)
+    : m_dict(dict)
+    , m_options(options) {
+    if (m_options.split_size == 0) {
+        m_options.split_size = 1;
+    }
+}
+
+bool BatchConverter::ConvertTree(const std::string& root, Summary& summary) {
+    UNILANG_TRACE_SCOPE("convert", "BatchConverter::ConvertTree");
+    m_summary = Summary();
+    const auto start = std::chrono::steady_clock::now();
+
+    std::error_code ec;
+    const fs::path root_path = fs::u8path(root);
+    const fs::file_status root_status = fs::status(root_path, ec);
+    if (ec || !fs::exists(root_status)) {
+        m_last_error = "Cannot access " + root;
+        return false;
+    }
+
+    TaskPool pool(m_options.threads);
+
+    auto submit = [this, &pool](const fs::path& path) {
+        std::string file = path.u8string();
+        pool.Submit([this, &pool, file]() { ConvertFile(pool, file); });
+    };
+
+    if (fs::is_regular_file(root_status)) {
+        submit(root_path);
+    } else {
+        // Workers start converting while the walk is still in progress
+        fs::recursive_directory_iterator it(root_path, fs::directory_options::skip_permission_denied, ec);
+        if (ec) {
+            m_last_error = "Cannot walk " + root + ": " + ec.message();
+            return false;
+        }
+        for (; it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) {
+                break;
+            }
+
+            const fs::file_status status = it->symlink_status(ec);
+            const std::string name = it->path().filename().u8string();
+
+            // Skip hidden directories (.git, .svn, ...) and never follow symlinks
+            if (fs::is_directory(status)) {
+                if (!name.empty() && name[0] == '.') {
+                    it.disable_recursion_pending();
+                }
+                continue;
+            }
+            if (!fs::is_regular_file(status) || EndsWith(name, TEMP_SUFFIX)) {
+                continue;
+            }
+            if (!MatchesExtension(name)) {
+                continue;
+            }
+            submit(it->path());
+        }
+    }
+
+    pool.Wait();
+
+    std::sort(m_summary.files.begin(), m_summary.files.end(),
+              [](const FileResult& a, const FileResult& b) { return a.path < b.path; });
+    m_summary.threads = pool.GetThreadCount();
+    m_summary.steals = pool.GetStealCount();
+    m_summary.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    summary = std::move(m_summary);
+    m_summary = Summary();
+    return true;
+}
+
+void BatchConverter::ConvertFile(TaskPool& pool, const std::string& path) {
+    auto job = std::make_shared<FileJob>();
+    job->result.path = path;
+
+    if (!ReadFile(path, job->input, job->result.error)) {
+        Record(std::move(job->result), false);
+        return;
+    }
+    job->result.bytes_in = job->input.size();
+
+    const size_t probe = std::min(job->input.size(), BINARY_PROBE_SIZE);
+    if (std::memchr(job->input.data(), '\0', probe) != nullptr) {
+        Record(std::move(job->result), true);
+        return;
+    }
+
+    // Split right after a newline at or past each split_size step. The
+    // matcher resets on '\n', so no pattern can span two chunks.
+    const std::string& input = job->input;
+    job->bounds.push_back(0);
+    size_t next = m_options.split_size;
+    while (next < input.size()) {
+        const void* newline = std::memchr(input.data() + next, '\n', input.size() - next);
+        if (newline == nullptr) {
+            break;
+        }
+        const size_t split = static_cast<const char*>(newline) - input.data() + 1;
+        if (split >= input.size()) {
+            break;
+        }
+        job->bounds.push_back(split);
+        next = split + m_options.split_size;
+    }
+    job->bounds.push_back(input.size());
+
+    const size_t chunks = job->bounds.size() - 1;
+    job->result.chunks = chunks;
+    job->outputs.resize(chunks);
+    job->replacements.resize(chunks);
+    job->remaining.store(chunks, std::memory_order_relaxed);
+
+    // Fan out all but the first chunk so idle workers can steal them
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        pool.Submit([this, job, chunk]() { ConvertChunk(*job, chunk); });
+    }
+    ConvertChunk(*job, 0);
+}
+
+void BatchConverter::ConvertChunk(FileJob& job, size_t chunk) {
+    UNILANG_TRACE_SCOPE("convert", "BatchConverter::ConvertChunk");
+    const size_t begin = job.bounds[chunk];
+    const size_t end = job.bounds[chunk + 1];
+
+    TextConverter converter(m_dict);
+    converter.SetCategoryMask(m_options.categories);
+    std::string& out = job.outputs[chunk];
+    out.reserve(end - begin + (end - begin) / 8);
+    converter.Convert(std::string_view(job.input).substr(begin, end - begin), out);
+    converter.Finish(out);
+    job.replacements[chunk] = converter.GetReplacementCount();
+
+    if (job.remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        FinishFile(job);
+    }
+}
+
+void BatchConverter::FinishFile(FileJob& job) {
+    UNILANG_TRACE_SCOPE("convert", "BatchConverter::FinishFile");
+    FileResult& result = job.result;
+    for (uint64_t count : job.replacements) {
+        result.replacements += count;
+    }
+
+    if (result.replacements > 0) {
+        std::string output;
+        if (job.outputs.size() == 1) {
+            output = std::move(job.outputs[0]);
+        } else {
+            size_t total = 0;
+            for (const std::string& part : job.outputs) {
+                total += part.size();
+            }
+            output.reserve(total);
+            for (const std::string& part : job.outputs) {
+                output += part;
+            }
+        }
+
+        result.bytes_out = output.size();
+        result.changed = output != job.input;
+        if (result.changed && !m_options.dry_run) {
+            WriteFileAtomic(result.path, output, result.error);
+        }
+    } else {
+        result.bytes_out = result.bytes_in;
+    }
+
+    // Release the file contents before the job is recorded
+    job.input.clear();
+    job.input.shrink_to_fit();
+    job.outputs.clear();
+
+    Record(std::move(result), false);
+}
+
+void BatchConverter::Record(FileResult&& result, bool skipped) {
+    std::lock_guard<std::mutex> lock(m_summary_mutex);
+
+    ++m_summary.files_scanned;
+    if (skipped) {
+        ++m_summary.files_skipped;
+        return;
+    }
+
+    m_summary.bytes_in += result.bytes_in;
+    m_summary.bytes_out += result.bytes_out;
+    m_summary.replacements += result.replacements;
+    if (result.changed && result.error.empty()) {
+        ++m_summary.files_changed;
+    }
+    if (result.changed || !result.error.empty()) {
+        m_summary.files.push_back(std::move(result));
+    }
+}
+
+bool BatchConverter::MatchesExtension(const std::string& name) const {
+    if (m_options.extensions.empty()) {
+        return true;
+    }
+    for (const std::string& extension : m_options.extensions) {
+        if (EndsWith(name, extension)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string BatchConverter::SummaryToJson(const Summary& summary) {
+    nlohmann::ordered_json files = nlohmann::ordered_json::array();
+    for (const FileResult& file : summary.files) {
+        nlohmann::ordered_json entry;
+        entry["path"] = file.path;
+        entry["replacements"] = file.replacements;
+        entry["bytes_in"] = file.bytes_in;
+        entry["bytes_out"] = file.bytes_out;
+        entry["chunks"] = file.chunks;
+        if (!file.error.empty()) {
+            entry["error"] = file.error;
+        }
+        files.push_back(std::move(entry));
+    }
+
+    nlohmann::ordered_json json;
+    json["files_scanned"] = summary.files_scanned;
+    json["files_changed"] = summary.files_changed;
+    json["files_skipped"] = summary.files_skipped;
+    json["replacements"] = summary.replacements;
+    json["bytes_in"] = summary.bytes_in;
+    json["bytes_out"] = summary.bytes_out;
+    json["threads"] = summary.threads;
+    json["steals"] = summary.steals;
+    json["seconds"] = summary.seconds;
+    json["files"] = std::move(files);
+    return json.dump(2);
+}
+
+} // namespace UniLang
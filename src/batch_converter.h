@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace UniLang {
+
+class ShortcutsDict;
+class TaskPool;
+
+/**
+ * @brief Converts every text file under a directory tree in parallel
+ *
+ * Files are scheduled on a work-stealing TaskPool as the tree is walked.
+ * Files larger than split_size are cut into chunks right after a newline;
+ * a newline resets the matcher, so each chunk converts independently and
+ * the joined result is byte-identical to a serial conversion.
+ *
+ * Changed files are replaced atomically (write to a temporary file in the
+ * same directory, then rename over the original). Unchanged files are not
+ * touched.
+ */
+class BatchConverter {
+public:
+    struct Options {
+        size_t threads = 0;                         // 0 = one per hardware thread
+        size_t split_size = 8 << 20;                // Files above this are split into chunks
+        std::vector<std::string> extensions;        // e.g. ".md"; empty = all files
+        bool dry_run = false;                       // Report edits without writing
+        uint64_t categories = UINT64_MAX;           // Enabled dictionary categories (see ShortcutsDict)
+    };
+
+    struct FileResult {
+        std::string path;
+        uint64_t bytes_in = 0;
+        uint64_t bytes_out = 0;
+        uint64_t replacements = 0;
+        size_t chunks = 1;
+        bool changed = false;
+        std::string error;                          // Empty on success
+    };
+
+    struct Summary {
+        uint64_t files_scanned = 0;
+        uint64_t files_changed = 0;
+        uint64_t files_skipped = 0;                 // Binary files
+        uint64_t replacements = 0;
+        uint64_t bytes_in = 0;
+        uint64_t bytes_out = 0;
+        uint64_t steals = 0;
+        size_t threads = 0;
+        double seconds = 0.0;
+        std::vector<FileResult> files;              // Changed files and errors, sorted by path
+    };
+
+    BatchConverter(const ShortcutsDict& dict, const Options& options);
+
+    /**
+     * @brief Convert all matching files below root
+     * @param root Directory to walk (or a single file)
+     * @param summary Filled with totals and per-file edits
+     * @return false if root can't be walked (see GetLastError)
+     */
+    bool ConvertTree(const std::string& root, Summary& summary);
+
+    /**
+     * @brief Machine-readable form of a summary (JSON)
+     */
+    static std::string SummaryToJson(const Summary& summary);
+
+    const std::string& GetLastError() const { return m_last_error; }
+
+private:
+    struct FileJob;
+
+    /**
+     * @brief Read a file and convert it, fanning out chunk tasks for large files
+     */
+    void ConvertFile(TaskPool& pool, const std::string& path);
+
+    /**
+     * @brief Convert one chunk of a file; the last chunk to finish writes the file
+     */
+    void ConvertChunk(FileJob& job, size_t chunk);
+
+    /**
+     * @brief Join converted chunks, write the file if it changed and record the result
+     */
+    void FinishFile(FileJob& job);
+
+    /**
+     * @brief Add a finished file to the running summary
+     */
+    void Record(FileResult&& result, bool skipped);
+
+    bool MatchesExtension(const std::string& path) const;
+
+    const ShortcutsDict& m_dict;
+    Options m_options;
+    std::string m_last_error;
+
+    std::mutex m_summary_mutex;
+    Summary m_summary;
+};
+
+} // namespace UniLang
@@ -0,0 +1,549 @@
+#include "binary_delta.h"
+#include <algorithm>
+#include <cstring>
+
+namespace UniLang {
+
+namespace {
+
+// Zero runs shorter than this stay inside literals (a pair costs two varints)
+const size_t MIN_ZERO_RUN = 4;
+
+void PutU32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out += static_cast<char>(value >> (8 * i));
+    }
+}
+
+void PutU64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out += static_cast<char>(value >> (8 * i));
+    }
+}
+
+uint64_t GetLittleEndian(const char* data, int size) {
+    uint64_t value = 0;
+    for (int i = 0; i < size; ++i) {
+        value |= static_cast<uint64_t>(static_cast<uint8_t>(data[i])) << (8 * i);
+    }
+    return value;
+}
+
+void PutVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+/**
+ * @brief Read a varint at pos
+ * @return 1 if read (pos advanced), 0 if more data is needed, -1 if malformed
+ */
+int GetVarint(std::string_view data, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (size_t i = 0; i < 10; ++i) {
+        if (pos + i >= data.size()) {
+            return 0;
+        }
+        const uint8_t byte = static_cast<uint8_t>(data[pos + i]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << (7 * i);
+        if ((byte & 0x80) == 0) {
+            pos += i + 1;
+            return 1;
+        }
+    }
+    return -1;
+}
+
+uint64_t ZigZag(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+/**
+ * @brief Suffix array of data plus its empty suffix (prefix doubling, radix sorted)
+ */
+std::vector<int32_t> BuildSuffixArray(std::string_view data) {
+    const int32_t n = static_cast<int32_t>(data.size()) + 1;
+    std::vector<int32_t> sa(n), rank(n), next(n), count(std::max<int32_t>(n, 257) + 1);
+
+    // Rank by first byte; the empty suffix sorts first
+    for (int32_t i = 0; i < n; ++i) {
+        rank[i] = i + 1 < n ? static_cast<uint8_t>(data[i]) + 1 : 0;
+        count[rank[i]]++;
+    }
+    for (size_t i = 1; i < count.size(); ++i) {
+        count[i] += count[i - 1];
+    }
+    for (int32_t i = n - 1; i >= 0; --i) {
+        sa[--count[rank[i]]] = i;
+    }
+
+    for (int32_t k = 1;; k <<= 1) {
+        // Order by second key (rank at i + k, missing sorts first), then stably by first key
+        int32_t p = 0;
+        for (int32_t i = std::max(n - k, 0); i < n; ++i) {
+            next[p++] = i;
+        }
+        for (int32_t i = 0; i < n; ++i) {
+            if (sa[i] >= k) {
+                next[p++] = sa[i] - k;
+            }
+        }
+        std::fill(count.begin(), count.end(), 0);
+        for (int32_t i = 0; i < n; ++i) {
+            count[rank[i]]++;
+        }
+        for (size_t i = 1; i < count.size(); ++i) {
+            count[i] += count[i - 1];
+        }
+        for (int32_t i = n - 1; i >= 0; --i) {
+            sa[--count[rank[next[i]]]] = next[i];
+        }
+
+        // New ranks from (rank[i], rank[i + k]) pairs
+        auto second = [&](int32_t i) { return i + k < n ? rank[i + k] : -1; };
+        next[sa[0]] = 0;
+        for (int32_t i = 1; i < n; ++i) {
+            const bool same = rank[sa[i]] == rank[sa[i - 1]] && second(sa[i]) == second(sa[i - 1]);
+            next[sa[i]] = next[sa[i - 1]] + (same ? 0 : 1);
+        }
+        rank.swap(next);
+        if (rank[sa[n - 1]] == n - 1) {
+            return sa;
+        }
+    }
+}
+
+int64_t MatchLength(std::string_view a, std::string_view b) {
+    const size_t limit = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i < limit && a[i] == b[i]) {
+        ++i;
+    }
+    return static_cast<int64_t>(i);
+}
+
+/**
+ * @brief Longest match of target in old, by binary search over the suffix array
+ */
+int64_t Search(const std::vector<int32_t>& sa, std::string_view old_data, std::string_view target,
+               int64_t start, int64_t end, int64_t& pos) {
+    while (end - start >= 2) {
+        const int64_t middle = start + (end - start) / 2;
+        const std::string_view suffix = old_data.substr(sa[middle]);
+        if (suffix.compare(0, target.size(), target.substr(0, suffix.size())) < 0) {
+            start = middle;
+        } else {
+            end = middle;
+        }
+    }
+    const int64_t x = MatchLength(old_data.substr(sa[start]), target);
+    const int64_t y = MatchLength(old_data.substr(sa[end]), target);
+    pos = x > y ? sa[start] : sa[end];
+    return std::max(x, y);
+}
+
+/**
+ * @brief Append one record: diff over the approximate match, then new bytes
+ */
+void PutRecord(std::string& out, std::string_view old_data, std::string_view new_data,
+               int64_t old_pos, int64_t new_pos, int64_t add, int64_t extra, int64_t seek) {
+    PutVarint(out, static_cast<uint64_t>(add));
+    PutVarint(out, static_cast<uint64_t>(extra));
+    PutVarint(out, ZigZag(seek));
+
+    int64_t i = 0;
+    while (i < add) {
+        const int64_t zero_start = i;
+        while (i < add && new_data[new_pos + i] == old_data[old_pos + i]) {
+            ++i;
+        }
+        const int64_t zeros = i - zero_start;
+
+        // Literals run until the next zero run worth its own pair
+        const int64_t literal_start = i;
+        int64_t literal_end = i;
+        while (literal_end < add) {
+            int64_t run = 0;
+            while (literal_end + run < add && run < static_cast<int64_t>(MIN_ZERO_RUN) &&
+                   new_data[new_pos + literal_end + run] == old_data[old_pos + literal_end + run]) {
+                ++run;
+            }
+            if (run >= static_cast<int64_t>(MIN_ZERO_RUN) || literal_end + run == add) {
+                break;
+            }
+            literal_end += run + 1;
+        }
+
+        PutVarint(out, static_cast<uint64_t>(zeros));
+        PutVarint(out, static_cast<uint64_t>(literal_end - literal_start));
+        for (int64_t j = literal_start; j < literal_end; ++j) {
+            out += static_cast<char>(new_data[new_pos + j] - old_data[old_pos + j]);
+        }
+        i = literal_end;
+    }
+    out.append(new_data.substr(static_cast<size_t>(new_pos + add), static_cast<size_t>(extra)));
+}
+
+} // namespace
+
+std::string BinaryDelta::Create(std::string_view old_data, std::string_view new_data) {
+    std::string out(MAGIC, MAGIC_SIZE);
+    PutU64(out, old_data.size());
+    PutU64(out, new_data.size());
+    const Sha256::Digest old_hash = [&]() { Sha256 h; h.Update(old_data); return h.Final(); }();
+    const Sha256::Digest new_hash = [&]() { Sha256 h; h.Update(new_data); return h.Final(); }();
+    out.append(reinterpret_cast<const char*>(old_hash.data()), old_hash.size());
+    out.append(reinterpret_cast<const char*>(new_hash.data()), new_hash.size());
+
+    const uint32_t blocks = static_cast<uint32_t>((new_data.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    PutU32(out, BLOCK_SIZE);
+    PutU32(out, blocks);
+    for (uint32_t i = 0; i < blocks; ++i) {
+        Sha256 hasher;
+        hasher.Update(new_data.substr(static_cast<size_t>(i) * BLOCK_SIZE, BLOCK_SIZE));
+        const Sha256::Digest digest = hasher.Final();
+        out.append(reinterpret_cast<const char*>(digest.data()), digest.size());
+    }
+
+    // bsdiff's scan: extend approximate matches, cut where an exact match elsewhere wins
+    const std::vector<int32_t> sa = BuildSuffixArray(old_data);
+    const int64_t old_size = static_cast<int64_t>(old_data.size());
+    const int64_t new_size = static_cast<int64_t>(new_data.size());
+    int64_t scan = 0, len = 0, pos = 0;
+    int64_t last_scan = 0, last_pos = 0, last_offset = 0;
+
+    while (scan < new_size) {
+        int64_t old_score = 0;
+        int64_t scsc = scan += len;
+        for (; scan < new_size; ++scan) {
+            len = Search(sa, old_data, new_data.substr(scan), 0, old_size, pos);
+            for (; scsc < scan + len; ++scsc) {
+                if (scsc + last_offset < old_size && old_data[scsc + last_offset] == new_data[scsc]) {
+                    ++old_score;
+                }
+            }
+            if ((len == old_score && len != 0) || len > old_score + 8) {
+                break;
+            }
+            if (scan + last_offset < old_size && old_data[scan + last_offset] == new_data[scan]) {
+                --old_score;
+            }
+        }
+
+        if (len == old_score && scan != new_size) {
+            continue;
+        }
+
+        // Grow the previous match forward and the new one backward while mostly equal
+        int64_t s = 0, best = 0, forward = 0;
+        for (int64_t i = 0; last_scan + i < scan && last_pos + i < old_size;) {
+            if (old_data[last_pos + i] == new_data[last_scan + i]) {
+                ++s;
+            }
+            ++i;
+            if (s * 2 - i > best * 2 - forward) {
+                best = s;
+                forward = i;
+            }
+        }
+
+        int64_t backward = 0;
+        if (scan < new_size) {
+            s = 0;
+            best = 0;
+            for (int64_t i = 1; scan >= last_scan + i && pos >= i; ++i) {
+                if (old_data[pos - i] == new_data[scan - i]) {
+                    ++s;
+                }
+                if (s * 2 - i > best * 2 - backward) {
+                    best = s;
+                    backward = i;
+                }
+            }
+        }
+
+        // Split an overlap where it costs least
+        if (last_scan + forward > scan - backward) {
+            const int64_t overlap = (last_scan + forward) - (scan - backward);
+            s = 0;
+            best = 0;
+            int64_t split = 0;
+            for (int64_t i = 0; i < overlap; ++i) {
+                if (new_data[last_scan + forward - overlap + i] == old_data[last_pos + forward - overlap + i]) {
+                    ++s;
+                }
+                if (new_data[scan - backward + i] == old_data[pos - backward + i]) {
+                    --s;
+                }
+                if (s > best) {
+                    best = s;
+                    split = i + 1;
+                }
+            }
+            forward += split - overlap;
+            backward -= split;
+        }
+
+        const int64_t extra = (scan - backward) - (last_scan + forward);
+        const int64_t seek = (pos - backward) - (last_pos + forward);
+        PutRecord(out, old_data, new_data, last_pos, last_scan, forward, extra, seek);
+
+        last_scan = scan - backward;
+        last_pos = pos - backward;
+        last_offset = pos - scan;
+    }
+
+    return out;
+}
+
+DeltaApplier::DeltaApplier(std::string_view old_data, Output output, uint64_t max_new_size)
+    : m_old(old_data), m_output(std::move(output)),
+      m_max_new_size(std::min<uint64_t>(max_new_size, BinaryDelta::MAX_NEW_SIZE)) {
+}
+
+bool DeltaApplier::Fail(const std::string& error) {
+    m_last_error = error;
+    m_state = State::Done;
+    m_pending.clear();
+    m_pos = 0;
+    return false;
+}
+
+bool DeltaApplier::Feed(std::string_view data) {
+    if (!m_last_error.empty()) {
+        return false;
+    }
+    m_pending.append(data);
+    const bool ok = Parse();
+    if (ok) {
+        m_pending.erase(0, m_pos);
+        m_pos = 0;
+    }
+    return ok;
+}
+
+bool DeltaApplier::Parse() {
+    for (;;) {
+        const std::string_view input = std::string_view(m_pending).substr(m_pos);
+        switch (m_state) {
+            case State::Header: {
+                if (input.size() < BinaryDelta::HEADER_SIZE) {
+                    return true;
+                }
+                if (input.compare(0, BinaryDelta::MAGIC_SIZE, BinaryDelta::MAGIC) != 0) {
+                    return Fail("not a UniLang delta");
+                }
+                const char* p = input.data() + BinaryDelta::MAGIC_SIZE;
+                m_header.old_size = GetLittleEndian(p, 8);
+                m_header.new_size = GetLittleEndian(p + 8, 8);
+                std::memcpy(m_header.old_sha256.data(), p + 16, 32);
+                std::memcpy(m_header.new_sha256.data(), p + 48, 32);
+                m_header.block_size = static_cast<uint32_t>(GetLittleEndian(p + 80, 4));
+                const uint64_t blocks = GetLittleEndian(p + 84, 4);
+                if (m_header.block_size == 0 || blocks > BinaryDelta::MAX_BLOCKS ||
+                    blocks != m_header.new_size / m_header.block_size + (m_header.new_size % m_header.block_size != 0)) {
+                    return Fail("malformed delta header");
+                }
+                if (m_header.new_size > m_max_new_size) {
+                    return Fail("delta describes a file larger than expected");
+                }
+                m_header.block_sha256.resize(static_cast<size_t>(blocks));
+
+                // The delta only makes sense against the exact base it was made from
+                Sha256 hasher;
+                hasher.Update(m_old);
+                if (m_old.size() != m_header.old_size || hasher.Final() != m_header.old_sha256) {
+                    return Fail("delta was made for a different base file");
+                }
+                m_pos += BinaryDelta::HEADER_SIZE;
+                m_state = State::BlockHashes;
+                break;
+            }
+
+            case State::BlockHashes: {
+                const size_t size = m_header.block_sha256.size() * 32;
+                if (input.size() < size) {
+                    return true;
+                }
+                for (size_t i = 0; i < m_header.block_sha256.size(); ++i) {
+                    std::memcpy(m_header.block_sha256[i].data(), input.data() + i * 32, 32);
+                }
+                m_pos += size;
+                m_state = m_header.new_size == 0 ? State::Done : State::Control;
+                break;
+            }
+
+            case State::Control: {
+                bool need_more = false;
+                if (!ParseControl(need_more)) {
+                    return false;
+                }
+                if (need_more) {
+                    return true;
+                }
+                break;
+            }
+
+            case State::Add: {
+                if (m_add_left == 0) {
+                    // The seek moves the base position after the add bytes
+                    m_old_pos += m_seek;
+                    m_state = State::Extra;
+                    break;
+                }
+                size_t pos = m_pos;
+                uint64_t zeros = 0, literals = 0;
+                int read = GetVarint(m_pending, pos, zeros);
+                if (read == 1) {
+                    read = GetVarint(m_pending, pos, literals);
+                }
+                if (read == 0) {
+                    return true;
+                }
+                // Each term on its own: a corrupt varint must not wrap the sum
+                if (read < 0 || zeros > m_add_left || literals > m_add_left - zeros || zeros + literals == 0) {
+                    return Fail("malformed delta record");
+                }
+                m_pos = pos;
+                // Unchanged bytes come straight from the base
+                if (!Emit(m_old.data() + m_old_pos, static_cast<size_t>(zeros))) {
+                    return false;
+                }
+                m_old_pos += static_cast<int64_t>(zeros);
+                m_add_left -= zeros + literals;
+                m_literal_left = literals;
+                m_state = State::AddLiteral;
+                break;
+            }
+
+            case State::AddLiteral: {
+                if (m_literal_left == 0) {
+                    m_state = State::Add;
+                    break;
+                }
+                if (input.empty()) {
+                    return true;
+                }
+                const size_t take = static_cast<size_t>(std::min<uint64_t>(m_literal_left, input.size()));
+                m_literal.resize(take);
+                for (size_t i = 0; i < take; ++i) {
+                    m_literal[i] = static_cast<char>(m_old[static_cast<size_t>(m_old_pos) + i] + input[i]);
+                }
+                if (!Emit(m_literal.data(), take)) {
+                    return false;
+                }
+                m_pos += take;
+                m_old_pos += static_cast<int64_t>(take);
+                m_literal_left -= take;
+                break;
+            }
+
+            case State::Extra: {
+                if (m_extra_left == 0) {
+                    m_state = m_written == m_header.new_size ? State::Done : State::Control;
+                    break;
+                }
+                if (input.empty()) {
+                    return true;
+                }
+                const size_t take = static_cast<size_t>(std::min<uint64_t>(m_extra_left, input.size()));
+                if (!Emit(input.data(), take)) {
+                    return false;
+                }
+                m_pos += take;
+                m_extra_left -= take;
+                break;
+            }
+
+            case State::Done:
+                if (!input.empty()) {
+                    return Fail("data after the end of the delta");
+                }
+                return true;
+        }
+    }
+}
+
+bool DeltaApplier::ParseControl(bool& need_more) {
+    size_t pos = m_pos;
+    uint64_t add = 0, extra = 0, seek = 0;
+    int read = GetVarint(m_pending, pos, add);
+    if (read == 1) {
+        read = GetVarint(m_pending, pos, extra);
+    }
+    if (read == 1) {
+        read = GetVarint(m_pending, pos, seek);
+    }
+    if (read == 0) {
+        need_more = true;
+        return true;
+    }
+
+    // Every byte of the record must land inside both files, and no seek can
+    // go further than the base is long (which also keeps m_old_pos from overflowing)
+    const uint64_t remaining = m_header.new_size - m_written;
+    const int64_t seek_value = UnZigZag(seek);
+    const uint64_t seek_distance = seek_value < 0 ? 0 - static_cast<uint64_t>(seek_value) : static_cast<uint64_t>(seek_value);
+    if (read < 0 || add > remaining || extra > remaining - add || m_old_pos < 0 ||
+        static_cast<uint64_t>(m_old_pos) > m_old.size() || add > m_old.size() - static_cast<uint64_t>(m_old_pos) ||
+        seek_distance > m_old.size()) {
+        return Fail("malformed delta record");
+    }
+    m_pos = pos;
+    m_add_left = add;
+    m_extra_left = extra;
+    m_seek = seek_value;
+    m_state = State::Add;
+    return true;
+}
+
+bool DeltaApplier::Emit(const char* data, size_t size) {
+    if (size == 0) {
+        return true;
+    }
+    if (!m_output(std::string_view(data, size))) {
+        return Fail("failed to write the new file");
+    }
+    m_file_hash.Update(data, size);
+    m_written += size;
+
+    // Only the file's last block may be short
+    while (size > 0) {
+        const size_t take = static_cast<size_t>(std::min<uint64_t>(size, m_header.block_size - m_block_fill));
+        m_block_hash.Update(data, take);
+        m_block_fill += take;
+        data += take;
+        size -= take;
+        if (m_block_fill == m_header.block_size || (size == 0 && m_written == m_header.new_size)) {
+            if (m_block_hash.Final() != m_header.block_sha256[m_block_index]) {
+                return Fail("block " + std::to_string(m_block_index) + " of the new file does not match");
+            }
+            m_block_hash.Reset();
+            m_block_fill = 0;
+            ++m_block_index;
+        }
+    }
+    return true;
+}
+
+bool DeltaApplier::Finish() {
+    if (!m_last_error.empty()) {
+        return false;
+    }
+    if (m_state != State::Done || m_written != m_header.new_size || !m_pending.empty()) {
+        return Fail("delta ended early");
+    }
+    if (m_file_hash.Final() != m_header.new_sha256) {
+        return Fail("new file does not match its SHA-256");
+    }
+    return true;
+}
+
+} // namespace UniLang
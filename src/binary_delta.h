@@ -0,0 +1,144 @@
+#pragma once
+
+#include "sha256.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace UniLang {
+
+/**
+ * @brief bsdiff-style binary deltas between two releases of a file
+ *
+ * Create() matches the new file against a suffix array of the old one,
+ * as bsdiff does, and emits records of three parts: "add" bytes (new
+ * minus old over an approximate match, mostly zeros when code merely
+ * moved), "extra" bytes copied verbatim, and a seek in the old file.
+ * bsdiff leaves the zeros to bzip2; with no compressor in the tree, the
+ * add bytes are stored as zero runs and literals instead, and records are
+ * interleaved so a delta can be applied while it downloads.
+ *
+ * Format (integers little-endian, "varint" is LEB128, seek zigzag):
+ *   "ULDELTA1", old size u64, new size u64, old SHA-256, new SHA-256,
+ *   block size u32, block count u32, SHA-256 of each new-file block,
+ *   then records until the new size is reached:
+ *     varint add, varint extra, varint seek,
+ *     add bytes as (varint zero run, varint literal length, literals)...,
+ *     extra bytes
+ */
+class BinaryDelta {
+public:
+    static constexpr const char* MAGIC = "ULDELTA1";
+    static const size_t MAGIC_SIZE = 8;
+    static const uint32_t BLOCK_SIZE = 64 * 1024;
+    static const size_t HEADER_SIZE = MAGIC_SIZE + 8 + 8 + 32 + 32 + 4 + 4;
+
+    // Limits a header must respect before anything is allocated for it
+    static constexpr uint64_t MAX_NEW_SIZE = uint64_t(1) << 30;
+    static constexpr uint32_t MAX_BLOCKS = 1 << 16;     // Block hashes are kept in memory (32 bytes each)
+
+    struct Header {
+        uint64_t old_size = 0;
+        uint64_t new_size = 0;
+        Sha256::Digest old_sha256 = {};
+        Sha256::Digest new_sha256 = {};
+        uint32_t block_size = BLOCK_SIZE;
+        std::vector<Sha256::Digest> block_sha256;
+    };
+
+    /**
+     * @brief Build a delta that turns old_data into new_data
+     */
+    static std::string Create(std::string_view old_data, std::string_view new_data);
+};
+
+/**
+ * @brief Applies a BinaryDelta as it streams in
+ *
+ * Feed() takes the delta in pieces of any size and writes new-file bytes
+ * to the output as soon as they are known. Each finished block is checked
+ * against its hash, so a bad base or corrupt delta fails within one block
+ * instead of after the whole download; Finish() checks the size and the
+ * whole-file hash.
+ */
+class DeltaApplier {
+public:
+    using Output = std::function<bool(std::string_view data)>;
+
+    /**
+     * @param old_data Base file (must outlive the applier)
+     * @param output Receives the new file in order; return false to abort
+     * @param max_new_size Largest new file to accept (e.g., the release asset's size)
+     */
+    DeltaApplier(std::string_view old_data, Output output, uint64_t max_new_size = BinaryDelta::MAX_NEW_SIZE);
+
+    /**
+     * @brief Consume more of the delta
+     * @return false on a malformed delta, wrong base, hash mismatch or output failure
+     */
+    bool Feed(std::string_view data);
+
+    /**
+     * @brief Check that the delta ended exactly at the end of a verified new file
+     */
+    bool Finish();
+
+    /**
+     * @brief Header, once Feed() has seen it
+     */
+    bool HasHeader() const { return m_state != State::Header && m_state != State::BlockHashes; }
+    const BinaryDelta::Header& GetHeader() const { return m_header; }
+
+    uint64_t GetOutputSize() const { return m_written; }
+    const std::string& GetLastError() const { return m_last_error; }
+
+private:
+    enum class State : uint8_t {
+        Header,
+        BlockHashes,
+        Control,        // Next record's add/extra/seek
+        Add,            // Zero run + literal pairs
+        AddLiteral,
+        Extra,
+        Done,
+    };
+
+    bool Parse();
+    bool ParseControl(bool& need_more);
+
+    /**
+     * @brief Write new-file bytes, verifying each block as it completes
+     */
+    bool Emit(const char* data, size_t size);
+
+    bool Fail(const std::string& error);
+
+private:
+    std::string_view m_old;
+    Output m_output;
+    uint64_t m_max_new_size;
+    BinaryDelta::Header m_header;
+    State m_state = State::Header;
+
+    std::string m_pending;      // Received delta bytes not yet parsed
+    size_t m_pos = 0;           // Parse position in m_pending
+
+    int64_t m_old_pos = 0;      // Read position in the old file
+    int64_t m_seek = 0;         // Of the current record, applied after its add bytes
+    uint64_t m_add_left = 0;
+    uint64_t m_extra_left = 0;
+    uint64_t m_literal_left = 0;
+
+    uint64_t m_written = 0;
+    Sha256 m_file_hash;
+    Sha256 m_block_hash;
+    uint64_t m_block_fill = 0;  // Bytes hashed into the current block
+    size_t m_block_index = 0;
+    std::string m_literal;      // Scratch for old + diff bytes
+
+    std::string m_last_error;
+};
+
+} // namespace UniLang
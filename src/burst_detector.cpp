@@ -0,0 +1,47 @@
+#include "burst_detector.h"
+
+namespace UniLang {
+
+BurstDetector::Class BurstDetector::OnKeyDown(const KeyEvent& event) {
+    const bool repeat = event.vk < 256 && m_keys_down[event.vk];
+    if (event.vk < 256) {
+        m_keys_down[event.vk] = true;
+    }
+
+    // Only character keys take part in rate classification; modifier chords
+    // (Shift+A pressed together) must not look like a burst
+    if (event.ch == 0) {
+        return Class::Normal;
+    }
+
+    // Unsigned subtraction handles the 49.7-day wrap of the millisecond tick
+    const uint32_t gap = m_has_last ? event.time_ms - m_last_time_ms : UINT32_MAX;
+    m_last_time_ms = event.time_ms;
+    m_has_last = true;
+
+    if (m_in_burst) {
+        if (gap <= m_config.quiet_ms) {
+            return Class::Burst;
+        }
+        m_in_burst = false;
+    }
+
+    m_run = gap <= m_config.max_gap_ms ? m_run + 1 : 1;
+
+    const uint32_t needed = event.is_injected ? 2 : m_config.min_run;
+    if (m_run >= needed) {
+        m_in_burst = true;
+        ++m_burst_count;
+        return Class::Burst;
+    }
+
+    return repeat ? Class::Repeat : Class::Normal;
+}
+
+void BurstDetector::OnKeyUp(uint32_t vk) {
+    if (vk < 256) {
+        m_keys_down[vk] = false;
+    }
+}
+
+} // namespace UniLang
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "key_event.h"
+#include <bitset>
+#include <cstdint>
+
+namespace UniLang {
+
+/**
+ * @brief Classifies key events as human typing or machine-generated input
+ *
+ * Pasted text typed by other tools, barcode scanners, macro keyboards and
+ * autorepeat all arrive far faster than a person types. Such events are
+ * reported as Burst/Repeat so InputEngine can pass them straight through
+ * without running the matcher, then resync once the burst is over.
+ *
+ * - Burst: a run of character key-downs closer together than max_gap_ms
+ *   (min_run events for physical keys, 2 for injected ones). The burst
+ *   lasts until no event arrives for quiet_ms.
+ * - Repeat: a key-down for a character key that is already held down.
+ */
+class BurstDetector {
+public:
+    struct Config {
+        uint32_t max_gap_ms = 8;    // Max spacing between events of a run
+        uint32_t min_run = 3;       // Physical key-downs needed to start a burst
+        uint32_t quiet_ms = 60;     // Gap that ends a burst
+    };
+
+    enum class Class : uint8_t {
+        Normal,     // Human typing: run the matcher
+        Burst,      // Machine-generated: pass through
+        Repeat      // Autorepeat of a held key: pass through
+    };
+
+    BurstDetector() = default;
+    explicit BurstDetector(const Config& config) : m_config(config) {}
+
+    /**
+     * @brief Classify a key-down event
+     * @param event Key event (uses vk, ch, is_injected, time_ms)
+     */
+    Class OnKeyDown(const KeyEvent& event);
+
+    /**
+     * @brief Track key release (needed for autorepeat detection)
+     */
+    void OnKeyUp(uint32_t vk);
+
+    /**
+     * @brief Check if currently inside a burst
+     */
+    bool InBurst() const { return m_in_burst; }
+
+    /**
+     * @brief Number of bursts detected so far
+     */
+    uint64_t GetBurstCount() const { return m_burst_count; }
+
+private:
+    Config m_config;
+    std::bitset<256> m_keys_down;
+    uint32_t m_last_time_ms = 0;
+    uint32_t m_run = 0;
+    bool m_has_last = false;
+    bool m_in_burst = false;
+    uint64_t m_burst_count = 0;
+};
+
+} // namespace UniLang
@@ -0,0 +1,73 @@
+#include "context_table.h"
+
+namespace UniLang {
+
+ContextTable::ContextTable() {
+    Clear();
+}
+
+void ContextTable::Clear() {
+    for (auto& slot : m_slots) {
+        slot.matcher.Reset();
+    }
+    m_ids.fill(0);
+
+    // Slot 0 starts out as the anonymous context 0
+    m_size = 1;
+    m_head = 0;
+    m_tail = 0;
+}
+
+PatternMatcher& ContextTable::Activate(ContextId id) {
+    // Fast path: still typing in the same context
+    if (m_ids[m_head] == id) {
+        return m_slots[m_head].matcher;
+    }
+
+    for (size_t i = 0; i < m_size; ++i) {
+        if (m_ids[i] == id) {
+            MoveToFront(static_cast<uint8_t>(i));
+            return m_slots[i].matcher;
+        }
+    }
+
+    // New context: take a free slot, or recycle the least recently used one
+    uint8_t index;
+    if (m_size < MAX_CONTEXTS) {
+        index = static_cast<uint8_t>(m_size++);
+        m_slots[index].prev = index;
+        m_slots[index].next = m_head;
+        m_slots[m_head].prev = index;
+        m_head = index;
+    } else {
+        index = m_tail;
+        MoveToFront(index);
+    }
+
+    m_ids[index] = id;
+    m_slots[index].matcher.Reset();
+    return m_slots[index].matcher;
+}
+
+void ContextTable::MoveToFront(uint8_t index) {
+    if (index == m_head) {
+        return;
+    }
+
+    // Unlink
+    Slot& slot = m_slots[index];
+    m_slots[slot.prev].next = slot.next;
+    if (index == m_tail) {
+        m_tail = slot.prev;
+    } else {
+        m_slots[slot.next].prev = slot.prev;
+    }
+
+    // Link at head
+    slot.prev = index;
+    slot.next = m_head;
+    m_slots[m_head].prev = index;
+    m_head = index;
+}
+
+} // namespace UniLang
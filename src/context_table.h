@@ -0,0 +1,76 @@
+#pragma once
+
+#include "pattern_matcher.h"
+#include <array>
+#include <cstdint>
+
+namespace UniLang {
+
+/**
+ * @brief Per-input-context matcher states with LRU eviction
+ *
+ * Each focus context (window or focused control) gets its own
+ * PatternMatcher, so switching windows mid-shortcut no longer mixes buffers
+ * across applications. States live in a fixed arena of MAX_CONTEXTS slots;
+ * when the arena is full the least recently used context is recycled.
+ *
+ * Activating the current context is a single compare; activating another
+ * one scans MAX_CONTEXTS ids and relinks the LRU list - bounded, constant
+ * work with no allocation.
+ */
+class ContextTable {
+public:
+    using ContextId = uint64_t;
+    static const size_t MAX_CONTEXTS = 16;
+
+    ContextTable();
+
+    /**
+     * @brief Switch to a context, creating (or recycling) its state if needed
+     * @param id Focus context identifier (e.g., HWND of the focused control)
+     * @return Matcher state for this context
+     */
+    PatternMatcher& Activate(ContextId id);
+
+    /**
+     * @brief Matcher of the most recently activated context
+     */
+    PatternMatcher& Current() { return m_slots[m_head].matcher; }
+    const PatternMatcher& Current() const { return m_slots[m_head].matcher; }
+
+    /**
+     * @brief Identifier of the most recently activated context
+     */
+    ContextId GetCurrentId() const { return m_ids[m_head]; }
+
+    /**
+     * @brief Number of contexts currently holding state
+     */
+    size_t GetSize() const { return m_size; }
+
+    /**
+     * @brief Drop all context states
+     */
+    void Clear();
+
+private:
+    struct Slot {
+        PatternMatcher matcher;
+        uint8_t prev = 0;   // Towards most recently used
+        uint8_t next = 0;   // Towards least recently used
+    };
+
+    /**
+     * @brief Move a slot to the front of the LRU list
+     */
+    void MoveToFront(uint8_t index);
+
+private:
+    std::array<ContextId, MAX_CONTEXTS> m_ids{};  // Kept apart from slots for a tight scan
+    std::array<Slot, MAX_CONTEXTS> m_slots;
+    size_t m_size = 0;
+    uint8_t m_head = 0;     // Most recently used
+    uint8_t m_tail = 0;     // Least recently used
+};
+
+} // namespace UniLang
@@ -0,0 +1,435 @@
+#include "downloader.h"
+#include "binary_delta.h"
+#include "sha256.h"
+#include "trace.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace UniLang {
+
+namespace {
+
+const size_t READ_BACK_SIZE = 64 * 1024;
+
+/**
+ * @brief Parse "bytes start-end/total" (total may be "*")
+ */
+bool ParseContentRange(std::string_view value, uint64_t& start, uint64_t& total) {
+    if (value.compare(0, 6, "bytes ") != 0) {
+        return false;
+    }
+    const std::string range(value.substr(6));
+    char* end = nullptr;
+    start = std::strtoull(range.c_str(), &end, 10);
+    if (end == range.c_str() || *end != '-') {
+        return false;
+    }
+    const size_t slash = range.find('/');
+    total = slash == std::string::npos ? 0 : std::strtoull(range.c_str() + slash + 1, nullptr, 10);
+    return true;
+}
+
+/**
+ * @brief What a partial file is the start of (stored next to it as partial + ".meta")
+ */
+struct PartialInfo {
+    std::string url;
+    std::string sha256;
+    std::string etag;       // Strong ETag of the response the bytes came from
+};
+
+bool ReadPartialInfo(const std::string& path, PartialInfo& info) {
+    try {
+        std::ifstream file(path);
+        if (!file.is_open()) {
+            return false;
+        }
+        json j;
+        file >> j;
+        info.url = j.value("url", "");
+        info.sha256 = j.value("sha256", "");
+        info.etag = j.value("etag", "");
+        return true;
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+void WritePartialInfo(const std::string& path, const PartialInfo& info) {
+    json j;
+    j["url"] = info.url;
+    j["sha256"] = info.sha256;
+    j["etag"] = info.etag;
+    std::ofstream(path, std::ios::trunc) << j.dump();
+}
+
+char ToLower(char ch) {
+    return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+} // namespace
+
+Downloader::Downloader(Options options)
+    : m_options(std::move(options)) {
+}
+
+bool Downloader::DigestMatches(const std::string& actual, const std::string& expected) {
+    std::string_view want(expected);
+    if (want.compare(0, 7, "sha256:") == 0) {
+        want.remove_prefix(7);
+    }
+    return actual.size() == want.size() &&
+           std::equal(actual.begin(), actual.end(), want.begin(), [](char a, char b) { return ToLower(a) == ToLower(b); });
+}
+
+bool Downloader::Download(const std::vector<File>& files) {
+    m_last_error.clear();
+    m_outcomes.assign(files.size(), Outcome());
+    {
+        std::lock_guard<std::mutex> lock(m_progress_mutex);
+        m_received.assign(files.size(), 0);
+        m_totals.clear();
+        for (const File& file : files) {
+            m_totals.push_back(file.size);
+        }
+        m_last_percentage = -1;
+    }
+    if (files.empty()) {
+        return true;
+    }
+
+    // The first file on this thread, the rest alongside it
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < files.size(); ++i) {
+        threads.emplace_back(&Downloader::DownloadOne, this, i, std::cref(files[i]));
+    }
+    DownloadOne(0, files[0]);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!m_outcomes[i].ok && files[i].required) {
+            m_last_error = m_outcomes[i].error;
+            return false;
+        }
+    }
+    return true;
+}
+
+void Downloader::DownloadOne(size_t index, const File& file) {
+    UNILANG_TRACE_SCOPE("update", "Downloader::DownloadOne");
+    Outcome& outcome = m_outcomes[index];
+    const std::string partial = file.path + ".download";
+    const std::string partial_info_path = partial + ".meta";
+    std::unique_ptr<HttpClient> http = m_options.create_client ? m_options.create_client() : HttpClient::Create();
+
+    // Resume what an earlier run left behind, but only a prefix of this very file: the
+    // staged name is reused across releases, so anything else there is stale bytes.
+    // The recorded ETag goes out as If-Range, so a changed file comes back whole.
+    Sha256 hasher;
+    uint64_t offset = 0;
+    std::string etag;               // Pins resumed ranges to the same file
+    PartialInfo partial_info;
+    if (!ReadPartialInfo(partial_info_path, partial_info) || partial_info.url != file.url ||
+        partial_info.sha256 != file.sha256 || partial_info.etag.empty()) {
+        std::error_code ec;
+        fs::remove(partial, ec);
+        fs::remove(partial_info_path, ec);
+        partial_info = PartialInfo();
+    } else {
+        etag = partial_info.etag;
+        std::ifstream existing(partial, std::ios::binary);
+        std::vector<char> buffer(READ_BACK_SIZE);
+        while (existing.read(buffer.data(), buffer.size()) || existing.gcount() > 0) {
+            hasher.Update(buffer.data(), static_cast<size_t>(existing.gcount()));
+            offset += static_cast<uint64_t>(existing.gcount());
+        }
+    }
+
+    // A delta only starts from scratch; a partial full download is resumed instead.
+    // What the delta leaves in the partial file is never resumed.
+    if (!file.delta_url.empty() && offset == 0) {
+        std::error_code ec;
+        fs::remove(partial_info_path, ec);
+        partial_info = PartialInfo();
+        if (DownloadDelta(index, file, partial, *http, outcome)) {
+            return;
+        }
+    }
+
+    uint64_t total = 0;             // Full size once known
+    uint32_t delay_ms = m_options.retry_delay_ms;
+
+    for (outcome.attempts = 1;; ++outcome.attempts) {
+        if (Cancelled()) {
+            outcome.error = "Download cancelled: " + file.url;
+            return;
+        }
+
+        std::ofstream out(partial, std::ios::binary | std::ios::app);
+        if (!out) {
+            outcome.error = "Failed to write " + partial;
+            return;
+        }
+
+        HttpClient::Request request;
+        request.url = file.url;
+        request.headers.emplace_back("Accept", "application/octet-stream");
+        request.timeout_ms = m_options.timeout_ms;
+        request.cancel = m_options.cancel;
+        if (offset > 0) {
+            request.headers.emplace_back("Range", "bytes=" + std::to_string(offset) + "-");
+            if (!etag.empty()) {
+                request.headers.emplace_back("If-Range", etag);
+            }
+        }
+
+        bool started = false;
+        bool restart = false;       // Partial file is unusable, start over
+        bool fatal = false;
+        std::string sink_error;
+
+        auto begin = [&](const HttpClient::Response& head) {
+            started = true;
+            if (head.status == 206) {
+                uint64_t start = 0;
+                if (!ParseContentRange(head.GetHeader("content-range"), start, total) || start != offset) {
+                    sink_error = "Server resumed at the wrong offset: " + file.url;
+                    restart = true;
+                    return false;
+                }
+                outcome.resumed_bytes += offset;
+            } else {
+                // A full body replaces whatever we had
+                if (offset > 0) {
+                    out.close();
+                    out.open(partial, std::ios::binary | std::ios::trunc);
+                    hasher.Reset();
+                    offset = 0;
+                }
+                const std::string length(head.GetHeader("content-length"));
+                total = length.empty() ? 0 : std::strtoull(length.c_str(), nullptr, 10);
+            }
+            const std::string_view tag = head.GetHeader("etag");
+            etag = tag.compare(0, 2, "W/") != 0 ? std::string(tag) : std::string();
+
+            // Recorded before any of these bytes are written; without a strong
+            // ETag a later run can't tell the file changed, so it starts over
+            if (etag.empty()) {
+                std::error_code ec;
+                fs::remove(partial_info_path, ec);
+            } else if (etag != partial_info.etag) {
+                partial_info = PartialInfo{file.url, file.sha256, etag};
+                WritePartialInfo(partial_info_path, partial_info);
+            }
+            return true;
+        };
+
+        request.on_body = [&](const HttpClient::Response& head, std::string_view data) {
+            if (!started && !begin(head)) {
+                return false;
+            }
+            if (!out.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+                sink_error = "Failed to write " + partial;
+                fatal = true;
+                return false;
+            }
+            hasher.Update(data);
+            offset += data.size();
+            ReportProgress(index, offset, total);
+            return true;
+        };
+
+        HttpClient::Response response;
+        const bool exchanged = http->Get(request, response);
+        out.close();
+
+        bool complete = false;
+        if (!sink_error.empty()) {
+            outcome.error = sink_error;
+        } else if (!exchanged) {
+            outcome.error = "Failed to download file: " + http->GetLastError();
+        } else if (response.status == 416 && offset > 0) {
+            outcome.error = "Server rejected the resume range: " + file.url;
+            restart = true;
+        } else if (response.status != 200 && response.status != 206) {
+            outcome.error = "HTTP " + std::to_string(response.status) + " from " + file.url;
+            // Only server errors and throttling are worth another try
+            fatal = response.status < 500 && response.status != 408 && response.status != 429;
+        } else if (!started && !begin(response)) {
+            // Empty body; begin() only fails on a bad 206
+            outcome.error = sink_error;
+        } else if (total > 0 && offset < total) {
+            outcome.error = "Connection closed after " + std::to_string(offset) + " of " +
+                            std::to_string(total) + " bytes: " + file.url;
+        } else if (!file.sha256.empty() && !DigestMatches(Sha256::ToHex(hasher.Final()), file.sha256)) {
+            outcome.error = "SHA-256 mismatch for " + file.url;
+            restart = true;
+        } else {
+            complete = true;
+        }
+
+        if (complete) {
+            std::error_code ec;
+            fs::rename(partial, file.path, ec);
+            if (ec) {
+                outcome.error = "Failed to replace " + file.path;
+                return;
+            }
+            fs::remove(partial_info_path, ec);
+            outcome.ok = true;
+            outcome.size = offset;
+            outcome.error.clear();
+            ReportProgress(index, offset, offset);
+            return;
+        }
+
+        if (restart) {
+            std::error_code ec;
+            fs::remove(partial, ec);
+            fs::remove(partial_info_path, ec);
+            hasher.Reset();
+            offset = 0;
+            total = 0;
+            etag.clear();
+            partial_info.etag.clear();
+        }
+        if (fatal || outcome.attempts >= m_options.max_attempts || Cancelled()) {
+            return;
+        }
+        Wait(delay_ms);
+        delay_ms *= 2;
+    }
+}
+
+bool Downloader::DownloadDelta(size_t index, const File& file, const std::string& partial, HttpClient& http,
+                               Outcome& outcome) {
+    UNILANG_TRACE_SCOPE("update", "Downloader::DownloadDelta");
+    std::string base;
+    {
+        std::ifstream input(file.delta_base, std::ios::binary);
+        if (!input) {
+            outcome.delta_error = "Cannot read delta base " + file.delta_base;
+            return false;
+        }
+        base.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+
+    std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        outcome.delta_error = "Failed to write " + partial;
+        return false;
+    }
+
+    // The applier verifies blocks against the delta; the digest check covers the delta's author too
+    Sha256 hasher;
+    uint64_t produced = 0;
+    DeltaApplier applier(base, [&](std::string_view data) {
+        if (!out.write(data.data(), static_cast<std::streamsize>(data.size()))) {
+            return false;
+        }
+        hasher.Update(data);
+        produced += data.size();
+        ReportProgress(index, produced, applier.GetHeader().new_size);
+        return true;
+    }, file.size > 0 ? file.size : BinaryDelta::MAX_NEW_SIZE);
+
+    HttpClient::Request request;
+    request.url = file.delta_url;
+    request.headers.emplace_back("Accept", "application/octet-stream");
+    request.timeout_ms = m_options.timeout_ms;
+    request.cancel = m_options.cancel;
+    request.on_body = [&applier](const HttpClient::Response&, std::string_view data) { return applier.Feed(data); };
+
+    HttpClient::Response response;
+    const bool exchanged = http.Get(request, response);
+    const bool applied = exchanged && response.status == 200 && applier.Finish();
+    out.close();
+
+    if (!applied) {
+        if (!applier.GetLastError().empty()) {
+            outcome.delta_error = "Delta rejected: " + applier.GetLastError();
+        } else if (!exchanged) {
+            outcome.delta_error = "Failed to download delta: " + http.GetLastError();
+        } else {
+            outcome.delta_error = "HTTP " + std::to_string(response.status) + " from " + file.delta_url;
+        }
+    } else if (!out) {
+        outcome.delta_error = "Failed to write " + partial;
+    } else if (!file.sha256.empty() && !DigestMatches(Sha256::ToHex(hasher.Final()), file.sha256)) {
+        outcome.delta_error = "SHA-256 mismatch for the file built from " + file.delta_url;
+    } else {
+        std::error_code ec;
+        fs::rename(partial, file.path, ec);
+        if (!ec) {
+            outcome.ok = true;
+            outcome.patched = true;
+            outcome.size = produced;
+            outcome.attempts = 1;
+            ReportProgress(index, produced, produced);
+            return true;
+        }
+        outcome.delta_error = "Failed to replace " + file.path;
+    }
+
+    std::error_code ec;
+    fs::remove(partial, ec);
+    return false;
+}
+
+void Downloader::ReportProgress(size_t index, uint64_t received, uint64_t total) {
+    if (!m_options.progress) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_progress_mutex);
+    m_received[index] = received;
+    if (total > 0) {
+        m_totals[index] = total;
+    }
+
+    // Files of unknown size count once they're done
+    uint64_t done = 0;
+    uint64_t expected = 0;
+    for (size_t i = 0; i < m_totals.size(); ++i) {
+        if (m_totals[i] > 0) {
+            done += std::min(m_received[i], m_totals[i]);
+            expected += m_totals[i];
+        }
+    }
+    // A size arriving late, a restart or a delta falling back to the full
+    // file can lower the raw ratio; the bar holds still until it catches up
+    const int percentage = std::max(expected == 0 ? 0 : static_cast<int>(done * 100 / expected), m_last_percentage);
+    if (percentage == m_last_percentage) {
+        return;
+    }
+    m_last_percentage = percentage;
+
+    const std::string status = m_received.size() == 1
+        ? "Downloading..."
+        : "Downloading " + std::to_string(m_received.size()) + " files...";
+    m_options.progress(percentage, status);
+}
+
+bool Downloader::Cancelled() const {
+    return m_options.cancel != nullptr && m_options.cancel->load(std::memory_order_relaxed);
+}
+
+void Downloader::Wait(uint32_t delay_ms) const {
+    const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(delay_ms);
+    while (!Cancelled() && std::chrono::steady_clock::now() < until) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(HttpClient::CANCEL_POLL_MS));
+    }
+}
+
+} // namespace UniLang
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "http_client.h"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace UniLang {
+
+/**
+ * @brief Streams update assets to disk with resume and SHA-256 verification
+ *
+ * Each file is written to path + ".download" and hashed as the bytes
+ * arrive. A dropped connection or short body is retried with a Range
+ * request from where the partial file ends (If-Range pins it to the same
+ * ETag), so only the missing tail is fetched again. Partial files left by
+ * an earlier run are resumed too, if path + ".download.meta" says they
+ * came from the same URL, for the same digest, with a strong ETag (sent
+ * as If-Range right away); any other partial file is deleted. Only then
+ * are existing bytes read back to seed the hash. A verified file is
+ * renamed over path; a hash mismatch deletes the partial file so the next
+ * attempt starts clean.
+ *
+ * A file may offer a binary delta (BinaryDelta) against a local base,
+ * usually the running executable. The delta is applied while it streams
+ * in, checked block by block, and the full file is downloaded instead if
+ * anything about it fails.
+ *
+ * Files are fetched concurrently, one thread and HttpClient each, and
+ * progress is reported as one percentage over all of them. Files with a
+ * File::size are weighted from the start, the others once their size
+ * arrives; the percentage never goes down.
+ */
+class Downloader {
+public:
+    using ProgressCallback = std::function<void(int percentage, const std::string& status)>;
+    using ClientFactory = std::function<std::unique_ptr<HttpClient>()>;
+
+    struct File {
+        std::string url;
+        std::string path;
+        std::string sha256;         // Expected digest (hex), empty skips the check
+        bool required = true;       // A failed optional file doesn't fail Download()
+        std::string delta_url;      // Binary delta to try before url (optional)
+        std::string delta_base;     // File the delta applies to
+        uint64_t size = 0;          // Expected size if known up front (release assets); weights progress
+    };
+
+    struct Options {
+        uint32_t timeout_ms = 5 * 60 * 1000;        // Per attempt
+        uint32_t max_attempts = 5;
+        uint32_t retry_delay_ms = 1000;             // Doubles after each failed attempt
+        const std::atomic<bool>* cancel = nullptr;  // Set by another thread to abort
+        ProgressCallback progress;                  // Called from download threads, serialized
+        ClientFactory create_client;                // Empty uses HttpClient::Create
+    };
+
+    struct Outcome {
+        bool ok = false;
+        std::string error;
+        uint64_t size = 0;              // Bytes in the finished file
+        uint64_t resumed_bytes = 0;     // Bytes kept from partial files instead of fetched again
+        uint32_t attempts = 0;
+        bool patched = false;           // Built from the delta
+        std::string delta_error;        // Why an offered delta was not used
+    };
+
+    explicit Downloader(Options options);
+
+    /**
+     * @brief Fetch all files concurrently
+     * @return false if a required file failed (see GetLastError, GetOutcomes)
+     */
+    bool Download(const std::vector<File>& files);
+
+    /**
+     * @brief Per-file results of the last Download, in order
+     */
+    const std::vector<Outcome>& GetOutcomes() const { return m_outcomes; }
+
+    const std::string& GetLastError() const { return m_last_error; }
+
+    /**
+     * @brief Compare digests ignoring case (and a "sha256:" prefix on expected)
+     */
+    static bool DigestMatches(const std::string& actual, const std::string& expected);
+
+private:
+    void DownloadOne(size_t index, const File& file);
+
+    /**
+     * @brief Build the file from its delta into the partial file and move it into place
+     * @return false if the full file must be downloaded (reason in outcome.delta_error)
+     */
+    bool DownloadDelta(size_t index, const File& file, const std::string& partial, HttpClient& http, Outcome& outcome);
+
+    /**
+     * @brief Record bytes for one file and report the combined percentage
+     */
+    void ReportProgress(size_t index, uint64_t received, uint64_t total);
+
+    bool Cancelled() const;
+
+    /**
+     * @brief Sleep for a retry delay, waking early on cancel
+     */
+    void Wait(uint32_t delay_ms) const;
+
+private:
+    Options m_options;
+    std::vector<Outcome> m_outcomes;
+    std::string m_last_error;
+
+    std::mutex m_progress_mutex;
+    std::vector<uint64_t> m_received;   // Guarded by m_progress_mutex
+    std::vector<uint64_t> m_totals;     // Guarded by m_progress_mutex (0 = unknown)
+    int m_last_percentage = -1;         // Guarded by m_progress_mutex
+};
+
+} // namespace UniLang
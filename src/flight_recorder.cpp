@@ -0,0 +1,157 @@
+#include "flight_recorder.h"
+#include "metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace UniLang {
+
+namespace {
+
+void PutU32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out += static_cast<char>(value >> (8 * i));
+    }
+}
+
+void PutU64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out += static_cast<char>(value >> (8 * i));
+    }
+}
+
+uint32_t GetU32(const char* p) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; --i) {
+        value = value << 8 | static_cast<uint8_t>(p[i]);
+    }
+    return value;
+}
+
+uint64_t GetU64(const char* p) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = value << 8 | static_cast<uint8_t>(p[i]);
+    }
+    return value;
+}
+
+} // namespace
+
+std::vector<FlightRecorder::Record> FlightRecorder::Snapshot(uint64_t* total) const {
+    const uint64_t end = m_next.load(std::memory_order_acquire);
+    const uint64_t begin = end > CAPACITY ? end - CAPACITY : 0;
+
+    std::vector<Record> records;
+    records.reserve(static_cast<size_t>(end - begin));
+    for (uint64_t index = begin; index < end; ++index) {
+        const Slot& slot = m_slots[index & (CAPACITY - 1)];
+        records.push_back(Unpack(slot.ticks.load(std::memory_order_relaxed),
+                                 slot.fields.load(std::memory_order_relaxed)));
+    }
+
+    // The writer went on meanwhile: drop the records whose slots it may have reused
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t now = m_next.load(std::memory_order_relaxed);
+    if (now + 1 > begin + CAPACITY) {
+        const uint64_t overwritten = std::min<uint64_t>(now + 1 - (begin + CAPACITY), records.size());
+        records.erase(records.begin(), records.begin() + static_cast<ptrdiff_t>(overwritten));
+    }
+    if (total) {
+        *total = end;
+    }
+    return records;
+}
+
+std::string FlightRecorder::Serialize() const {
+    const uint64_t dump_ticks = TickClock::Now();
+    const uint64_t dump_unix_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    const double ns_per_tick = TickClock::GetNanosecondsPerTick();
+    uint64_t ns_per_tick_bits;
+    std::memcpy(&ns_per_tick_bits, &ns_per_tick, sizeof(ns_per_tick_bits));
+
+    uint64_t total = 0;
+    const std::vector<Record> records = Snapshot(&total);
+
+    std::string out(MAGIC, MAGIC_SIZE);
+    out.reserve(HEADER_SIZE + records.size() * RECORD_SIZE);
+    PutU64(out, total);
+    PutU64(out, ns_per_tick_bits);
+    PutU64(out, dump_ticks);
+    PutU64(out, dump_unix_ms);
+    PutU32(out, static_cast<uint32_t>(records.size()));
+    for (const Record& record : records) {
+        PutU64(out, record.ticks);
+        PutU64(out, Pack(record));
+    }
+    return out;
+}
+
+bool FlightRecorder::Parse(const std::string& data, Dump& dump) {
+    if (data.size() < HEADER_SIZE || data.compare(0, MAGIC_SIZE, MAGIC) != 0) {
+        return false;
+    }
+
+    const char* p = data.data() + MAGIC_SIZE;
+    dump.total = GetU64(p);
+    const uint64_t ns_per_tick_bits = GetU64(p + 8);
+    std::memcpy(&dump.ns_per_tick, &ns_per_tick_bits, sizeof(dump.ns_per_tick));
+    dump.dump_ticks = GetU64(p + 16);
+    dump.dump_unix_ms = GetU64(p + 24);
+    const uint32_t count = GetU32(p + 32);
+    if (data.size() != HEADER_SIZE + static_cast<size_t>(count) * RECORD_SIZE) {
+        return false;
+    }
+
+    dump.records.clear();
+    dump.records.reserve(count);
+    for (p = data.data() + HEADER_SIZE; p != data.data() + data.size(); p += RECORD_SIZE) {
+        dump.records.push_back(Unpack(GetU64(p), GetU64(p + 8)));
+    }
+    return true;
+}
+
+FlightRecorder::Record FlightRecorder::Unpack(uint64_t ticks, uint64_t fields) {
+    Record record;
+    record.ticks = ticks;
+    record.event = static_cast<Event>(fields & 0xF);
+    record.decision = static_cast<Decision>(fields >> 4 & 0xF);
+    record.flags = static_cast<uint8_t>(fields >> 8);
+    record.buffer_length = static_cast<uint8_t>(fields >> 16);
+    record.backspaces = static_cast<uint8_t>(fields >> 24);
+    record.output_length = static_cast<uint16_t>(fields >> 32);
+    record.latency_bucket = static_cast<uint16_t>(fields >> 48);
+    return record;
+}
+
+const char* FlightRecorder::GetEventName(Event event) {
+    switch (event) {
+        case Event::Char: return "char";
+        case Event::Space: return "space";
+        case Event::NonAscii: return "non-ascii";
+        case Event::Control: return "control";
+        case Event::Reset: return "reset";
+        case Event::Backspace: return "backspace";
+        case Event::NoChar: return "no-char";
+        case Event::NoDictionary: return "no-dictionary";
+    }
+    return "?";
+}
+
+const char* FlightRecorder::GetDecisionName(Decision decision) {
+    switch (decision) {
+        case Decision::Pass: return "pass";
+        case Decision::Defer: return "defer";
+        case Decision::Bypass: return "bypass";
+        case Decision::Replace: return "replace";
+        case Decision::Family: return "family";
+        case Decision::Rule: return "rule";
+        case Decision::Correction: return "correction";
+        case Decision::Miss: return "miss";
+        case Decision::Dropped: return "dropped";
+    }
+    return "?";
+}
+
+} // namespace UniLang
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace UniLang {
+
+/**
+ * @brief Ring of the most recent engine decisions, for post-mortem analysis
+ *
+ * InputEngine adds one record per key-down decision: when it happened,
+ * what kind of key it was, the matcher state afterwards, what was decided
+ * and how much output that queued. Records never hold the typed text or
+ * virtual-key codes, only classes and lengths, so a dump can be shared
+ * with a bug report.
+ *
+ * The ring is a fixed array of CAPACITY records written by one thread;
+ * Add() is two relaxed stores and a release store of the write index,
+ * with no allocation or lock. Snapshot() and Serialize() may run on any
+ * thread: records overwritten while they were being copied are left out,
+ * as is the oldest one, whose slot the writer may be reusing right then.
+ *
+ * File format (integers little-endian):
+ *   "ULFLREC1", records ever added u64, nanoseconds per tick (IEEE double
+ *   as u64), ticks at dump u64, Unix time at dump in ms u64, record count
+ *   u32, then the records oldest first, RECORD_SIZE bytes each:
+ *   ticks u64, packed fields u64 (see Pack).
+ */
+class FlightRecorder {
+public:
+    static constexpr const char* MAGIC = "ULFLREC1";
+    static const size_t MAGIC_SIZE = 8;
+    static const size_t HEADER_SIZE = MAGIC_SIZE + 8 + 8 + 8 + 8 + 4;
+    static const size_t RECORD_SIZE = 16;
+    static const size_t CAPACITY = 4096;    // Power of two; 64 KB
+
+    /**
+     * @brief What kind of key the event was
+     */
+    enum class Event : uint8_t {
+        Char,           // Printable ASCII other than space
+        Space,
+        NonAscii,       // Character outside ASCII (never part of a pattern)
+        Control,        // Ctrl+letter and other control characters
+        Reset,          // Enter, Tab or Escape
+        Backspace,
+        NoChar,         // Key without a character (modifiers, arrows, function keys)
+        NoDictionary    // Arrived before a dictionary was set
+    };
+
+    /**
+     * @brief What the engine did with it
+     */
+    enum class Decision : uint8_t {
+        Pass,           // Nothing to do
+        Defer,          // Held back until pending output has been typed
+        Bypass,         // Part of a burst of machine-generated input; matcher reset
+        Replace,        // Dictionary replacement queued
+        Family,         // Symbol family replacement queued
+        Rule,           // Context rule replacement queued
+        Correction,     // Autocorrection queued
+        Miss,           // Pattern completed, but no enabled replacement
+        Dropped         // Output queue full; the key passed through
+    };
+
+    enum Flags : uint8_t {
+        FLAG_BLOCKED = 1 << 0,          // The key was blocked
+        FLAG_OUTPUT_PENDING = 1 << 1,   // Earlier output had not been typed yet
+        FLAG_CONTEXT_SWITCH = 1 << 2,   // First key in a different focus context
+        FLAG_SUPERSCRIPT = 1 << 3,      // Matcher in superscript mode afterwards
+        FLAG_SUBSCRIPT = 1 << 4,        // Matcher in subscript mode afterwards
+        FLAG_LATEX = 1 << 5             // Matcher inside a trigger grammar afterwards
+    };
+
+    struct Record {
+        uint64_t ticks = 0;             // TickClock at the start of the decision
+        Event event = Event::Char;
+        Decision decision = Decision::Pass;
+        uint8_t flags = 0;
+        uint8_t buffer_length = 0;      // Matcher buffer afterwards
+        uint8_t backspaces = 0;         // Of the queued replacement
+        uint16_t output_length = 0;     // UTF-16 units the queued replacement types
+        uint16_t latency_bucket = 0;    // LatencyHistogram bucket of the decision's duration
+    };
+
+    /**
+     * @brief A decoded dump
+     */
+    struct Dump {
+        uint64_t total = 0;             // Records ever added (more than records.size() once the ring wrapped)
+        double ns_per_tick = 1.0;
+        uint64_t dump_ticks = 0;
+        uint64_t dump_unix_ms = 0;
+        std::vector<Record> records;    // Oldest first
+    };
+
+    /**
+     * @brief Add a record (owning thread only)
+     */
+    void Add(const Record& record) {
+        const uint64_t index = m_next.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[index & (CAPACITY - 1)];
+        slot.ticks.store(record.ticks, std::memory_order_relaxed);
+        slot.fields.store(Pack(record), std::memory_order_relaxed);
+        m_next.store(index + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy of the records still in the ring, oldest first (any thread)
+     * @param total Receives the number of records ever added
+     */
+    std::vector<Record> Snapshot(uint64_t* total = nullptr) const;
+
+    /**
+     * @brief Encode the ring in the dump format (any thread)
+     */
+    std::string Serialize() const;
+
+    /**
+     * @brief Decode a dump
+     * @return false if data is not a complete dump
+     */
+    static bool Parse(const std::string& data, Dump& dump);
+
+    static const char* GetEventName(Event event);
+    static const char* GetDecisionName(Decision decision);
+
+    /**
+     * @brief Fields of a record in one word: event (4 bits), decision (4),
+     * flags (8), buffer length (8), backspaces (8), output length (16),
+     * latency bucket (16), from the lowest bit up
+     */
+    static uint64_t Pack(const Record& record) {
+        return static_cast<uint64_t>(record.event) |
+               static_cast<uint64_t>(record.decision) << 4 |
+               static_cast<uint64_t>(record.flags) << 8 |
+               static_cast<uint64_t>(record.buffer_length) << 16 |
+               static_cast<uint64_t>(record.backspaces) << 24 |
+               static_cast<uint64_t>(record.output_length) << 32 |
+               static_cast<uint64_t>(record.latency_bucket) << 48;
+    }
+
+    static Record Unpack(uint64_t ticks, uint64_t fields);
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> ticks{0};
+        std::atomic<uint64_t> fields{0};
+    };
+
+private:
+    Slot m_slots[CAPACITY];
+    std::atomic<uint64_t> m_next{0};    // Index of the next record ever added
+};
+
+} // namespace UniLang
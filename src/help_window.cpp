@@ -1,5 +1,6 @@
 #include "help_window.h"
 #include "shortcuts_dict.h"
+#include "trace.h"
 #include <algorithm>
 #include <sstream>
 
@@ -106,9 +107,7 @@ bool HelpWindow::Create(HINSTANCE hInstance, const ShortcutsDict* shortcuts_dict
     // Enable dark mode colors (Windows 10 dark theme style)
     SetClassLongPtrW(m_hwnd, GCLP_HBRBACKGROUND, (LONG_PTR)CreateSolidBrush(RGB(43, 43, 43)));
 
-    // Populate with all shortcuts initially
-    PopulateListBox();
-
+    // The list is filled when the window is first shown (see Show)
     return true;
 }
 
@@ -330,6 +329,8 @@ void HelpWindow::OnListBoxClick() {
 }
 
 void HelpWindow::PopulateListBox(const std::string& filter) {
+    UNILANG_TRACE_SCOPE("search", "HelpWindow::PopulateListBox");
+    m_list_stale = false;
     // Clear existing items
     SendMessageW(m_listbox, LB_RESETCONTENT, 0, 0);
     m_item_urls.clear();
@@ -370,18 +371,19 @@ void HelpWindow::PopulateListBox(const std::string& filter) {
             }
         }
 
-        // Format display text based on type
+        // Format display text based on type (shortcuts as typed, e.g. ":smile:")
+        const std::string typed = m_shortcuts_dict->GetTypedForm(shortcut);
         std::string display_text;
         std::string url_for_item;
 
         if (IsURL(replacement)) {
             // URL shortcut - format as: "🔗 shortcut  →  URL"
-            display_text = "🔗 " + shortcut + "  →  " + replacement;
+            display_text = "🔗 " + typed + "  →  " + replacement;
             url_for_item = replacement;
         } else {
             // Normal shortcut - format as: "symbol  -  shortcut  (description)"
             // Example: "α  -  \al  (alpha)"
-            display_text = replacement + "  -  " + shortcut;
+            display_text = replacement + "  -  " + typed;
             if (!description.empty()) {
                 display_text += "  (" + description + ")";
             }
@@ -417,8 +419,20 @@ void HelpWindow::OnSearchTextChanged() {
     PopulateListBox(search_text);
 }
 
+void HelpWindow::SetDictionary(const ShortcutsDict* shortcuts_dict) {
+    m_shortcuts_dict = shortcuts_dict;
+    if (IsVisible()) {
+        OnSearchTextChanged();
+    } else {
+        m_list_stale = true;
+    }
+}
+
 void HelpWindow::Show() {
     if (m_hwnd) {
+        if (m_list_stale) {
+            OnSearchTextChanged();
+        }
         ShowWindow(m_hwnd, SW_SHOW);
         SetForegroundWindow(m_hwnd);
         SetFocus(m_search_edit);  // Focus on search box
@@ -23,13 +23,18 @@ public:
     ~HelpWindow();
 
     /**
-     * @brief Create the help window
+     * @brief Create the help window (the list is filled on the first Show)
      * @param hInstance Application instance
      * @param shortcuts_dict Reference to shortcuts dictionary
      * @return true if successful
      */
     bool Create(HINSTANCE hInstance, const ShortcutsDict* shortcuts_dict);
 
+    /**
+     * @brief Show another dictionary (e.g., after an update), keeping the search
+     */
+    void SetDictionary(const ShortcutsDict* shortcuts_dict);
+
     /**
      * @brief Show the help window
      */
@@ -102,6 +107,7 @@ private:
     HWND m_listbox = nullptr;
     HINSTANCE m_hinstance = nullptr;
     const ShortcutsDict* m_shortcuts_dict = nullptr;
+    bool m_list_stale = true;       // List not filled for the current dictionary; Show() fills it
 
     // Map listbox index to URL (for clickable URLs)
     std::vector<std::string> m_item_urls;
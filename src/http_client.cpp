@@ -0,0 +1,86 @@
+#include "http_client.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace UniLang {
+
+namespace {
+
+char ToLower(char ch) {
+    return ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+}
+
+bool EqualsIgnoreCase(std::string_view a, std::string_view b) {
+    return a.size() == b.size() &&
+           std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) { return ToLower(x) == ToLower(y); });
+}
+
+std::string_view Trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+} // namespace
+
+std::string_view HttpClient::Response::GetHeader(std::string_view name) const {
+    for (const Header& header : headers) {
+        if (EqualsIgnoreCase(header.first, name)) {
+            return header.second;
+        }
+    }
+    return std::string_view();
+}
+
+bool HttpClient::ParseUrl(std::string_view url, Url& parts) {
+    parts = Url();
+    if (url.compare(0, 7, "http://") == 0) {
+        url.remove_prefix(7);
+    } else if (url.compare(0, 8, "https://") == 0) {
+        url.remove_prefix(8);
+        parts.https = true;
+        parts.port = 443;
+    } else {
+        return false;
+    }
+
+    const size_t slash = std::min(url.find('/'), url.find('?'));
+    std::string_view authority = url.substr(0, slash);
+    if (slash != std::string_view::npos) {
+        parts.target = url[slash] == '/' ? std::string(url.substr(slash)) : "/" + std::string(url.substr(slash));
+    }
+
+    const size_t colon = authority.rfind(':');
+    if (colon != std::string_view::npos && authority.find(']', colon) == std::string_view::npos) {
+        const std::string port(authority.substr(colon + 1));
+        char* end = nullptr;
+        const unsigned long value = std::strtoul(port.c_str(), &end, 10);
+        if (port.empty() || *end != '\0' || value == 0 || value > 65535) {
+            return false;
+        }
+        parts.port = static_cast<uint16_t>(value);
+        authority = authority.substr(0, colon);
+    }
+    // IPv6 literals keep their brackets out of the host name
+    if (authority.size() >= 2 && authority.front() == '[' && authority.back() == ']') {
+        authority = authority.substr(1, authority.size() - 2);
+    }
+    parts.host = std::string(authority);
+    return !parts.host.empty();
+}
+
+void HttpClient::Response::AddHeaderLine(std::string_view line) {
+    const size_t colon = line.find(':');
+    if (colon == std::string_view::npos || colon == 0) {
+        return;
+    }
+    std::string name(Trim(line.substr(0, colon)));
+    std::transform(name.begin(), name.end(), name.begin(), ToLower);
+    headers.emplace_back(std::move(name), std::string(Trim(line.substr(colon + 1))));
+}
+
+} // namespace UniLang
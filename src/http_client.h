@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace UniLang {
+
+/**
+ * @brief Minimal blocking HTTP GET client behind an interface
+ *
+ * The update flow (UpdateManager, UpdateWorker) only talks to this
+ * interface, so it runs the same against GitHub through WinINet and
+ * against a local stand-in server on any platform.
+ *
+ * Every request has a deadline and can be cancelled from another thread
+ * through Request::cancel; a cancelled or timed-out request returns false
+ * within about CANCEL_POLL_MS, even from the middle of a blocked connect
+ * or read. Name resolution is bounded the same way: a slow lookup is left
+ * to finish in the background (the socket client resolves on a thread of
+ * its own; WinINet's lookup fails once the watchdog closes the session).
+ *
+ * Create() returns the platform client: WinINet on Windows (HTTP and
+ * HTTPS), plain sockets elsewhere (HTTP only, for local servers and
+ * tests).
+ */
+class HttpClient {
+public:
+    using Header = std::pair<std::string, std::string>;
+    struct Response;
+
+    /**
+     * @brief Receives a 2xx body piece by piece instead of Response::body
+     *
+     * Called with the final response's status and headers already filled in;
+     * return false to abort the request.
+     */
+    using BodySink = std::function<bool(const Response& head, std::string_view data)>;
+
+    struct Request {
+        std::string url;
+        std::vector<Header> headers;                 // Extra request headers
+        uint32_t timeout_ms = 15000;                 // Deadline for the whole request
+        const std::atomic<bool>* cancel = nullptr;   // Set by another thread to abort
+        BodySink on_body;                            // Stream 2xx bodies (optional)
+    };
+
+    struct Response {
+        int status = 0;                 // HTTP status code (after redirects)
+        std::vector<Header> headers;    // Names in lowercase
+        std::string body;
+
+        /**
+         * @brief Value of a response header (case-insensitive), empty if absent
+         */
+        std::string_view GetHeader(std::string_view name) const;
+
+        /**
+         * @brief Add a "Name: value" header line (name lowercased, value trimmed)
+         */
+        void AddHeaderLine(std::string_view line);
+    };
+
+    /**
+     * @brief Parts of an http:// or https:// URL
+     */
+    struct Url {
+        bool https = false;
+        std::string host;
+        uint16_t port = 80;
+        std::string target = "/";       // Path and query
+    };
+
+    static constexpr uint32_t CANCEL_POLL_MS = 50;
+    static const int MAX_REDIRECTS = 5;
+    static constexpr const char* USER_AGENT = "UniLang/1.0";
+
+    virtual ~HttpClient() = default;
+
+    /**
+     * @brief Send a GET request and read the whole response
+     *
+     * Redirects are followed. Any status is a successful exchange; the
+     * caller decides what a 404 means. A body that ends early (connection
+     * dropped) is a failure, with the bytes read so far already delivered
+     * to Request::on_body.
+     *
+     * @return false if the request failed, timed out or was cancelled (see GetLastError)
+     */
+    virtual bool Get(const Request& request, Response& response) = 0;
+
+    const std::string& GetLastError() const { return m_last_error; }
+
+    /**
+     * @brief Platform client (WinINet on Windows, sockets elsewhere)
+     */
+    static std::unique_ptr<HttpClient> Create();
+
+    /**
+     * @brief Split a URL into its parts
+     * @return false if it is not an http:// or https:// URL
+     */
+    static bool ParseUrl(std::string_view url, Url& parts);
+
+protected:
+    std::string m_last_error;
+};
+
+} // namespace UniLang
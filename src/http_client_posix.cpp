@@ -0,0 +1,485 @@
+#include "http_client.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace UniLang {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const size_t MAX_HEADER_BYTES = 64 * 1024;
+const size_t READ_SIZE = 64 * 1024;
+
+/**
+ * @brief A getaddrinfo call on a thread of its own, which the requester can walk away from
+ *
+ * getaddrinfo can't be cancelled and follows the resolver's timeouts, not
+ * the request's. The requester waits for it in CANCEL_POLL_MS slices; an
+ * abandoned lookup runs to completion on its detached thread, which then
+ * frees the result.
+ */
+struct Lookup {
+    std::mutex mutex;
+    std::condition_variable done_cv;
+    bool done = false;              // Guarded by mutex
+    bool abandoned = false;         // Guarded by mutex
+    int status = 0;                 // Guarded by mutex
+    addrinfo* addresses = nullptr;  // Guarded by mutex; owned by the requester unless abandoned
+
+    static std::shared_ptr<Lookup> Start(const std::string& host, const std::string& port) {
+        auto lookup = std::make_shared<Lookup>();
+        std::thread([lookup, host, port] {
+            addrinfo hints = {};
+            hints.ai_family = AF_UNSPEC;
+            hints.ai_socktype = SOCK_STREAM;
+            addrinfo* addresses = nullptr;
+            const int status = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+
+            std::lock_guard<std::mutex> lock(lookup->mutex);
+            if (lookup->abandoned) {
+                if (status == 0) {
+                    freeaddrinfo(addresses);
+                }
+            } else {
+                lookup->status = status;
+                lookup->addresses = status == 0 ? addresses : nullptr;
+            }
+            lookup->done = true;
+            lookup->done_cv.notify_all();
+        }).detach();
+        return lookup;
+    }
+};
+
+/**
+ * @brief One HTTP/1.1 exchange over a plain socket, with a deadline and cancellation
+ */
+class Connection {
+public:
+    using Sink = std::function<bool(std::string_view data)>;
+
+    Connection(Clock::time_point deadline, const std::atomic<bool>* cancel)
+        : m_deadline(deadline), m_cancel(cancel) {}
+
+    ~Connection() {
+        if (m_fd >= 0) {
+            close(m_fd);
+        }
+    }
+
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+    bool Open(const HttpClient::Url& url) {
+        const std::string port = std::to_string(url.port);
+        addrinfo* addresses = Resolve(url.host, port);
+        if (addresses == nullptr) {
+            return false;
+        }
+
+        m_error = "cannot connect to " + url.host + ":" + port;
+        for (addrinfo* address = addresses; address != nullptr; address = address->ai_next) {
+            const int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+            if (fd < 0) {
+                continue;
+            }
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+            m_fd = fd;
+            if (connect(fd, address->ai_addr, address->ai_addrlen) == 0 ||
+                (errno == EINPROGRESS && WaitFor(POLLOUT) && ConnectError() == 0)) {
+                freeaddrinfo(addresses);
+                m_error.clear();
+                return true;
+            }
+            close(fd);
+            m_fd = -1;
+            if (Stopped()) {
+                break;
+            }
+        }
+        freeaddrinfo(addresses);
+        return false;
+    }
+
+    bool Send(std::string_view data) {
+        while (!data.empty()) {
+            const ssize_t sent = send(m_fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (sent > 0) {
+                data.remove_prefix(static_cast<size_t>(sent));
+            } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+                if (!WaitFor(POLLOUT)) {
+                    return false;
+                }
+            } else {
+                m_error = "connection lost while sending";
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Read the status line and headers
+     */
+    bool ReadHead(HttpClient::Response& response) {
+        std::string line;
+        if (!ReadLine(line)) {
+            return false;
+        }
+        // "HTTP/1.1 200 OK"
+        const size_t space = line.find(' ');
+        if (line.compare(0, 5, "HTTP/") != 0 || space == std::string::npos) {
+            m_error = "malformed status line";
+            return false;
+        }
+        response.status = std::atoi(line.c_str() + space + 1);
+        response.headers.clear();
+
+        size_t header_bytes = line.size();
+        for (;;) {
+            if (!ReadLine(line)) {
+                return false;
+            }
+            if (line.empty()) {
+                return true;
+            }
+            header_bytes += line.size();
+            if (header_bytes > MAX_HEADER_BYTES) {
+                m_error = "response headers too large";
+                return false;
+            }
+            response.AddHeaderLine(line);
+        }
+    }
+
+    /**
+     * @brief Read the body as framed by the headers, handing each piece to sink
+     */
+    bool ReadBody(const HttpClient::Response& response, const Sink& sink) {
+        if (response.status == 204 || response.status == 304 || (response.status >= 100 && response.status < 200)) {
+            return true;
+        }
+
+        std::string_view encoding = response.GetHeader("transfer-encoding");
+        if (!encoding.empty() && encoding.find("chunked") != std::string_view::npos) {
+            return ReadChunked(sink);
+        }
+
+        const std::string_view length = response.GetHeader("content-length");
+        if (!length.empty()) {
+            const uint64_t size = std::strtoull(std::string(length).c_str(), nullptr, 10);
+            return ReadExactly(size, sink);
+        }
+
+        // No framing: the body ends when the server closes the connection
+        for (;;) {
+            if (!Take(m_buffer.size(), sink)) {
+                return false;
+            }
+            if (m_eof) {
+                return true;
+            }
+            if (!Fill()) {
+                return false;
+            }
+        }
+    }
+
+    const std::string& GetError() const { return m_error; }
+
+private:
+    bool ReadChunked(const Sink& sink) {
+        std::string line;
+        for (;;) {
+            if (!ReadLine(line)) {
+                return false;
+            }
+            char* end = nullptr;
+            const uint64_t size = std::strtoull(line.c_str(), &end, 16);
+            if (end == line.c_str()) {
+                m_error = "malformed chunk header";
+                return false;
+            }
+            if (size == 0) {
+                break;
+            }
+            if (!ReadExactly(size, sink) || !ReadLine(line)) {
+                return false;
+            }
+        }
+        // Trailers, up to the empty line
+        do {
+            if (!ReadLine(line)) {
+                return false;
+            }
+        } while (!line.empty());
+        return true;
+    }
+
+    bool ReadExactly(uint64_t size, const Sink& sink) {
+        while (size > 0) {
+            if (m_buffer.empty() && !Fill()) {
+                return false;
+            }
+            if (m_buffer.empty()) {
+                m_error = "connection closed before the end of the body";
+                return false;
+            }
+            const size_t take = static_cast<size_t>(std::min<uint64_t>(size, m_buffer.size()));
+            if (!Take(take, sink)) {
+                return false;
+            }
+            size -= take;
+        }
+        return true;
+    }
+
+    bool ReadLine(std::string& line) {
+        size_t end;
+        while ((end = m_buffer.find("\r\n")) == std::string::npos) {
+            if (m_buffer.size() > MAX_HEADER_BYTES) {
+                m_error = "response line too long";
+                return false;
+            }
+            const size_t before = m_buffer.size();
+            if (!Fill()) {
+                return false;
+            }
+            if (m_buffer.size() == before) {
+                m_error = "connection closed unexpectedly";
+                return false;
+            }
+        }
+        line.assign(m_buffer, 0, end);
+        m_buffer.erase(0, end + 2);
+        return true;
+    }
+
+    bool Take(size_t size, const Sink& sink) {
+        if (size == 0) {
+            return true;
+        }
+        const bool keep_going = sink(std::string_view(m_buffer).substr(0, size));
+        m_buffer.erase(0, size);
+        if (!keep_going) {
+            m_error = "aborted by the receiver";
+        }
+        return keep_going;
+    }
+
+    /**
+     * @brief Append whatever the socket has to the buffer (nothing at end of stream)
+     */
+    bool Fill() {
+        if (m_eof) {
+            return true;
+        }
+        char chunk[READ_SIZE];
+        for (;;) {
+            const ssize_t received = recv(m_fd, chunk, sizeof(chunk), 0);
+            if (received > 0) {
+                m_buffer.append(chunk, static_cast<size_t>(received));
+                return true;
+            }
+            if (received == 0) {
+                m_eof = true;
+                return true;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                m_error = "connection lost while receiving";
+                return false;
+            }
+            if (!WaitFor(POLLIN)) {
+                return false;
+            }
+        }
+    }
+
+    /**
+     * @brief Look up a host without outstaying the deadline or a cancel (see Lookup)
+     * @return Addresses to free with freeaddrinfo, nullptr on failure
+     */
+    addrinfo* Resolve(const std::string& host, const std::string& port) {
+        std::shared_ptr<Lookup> lookup = Lookup::Start(host, port);
+        std::unique_lock<std::mutex> lock(lookup->mutex);
+        while (!lookup->done) {
+            if (Stopped()) {
+                lookup->abandoned = true;
+                return nullptr;
+            }
+            lookup->done_cv.wait_until(
+                lock, std::min(m_deadline, Clock::now() + std::chrono::milliseconds(HttpClient::CANCEL_POLL_MS)));
+        }
+        if (lookup->status != 0) {
+            m_error = "cannot resolve " + host;
+        }
+        return lookup->addresses;
+    }
+
+    /**
+     * @brief Wait until the socket is ready, in slices short enough to notice cancellation
+     */
+    bool WaitFor(short events) {
+        for (;;) {
+            if (Stopped()) {
+                return false;
+            }
+            // The deadline can pass after Stopped(); poll must never get a negative (infinite) timeout
+            const long long remaining = RemainingMs();
+            if (remaining <= 0) {
+                m_error = "timed out";
+                return false;
+            }
+            pollfd fd = {m_fd, events, 0};
+            const int ready = poll(&fd, 1, static_cast<int>(std::min<long long>(remaining, HttpClient::CANCEL_POLL_MS)));
+            if (ready > 0) {
+                return true;
+            }
+            if (ready < 0 && errno != EINTR) {
+                m_error = "poll failed";
+                return false;
+            }
+        }
+    }
+
+    bool Stopped() {
+        if (m_cancel != nullptr && m_cancel->load(std::memory_order_relaxed)) {
+            m_error = "cancelled";
+            return true;
+        }
+        if (Clock::now() >= m_deadline) {
+            m_error = "timed out";
+            return true;
+        }
+        return false;
+    }
+
+    long long RemainingMs() const {
+        return std::max<long long>(
+            0, std::chrono::duration_cast<std::chrono::milliseconds>(m_deadline - Clock::now()).count());
+    }
+
+    int ConnectError() const {
+        int error = 0;
+        socklen_t size = sizeof(error);
+        getsockopt(m_fd, SOL_SOCKET, SO_ERROR, &error, &size);
+        return error;
+    }
+
+    int m_fd = -1;
+    Clock::time_point m_deadline;
+    const std::atomic<bool>* m_cancel;
+    std::string m_buffer;       // Received, not yet consumed
+    bool m_eof = false;
+    std::string m_error;
+};
+
+/**
+ * @brief Resolve a Location header against the URL that sent it
+ */
+std::string ResolveLocation(const HttpClient::Url& base, std::string_view location) {
+    if (location.compare(0, 7, "http://") == 0 || location.compare(0, 8, "https://") == 0) {
+        return std::string(location);
+    }
+    std::string url = (base.https ? "https://" : "http://") + base.host + ":" + std::to_string(base.port);
+    if (location.empty() || location.front() != '/') {
+        const size_t slash = base.target.rfind('/');
+        url += base.target.substr(0, slash + 1);
+    }
+    url += location;
+    return url;
+}
+
+class SocketHttpClient : public HttpClient {
+public:
+    bool Get(const Request& request, Response& response) override {
+        m_last_error.clear();
+        const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(request.timeout_ms);
+
+        std::string url = request.url;
+        for (int redirects = 0;; ++redirects) {
+            Url parts;
+            if (!ParseUrl(url, parts)) {
+                m_last_error = "invalid URL: " + url;
+                return false;
+            }
+            if (parts.https) {
+                m_last_error = "HTTPS is not supported by this client: " + url;
+                return false;
+            }
+
+            response = Response();
+            Connection connection(deadline, request.cancel);
+            if (!connection.Open(parts) || !connection.Send(BuildRequest(parts, request)) ||
+                !connection.ReadHead(response)) {
+                m_last_error = connection.GetError() + " (" + url + ")";
+                return false;
+            }
+
+            const bool redirect = response.status == 301 || response.status == 302 || response.status == 303 ||
+                                  response.status == 307 || response.status == 308;
+            const std::string_view location = response.GetHeader("location");
+            const bool final = !redirect || location.empty();
+
+            // Only the final 2xx body goes to the caller's sink
+            Connection::Sink sink = [&response](std::string_view data) {
+                response.body.append(data);
+                return true;
+            };
+            if (final && request.on_body && response.status >= 200 && response.status < 300) {
+                sink = [&request, &response](std::string_view data) { return request.on_body(response, data); };
+            }
+            if (!connection.ReadBody(response, sink)) {
+                m_last_error = connection.GetError() + " (" + url + ")";
+                return false;
+            }
+            if (final) {
+                return true;
+            }
+            if (redirects == MAX_REDIRECTS) {
+                m_last_error = "too many redirects (" + request.url + ")";
+                return false;
+            }
+            url = ResolveLocation(parts, location);
+        }
+    }
+
+private:
+    static std::string BuildRequest(const Url& url, const Request& request) {
+        std::string text = "GET " + url.target + " HTTP/1.1\r\nHost: " + url.host;
+        if (url.port != 80) {
+            text += ":" + std::to_string(url.port);
+        }
+        text += "\r\nUser-Agent: ";
+        text += USER_AGENT;
+        text += "\r\nAccept-Encoding: identity\r\nConnection: close\r\n";
+        for (const Header& header : request.headers) {
+            text += header.first + ": " + header.second + "\r\n";
+        }
+        text += "\r\n";
+        return text;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<HttpClient> HttpClient::Create() {
+    return std::make_unique<SocketHttpClient>();
+}
+
+} // namespace UniLang
@@ -0,0 +1,205 @@
+#include "http_client.h"
+#include <Windows.h>
+#include <wininet.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#pragma comment(lib, "wininet.lib")
+
+namespace UniLang {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief Closes a session once its request is cancelled or past its deadline
+ *
+ * A blocked WinINet call (connect, send, InternetReadFile) only returns when
+ * its own timeout expires, which for a download is the whole request timeout.
+ * Closing the session handle from another thread fails the call in progress
+ * at once and closes the handles opened from it, so the watchdog polls the
+ * cancel flag and the deadline every CANCEL_POLL_MS and closes the session
+ * on either.
+ */
+class Watchdog {
+public:
+    Watchdog(HINTERNET session, const std::atomic<bool>* cancel, Clock::time_point deadline)
+        : m_thread([this, session, cancel, deadline] { Run(session, cancel, deadline); }) {
+    }
+
+    ~Watchdog() {
+        if (m_thread.joinable()) {
+            Stop();
+        }
+    }
+
+    Watchdog(const Watchdog&) = delete;
+    Watchdog& operator=(const Watchdog&) = delete;
+
+    /**
+     * @brief Stop watching
+     * @return Why the watchdog closed the session ("cancelled", "timed out"), nullptr if it did not
+     */
+    const char* Stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopped = true;
+        }
+        m_wake.notify_one();
+        m_thread.join();
+        return m_reason;
+    }
+
+private:
+    void Run(HINTERNET session, const std::atomic<bool>* cancel, Clock::time_point deadline) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (!m_stopped) {
+            if (cancel != nullptr && cancel->load(std::memory_order_relaxed)) {
+                m_reason = "cancelled";
+            } else if (Clock::now() >= deadline) {
+                m_reason = "timed out";
+            }
+            if (m_reason != nullptr) {
+                InternetCloseHandle(session);
+                return;
+            }
+            m_wake.wait_for(lock, std::chrono::milliseconds(HttpClient::CANCEL_POLL_MS));
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopped = false;             // Guarded by m_mutex
+    const char* m_reason = nullptr;     // Set before the session is closed; read after join
+    std::thread m_thread;               // Last: starts once the members above exist
+};
+
+class WinInetHttpClient : public HttpClient {
+public:
+    bool Get(const Request& request, Response& response) override {
+        m_last_error.clear();
+        response = Response();
+        const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(request.timeout_ms);
+
+        HINTERNET session = InternetOpenA(USER_AGENT, INTERNET_OPEN_TYPE_DIRECT, nullptr, nullptr, 0);
+        if (!session) {
+            m_last_error = "Failed to initialize WinINet";
+            return false;
+        }
+
+        // Connect, send and each receive are bounded by the request deadline
+        DWORD timeout = request.timeout_ms;
+        InternetSetOptionA(session, INTERNET_OPTION_CONNECT_TIMEOUT, &timeout, sizeof(timeout));
+        InternetSetOptionA(session, INTERNET_OPTION_SEND_TIMEOUT, &timeout, sizeof(timeout));
+        InternetSetOptionA(session, INTERNET_OPTION_RECEIVE_TIMEOUT, &timeout, sizeof(timeout));
+
+        // The handles are closed only after the watchdog has stopped, by whichever side is left
+        Watchdog watchdog(session, request.cancel, deadline);
+        HINTERNET url = nullptr;
+        const bool ok = Fetch(session, request, deadline, response, url);
+        if (const char* reason = watchdog.Stop()) {
+            m_last_error = reason;
+            return false;
+        }
+        if (url) {
+            InternetCloseHandle(url);
+        }
+        InternetCloseHandle(session);
+        return ok;
+    }
+
+private:
+    bool Fetch(HINTERNET session, const Request& request, Clock::time_point deadline, Response& response,
+               HINTERNET& url) {
+        std::string headers;
+        for (const Header& header : request.headers) {
+            headers += header.first + ": " + header.second + "\r\n";
+        }
+
+        url = InternetOpenUrlA(
+            session,
+            request.url.c_str(),
+            headers.empty() ? nullptr : headers.c_str(),
+            headers.empty() ? 0 : static_cast<DWORD>(-1),
+            INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE,
+            0
+        );
+        if (!url) {
+            m_last_error = "Failed to open URL: " + request.url;
+            return false;
+        }
+        if (Stopped(request, deadline)) {
+            return false;
+        }
+
+        DWORD status = 0;
+        DWORD size = sizeof(status);
+        if (!HttpQueryInfoA(url, HTTP_QUERY_STATUS_CODE | HTTP_QUERY_FLAG_NUMBER, &status, &size, nullptr)) {
+            m_last_error = "No HTTP status from: " + request.url;
+            return false;
+        }
+        response.status = static_cast<int>(status);
+
+        // Raw headers: the status line, then one header per line
+        size = 0;
+        HttpQueryInfoA(url, HTTP_QUERY_RAW_HEADERS_CRLF, nullptr, &size, nullptr);
+        std::string raw(size, '\0');
+        if (size > 0 && HttpQueryInfoA(url, HTTP_QUERY_RAW_HEADERS_CRLF, &raw[0], &size, nullptr)) {
+            raw.resize(size);
+            size_t start = raw.find("\r\n");
+            while (start != std::string::npos && start + 2 < raw.size()) {
+                const size_t end = raw.find("\r\n", start + 2);
+                response.AddHeaderLine(std::string_view(raw).substr(start + 2, end - start - 2));
+                start = end;
+            }
+        }
+
+        // WinINet follows redirects itself, so this is the final response
+        const bool stream = request.on_body && response.status >= 200 && response.status < 300;
+
+        char buffer[16384];
+        DWORD bytes_read = 0;
+        for (;;) {
+            if (!InternetReadFile(url, buffer, sizeof(buffer), &bytes_read)) {
+                m_last_error = "Connection lost while reading: " + request.url;
+                return false;
+            }
+            if (bytes_read == 0) {
+                return true;
+            }
+            if (!stream) {
+                response.body.append(buffer, bytes_read);
+            } else if (!request.on_body(response, std::string_view(buffer, bytes_read))) {
+                m_last_error = "Aborted by the receiver: " + request.url;
+                return false;
+            }
+            if (Stopped(request, deadline)) {
+                return false;
+            }
+        }
+    }
+
+    bool Stopped(const Request& request, Clock::time_point deadline) {
+        if (request.cancel != nullptr && request.cancel->load(std::memory_order_relaxed)) {
+            m_last_error = "cancelled";
+            return true;
+        }
+        if (Clock::now() >= deadline) {
+            m_last_error = "timed out";
+            return true;
+        }
+        return false;
+    }
+};
+
+} // namespace
+
+std::unique_ptr<HttpClient> HttpClient::Create() {
+    return std::make_unique<WinInetHttpClient>();
+}
+
+} // namespace UniLang
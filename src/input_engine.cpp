@@ -0,0 +1,436 @@
+#include "input_engine.h"
+#include "symbol_families.h"
+#include "trace.h"
+#include "unicode_utils.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+
+namespace UniLang {
+
+namespace {
+
+// Virtual-key codes used by the decision logic
+const uint32_t KEY_BACK = 0x08;
+const uint32_t KEY_TAB = 0x09;
+const uint32_t KEY_RETURN = 0x0D;
+const uint32_t KEY_ESCAPE = 0x1B;
+
+/**
+ * @brief Class of a key-down event for the flight recorder (never the key itself)
+ */
+FlightRecorder::Event ClassifyEvent(const KeyEvent& event) {
+    using Event = FlightRecorder::Event;
+    if (event.vk == KEY_RETURN || event.vk == KEY_ESCAPE || event.vk == KEY_TAB) {
+        return Event::Reset;
+    }
+    if (event.vk == KEY_BACK) {
+        return Event::Backspace;
+    }
+    if (event.ch == 0) {
+        return Event::NoChar;
+    }
+    if (event.ch >= 0x80) {
+        return Event::NonAscii;
+    }
+    if (event.ch == ' ') {
+        return Event::Space;
+    }
+    return event.ch < 0x20 || event.ch == 0x7F ? Event::Control : Event::Char;
+}
+
+} // namespace
+
+InputEngine::InputEngine() {
+    // Sized for the longest pattern and correction so that computing an entry never allocates in the hook
+    static_assert(WordAutomaton::MAX_CORRECTION_LENGTH <= PatternMatcher::MAX_BUFFER_SIZE * 4,
+                  "corrections must fit the computed entries");
+    for (ShortcutsDict::Entry& entry : m_computed_entries) {
+        entry.shortcut.reserve(PatternMatcher::MAX_BUFFER_SIZE);
+        entry.replacement.reserve(PatternMatcher::MAX_BUFFER_SIZE * 4);
+        entry.utf16.reserve(PatternMatcher::MAX_BUFFER_SIZE * 4);
+    }
+}
+
+InputEngine::~InputEngine() {
+    Stop();
+}
+
+bool InputEngine::Start(OutputHandler handler) {
+    if (m_worker.joinable()) {
+        return false;
+    }
+
+    m_handler = handler;
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_stop = false;
+    }
+    m_worker = std::thread(&InputEngine::WorkerLoop, this);
+    return true;
+}
+
+void InputEngine::Stop() {
+    if (!m_worker.joinable()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_stop = true;
+    }
+    m_wake_cv.notify_one();
+    m_worker.join();
+}
+
+bool InputEngine::OnKeyEvent(const KeyEvent& event) {
+    m_key_events.Add();
+
+    // Our own SendInput output must never feed back into the matcher
+    if (event.is_own_injection) {
+        m_own_injected.Add();
+        return false;
+    }
+
+    if (!event.is_key_down) {
+        m_burst.OnKeyUp(event.vk);
+        return false; // Don't block key-up events
+    }
+
+    // Only decisions are timed and recorded; the returns above cost next to nothing
+    const uint64_t start = TickClock::Now();
+    m_record = FlightRecorder::Record();
+    m_record.ticks = start;
+    m_record.event = ClassifyEvent(event);
+
+    const bool block = Decide(event);
+
+    const uint64_t end = TickClock::Now();
+    const uint64_t elapsed = end - start;
+    m_hook_latency.Record(elapsed);
+    UNILANG_TRACE_SPAN("engine", "InputEngine::OnKeyEvent", start, end);
+
+    const PatternMatcher& matcher = m_contexts.Current();
+    m_record.buffer_length = static_cast<uint8_t>(matcher.GetBuffer().size());
+    m_record.flags |= (block ? FlightRecorder::FLAG_BLOCKED : 0) |
+                      (matcher.IsInSuperscriptMode() ? FlightRecorder::FLAG_SUPERSCRIPT : 0) |
+                      (matcher.IsInSubscriptMode() ? FlightRecorder::FLAG_SUBSCRIPT : 0) |
+                      (matcher.IsInLatexMode() ? FlightRecorder::FLAG_LATEX : 0);
+    m_record.latency_bucket = static_cast<uint16_t>(LatencyHistogram::BucketIndex(elapsed));
+    m_flight_recorder.Add(m_record);
+    return block;
+}
+
+bool InputEngine::Decide(const KeyEvent& event) {
+    if (m_dict == nullptr) {
+        m_record.event = FlightRecorder::Event::NoDictionary;
+        return false;
+    }
+
+    if (event.context != m_contexts.GetCurrentId()) {
+        m_record.flags |= FlightRecorder::FLAG_CONTEXT_SWITCH;
+    }
+    PatternMatcher& matcher = m_contexts.Activate(event.context);
+
+    // Fast path for pastes, macro tools and autorepeat: no matching at all.
+    // The buffer no longer reflects the text before the cursor, so the
+    // context resumes from a clean state once normal typing returns.
+    const auto input_class = m_burst.OnKeyDown(event);
+    if (input_class != BurstDetector::Class::Normal) {
+        m_bypassed.Add();
+        m_bursts.Set(m_burst.GetBurstCount());
+        m_record.decision = FlightRecorder::Decision::Bypass;
+        matcher.Reset();
+        return false;
+    }
+
+    const bool deferring = HasPendingOutput();
+    if (deferring) {
+        m_record.flags |= FlightRecorder::FLAG_OUTPUT_PENDING;
+    }
+
+    // Handle special keys that should reset the pattern buffer
+    // NOTE: Space is NOT here because it's used as trigger for LaTeX patterns
+    if (event.vk == KEY_RETURN || event.vk == KEY_ESCAPE || event.vk == KEY_TAB) {
+        matcher.Reset();
+        return event.vk != KEY_ESCAPE && deferring && Defer(event);
+    }
+
+    // Handle Backspace - remove last character from buffer
+    if (event.vk == KEY_BACK) {
+        matcher.RemoveLastChar();
+        return deferring && Defer(event);
+    }
+
+    if (event.ch == 0) {
+        return false;
+    }
+
+    // Non-ASCII characters can never be part of a pattern; feed a non-pattern byte
+    const char ch = event.ch < 0x80 ? static_cast<char>(event.ch) : '\x7F';
+
+    // Switched-off categories behave as if their entries weren't in the dictionary
+    const uint64_t categories = m_categories.load(std::memory_order_relaxed);
+
+    // A clock read costs about as much as the matcher step, so only every MATCH_SAMPLE_INTERVAL-th one is timed
+    const bool sampled = (++m_match_samples & (MATCH_SAMPLE_INTERVAL - 1)) == 0;
+    const uint64_t match_start = sampled ? TickClock::Now() : 0;
+    PatternMatcher::MatchView match;
+    const bool completed = matcher.AddChar(ch, match, m_dict->GetGrammars());
+    if (sampled) {
+        m_match_latency.Record(TickClock::Now() - match_start);
+    }
+    if (completed) {
+        const uint64_t lookup_start = TickClock::Now();
+        const uint32_t entry_id = m_dict->FindEntryId(match.Key(), categories);
+        const ShortcutsDict::Entry* entry = nullptr;
+        if (entry_id != ShortcutsDict::INVALID_ENTRY_ID) {
+            entry = &m_dict->GetEntry(entry_id);
+            m_record.decision = FlightRecorder::Decision::Replace;
+        } else if (ShortcutsDict::IsEnabled(categories, m_dict->GetFamilyCategory())) {
+            entry = ExpandFamily(match.Key());
+            m_record.decision = FlightRecorder::Decision::Family;
+        }
+        m_lookup_latency.Record(TickClock::Now() - lookup_start);
+        if (entry) {
+            m_matches.Add();
+            EngineAction action;
+            action.type = EngineAction::Type::Replace;
+            action.entry = entry;
+            // For length == 1 we're in auto-convert mode (superscript/subscript):
+            // only the current character is replaced, and it is blocked.
+            // Otherwise (length - 1) because the trigger key is blocked and was never sent.
+            action.backspaces = match.length == 1 ? 0 : static_cast<uint32_t>(match.length - 1);
+
+            // Don't reset pattern matcher if we're still in mode
+            if (!matcher.IsInSuperscriptMode() && !matcher.IsInSubscriptMode()) {
+                matcher.ResetPattern();
+            }
+
+            // Block the trigger key only if the worker will type the replacement
+            return Post(action);
+        }
+        // Pattern detected but no replacement found - silently ignore
+        m_misses.Add();
+        m_record.decision = FlightRecorder::Decision::Miss;
+    }
+
+    // Context rules: one DFA step per character, however many rules there are
+    const RuleSet& rules = m_dict->GetRules();
+    if (!rules.Empty()) {
+        const uint32_t rule = matcher.StepRules(rules, m_dict->GetGrammars(), ch, categories);
+        if (rule != RuleSet::NO_RULE) {
+            m_matches.Add();
+            m_record.decision = FlightRecorder::Decision::Rule;
+            EngineAction action;
+            action.type = EngineAction::Type::Replace;
+            action.entry = &m_dict->GetEntry(m_dict->GetRuleEntryId(rule));
+
+            if (rules.HasTrigger(rule)) {
+                // The trigger key is blocked and replayed after the replacement
+                action.backspaces = rules.GetMatchLength(rule);
+                return PostWithReplay(action, event);
+            }
+            // The last character of the match is the key being typed (blocked)
+            action.backspaces = rules.GetMatchLength(rule) - 1;
+            return Post(action);
+        }
+    }
+
+    // Autocorrect: one automaton step per letter, fired by the boundary after a typo
+    const WordAutomaton& words = m_dict->GetWords();
+    if (!words.Empty()) {
+        const uint32_t word = matcher.StepWords(words, m_dict->GetGrammars(), ch, match, categories);
+        if (word != WordAutomaton::NO_WORD) {
+            m_matches.Add();
+            m_record.decision = FlightRecorder::Decision::Correction;
+            EngineAction action;
+            action.type = EngineAction::Type::Replace;
+            action.entry = ExpandCorrection(match.Key(), word);
+            // The boundary key is blocked and replayed after the correction
+            action.backspaces = match.length;
+            return PostWithReplay(action, event);
+        }
+    }
+
+    // Control characters (Ctrl+letter) are shortcuts, not text: never hold them back
+    return deferring && ch >= 0x20 && Defer(event);
+}
+
+bool InputEngine::Defer(const KeyEvent& event) {
+    EngineAction action;
+    action.type = event.ch != 0 ? EngineAction::Type::ReplayChar : EngineAction::Type::ReplayKey;
+    action.vk = event.vk;
+    action.ch = event.ch;
+    return Post(action);
+}
+
+bool InputEngine::PostWithReplay(const EngineAction& action, const KeyEvent& event) {
+    // Only this thread pushes, so two free slots now are still free for both pushes
+    if (m_queue.FreeSlots() < 2) {
+        m_dropped.Add();
+        m_record.decision = FlightRecorder::Decision::Dropped;
+        return false;
+    }
+    return Post(action) && Defer(event);
+}
+
+bool InputEngine::Post(const EngineAction& action) {
+    m_pending_outputs.fetch_add(1, std::memory_order_acq_rel);
+    if (!m_queue.TryPush(action)) {
+        m_pending_outputs.fetch_sub(1, std::memory_order_acq_rel);
+        m_dropped.Add();
+        m_record.decision = FlightRecorder::Decision::Dropped;
+        return false;
+    }
+    if (action.type == EngineAction::Type::Replace) {
+        m_record.backspaces = static_cast<uint8_t>(std::min<uint32_t>(action.backspaces, UINT8_MAX));
+        m_record.output_length = static_cast<uint16_t>(std::min<size_t>(action.entry->utf16.size(), UINT16_MAX));
+    } else if (m_record.decision == FlightRecorder::Decision::Pass || m_record.decision == FlightRecorder::Decision::Miss) {
+        m_record.decision = FlightRecorder::Decision::Defer;
+    }
+
+    // Pairs with the fence in WorkerLoop: either the worker sees the new item
+    // before parking, or we see it parked and wake it. The mutex is only
+    // touched when the worker is actually asleep.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_worker_parked.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_wake_cv.notify_one();
+    }
+    return true;
+}
+
+const ShortcutsDict::Entry* InputEngine::ExpandFamily(std::string_view key) {
+    if (!IsSymbolFamilyKey(key)) {
+        return nullptr;
+    }
+
+    ShortcutsDict::Entry& entry = NextComputedEntry(key);
+    ExpandSymbolFamily(key, entry.replacement);
+    EncodeComputedEntry(entry);
+    return &entry;
+}
+
+const ShortcutsDict::Entry* InputEngine::ExpandCorrection(std::string_view word, uint32_t index) {
+    ShortcutsDict::Entry& entry = NextComputedEntry(word);
+    WordAutomaton::AppendInCase(m_dict->GetWords().GetCorrection(index), WordAutomaton::GetCase(word),
+                                entry.replacement);
+    EncodeComputedEntry(entry);
+    return &entry;
+}
+
+ShortcutsDict::Entry& InputEngine::NextComputedEntry(std::string_view key) {
+    ShortcutsDict::Entry& entry = m_computed_entries[m_computed_next];
+    m_computed_next = (m_computed_next + 1) % COMPUTED_SLOTS;
+
+    entry.shortcut.assign(key.data(), key.size());
+    entry.replacement.clear();
+    return entry;
+}
+
+void InputEngine::EncodeComputedEntry(ShortcutsDict::Entry& entry) {
+    entry.utf16.clear();
+    size_t pos = 0;
+    while (pos < entry.replacement.size()) {
+        AppendUtf16(entry.utf16, DecodeUtf8(entry.replacement, pos));
+    }
+    entry.input_events = entry.utf16.size() * 2;
+}
+
+void InputEngine::WorkerLoop() {
+    UNILANG_TRACE_THREAD("InputEngine worker");
+    for (;;) {
+        EngineAction action;
+        while (m_queue.TryPop(action)) {
+            const uint64_t start = TickClock::Now();
+            if (m_handler) {
+                m_handler(action);
+            }
+            const uint64_t end = TickClock::Now();
+            if (action.type == EngineAction::Type::Replace) {
+                m_output_latency.Record(end - start);
+                m_replacements.Add();
+                UNILANG_TRACE_SPAN("engine", "InputEngine output: replace", start, end);
+            } else {
+                m_replays.Add();
+                UNILANG_TRACE_SPAN("engine", "InputEngine output: replay", start, end);
+            }
+            m_pending_outputs.fetch_sub(1, std::memory_order_acq_rel);
+        }
+
+        std::unique_lock<std::mutex> lock(m_wake_mutex);
+        m_worker_parked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_wake_cv.wait(lock, [this]() { return m_stop || !m_queue.Empty(); });
+        m_worker_parked.store(false, std::memory_order_relaxed);
+
+        if (m_stop && m_queue.Empty()) {
+            break;
+        }
+    }
+}
+
+InputEngine::Stats InputEngine::GetStats() const {
+    Stats stats;
+    stats.key_events = m_key_events.Get();
+    stats.replacements = m_replacements.Get();
+    stats.replays = m_replays.Get();
+    stats.own_injected = m_own_injected.Get();
+    stats.dropped = m_dropped.Get();
+    stats.bursts = m_bursts.Get();
+    stats.bypassed = m_bypassed.Get();
+    stats.matches = m_matches.Get();
+    stats.misses = m_misses.Get();
+    return stats;
+}
+
+std::string InputEngine::GetMetricsJson() const {
+    const double ns_per_tick = TickClock::GetNanosecondsPerTick();
+    auto to_ns = [ns_per_tick](uint64_t ticks) {
+        return static_cast<uint64_t>(static_cast<double>(ticks) * ns_per_tick + 0.5);
+    };
+    auto histogram_json = [&to_ns](const LatencyHistogram::Summary& summary) {
+        nlohmann::json buckets = nlohmann::json::array();
+        for (const auto& [highest, count] : summary.buckets) {
+            buckets.push_back({to_ns(std::min(highest, summary.max)), count});
+        }
+        return nlohmann::json{
+            {"count", summary.count},
+            {"mean", summary.count == 0 ? 0 : to_ns(summary.sum / summary.count)},
+            {"max", to_ns(summary.max)},
+            {"p50", to_ns(summary.Percentile(50.0))},
+            {"p90", to_ns(summary.Percentile(90.0))},
+            {"p99", to_ns(summary.Percentile(99.0))},
+            {"p99.9", to_ns(summary.Percentile(99.9))},
+            {"buckets", std::move(buckets)}
+        };
+    };
+
+    const Stats stats = GetStats();
+    const LatencyHistogram::Summary hook = m_hook_latency.GetSummary();
+    const uint64_t slow_ticks = static_cast<uint64_t>(SLOW_DECISION_MS * 1000000.0 / ns_per_tick);
+
+    nlohmann::json metrics;
+    metrics["counters"] = {
+        {"key_events", stats.key_events},
+        {"matches", stats.matches},
+        {"misses", stats.misses},
+        {"replacements", stats.replacements},
+        {"replays", stats.replays},
+        {"own_injected", stats.own_injected},
+        {"dropped", stats.dropped},
+        {"bursts", stats.bursts},
+        {"bypassed", stats.bypassed},
+        {"slow_decisions", hook.CountAbove(slow_ticks)}
+    };
+    metrics["match_sample_interval"] = MATCH_SAMPLE_INTERVAL;
+    metrics["latency_ns"] = {
+        {"hook", histogram_json(hook)},
+        {"match", histogram_json(m_match_latency.GetSummary())},
+        {"lookup", histogram_json(m_lookup_latency.GetSummary())},
+        {"output", histogram_json(m_output_latency.GetSummary())}
+    };
+    return metrics.dump(2);
+}
+
+} // namespace UniLang
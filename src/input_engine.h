@@ -0,0 +1,260 @@
+#pragma once
+
+#include "burst_detector.h"
+#include "context_table.h"
+#include "flight_recorder.h"
+#include "key_event.h"
+#include "metrics.h"
+#include "pattern_matcher.h"
+#include "shortcuts_dict.h"
+#include "spsc_queue.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace UniLang {
+
+/**
+ * @brief Work item handed from the keyboard hook to the output worker
+ */
+struct EngineAction {
+    enum class Type : uint8_t {
+        Replace,        // Delete `backspaces` characters, then type entry->utf16
+        ReplayChar,     // Re-type a character that was held back while output was in flight
+        ReplayKey       // Re-send an editing key (Enter, Tab, Backspace) held back the same way
+    };
+
+    Type type = Type::Replace;
+    const ShortcutsDict::Entry* entry = nullptr;
+    uint32_t backspaces = 0;
+    uint32_t vk = 0;
+    char16_t ch = 0;
+};
+
+/**
+ * @brief Keystroke pipeline split into a synchronous decision and an async worker
+ *
+ * OnKeyEvent runs inside the low-level keyboard hook. It only updates the
+ * matcher state of the event's focus context (see ContextTable), looks up
+ * the dictionary and decides block-or-pass; any
+ * resulting work (popup, SendInput output) is pushed into a bounded SPSC
+ * ring and executed by a worker thread through the OutputHandler.
+ *
+ * While output is in flight, text-editing keys are held back and replayed
+ * by the worker after it, so the backspaces of a replacement never delete
+ * characters typed after the trigger.
+ *
+ * Machine-generated input (pastes typed by other tools, autorepeat) is
+ * detected by BurstDetector and passed through without touching the
+ * matcher; the context's matcher is reset so it resumes from a clean state.
+ *
+ * The enabled dictionary categories are one atomic mask, read once per
+ * key event: any thread can switch categories (e.g., per app on a focus
+ * change) without locking or rebuilding anything.
+ *
+ * Every key-down decision is timed (TickClock) into latency histograms,
+ * as are the dictionary lookup of each completed pattern, a sample of the
+ * matcher steps and, on the worker, the output of each replacement. Each
+ * histogram and counter has a single writing thread, so recording is
+ * plain relaxed stores; GetMetricsJson() reads them from any thread.
+ * Each decision also goes into a FlightRecorder (no text, only classes
+ * and lengths), the record to look at when a key went missing.
+ */
+class InputEngine {
+public:
+    using OutputHandler = std::function<void(const EngineAction& action)>;
+
+    struct Stats {
+        uint64_t key_events = 0;      // Events seen by the hook side
+        uint64_t replacements = 0;    // Replace actions executed by the worker
+        uint64_t replays = 0;         // Held-back keys replayed by the worker
+        uint64_t own_injected = 0;    // UniLang's own output events passed through
+        uint64_t dropped = 0;         // Actions not queued because the ring was full
+        uint64_t bursts = 0;          // Bursts of machine-generated input detected
+        uint64_t bypassed = 0;        // Burst/autorepeat events passed through unmatched
+        uint64_t matches = 0;         // Replacements decided by the hook (dictionary, family, rule or word)
+        uint64_t misses = 0;          // Completed patterns with no enabled replacement
+    };
+
+    // Hook decisions at least this slow are counted separately: Windows skips
+    // a low-level hook that keeps it waiting past LowLevelHooksTimeout
+    static const uint32_t SLOW_DECISION_MS = 50;
+
+    // Actions (replacements and held-back keys) the ring holds before keys pass through unhandled
+    static const size_t QUEUE_CAPACITY = 256;
+
+    InputEngine();
+    ~InputEngine();
+
+    /**
+     * @brief Set dictionary used for lookups (hook thread)
+     *
+     * May be called again to swap in an updated dictionary between key
+     * events. Queued actions point into the previous dictionary's entries,
+     * so it must stay alive until they have run (the app keeps it until exit).
+     */
+    void SetDictionary(const ShortcutsDict* dict) { m_dict = dict; }
+
+    /**
+     * @brief Set the dictionary categories whose replacements fire (any thread)
+     * @param categories Mask from ShortcutsDict::GetCategoryMask
+     */
+    void SetCategoryMask(uint64_t categories) { m_categories.store(categories, std::memory_order_relaxed); }
+    uint64_t GetCategoryMask() const { return m_categories.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Override burst detection thresholds (hook thread only)
+     */
+    void SetBurstConfig(const BurstDetector::Config& config) { m_burst = BurstDetector(config); }
+
+    /**
+     * @brief Start the worker thread
+     * @param handler Called on the worker thread for every action, in order
+     * @return false if already running
+     */
+    bool Start(OutputHandler handler);
+
+    /**
+     * @brief Drain remaining actions and stop the worker thread
+     */
+    void Stop();
+
+    /**
+     * @brief Hook-side entry point: decide whether to block the key
+     * @param event Key event with the translated character filled in
+     * @return true to block the key
+     */
+    bool OnKeyEvent(const KeyEvent& event);
+
+    /**
+     * @brief Check whether queued output has not been executed yet
+     */
+    bool HasPendingOutput() const { return m_pending_outputs.load(std::memory_order_acquire) != 0; }
+
+    /**
+     * @brief Snapshot of engine counters
+     */
+    Stats GetStats() const;
+
+    /**
+     * @brief Counters and latency histograms as JSON (any thread)
+     *
+     * Latencies are in nanoseconds: count, mean, max, p50/p90/p99/p99.9
+     * and the non-empty buckets as [highest value, count] pairs.
+     */
+    std::string GetMetricsJson() const;
+
+    /**
+     * @brief Recent key-down decisions (Snapshot/Serialize from any thread)
+     */
+    const FlightRecorder& GetFlightRecorder() const { return m_flight_recorder; }
+
+    /**
+     * @brief Matcher state of the most recent focus context (hook thread only)
+     */
+    const PatternMatcher& GetMatcher() const { return m_contexts.Current(); }
+
+private:
+    /**
+     * @brief Block-or-pass decision for a key-down event (timed by OnKeyEvent)
+     */
+    bool Decide(const KeyEvent& event);
+
+    /**
+     * @brief Queue an action for the worker and wake it if parked
+     * @return false if the ring is full
+     */
+    bool Post(const EngineAction& action);
+
+    /**
+     * @brief Queue a held-back key for replay after pending output
+     */
+    bool Defer(const KeyEvent& event);
+
+    /**
+     * @brief Queue a replacement and the blocked key it replays, both or neither
+     *
+     * The replacement's backspaces are counted without the key, so the key
+     * must not reach the app unless the replacement is dropped too.
+     */
+    bool PostWithReplay(const EngineAction& action, const KeyEvent& event);
+
+    /**
+     * @brief Compute the entry for a symbol family pattern (\mathbb{R})
+     * @return Entry in the computed ring, or nullptr if the key is not a family pattern
+     */
+    const ShortcutsDict::Entry* ExpandFamily(std::string_view key);
+
+    /**
+     * @brief Compute the entry for an autocorrected word, in the case it was typed in
+     * @param word Typed word (e.g., "Teh")
+     * @param index Typo index from PatternMatcher::StepWords
+     * @return Entry in the computed ring
+     */
+    const ShortcutsDict::Entry* ExpandCorrection(std::string_view word, uint32_t index);
+
+    /**
+     * @brief Take the next entry of the computed ring, keyed by `key`
+     */
+    ShortcutsDict::Entry& NextComputedEntry(std::string_view key);
+
+    /**
+     * @brief Fill in the UTF-16 form of a computed entry's replacement
+     */
+    static void EncodeComputedEntry(ShortcutsDict::Entry& entry);
+
+    /**
+     * @brief Worker thread main loop
+     */
+    void WorkerLoop();
+
+private:
+    static constexpr uint32_t MATCH_SAMPLE_INTERVAL = 16;  // Power of two
+    // A slot is reused only after the queue wrapped around while the worker ran one action
+    static const size_t COMPUTED_SLOTS = QUEUE_CAPACITY + 1;
+
+    // Hook-side state
+    ContextTable m_contexts;
+    const ShortcutsDict* m_dict = nullptr;
+    BurstDetector m_burst;
+    ShortcutsDict::Entry m_computed_entries[COMPUTED_SLOTS];  // Families and corrections in flight
+    size_t m_computed_next = 0;
+    std::atomic<uint64_t> m_categories{ShortcutsDict::ALL_CATEGORIES};  // Written by any thread
+
+    // Handoff
+    SpscQueue<EngineAction, QUEUE_CAPACITY> m_queue;
+    std::atomic<uint32_t> m_pending_outputs{0};
+    std::atomic<bool> m_worker_parked{false};
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake_cv;
+    bool m_stop = false;  // Guarded by m_wake_mutex
+
+    // Worker
+    std::thread m_worker;
+    OutputHandler m_handler;
+
+    // Hook-side metrics
+    Counter m_key_events;
+    Counter m_own_injected;
+    Counter m_dropped;
+    Counter m_bursts;
+    Counter m_bypassed;
+    Counter m_matches;
+    Counter m_misses;
+    LatencyHistogram m_hook_latency;    // Key-down decisions
+    LatencyHistogram m_match_latency;   // PatternMatcher::AddChar, sampled
+    uint32_t m_match_samples = 0;
+    FlightRecorder::Record m_record;    // Decision being made, filled in along the way
+    FlightRecorder m_flight_recorder;
+    LatencyHistogram m_lookup_latency;  // Dictionary/family lookup of a completed pattern
+
+    // Worker metrics
+    Counter m_replacements;
+    Counter m_replays;
+    LatencyHistogram m_output_latency;  // OutputHandler for Replace actions
+};
+
+} // namespace UniLang
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+namespace UniLang {
+
+/**
+ * @brief Platform-independent description of one keyboard hook event
+ *
+ * Filled by KeyboardHook from KBDLLHOOKSTRUCT; the character is filled in by
+ * the caller through KeyTranslator before the event reaches InputEngine.
+ */
+struct KeyEvent {
+    uint32_t vk = 0;                // Virtual-key code
+    char16_t ch = 0;                // Translated character, 0 if the key produces none
+    bool is_key_down = false;       // Key-down (true) or key-up (false)
+    bool is_injected = false;       // Synthesized by some process (LLKHF_INJECTED)
+    bool is_own_injection = false;  // Synthesized by UniLang's own TextReplacer
+    uint32_t time_ms = 0;           // Event timestamp in milliseconds
+    uint64_t context = 0;           // Focus context (focused window/control), 0 if unknown
+
+    // dwExtraInfo value stamped on every event UniLang injects
+    static const uintptr_t OWN_INJECTION_TAG = 0x554E4C47;  // "UNLG"
+};
+
+} // namespace UniLang
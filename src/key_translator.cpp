@@ -0,0 +1,167 @@
+#include "key_translator.h"
+#include <algorithm>
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+namespace UniLang {
+
+namespace {
+
+// Virtual-key codes, spelled out so the table logic does not depend on Windows.h
+const uint32_t KEY_SHIFT = 0x10;
+const uint32_t KEY_CONTROL = 0x11;
+const uint32_t KEY_MENU = 0x12;
+const uint32_t KEY_CAPITAL = 0x14;
+const uint32_t KEY_LSHIFT = 0xA0;
+const uint32_t KEY_RSHIFT = 0xA1;
+const uint32_t KEY_LCONTROL = 0xA2;
+const uint32_t KEY_RCONTROL = 0xA3;
+const uint32_t KEY_LMENU = 0xA4;
+const uint32_t KEY_RMENU = 0xA5;
+
+} // namespace
+
+std::unique_ptr<KeyTranslator::LayoutTable> KeyTranslator::CreateLayout(LayoutId id, const TranslateFn& translate) {
+    auto table = std::make_unique<LayoutTable>();
+    table->id = id;
+    for (int vk = 0; vk < 256; ++vk) {
+        for (uint8_t mods = 0; mods < MODIFIER_COMBINATIONS; ++mods) {
+            table->chars[vk][mods] = translate(static_cast<uint8_t>(vk), mods);
+        }
+    }
+    return table;
+}
+
+void KeyTranslator::AddLayout(std::unique_ptr<LayoutTable> table) {
+    m_requested.erase(std::remove(m_requested.begin(), m_requested.end(), table->id), m_requested.end());
+    for (auto& layout : m_layouts) {
+        if (layout->id == table->id) {
+            if (m_active == layout.get()) {
+                m_active = table.get();
+            }
+            layout = std::move(table);
+            return;
+        }
+    }
+    m_layouts.push_back(std::move(table));
+}
+
+void KeyTranslator::BuildLayout(LayoutId id, const TranslateFn& translate) {
+    AddLayout(CreateLayout(id, translate));
+    SetActiveLayout(id);
+}
+
+bool KeyTranslator::RequestLayout(LayoutId id) {
+    if (HasLayout(id) || std::find(m_requested.begin(), m_requested.end(), id) != m_requested.end()) {
+        return false;
+    }
+    m_requested.push_back(id);
+    return true;
+}
+
+bool KeyTranslator::SetActiveLayout(LayoutId id) {
+    if (m_active && m_active->id == id) {
+        return true;
+    }
+    for (const auto& layout : m_layouts) {
+        if (layout->id == id) {
+            m_active = layout.get();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool KeyTranslator::HasLayout(LayoutId id) const {
+    for (const auto& layout : m_layouts) {
+        if (layout->id == id) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void KeyTranslator::OnKeyEvent(uint32_t vk, bool isKeyDown) {
+    switch (vk) {
+        // Generic codes come from injected input; treat them as the left key
+        case KEY_SHIFT:
+        case KEY_LSHIFT:   m_left_shift = isKeyDown; break;
+        case KEY_RSHIFT:   m_right_shift = isKeyDown; break;
+        case KEY_CONTROL:
+        case KEY_LCONTROL: m_left_ctrl = isKeyDown; break;
+        case KEY_RCONTROL: m_right_ctrl = isKeyDown; break;
+        case KEY_MENU:
+        case KEY_LMENU:    m_left_alt = isKeyDown; break;
+        case KEY_RMENU:    m_right_alt = isKeyDown; break;
+        case KEY_CAPITAL:
+            // Caps Lock toggles on the up->down transition only; holding the key
+            // autorepeats key-down events that must not flip the state again
+            if (isKeyDown && !m_caps_down) {
+                m_caps_lock = !m_caps_lock;
+            }
+            m_caps_down = isKeyDown;
+            break;
+        default:
+            break;
+    }
+}
+
+char16_t KeyTranslator::Translate(uint32_t vk) const {
+    if (!m_active || vk > 0xFF) {
+        return 0;
+    }
+    return m_active->chars[vk][GetModifiers()];
+}
+
+uint8_t KeyTranslator::GetModifiers() const {
+    uint8_t mods = 0;
+    if (m_left_shift || m_right_shift) mods |= MOD_SHIFT;
+    if (m_left_ctrl || m_right_ctrl) mods |= MOD_CTRL;
+    if (m_left_alt || m_right_alt) mods |= MOD_ALT;
+    if (m_caps_lock) mods |= MOD_CAPS;
+    return mods;
+}
+
+void KeyTranslator::SetModifierState(bool shift, bool ctrl, bool alt, bool caps_lock) {
+    m_left_shift = shift;
+    m_right_shift = false;
+    m_left_ctrl = ctrl;
+    m_right_ctrl = false;
+    m_left_alt = alt;
+    m_right_alt = false;
+    m_caps_lock = caps_lock;
+}
+
+#ifdef _WIN32
+std::unique_ptr<KeyTranslator::LayoutTable> KeyTranslator::CreateSystemLayout(LayoutId id) {
+    HKL hkl = reinterpret_cast<HKL>(id);
+
+    return CreateLayout(id, [hkl](uint8_t vk, uint8_t mods) -> char16_t {
+        BYTE keyState[256] = {};
+        if (mods & MOD_SHIFT) keyState[VK_SHIFT] = 0x80;
+        if (mods & MOD_CTRL) keyState[VK_CONTROL] = 0x80;
+        if (mods & MOD_ALT) keyState[VK_MENU] = 0x80;
+        if (mods & MOD_CAPS) keyState[VK_CAPITAL] = 0x01;
+
+        // Flag 0x4: do not change keyboard state (keeps pending dead keys intact)
+        wchar_t buffer[4] = {};
+        UINT scanCode = MapVirtualKeyExW(vk, MAPVK_VK_TO_VSC, hkl);
+        int result = ToUnicodeEx(vk, scanCode, keyState, buffer, 4, 0x4, hkl);
+
+        // Only single-character results; dead keys (-1) and composed pairs are skipped
+        return result == 1 ? static_cast<char16_t>(buffer[0]) : 0;
+    });
+}
+
+void KeyTranslator::SyncModifiersFromSystem() {
+    SetModifierState(
+        (GetAsyncKeyState(VK_SHIFT) & 0x8000) != 0,
+        (GetAsyncKeyState(VK_CONTROL) & 0x8000) != 0,
+        (GetAsyncKeyState(VK_MENU) & 0x8000) != 0,
+        (GetKeyState(VK_CAPITAL) & 0x0001) != 0
+    );
+}
+#endif
+
+} // namespace UniLang
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace UniLang {
+
+/**
+ * @brief Translates virtual-key codes to characters without querying the OS per keystroke
+ *
+ * For each keyboard layout a (VK, modifier mask) -> character table is built
+ * once, when the layout is first seen. Modifier state is tracked from the
+ * hook's own key-down/key-up stream, so a keystroke costs one table lookup
+ * instead of GetKeyboardState/GetAsyncKeyState/ToAscii, and dead-key state
+ * in the system keyboard buffer is never consumed.
+ *
+ * Building a table takes 4096 translations, too slow for a keyboard hook.
+ * CreateLayout touches nothing but the new table, so it can run on a
+ * worker; the owning thread marks the layout with RequestLayout meanwhile
+ * and adds the finished table with AddLayout.
+ */
+class KeyTranslator {
+public:
+    using LayoutId = uintptr_t;
+
+    /**
+     * @brief Character producer used to fill a layout table
+     * @param vk Virtual-key code (0-255)
+     * @param modifiers Combination of MOD_* bits
+     * @return Character produced by the key, or 0 if none (dead keys, non-character keys)
+     */
+    using TranslateFn = std::function<char16_t(uint8_t vk, uint8_t modifiers)>;
+
+    // Modifier bits (index into the per-VK row)
+    static const uint8_t MOD_SHIFT = 0x01;
+    static const uint8_t MOD_CTRL = 0x02;
+    static const uint8_t MOD_ALT = 0x04;
+    static const uint8_t MOD_CAPS = 0x08;
+    static const size_t MODIFIER_COMBINATIONS = 16;
+
+    struct LayoutTable {
+        LayoutId id = 0;
+        char16_t chars[256][MODIFIER_COMBINATIONS] = {};
+    };
+
+    KeyTranslator() = default;
+    ~KeyTranslator() = default;
+
+    /**
+     * @brief Build the table for a layout without touching any translator (safe on any thread)
+     * @param id Layout identifier (HKL on Windows)
+     * @param translate Called once per (VK, modifier mask) pair
+     */
+    static std::unique_ptr<LayoutTable> CreateLayout(LayoutId id, const TranslateFn& translate);
+
+    /**
+     * @brief Add a table from CreateLayout, replacing any table of the same layout
+     *
+     * Which layout is active doesn't change; if the replaced table was
+     * active, the new one takes its place.
+     */
+    void AddLayout(std::unique_ptr<LayoutTable> table);
+
+    /**
+     * @brief Build (or rebuild) the table for a layout and make it active
+     */
+    void BuildLayout(LayoutId id, const TranslateFn& translate);
+
+    /**
+     * @brief Note that a table for a layout is being built elsewhere (see AddLayout)
+     * @return false if the layout already has a table or was requested before
+     */
+    bool RequestLayout(LayoutId id);
+
+    /**
+     * @brief Switch to a previously built layout
+     * @return false if no table exists for this layout yet
+     */
+    bool SetActiveLayout(LayoutId id);
+
+    /**
+     * @brief Check whether a table exists for a layout
+     */
+    bool HasLayout(LayoutId id) const;
+
+    /**
+     * @brief Update modifier state from a key event
+     * @param vk Virtual-key code from the hook
+     * @param isKeyDown true for key-down, false for key-up
+     */
+    void OnKeyEvent(uint32_t vk, bool isKeyDown);
+
+    /**
+     * @brief Translate a key-down to a character using the active layout
+     * @return Character, or 0 if the key does not produce one
+     */
+    char16_t Translate(uint32_t vk) const;
+
+    /**
+     * @brief Current modifier mask (combination of MOD_* bits)
+     */
+    uint8_t GetModifiers() const;
+
+    /**
+     * @brief Overwrite the tracked modifier state (e.g., after resyncing with the OS)
+     */
+    void SetModifierState(bool shift, bool ctrl, bool alt, bool caps_lock);
+
+#ifdef _WIN32
+    /**
+     * @brief Build the table for a Windows keyboard layout using ToUnicodeEx (safe on any thread)
+     */
+    static std::unique_ptr<LayoutTable> CreateSystemLayout(LayoutId id);
+
+    /**
+     * @brief Resync modifier state with GetAsyncKeyState/GetKeyState
+     */
+    void SyncModifiersFromSystem();
+#endif
+
+private:
+    std::vector<std::unique_ptr<LayoutTable>> m_layouts;
+    const LayoutTable* m_active = nullptr;
+    std::vector<LayoutId> m_requested;      // Being built elsewhere
+
+    // Pressed state per side; a modifier is active if either side is down
+    bool m_left_shift = false;
+    bool m_right_shift = false;
+    bool m_left_ctrl = false;
+    bool m_right_ctrl = false;
+    bool m_left_alt = false;
+    bool m_right_alt = false;
+    bool m_caps_lock = false;
+    bool m_caps_down = false;
+};
+
+} // namespace UniLang
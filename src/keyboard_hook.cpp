@@ -62,11 +62,16 @@ LRESULT KeyboardHook::HandleKeyEvent(int nCode, WPARAM wParam, LPARAM lParam) {
     if (nCode >= 0) {
         KBDLLHOOKSTRUCT* kb = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
 
-        bool isKeyDown = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
+        KeyEvent event;
+        event.vk = kb->vkCode;
+        event.is_key_down = (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN);
+        event.is_injected = (kb->flags & LLKHF_INJECTED) != 0;
+        event.is_own_injection = event.is_injected && kb->dwExtraInfo == KeyEvent::OWN_INJECTION_TAG;
+        event.time_ms = kb->time;
 
         // Call the registered callback
         if (m_callback) {
-            bool shouldBlock = m_callback(kb->vkCode, isKeyDown);
+            bool shouldBlock = m_callback(event);
 
             // If callback returns true, block the key event
             if (shouldBlock) {
@@ -2,6 +2,7 @@
 
 #include <Windows.h>
 #include <functional>
+#include "key_event.h"
 
 namespace UniLang {
 
@@ -10,10 +11,13 @@ namespace UniLang {
  *
  * Uses SetWindowsHookEx(WH_KEYBOARD_LL) to intercept keyboard events
  * system-wide. Forwards key events to registered callback.
+ *
+ * The callback runs inside the hook and must return quickly: Windows
+ * silently removes hooks that exceed the LowLevelHooksTimeout.
  */
 class KeyboardHook {
 public:
-    using KeyCallback = std::function<bool(DWORD vkCode, bool isKeyDown)>;
+    using KeyCallback = std::function<bool(const KeyEvent& event)>;
 
     KeyboardHook();
     ~KeyboardHook();
@@ -0,0 +1,233 @@
+#include "latex_symbols.h"
+#include <algorithm>
+#include <array>
+#include <iterator>
+
+namespace UniLang {
+
+namespace {
+
+using Type = LatexCommand::Type;
+constexpr Type S = Type::Symbol;
+constexpr Type Op = Type::Operator;
+constexpr Type Ac = Type::Accent;
+
+// Kept in any order; sorted once on first use
+LatexCommand g_commands[] = {
+    // Greek lowercase
+    {"alpha", S, "α"}, {"beta", S, "β"}, {"gamma", S, "γ"}, {"delta", S, "δ"}, {"epsilon", S, "ϵ"},
+    {"varepsilon", S, "ε"}, {"zeta", S, "ζ"}, {"eta", S, "η"}, {"theta", S, "θ"}, {"vartheta", S, "ϑ"},
+    {"iota", S, "ι"}, {"kappa", S, "κ"}, {"varkappa", S, "ϰ"}, {"lambda", S, "λ"}, {"mu", S, "μ"},
+    {"nu", S, "ν"}, {"xi", S, "ξ"}, {"omicron", S, "ο"}, {"pi", S, "π"}, {"varpi", S, "ϖ"},
+    {"rho", S, "ρ"}, {"varrho", S, "ϱ"}, {"sigma", S, "σ"}, {"varsigma", S, "ς"}, {"tau", S, "τ"},
+    {"upsilon", S, "υ"}, {"phi", S, "ϕ"}, {"varphi", S, "φ"}, {"chi", S, "χ"}, {"psi", S, "ψ"},
+    {"omega", S, "ω"},
+
+    // Greek uppercase
+    {"Gamma", S, "Γ"}, {"Delta", S, "Δ"}, {"Theta", S, "Θ"}, {"Lambda", S, "Λ"}, {"Xi", S, "Ξ"},
+    {"Pi", S, "Π"}, {"Sigma", S, "Σ"}, {"Upsilon", S, "Υ"}, {"Phi", S, "Φ"}, {"Psi", S, "Ψ"},
+    {"Omega", S, "Ω"},
+
+    // Large operators
+    {"sum", S, "∑"}, {"prod", S, "∏"}, {"coprod", S, "∐"}, {"int", S, "∫"}, {"iint", S, "∬"},
+    {"iiint", S, "∭"}, {"oint", S, "∮"}, {"bigcup", S, "⋃"}, {"bigcap", S, "⋂"}, {"bigoplus", S, "⨁"},
+    {"bigotimes", S, "⨂"}, {"bigvee", S, "⋁"}, {"bigwedge", S, "⋀"}, {"bigsqcup", S, "⨆"},
+
+    // Binary operators
+    {"pm", S, "±"}, {"mp", S, "∓"}, {"times", S, "×"}, {"div", S, "÷"}, {"cdot", S, "⋅"},
+    {"ast", S, "∗"}, {"star", S, "⋆"}, {"circ", S, "∘"}, {"bullet", S, "∙"}, {"oplus", S, "⊕"},
+    {"ominus", S, "⊖"}, {"otimes", S, "⊗"}, {"oslash", S, "⊘"}, {"odot", S, "⊙"}, {"cup", S, "∪"},
+    {"cap", S, "∩"}, {"setminus", S, "∖"}, {"wedge", S, "∧"}, {"land", S, "∧"}, {"vee", S, "∨"},
+    {"lor", S, "∨"}, {"sqcup", S, "⊔"}, {"sqcap", S, "⊓"}, {"uplus", S, "⊎"}, {"wr", S, "≀"},
+    {"dagger", S, "†"}, {"ddagger", S, "‡"}, {"amalg", S, "⨿"},
+
+    // Relations
+    {"leq", S, "≤"}, {"le", S, "≤"}, {"geq", S, "≥"}, {"ge", S, "≥"}, {"neq", S, "≠"},
+    {"ne", S, "≠"}, {"equiv", S, "≡"}, {"approx", S, "≈"}, {"sim", S, "∼"}, {"simeq", S, "≃"},
+    {"cong", S, "≅"}, {"propto", S, "∝"}, {"ll", S, "≪"}, {"gg", S, "≫"}, {"prec", S, "≺"},
+    {"succ", S, "≻"}, {"preceq", S, "⪯"}, {"succeq", S, "⪰"}, {"subset", S, "⊂"}, {"supset", S, "⊃"},
+    {"subseteq", S, "⊆"}, {"supseteq", S, "⊇"}, {"subsetneq", S, "⊊"}, {"supsetneq", S, "⊋"}, {"in", S, "∈"},
+    {"notin", S, "∉"}, {"ni", S, "∋"}, {"mid", S, "∣"}, {"nmid", S, "∤"}, {"parallel", S, "∥"},
+    {"perp", S, "⊥"}, {"models", S, "⊨"}, {"vdash", S, "⊢"}, {"dashv", S, "⊣"}, {"doteq", S, "≐"},
+    {"asymp", S, "≍"}, {"lesssim", S, "≲"}, {"gtrsim", S, "≳"}, {"leqslant", S, "⩽"}, {"geqslant", S, "⩾"},
+    {"coloneqq", S, "≔"}, {"nleq", S, "≰"}, {"ngeq", S, "≱"}, {"nsim", S, "≁"}, {"ncong", S, "≇"},
+
+    // Arrows
+    {"to", S, "→"}, {"rightarrow", S, "→"}, {"leftarrow", S, "←"}, {"gets", S, "←"},
+    {"leftrightarrow", S, "↔"}, {"Rightarrow", S, "⇒"}, {"Leftarrow", S, "⇐"}, {"Leftrightarrow", S, "⇔"},
+    {"implies", S, "⟹"}, {"impliedby", S, "⟸"}, {"iff", S, "⟺"}, {"mapsto", S, "↦"},
+    {"longrightarrow", S, "⟶"}, {"longleftarrow", S, "⟵"}, {"longleftrightarrow", S, "⟷"},
+    {"Longrightarrow", S, "⟹"}, {"Longleftarrow", S, "⟸"}, {"longmapsto", S, "⟼"},
+    {"uparrow", S, "↑"}, {"downarrow", S, "↓"}, {"updownarrow", S, "↕"}, {"Uparrow", S, "⇑"},
+    {"Downarrow", S, "⇓"}, {"nearrow", S, "↗"}, {"searrow", S, "↘"}, {"swarrow", S, "↙"},
+    {"nwarrow", S, "↖"}, {"hookrightarrow", S, "↪"}, {"hookleftarrow", S, "↩"},
+    {"rightharpoonup", S, "⇀"}, {"leftharpoonup", S, "↼"}, {"rightleftharpoons", S, "⇌"},
+
+    // Miscellaneous
+    {"infty", S, "∞"}, {"partial", S, "∂"}, {"nabla", S, "∇"}, {"forall", S, "∀"}, {"exists", S, "∃"},
+    {"nexists", S, "∄"}, {"neg", S, "¬"}, {"lnot", S, "¬"}, {"emptyset", S, "∅"}, {"varnothing", S, "∅"},
+    {"aleph", S, "ℵ"}, {"beth", S, "ℶ"}, {"hbar", S, "ℏ"}, {"ell", S, "ℓ"}, {"wp", S, "℘"},
+    {"Re", S, "ℜ"}, {"Im", S, "ℑ"}, {"prime", S, "′"}, {"angle", S, "∠"}, {"triangle", S, "△"},
+    {"square", S, "□"}, {"Box", S, "□"}, {"Diamond", S, "◇"}, {"top", S, "⊤"}, {"bot", S, "⊥"},
+    {"cdots", S, "⋯"}, {"ldots", S, "…"}, {"dots", S, "…"}, {"vdots", S, "⋮"}, {"ddots", S, "⋱"},
+    {"langle", S, "⟨"}, {"rangle", S, "⟩"}, {"lceil", S, "⌈"}, {"rceil", S, "⌉"}, {"lfloor", S, "⌊"},
+    {"rfloor", S, "⌋"}, {"vert", S, "|"}, {"Vert", S, "‖"}, {"lvert", S, "|"}, {"rvert", S, "|"},
+    {"lVert", S, "‖"}, {"rVert", S, "‖"}, {"backslash", S, "\\"}, {"therefore", S, "∴"}, {"because", S, "∵"},
+    {"surd", S, "√"}, {"checkmark", S, "✓"}, {"flat", S, "♭"}, {"sharp", S, "♯"}, {"natural", S, "♮"},
+    {"clubsuit", S, "♣"}, {"diamondsuit", S, "♢"}, {"heartsuit", S, "♡"}, {"spadesuit", S, "♠"},
+    {"S", S, "§"}, {"P", S, "¶"}, {"dag", S, "†"}, {"ddag", S, "‡"}, {"copyright", S, "©"},
+    {"pounds", S, "£"}, {"imath", S, "ı"}, {"jmath", S, "ȷ"}, {"degree", S, "°"}, {"lbrace", S, "{"},
+    {"rbrace", S, "}"}, {"quad", S, " "}, {"qquad", S, "  "},
+
+    // Operator names typeset as upright words
+    {"Pr", Op}, {"arccos", Op}, {"arcsin", Op}, {"arctan", Op}, {"arg", Op}, {"cos", Op},
+    {"cosh", Op}, {"cot", Op}, {"coth", Op}, {"csc", Op}, {"deg", Op}, {"det", Op},
+    {"dim", Op}, {"exp", Op}, {"gcd", Op}, {"hom", Op}, {"inf", Op}, {"ker", Op},
+    {"lg", Op}, {"lim", Op}, {"liminf", Op}, {"limsup", Op}, {"ln", Op}, {"log", Op},
+    {"max", Op}, {"min", Op}, {"sec", Op}, {"sin", Op}, {"sinh", Op}, {"sup", Op},
+    {"tan", Op}, {"tanh", Op},
+
+    // Accents: the marks live in the symbol families (see symbol_families.h)
+    {"hat", Ac}, {"widehat", Ac}, {"check", Ac}, {"tilde", Ac}, {"widetilde", Ac}, {"bar", Ac},
+    {"vec", Ac}, {"dot", Ac}, {"ddot", Ac}, {"acute", Ac}, {"grave", Ac}, {"breve", Ac},
+    {"overline", Ac}, {"underline", Ac},
+
+    // Constructs
+    {"frac", Type::Fraction}, {"dfrac", Type::Fraction}, {"tfrac", Type::Fraction},
+    {"cfrac", Type::Fraction}, {"sqrt", Type::Root},
+    {"text", Type::Text}, {"textrm", Type::Text}, {"textit", Type::Text}, {"textbf", Type::Text},
+    {"textsf", Type::Text}, {"texttt", Type::Text}, {"mbox", Type::Text}, {"hbox", Type::Text},
+    {"mathrm", Type::Style}, {"mathit", Type::Style}, {"mathbf", Type::Style}, {"mathsf", Type::Style},
+    {"mathtt", Type::Style}, {"mathnormal", Type::Style}, {"boldsymbol", Type::Style}, {"bm", Type::Style},
+    {"operatorname", Type::Style}, {"mathcal", Type::Style}, {"mathbb", Type::Style},
+    {"mathfrak", Type::Style}, {"mathscr", Type::Style},
+
+    // Delimiter sizing: the delimiter that follows is kept ('.' means none)
+    {"left", Type::Delimiter}, {"right", Type::Delimiter}, {"bigl", Type::Delimiter},
+    {"bigr", Type::Delimiter}, {"Bigl", Type::Delimiter}, {"Bigr", Type::Delimiter},
+    {"biggl", Type::Delimiter}, {"biggr", Type::Delimiter},
+
+    // Layout commands with no visible output
+    {"big", Type::Ignore}, {"Big", Type::Ignore}, {"bigg", Type::Ignore}, {"Bigg", Type::Ignore},
+    {"displaystyle", Type::Ignore}, {"textstyle", Type::Ignore}, {"scriptstyle", Type::Ignore},
+    {"limits", Type::Ignore}, {"nolimits", Type::Ignore}, {"nonumber", Type::Ignore},
+    {"notag", Type::Ignore},
+};
+
+struct ScriptPair {
+    char32_t base;
+    char32_t script;
+};
+
+const ScriptPair g_superscripts[] = {
+    {U'0', U'⁰'}, {U'1', U'¹'}, {U'2', U'²'}, {U'3', U'³'}, {U'4', U'⁴'},
+    {U'5', U'⁵'}, {U'6', U'⁶'}, {U'7', U'⁷'}, {U'8', U'⁸'}, {U'9', U'⁹'},
+    {U'+', U'⁺'}, {U'-', U'⁻'}, {U'=', U'⁼'}, {U'(', U'⁽'}, {U')', U'⁾'},
+    {U'a', U'ᵃ'}, {U'b', U'ᵇ'}, {U'c', U'ᶜ'}, {U'd', U'ᵈ'}, {U'e', U'ᵉ'},
+    {U'f', U'ᶠ'}, {U'g', U'ᵍ'}, {U'h', U'ʰ'}, {U'i', U'ⁱ'}, {U'j', U'ʲ'},
+    {U'k', U'ᵏ'}, {U'l', U'ˡ'}, {U'm', U'ᵐ'}, {U'n', U'ⁿ'}, {U'o', U'ᵒ'},
+    {U'p', U'ᵖ'}, {U'r', U'ʳ'}, {U's', U'ˢ'}, {U't', U'ᵗ'}, {U'u', U'ᵘ'},
+    {U'v', U'ᵛ'}, {U'w', U'ʷ'}, {U'x', U'ˣ'}, {U'y', U'ʸ'}, {U'z', U'ᶻ'},
+    {U'A', U'ᴬ'}, {U'B', U'ᴮ'}, {U'D', U'ᴰ'}, {U'E', U'ᴱ'}, {U'G', U'ᴳ'},
+    {U'H', U'ᴴ'}, {U'I', U'ᴵ'}, {U'J', U'ᴶ'}, {U'K', U'ᴷ'}, {U'L', U'ᴸ'},
+    {U'M', U'ᴹ'}, {U'N', U'ᴺ'}, {U'O', U'ᴼ'}, {U'P', U'ᴾ'}, {U'R', U'ᴿ'},
+    {U'T', U'ᵀ'}, {U'U', U'ᵁ'}, {U'V', U'ⱽ'}, {U'W', U'ᵂ'},
+    {U'α', U'ᵅ'}, {U'β', U'ᵝ'}, {U'γ', U'ᵞ'}, {U'δ', U'ᵟ'}, {U'ε', U'ᵋ'},
+    {U'θ', U'ᶿ'}, {U'ι', U'ᶥ'}, {U'φ', U'ᵠ'}, {U'ϕ', U'ᵠ'}, {U'χ', U'ᵡ'},
+    {U'′', U'′'}, {U'″', U'″'}, {U'*', U'*'}, {U',', U','},
+};
+
+const ScriptPair g_subscripts[] = {
+    {U'0', U'₀'}, {U'1', U'₁'}, {U'2', U'₂'}, {U'3', U'₃'}, {U'4', U'₄'},
+    {U'5', U'₅'}, {U'6', U'₆'}, {U'7', U'₇'}, {U'8', U'₈'}, {U'9', U'₉'},
+    {U'+', U'₊'}, {U'-', U'₋'}, {U'=', U'₌'}, {U'(', U'₍'}, {U')', U'₎'},
+    {U'a', U'ₐ'}, {U'e', U'ₑ'}, {U'h', U'ₕ'}, {U'i', U'ᵢ'}, {U'j', U'ⱼ'},
+    {U'k', U'ₖ'}, {U'l', U'ₗ'}, {U'm', U'ₘ'}, {U'n', U'ₙ'}, {U'o', U'ₒ'},
+    {U'p', U'ₚ'}, {U'r', U'ᵣ'}, {U's', U'ₛ'}, {U't', U'ₜ'}, {U'u', U'ᵤ'},
+    {U'v', U'ᵥ'}, {U'x', U'ₓ'},
+    {U'β', U'ᵦ'}, {U'γ', U'ᵧ'}, {U'ρ', U'ᵨ'}, {U'φ', U'ᵩ'}, {U'ϕ', U'ᵩ'},
+    {U'χ', U'ᵪ'}, {U',', U','},
+};
+
+struct Fraction {
+    std::string_view numerator;
+    std::string_view denominator;
+    const char* text;
+};
+
+const Fraction g_fractions[] = {
+    {"1", "2", "½"}, {"1", "3", "⅓"}, {"2", "3", "⅔"}, {"1", "4", "¼"}, {"3", "4", "¾"},
+    {"1", "5", "⅕"}, {"2", "5", "⅖"}, {"3", "5", "⅗"}, {"4", "5", "⅘"}, {"1", "6", "⅙"},
+    {"5", "6", "⅚"}, {"1", "7", "⅐"}, {"1", "8", "⅛"}, {"3", "8", "⅜"}, {"5", "8", "⅝"},
+    {"7", "8", "⅞"}, {"1", "9", "⅑"}, {"1", "10", "⅒"}, {"0", "3", "↉"},
+};
+
+/**
+ * @brief ASCII lookups are table-driven; the rest is a short linear scan
+ */
+template<size_t N>
+class ScriptTable {
+public:
+    explicit ScriptTable(const ScriptPair (&pairs)[N]) : m_pairs(pairs) {
+        for (const ScriptPair& pair : pairs) {
+            if (pair.base < 128) {
+                m_ascii[pair.base] = pair.script;
+            }
+        }
+    }
+
+    char32_t Map(char32_t cp) const {
+        if (cp < 128) {
+            return m_ascii[cp];
+        }
+        for (const ScriptPair& pair : m_pairs) {
+            if (pair.base == cp || pair.script == cp) {
+                return pair.script;
+            }
+        }
+        return 0;
+    }
+
+private:
+    const ScriptPair (&m_pairs)[N];
+    std::array<char32_t, 128> m_ascii = {};
+};
+
+} // namespace
+
+const LatexCommand* FindLatexCommand(std::string_view name) {
+    static const bool sorted = []() {
+        std::sort(std::begin(g_commands), std::end(g_commands),
+                  [](const LatexCommand& a, const LatexCommand& b) { return a.name < b.name; });
+        return true;
+    }();
+    (void)sorted;
+
+    const auto it = std::lower_bound(std::begin(g_commands), std::end(g_commands), name,
+                                     [](const LatexCommand& command, std::string_view key) { return command.name < key; });
+    if (it != std::end(g_commands) && it->name == name) {
+        return &*it;
+    }
+    return nullptr;
+}
+
+char32_t ToSuperscript(char32_t cp) {
+    static const ScriptTable<std::size(g_superscripts)> table(g_superscripts);
+    return table.Map(cp);
+}
+
+char32_t ToSubscript(char32_t cp) {
+    static const ScriptTable<std::size(g_subscripts)> table(g_subscripts);
+    return table.Map(cp);
+}
+
+const char* FindVulgarFraction(std::string_view numerator, std::string_view denominator) {
+    for (const Fraction& fraction : g_fractions) {
+        if (fraction.numerator == numerator && fraction.denominator == denominator) {
+            return fraction.text;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace UniLang
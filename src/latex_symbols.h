@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace UniLang {
+
+/**
+ * @brief Built-in LaTeX-to-Unicode tables
+ *
+ * Standard LaTeX names (\alpha, \leq, \sum, ...) for converting math text.
+ * The shortcuts dictionary uses short forms (\al, \leq); these tables cover
+ * the full names that appear in documents.
+ */
+
+/**
+ * @brief What a LaTeX control word does
+ */
+struct LatexCommand {
+    enum class Type : uint8_t {
+        Symbol,         // \alpha -> text
+        Operator,       // \sin: the name itself, upright
+        Accent,         // \hat{x}: symbol family applied to the argument
+        Fraction,       // \frac{a}{b}
+        Root,           // \sqrt[n]{x}
+        Text,           // \text{...}: literal content
+        Style,          // \mathrm{...}: content as is, or a symbol family (\mathbb)
+        Delimiter,      // \left, \right
+        Ignore,         // \displaystyle, \big, ...
+    };
+
+    std::string_view name;
+    Type type;
+    const char* text = nullptr;     // Symbol: UTF-8 replacement
+};
+
+/**
+ * @brief Look up a control word (without the backslash)
+ * @return Command description, or nullptr if unknown
+ */
+const LatexCommand* FindLatexCommand(std::string_view name);
+
+/**
+ * @brief Superscript form of a code point
+ * @return Superscript code point, the input if it already is one, or 0 if none exists
+ */
+char32_t ToSuperscript(char32_t cp);
+
+/**
+ * @brief Subscript form of a code point
+ * @return Subscript code point, the input if it already is one, or 0 if none exists
+ */
+char32_t ToSubscript(char32_t cp);
+
+/**
+ * @brief Precomposed fraction for a numerator/denominator pair (e.g., 1/2 -> "½")
+ * @return UTF-8 text, or nullptr if there is none
+ */
+const char* FindVulgarFraction(std::string_view numerator, std::string_view denominator);
+
+} // namespace UniLang
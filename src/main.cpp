@@ -4,17 +4,28 @@
 #include <string>
 #include <filesystem>
 #include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 #include "version.h"  // Generated by CMake
 #include "keyboard_hook.h"
+#include "key_translator.h"
 #include "shortcuts_dict.h"
-#include "pattern_matcher.h"
+#include "input_engine.h"
 #include "text_replacer.h"
 #include "popup_window.h"
 #include "settings_manager.h"
 #include "help_window.h"
-#include "update_manager.h"
+#include "update_worker.h"
 #include "auto_updater.h"
+#include "settings_writer.h"
+#include "trace.h"
+#include "startup_profiler.h"
 
 namespace fs = std::filesystem;
 
@@ -22,17 +33,45 @@ namespace fs = std::filesystem;
 constexpr UINT_PTR TIMER_UPDATE_CHECK = 1;
 constexpr UINT UPDATE_CHECK_INTERVAL = 7 * 24 * 60 * 60 * 1000; // 7 days in milliseconds
 
+// Restarted by every key-down until the deferred windows exist, so they are
+// created in the first pause in typing (WM_TIMER only arrives on an idle queue)
+constexpr UINT_PTR TIMER_DEFERRED_INIT = 2;
+constexpr UINT DEFERRED_INIT_IDLE_MS = 500;
+
+// Posted by the output worker so popups are rendered by the UI thread, outside the hook
+constexpr UINT WM_APP_SHOW_POPUP = WM_APP + 1;
+
+// Posted by the update worker with a finished job (LPARAM owns an UpdateWorker::Result)
+constexpr UINT WM_APP_UPDATE_RESULT = WM_APP + 2;
+
+// Posted by a layout worker with a finished table (LPARAM owns a KeyTranslator::LayoutTable)
+constexpr UINT WM_APP_LAYOUT_READY = WM_APP + 3;
+
 // Global application state
 struct AppState {
+    UniLang::StartupProfiler startup;       // First member: times AppState construction, too
     UniLang::KeyboardHook keyboard_hook;
-    UniLang::ShortcutsDict shortcuts_dict;
-    UniLang::PatternMatcher pattern_matcher;
-    UniLang::TextReplacer text_replacer;
+    UniLang::KeyTranslator key_translator;
+    std::unique_ptr<UniLang::ShortcutsDict> shortcuts_dict = std::make_unique<UniLang::ShortcutsDict>();
+    std::vector<std::unique_ptr<UniLang::ShortcutsDict>> retired_dicts;  // Replaced by diffs; queued output may point into them
+    const UniLang::ShortcutsDict* builtin_dict = nullptr;   // As embedded in this build; the saved diff starts from it
+    UniLang::InputEngine input_engine;
+    UniLang::TextReplacer text_replacer;  // Used by the output worker thread only
     UniLang::PopupWindow popup_window;
     UniLang::SettingsManager settings_manager;
     UniLang::HelpWindow help_window;
+    UniLang::UpdateWorker update_worker;    // Network I/O stays off the UI thread
 
+    HINSTANCE instance = nullptr;
     HWND main_window = nullptr;
+    HWND focus_window = nullptr;            // Last focused window/control (input context)
+    HWINEVENTHOOK focus_hooks[2] = {};      // Foreground + focus change notifications
+    uint64_t category_mask = UniLang::ShortcutsDict::ALL_CATEGORIES;    // Settings::disabled_categories
+    std::unordered_map<std::string, uint64_t> app_category_masks;       // Executable name -> mask in that app
+    std::atomic<bool> show_popup{false};    // Settings::show_popup as the output worker reads it
+    bool first_input_seen = false;          // Recorded in the startup phases
+    bool popup_created = false;             // Created after startup (see CreatePopupWindow)
+    bool help_created = false;
     bool running = true;
 };
 
@@ -40,12 +79,26 @@ AppState* g_app = nullptr;
 
 // Forward declarations
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
-bool OnKeyEvent(DWORD vkCode, bool isKeyDown);
+bool OnKeyEvent(const UniLang::KeyEvent& event);
+void OnEngineAction(const UniLang::EngineAction& action);
+void CALLBACK OnFocusEvent(HWINEVENTHOOK hook, DWORD event, HWND hwnd, LONG idObject,
+                           LONG idChild, DWORD idEventThread, DWORD dwmsEventTime);
 std::string GetExecutableDir();
+std::string GetProcessName(HWND hwnd);
 bool IsVSCodeWindow();
-void CheckForUpdatesAutomatic(HWND hwnd, bool show_notification);
+void OnUpdateResult(HWND hwnd, const UniLang::UpdateWorker::Result& result);
+void ShowUpdateNotification(HWND hwnd, const std::string& version);
+void UpdateCategoryMasks(AppState& app);
+bool ReadShortcutsDiff(const std::string& path, UniLang::ShortcutsDict::Diff& diff);
+void ApplyShortcutsDiff(const std::string& path);
+void SaveDiagnostics(HWND hwnd);
+void CreatePopupWindow();
+void CreateHelpWindow();
+void RequestLayoutTable(HWND window);
 
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
+    UNILANG_TRACE_THREAD("UI");
+
     // Check for single instance (prevent multiple instances running)
     HANDLE hMutex = CreateMutexW(nullptr, TRUE, L"UniLang_SingleInstance_Mutex");
     if (GetLastError() == ERROR_ALREADY_EXISTS) {
@@ -78,18 +131,65 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
     // Create application state
     AppState app;
     g_app = &app;
+    app.instance = hInstance;
+    app.startup.Mark("app state");
 
     // Load shortcuts dictionary from embedded resource
-    if (!app.shortcuts_dict.LoadFromResource()) {
+    if (!app.shortcuts_dict->LoadFromResource()) {
         MessageBoxA(nullptr,
                    "Failed to load shortcuts from resource!",
                    "UniLang - Error",
                    MB_OK | MB_ICONERROR);
         return 1;
     }
+    app.startup.Mark("dictionary");
+
+    // Settings are the "settings" section of config\shortcuts.json. Without the
+    // file the defaults apply (see SettingsManager::Settings) and changes stay in memory.
+    // Settings belong to the UI thread; what the output worker reads is
+    // published again on every load or change.
+    app.settings_manager.SetOnSettingsChangedCallback([&app](const UniLang::SettingsManager::Settings& settings) {
+        app.show_popup.store(settings.show_popup, std::memory_order_relaxed);
+    });
+    app.settings_manager.LoadSettings(UniLang::AutoUpdater().GetShortcutsPath());
+    app.startup.Mark("settings");
+
+    // LaTeX shortcuts start with the configured trigger key ("\\" by default)
+    if (!app.shortcuts_dict->SetTriggerKey(app.settings_manager.GetSettings().trigger_key)) {
+        MessageBoxA(nullptr,
+                   "Invalid trigger key in settings, using \\ instead.",
+                   "UniLang - Warning",
+                   MB_OK | MB_ICONWARNING);
+    }
+
+    // Autocorrect typos from a word list, if one is configured (relative paths are in config\)
+    std::string word_list = app.settings_manager.GetSettings().autocorrect_list;
+    if (!word_list.empty() && fs::path(word_list).is_relative()) {
+        word_list = GetExecutableDir() + "\\config\\" + word_list;
+    }
+    if (!word_list.empty() && !app.shortcuts_dict->LoadWordList(word_list)) {
+        MessageBoxA(nullptr,
+                   "Failed to load the autocorrect word list, autocorrect is off.",
+                   "UniLang - Warning",
+                   MB_OK | MB_ICONWARNING);
+    }
+
+    // Dictionary updates published since this build, saved as one diff from the
+    // embedded dictionary (see ApplyShortcutsDiff). A diff for another build is ignored.
+    app.builtin_dict = app.shortcuts_dict.get();
+    UniLang::ShortcutsDict::Diff shortcuts_diff;
+    if (ReadShortcutsDiff(UniLang::AutoUpdater().GetShortcutsDiffPath(), shortcuts_diff)) {
+        auto updated = std::make_unique<UniLang::ShortcutsDict>();
+        if (updated->LoadFromDiff(*app.builtin_dict, shortcuts_diff)) {
+            app.retired_dicts.push_back(std::move(app.shortcuts_dict));
+            app.shortcuts_dict = std::move(updated);
+        }
+    }
 
-    // Note: Settings use default values (enabled=true, show_popup=true, etc.)
-    // No external config file needed
+    // Category masks are computed once per dictionary; a focus change only picks one
+    UpdateCategoryMasks(app);
+    app.input_engine.SetCategoryMask(app.category_mask);
+    app.startup.Mark("dictionary settings");
 
     // Create invisible main window for message loop
     WNDCLASSEXW wc = {};
@@ -116,41 +216,66 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
         MessageBoxA(nullptr, "Failed to create main window!", "UniLang - Error", MB_OK | MB_ICONERROR);
         return 1;
     }
+    app.startup.Mark("main window");
 
-    // Initialize system tray
-    if (!app.settings_manager.InitializeTray(app.main_window)) {
-        MessageBoxA(nullptr, "Failed to create system tray icon!", "UniLang - Error", MB_OK | MB_ICONERROR);
+    // Typing works from here on: the hook goes in before anything the first
+    // keystroke does not need. Seed modifier state; the hook keeps it current.
+    app.key_translator.SyncModifiersFromSystem();
+    RequestLayoutTable(GetForegroundWindow());
+
+    // Start the output worker before the hook can queue anything. It reads
+    // only the settings published for it (see SetOnSettingsChangedCallback).
+    app.input_engine.SetDictionary(app.shortcuts_dict.get());
+    app.input_engine.Start(OnEngineAction);
+
+    // Install keyboard hook
+    if (!app.keyboard_hook.Install(OnKeyEvent)) {
+        MessageBoxA(nullptr, "Failed to install keyboard hook!", "UniLang - Error", MB_OK | MB_ICONERROR);
         return 1;
     }
 
-    // Create popup window
-    if (!app.popup_window.Create(hInstance)) {
-        MessageBoxA(nullptr, "Failed to create popup window!", "UniLang - Warning", MB_OK | MB_ICONWARNING);
-        // Continue anyway - popup is optional
-    }
+    // Track focus changes so each window/control keeps its own matcher state
+    app.focus_hooks[0] = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr,
+                                         OnFocusEvent, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+    app.focus_hooks[1] = SetWinEventHook(EVENT_OBJECT_FOCUS, EVENT_OBJECT_FOCUS, nullptr,
+                                         OnFocusEvent, 0, 0, WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+    app.startup.Mark("keyboard hook");
 
-    // Create help window
-    if (!app.help_window.Create(hInstance, &app.shortcuts_dict)) {
-        MessageBoxA(nullptr, "Failed to create help window!", "UniLang - Warning", MB_OK | MB_ICONWARNING);
-        // Continue anyway - help is optional
+    // Initialize system tray
+    if (!app.settings_manager.InitializeTray(app.main_window)) {
+        MessageBoxA(nullptr, "Failed to create system tray icon!", "UniLang - Error", MB_OK | MB_ICONERROR);
+        return 1;
     }
 
     // Set callback for tray icon left-click to show help window
     app.settings_manager.SetOnHelpRequestCallback([&app]() {
+        CreateHelpWindow();
         app.help_window.Toggle();
     });
-
-    // Install keyboard hook
-    if (!app.keyboard_hook.Install(OnKeyEvent)) {
-        MessageBoxA(nullptr, "Failed to install keyboard hook!", "UniLang - Error", MB_OK | MB_ICONERROR);
-        return 1;
-    }
+    app.startup.Mark("tray icon");
+
+    // Popup and help window wait for the first pause in typing, or for whatever
+    // needs them first (TIMER_DEFERRED_INIT); the help list waits until it is shown
+
+    // Update checks run on a worker; results come back as WM_APP_UPDATE_RESULT
+    UniLang::UpdateWorker::Config update_config;
+    update_config.repo_owner = "Aicua";
+    update_config.repo_name = "Unilang";
+    update_config.current_version = UNILANG_VERSION_STRING;
+    update_config.cache_path = GetExecutableDir() + "\\config\\update_cache.json";
+    app.update_worker.Start(UniLang::HttpClient::Create(), update_config,
+        [hwnd = app.main_window](std::unique_ptr<UniLang::UpdateWorker::Result> result) {
+            if (PostMessageW(hwnd, WM_APP_UPDATE_RESULT, 0, reinterpret_cast<LPARAM>(result.get()))) {
+                result.release();
+            }
+        });
 
     // Check for updates automatically on startup (silent, no notification)
-    CheckForUpdatesAutomatic(app.main_window, false);
+    app.update_worker.QueueCheck(UniLang::UpdateWorker::Mode::Silent);
 
     // Set timer for periodic update checks (every 7 days)
     SetTimer(app.main_window, TIMER_UPDATE_CHECK, UPDATE_CHECK_INTERVAL, nullptr);
+    app.startup.Mark("update worker");
 
     // UniLang is now running silently in the background
     // Check the system tray icon for status and options
@@ -163,16 +288,43 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
     }
 
     // Cleanup
+    // Hooks first: with no message loop left, every keystroke in the system would wait on them
     KillTimer(app.main_window, TIMER_UPDATE_CHECK);
+    KillTimer(app.main_window, TIMER_DEFERRED_INIT);
     app.keyboard_hook.Uninstall();
+    for (HWINEVENTHOOK hook : app.focus_hooks) {
+        if (hook) {
+            UnhookWinEvent(hook);
+        }
+    }
+    app.update_worker.Stop();
+    app.input_engine.Stop();
     app.settings_manager.RemoveTray();
 
     return 0;
 }
 
-bool OnKeyEvent(DWORD vkCode, bool isKeyDown) {
-    if (!g_app || !isKeyDown) {
-        return false; // Don't block key-up events
+bool OnKeyEvent(const UniLang::KeyEvent& hookEvent) {
+    if (!g_app) {
+        return false;
+    }
+
+    // The hook runs on the UI thread, so these flags need no synchronization.
+    // Nothing is created here: the windows wait for a pause in typing.
+    if (!g_app->help_created && hookEvent.is_key_down && !hookEvent.is_own_injection) {
+        if (!g_app->first_input_seen) {
+            g_app->first_input_seen = true;
+            g_app->startup.Restart();
+            g_app->startup.Mark("first key press");
+        }
+        SetTimer(g_app->main_window, TIMER_DEFERRED_INIT, DEFERRED_INIT_IDLE_MS, nullptr);
+    }
+
+    // Track modifiers from the hook's own event stream (needs key-ups too)
+    g_app->key_translator.OnKeyEvent(hookEvent.vk, hookEvent.is_key_down);
+
+    if (!hookEvent.is_key_down || hookEvent.is_own_injection) {
+        return g_app->input_engine.OnKeyEvent(hookEvent);
     }
 
     // Check if UniLang is enabled
@@ -186,91 +338,78 @@ bool OnKeyEvent(DWORD vkCode, bool isKeyDown) {
         return false; // Allow normal typing in search box
     }
 
-    // Handle special keys that should reset the pattern buffer
-    // NOTE: VK_SPACE is NOT here because it's used as trigger for LaTeX patterns
-    if (vkCode == VK_RETURN || vkCode == VK_ESCAPE || vkCode == VK_TAB) {
-        g_app->pattern_matcher.Reset();
-        return false;
+    // Convert virtual key to character using the per-layout table.
+    // The table is built once per layout, so ToUnicodeEx never runs per keystroke
+    // and pending dead keys in the system keyboard buffer are left alone.
+    // A layout seen for the first time is built on a worker; until it arrives
+    // its keys have no character and pass through untouched.
+    HKL layout = GetKeyboardLayout(GetWindowThreadProcessId(foreground, nullptr));
+    auto layout_id = reinterpret_cast<UniLang::KeyTranslator::LayoutId>(layout);
+    UniLang::KeyEvent event = hookEvent;
+    if (g_app->key_translator.SetActiveLayout(layout_id)) {
+        event.ch = g_app->key_translator.Translate(event.vk);
+    } else {
+        RequestLayoutTable(foreground);
+        event.ch = 0;
     }
 
-    // Handle Backspace - remove last character from buffer
-    if (vkCode == VK_BACK) {
-        g_app->pattern_matcher.RemoveLastChar();
-        return false; // Don't block backspace
+    // Input context: the focused control if it belongs to the foreground window
+    HWND context = g_app->focus_window;
+    if (!context || GetAncestor(context, GA_ROOT) != foreground) {
+        context = foreground;
     }
+    event.context = reinterpret_cast<uintptr_t>(context);
 
-    // Convert virtual key to character
-    BYTE keyState[256] = {};
-    GetKeyboardState(keyState);
+    // Only the block-or-pass decision happens here; output runs on the worker
+    return g_app->input_engine.OnKeyEvent(event);
+}
 
-    // Manually check for modifier keys using GetAsyncKeyState
-    // This is more reliable in keyboard hook context
-    if (GetAsyncKeyState(VK_SHIFT) & 0x8000) {
-        keyState[VK_SHIFT] = 0x80;
-    }
-    if (GetAsyncKeyState(VK_CONTROL) & 0x8000) {
-        keyState[VK_CONTROL] = 0x80;
-    }
-    if (GetAsyncKeyState(VK_MENU) & 0x8000) {  // Alt key
-        keyState[VK_MENU] = 0x80;
+// Called on the UI thread (out-of-context WinEvent hook) when focus moves
+void CALLBACK OnFocusEvent(HWINEVENTHOOK, DWORD event, HWND hwnd, LONG, LONG, DWORD, DWORD) {
+    if (!g_app || !hwnd) {
+        return;
     }
+    g_app->focus_window = hwnd;
 
-    char buffer[2] = {};
-    int result = ToAscii(vkCode, MapVirtualKey(vkCode, MAPVK_VK_TO_VSC),
-                        keyState, reinterpret_cast<LPWORD>(buffer), 0);
-
-    if (result == 1) {
-        char ch = buffer[0];
-
-        // Add character to pattern matcher
-        auto match = g_app->pattern_matcher.AddChar(ch);
+    // Usually the table is ready before the first key in a new app
+    if (event == EVENT_SYSTEM_FOREGROUND) {
+        RequestLayoutTable(hwnd);
+    }
 
-        if (match) {
-            // Found a pattern! Check if we have a replacement
-            auto replacement = g_app->shortcuts_dict.FindReplacement(match->pattern);
+    // Per-app categories: a single mask store when another app comes to the foreground
+    if (event == EVENT_SYSTEM_FOREGROUND && !g_app->app_category_masks.empty()) {
+        auto it = g_app->app_category_masks.find(GetProcessName(hwnd));
+        g_app->input_engine.SetCategoryMask(it != g_app->app_category_masks.end() ? it->second
+                                                                                  : g_app->category_mask);
+    }
+}
 
-            if (replacement) {
+// Runs on the input engine's worker thread
+void OnEngineAction(const UniLang::EngineAction& action) {
+    if (!g_app) {
+        return;
+    }
 
-                // Show popup preview
-                if (g_app->settings_manager.GetSettings().show_popup) {
-                    g_app->popup_window.Show(
-                        match->pattern,
-                        *replacement,
-                        g_app->settings_manager.GetSettings().popup_duration_ms
-                    );
-                }
+    switch (action.type) {
+        case UniLang::EngineAction::Type::Replace:
+            // Show popup preview (rendered by the UI thread, never activated,
+            // so the replacement doesn't wait for it)
+            if (g_app->show_popup.load(std::memory_order_relaxed)) {
+                PostMessageW(g_app->main_window, WM_APP_SHOW_POPUP, 0,
+                             reinterpret_cast<LPARAM>(action.entry));
+            }
 
-                // Determine if this is a LaTeX pattern (starts with backslash)
-                bool isLatexPattern = (match->pattern.length() > 0 && match->pattern[0] == '\\');
-
-                // Always block the trigger key and use delays to handle timing
-                Sleep(50);
-
-                // Replace text
-                // For length == 1, we're in auto-convert mode (superscript/subscript)
-                // Just replace the current character without backspace
-                if (match->length == 1) {
-                    g_app->text_replacer.Replace(0, *replacement);
-                } else {
-                    // Use (length - 1) because trigger key is blocked
-                    // match->length includes the trigger key which hasn't been sent yet
-                    g_app->text_replacer.Replace(match->length - 1, *replacement);
-                }
+            g_app->text_replacer.Replace(action.backspaces, action.entry->utf16);
+            break;
 
-                // Don't reset pattern matcher if we're still in mode
-                if (!g_app->pattern_matcher.IsInSuperscriptMode() &&
-                    !g_app->pattern_matcher.IsInSubscriptMode()) {
-                    g_app->pattern_matcher.Reset();
-                }
+        case UniLang::EngineAction::Type::ReplayChar:
+            g_app->text_replacer.SendUnicodeText(std::u16string(1, action.ch));
+            break;
 
-                // ALWAYS block the trigger key
-                return true;
-            }
-            // Pattern detected but no replacement found - silently ignore
-        }
+        case UniLang::EngineAction::Type::ReplayKey:
+            g_app->text_replacer.SendKey(static_cast<WORD>(action.vk));
+            break;
     }
-
-    return false; // Don't block normal typing
 }
 
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
@@ -301,10 +440,46 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             }
             return 0;
 
+        case WM_APP_SHOW_POPUP:
+            if (g_app) {
+                CreatePopupWindow();
+                const auto* entry = reinterpret_cast<const UniLang::ShortcutsDict::Entry*>(lParam);
+                g_app->popup_window.Show(
+                    entry->shortcut,
+                    entry->replacement,
+                    g_app->settings_manager.GetSettings().popup_duration_ms
+                );
+            }
+            return 0;
+
+        case WM_APP_UPDATE_RESULT:
+        {
+            std::unique_ptr<UniLang::UpdateWorker::Result> result(
+                reinterpret_cast<UniLang::UpdateWorker::Result*>(lParam));
+            if (g_app) {
+                OnUpdateResult(hwnd, *result);
+            }
+            return 0;
+        }
+
+        case WM_APP_LAYOUT_READY:
+        {
+            std::unique_ptr<UniLang::KeyTranslator::LayoutTable> table(
+                reinterpret_cast<UniLang::KeyTranslator::LayoutTable*>(lParam));
+            if (g_app) {
+                g_app->key_translator.AddLayout(std::move(table));
+            }
+            return 0;
+        }
+
         case WM_TIMER:
-            if (wParam == TIMER_UPDATE_CHECK) {
+            if (wParam == TIMER_UPDATE_CHECK && g_app) {
                 // Periodic update check (every 7 days)
-                CheckForUpdatesAutomatic(hwnd, true);
+                g_app->update_worker.QueueCheck(UniLang::UpdateWorker::Mode::Notify);
+            } else if (wParam == TIMER_DEFERRED_INIT && g_app) {
+                KillTimer(hwnd, TIMER_DEFERRED_INIT);
+                CreatePopupWindow();
+                CreateHelpWindow();
             }
             return 0;
 
@@ -323,53 +498,17 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
                         break;
 
                     case 1003: // ID_TRAY_UPDATE
-                    {
-                        // Check for updates
-                        UniLang::UpdateManager update_mgr;
-                        auto version_info = update_mgr.CheckForUpdates("Aicua", "Unilang", UNILANG_VERSION_STRING);
-
-                        if (!update_mgr.GetLastError().empty()) {
-                            std::wstring error_msg = L"Failed to check for updates:\n\n";
-                            std::string error = update_mgr.GetLastError();
-                            error_msg += std::wstring(error.begin(), error.end());
-                            MessageBoxW(hwnd, error_msg.c_str(), L"Update Check Failed", MB_OK | MB_ICONERROR);
-                            break;
-                        }
-
-                        if (version_info.is_newer) {
-                            // New version available
-                            std::wstring msg = L"New version available: ";
-                            msg += std::wstring(version_info.version.begin(), version_info.version.end());
-                            msg += L"\n\nRelease Notes:\n";
-                            msg += std::wstring(version_info.release_notes.begin(), version_info.release_notes.end());
-                            msg += L"\n\nDo you want to download and install this update?";
-
-                            int result = MessageBoxW(hwnd, msg.c_str(), L"Update Available", MB_YESNO | MB_ICONINFORMATION);
-
-                            if (result == IDYES) {
-                                // Download and install update
-                                UniLang::AutoUpdater updater;
-                                if (!updater.DownloadAndInstall(version_info.download_url, version_info.shortcuts_url)) {
-                                    std::wstring error_msg = L"Failed to download update:\n\n";
-                                    std::string error = updater.GetLastError();
-                                    error_msg += std::wstring(error.begin(), error.end());
-                                    MessageBoxW(hwnd, error_msg.c_str(), L"Update Failed", MB_OK | MB_ICONERROR);
-                                }
-                                // Note: If successful, app will exit and restart automatically
-                            }
-                        } else {
-                            // No updates available
-                            MessageBoxW(hwnd,
-                                       L"You are already running the latest version!",
-                                       L"No Updates Available",
-                                       MB_OK | MB_ICONINFORMATION);
-                        }
+                        // Answered by WM_APP_UPDATE_RESULT; the menu stays responsive meanwhile
+                        g_app->update_worker.QueueCheck(UniLang::UpdateWorker::Mode::Interactive);
                         break;
-                    }
 
                     case 1004: // ID_TRAY_EXIT
                         DestroyWindow(hwnd);
                         break;
+
+                    case 1005: // ID_TRAY_DIAGNOSTICS
+                        SaveDiagnostics(hwnd);
+                        break;
                 }
             }
             return 0;
@@ -379,40 +518,110 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     }
 }
 
-// Automatically check for updates and show balloon notification if available
-void CheckForUpdatesAutomatic(HWND hwnd, bool show_notification) {
-    if (!g_app) return;
+// Report a finished update job according to how it was requested
+void OnUpdateResult(HWND hwnd, const UniLang::UpdateWorker::Result& result) {
+    using Mode = UniLang::UpdateWorker::Mode;
+    const bool interactive = result.mode == Mode::Interactive;
 
-    // Check for updates silently
-    UniLang::UpdateManager update_mgr;
-    auto version_info = update_mgr.CheckForUpdates("Aicua", "Unilang", UNILANG_VERSION_STRING);
+    if (result.type == UniLang::UpdateWorker::Result::Type::ShortcutsDiff) {
+        if (!result.files.empty()) {
+            ApplyShortcutsDiff(result.files.front());
+        }
+        return;
+    }
 
-    // Ignore errors in automatic check (silent failure)
-    if (!update_mgr.GetLastError().empty()) {
+    if (result.type == UniLang::UpdateWorker::Result::Type::Download) {
+        if (!result.error.empty()) {
+            if (interactive && !result.cancelled) {
+                std::wstring error_msg = L"Failed to download update:\n\n";
+                error_msg += std::wstring(result.error.begin(), result.error.end());
+                MessageBoxW(hwnd, error_msg.c_str(), L"Update Failed", MB_OK | MB_ICONERROR);
+            }
+            return;
+        }
+
+        // Note: If successful, app will exit and restart automatically
+        UniLang::AutoUpdater updater;
+        if (!updater.Install(updater.GetStagedExePath())) {
+            std::wstring error_msg = L"Failed to install update:\n\n";
+            std::string error = updater.GetLastError();
+            error_msg += std::wstring(error.begin(), error.end());
+            MessageBoxW(hwnd, error_msg.c_str(), L"Update Failed", MB_OK | MB_ICONERROR);
+        }
         return;
     }
 
-    // If new version is available, show balloon notification
-    if (version_info.is_newer && show_notification) {
-        // Prepare notification message
-        std::wstring title = L"UniLang Update Available";
-        std::wstring msg = L"Version ";
-        msg += std::wstring(version_info.version.begin(), version_info.version.end());
-        msg += L" is now available!\n\nRight-click the tray icon and select 'Check for Updates' to install.";
+    // Errors in automatic checks are ignored (silent failure)
+    if (!result.error.empty()) {
+        if (interactive && !result.cancelled) {
+            std::wstring error_msg = L"Failed to check for updates:\n\n";
+            error_msg += std::wstring(result.error.begin(), result.error.end());
+            MessageBoxW(hwnd, error_msg.c_str(), L"Update Check Failed", MB_OK | MB_ICONERROR);
+        }
+        return;
+    }
+
+    const UniLang::UpdateManager::VersionInfo& version_info = result.info;
+
+    // A diff from the running dictionary applies right away, with or without a new version
+    UniLang::Downloader::File shortcuts_diff =
+        UniLang::AutoUpdater().GetShortcutsDiffFile(version_info, g_app->shortcuts_dict->GetContentHash());
+    if (!shortcuts_diff.url.empty()) {
+        g_app->update_worker.QueueShortcutsDiff(std::move(shortcuts_diff), Mode::Silent);
+    }
+    if (!version_info.is_newer) {
+        if (interactive) {
+            MessageBoxW(hwnd,
+                       L"You are already running the latest version!",
+                       L"No Updates Available",
+                       MB_OK | MB_ICONINFORMATION);
+        }
+        return;
+    }
 
-        // Show balloon notification from system tray
-        NOTIFYICONDATAW nid = {};
-        nid.cbSize = sizeof(NOTIFYICONDATAW);
-        nid.hWnd = hwnd;
-        nid.uID = 1;
-        nid.uFlags = NIF_INFO;
-        nid.dwInfoFlags = NIIF_INFO;
+    if (result.mode == Mode::Notify) {
+        ShowUpdateNotification(hwnd, version_info.version);
+        return;
+    }
+    if (!interactive) {
+        return;
+    }
 
-        wcsncpy_s(nid.szInfoTitle, title.c_str(), _TRUNCATE);
-        wcsncpy_s(nid.szInfo, msg.c_str(), _TRUNCATE);
+    // New version available
+    std::wstring msg = L"New version available: ";
+    msg += std::wstring(version_info.version.begin(), version_info.version.end());
+    msg += L"\n\nRelease Notes:\n";
+    msg += std::wstring(version_info.release_notes.begin(), version_info.release_notes.end());
+    msg += L"\n\nDo you want to download and install this update?";
 
-        Shell_NotifyIconW(NIM_MODIFY, &nid);
+    if (MessageBoxW(hwnd, msg.c_str(), L"Update Available", MB_YESNO | MB_ICONINFORMATION) != IDYES) {
+        return;
     }
+
+    // Download in the background; Install runs when the result comes back
+    UniLang::AutoUpdater updater;
+    g_app->update_worker.QueueDownload(updater.GetReleaseFiles(version_info), Mode::Interactive);
+}
+
+// Show a balloon notification from the system tray
+void ShowUpdateNotification(HWND hwnd, const std::string& version) {
+    // Prepare notification message
+    std::wstring title = L"UniLang Update Available";
+    std::wstring msg = L"Version ";
+    msg += std::wstring(version.begin(), version.end());
+    msg += L" is now available!\n\nRight-click the tray icon and select 'Check for Updates' to install.";
+
+    NOTIFYICONDATAW nid = {};
+    nid.cbSize = sizeof(NOTIFYICONDATAW);
+    nid.hWnd = hwnd;
+    nid.uID = 1;
+    nid.uFlags = NIF_INFO;
+    nid.dwInfoFlags = NIIF_INFO;
+
+    wcsncpy_s(nid.szInfoTitle, title.c_str(), _TRUNCATE);
+    wcsncpy_s(nid.szInfo, msg.c_str(), _TRUNCATE);
+
+    Shell_NotifyIconW(NIM_MODIFY, &nid);
 }
 
 std::string GetExecutableDir() {
@@ -423,6 +632,33 @@ std::string GetExecutableDir() {
     return exe_path.parent_path().string();
 }
 
+// Lowercase executable file name of a window's process (e.g., "code.exe")
+std::string GetProcessName(HWND hwnd) {
+    DWORD processId = 0;
+    GetWindowThreadProcessId(hwnd, &processId);
+
+    wchar_t processPath[MAX_PATH] = {};
+    HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
+    if (!hProcess) {
+        return std::string();
+    }
+    DWORD size = MAX_PATH;
+    const BOOL ok = QueryFullProcessImageNameW(hProcess, 0, processPath, &size);
+    CloseHandle(hProcess);
+    if (!ok) {
+        return std::string();
+    }
+
+    const wchar_t* file = wcsrchr(processPath, L'\\');
+    file = file ? file + 1 : processPath;
+    char name[MAX_PATH] = {};
+    WideCharToMultiByte(CP_UTF8, 0, file, -1, name, MAX_PATH, nullptr, nullptr);
+
+    std::string lower(name);
+    std::transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+    return lower;
+}
+
 bool IsVSCodeWindow() {
     HWND foreground = GetForegroundWindow();
     if (!foreground) {
@@ -471,3 +707,130 @@ bool IsVSCodeWindow() {
 
     return false;
 }
+
+void UpdateCategoryMasks(AppState& app) {
+    const auto& settings = app.settings_manager.GetSettings();
+    app.category_mask = app.shortcuts_dict->GetCategoryMask(settings.disabled_categories);
+    app.app_category_masks.clear();
+    for (const auto& [exe, disabled] : settings.app_disabled_categories) {
+        std::string name = exe;
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        app.app_category_masks[name] = app.category_mask & app.shortcuts_dict->GetCategoryMask(disabled);
+    }
+}
+
+bool ReadShortcutsDiff(const std::string& path, UniLang::ShortcutsDict::Diff& diff) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return UniLang::ShortcutsDict::ParseDiff(contents.str(), diff);
+}
+
+void ApplyShortcutsDiff(const std::string& path) {
+    UniLang::ShortcutsDict::Diff diff;
+    auto updated = std::make_unique<UniLang::ShortcutsDict>();
+    const bool applied = ReadShortcutsDiff(path, diff) && updated->LoadFromDiff(*g_app->shortcuts_dict, diff);
+    std::error_code ec;
+    fs::remove(path, ec);  // Only a download; what persists is written below
+    if (!applied) {
+        return;  // Not for this dictionary; the next release brings the full file
+    }
+
+    // Save the whole way from the embedded dictionary, not this step: the next start
+    // begins from the embedded one, and this diff's base exists only in memory
+    std::string error;
+    UniLang::SettingsWriter::WriteFileAtomic(
+        UniLang::AutoUpdater().GetShortcutsDiffPath(),
+        UniLang::ShortcutsDict::DiffToJson(UniLang::ShortcutsDict::ComputeDiff(*g_app->builtin_dict, *updated)),
+        error);
+
+    // The keyboard hook runs on this thread, so no key event sees the swap half done
+    g_app->input_engine.SetDictionary(updated.get());
+    g_app->help_window.SetDictionary(updated.get());
+    g_app->retired_dicts.push_back(std::move(g_app->shortcuts_dict));
+    g_app->shortcuts_dict = std::move(updated);
+
+    // New categories get bits of their own; settings may name them
+    UpdateCategoryMasks(*g_app);
+    auto it = g_app->app_category_masks.find(GetProcessName(GetForegroundWindow()));
+    g_app->input_engine.SetCategoryMask(it != g_app->app_category_masks.end() ? it->second : g_app->category_mask);
+}
+
+// Write the engine's counters, latency histograms, flight recorder and startup phases next to the settings
+// (and the trace so far, in builds with tracing)
+void SaveDiagnostics(HWND hwnd) {
+    const std::string config_dir = GetExecutableDir() + "\\config\\";
+    std::vector<std::pair<std::string, std::string>> files = {
+        {config_dir + "diagnostics.json", g_app->input_engine.GetMetricsJson()},
+        {config_dir + "flight_recorder.bin", g_app->input_engine.GetFlightRecorder().Serialize()},
+        {config_dir + "startup.json", g_app->startup.ToJson()},
+    };
+    if (UniLang::Tracer::IsCompiledIn()) {
+        files.emplace_back(config_dir + "trace.json", UniLang::Tracer::ToChromeJson());
+    }
+
+    std::wstring message = L"Diagnostics saved to:\n";
+    bool ok = true;
+    for (const auto& [path, data] : files) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        file.close();
+
+        const std::wstring wpath(path.begin(), path.end());
+        if (!file) {
+            message = L"Failed to write " + wpath;
+            ok = false;
+            break;
+        }
+        message += wpath + L"\n";
+    }
+    MessageBoxW(hwnd, message.c_str(), L"UniLang Diagnostics", MB_OK | (ok ? MB_ICONINFORMATION : MB_ICONERROR));
+}
+
+// Windows startup leaves out. Each is created once: in the first pause in
+// typing (TIMER_DEFERRED_INIT), or earlier if something needs it.
+void CreatePopupWindow() {
+    if (g_app->popup_created) {
+        return;
+    }
+    g_app->popup_created = true;
+    g_app->startup.Restart();
+    if (!g_app->popup_window.Create(g_app->instance)) {
+        MessageBoxA(nullptr, "Failed to create popup window!", "UniLang - Warning", MB_OK | MB_ICONWARNING);
+        // Continue anyway - popup is optional
+    }
+    g_app->startup.Mark("popup window (deferred)");
+}
+
+void CreateHelpWindow() {
+    if (g_app->help_created) {
+        return;
+    }
+    g_app->help_created = true;
+    g_app->startup.Restart();
+    if (!g_app->help_window.Create(g_app->instance, g_app->shortcuts_dict.get())) {
+        MessageBoxA(nullptr, "Failed to create help window!", "UniLang - Warning", MB_OK | MB_ICONWARNING);
+        // Continue anyway - help is optional
+    }
+    g_app->startup.Mark("help window (deferred)");
+}
+
+// Build the table for a window's keyboard layout on a worker (ToUnicodeEx
+// 4096 times is too slow for the hook); it arrives as WM_APP_LAYOUT_READY
+void RequestLayoutTable(HWND window) {
+    HKL layout = GetKeyboardLayout(GetWindowThreadProcessId(window, nullptr));
+    auto layout_id = reinterpret_cast<UniLang::KeyTranslator::LayoutId>(layout);
+    if (!g_app->key_translator.RequestLayout(layout_id)) {
+        return;
+    }
+    std::thread([hwnd = g_app->main_window, layout_id] {
+        UNILANG_TRACE_THREAD("Layout worker");
+        auto table = UniLang::KeyTranslator::CreateSystemLayout(layout_id);
+        if (PostMessageW(hwnd, WM_APP_LAYOUT_READY, 0, reinterpret_cast<LPARAM>(table.get()))) {
+            table.release();
+        }
+    }).detach();
+}
@@ -0,0 +1,675 @@
+#include "math_converter.h"
+#include "latex_symbols.h"
+#include "shortcuts_dict.h"
+#include "symbol_families.h"
+#include "unicode_utils.h"
+
+namespace UniLang {
+
+namespace {
+
+bool IsAsciiLetter(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+}
+
+bool IsAsciiAlnum(char32_t cp) {
+    return (cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z');
+}
+
+bool IsAsciiOnly(const std::string& text) {
+    for (char ch : text) {
+        if (static_cast<unsigned char>(ch) >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IsSpace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n';
+}
+
+std::string_view Trim(std::string_view text) {
+    while (!text.empty() && IsSpace(text.front())) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && IsSpace(text.back())) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+size_t CountCodePoints(std::string_view text) {
+    size_t count = 0;
+    for (char ch : text) {
+        if ((static_cast<unsigned char>(ch) & 0xC0) != 0x80) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+// Multi-character operands of / and √ need parentheses unless they are a
+// plain word or number
+bool NeedsParens(std::string_view text) {
+    if (CountCodePoints(text) <= 1) {
+        return false;
+    }
+    for (char ch : text) {
+        if (static_cast<unsigned char>(ch) < 0x80 && !IsAsciiAlnum(static_cast<unsigned char>(ch))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IsDigits(std::string_view text) {
+    if (text.empty()) {
+        return false;
+    }
+    for (char ch : text) {
+        if (ch < '0' || ch > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AppendOperand(std::string& out, std::string_view operand) {
+    if (NeedsParens(operand)) {
+        out += '(';
+        out.append(operand.data(), operand.size());
+        out += ')';
+    } else {
+        out.append(operand.data(), operand.size());
+    }
+}
+
+} // namespace
+
+MathConverter::MathConverter(const ShortcutsDict& dict, const Options& options)
+    : m_dict(dict)
+    , m_options(options) {
+    m_frames.resize(MAX_DEPTH + 1);
+    Reset();
+}
+
+void MathConverter::Reset() {
+    m_lex = m_options.delimited ? Lex::Text : Lex::Math;
+    m_math_close = 0;
+    m_word.clear();
+    m_utf8_length = 0;
+    m_utf8_needed = 0;
+    m_newlines = 0;
+    m_drop_dot = false;
+    m_depth = 0;
+    m_frames[0].kind = Kind::Root;
+    m_spans = 0;
+}
+
+void MathConverter::Convert(std::string_view chunk, std::string& out) {
+    size_t i = 0;
+    while (i < chunk.size()) {
+        if (m_lex == Lex::Text) {
+            ConvertText(chunk, i, out);
+            continue;
+        }
+        MathByte(chunk[i++], out);
+    }
+}
+
+void MathConverter::Finish(std::string& out) {
+    switch (m_lex) {
+    case Lex::TextBackslash:
+        out += '\\';
+        break;
+    case Lex::TextDollar:
+        out += '$';
+        break;
+    case Lex::MathBackslash:
+        m_lex = Lex::Math;
+        EmitItem("\\", out);
+        break;
+    case Lex::MathWord:
+        m_lex = Lex::Math;
+        OnControlWord(m_word, out);
+        break;
+    default:
+        break;
+    }
+
+    // Truncated UTF-8 sequence: pass the bytes through
+    if (m_utf8_length > 0) {
+        const std::string_view bytes(m_utf8, m_utf8_length);
+        m_utf8_length = 0;
+        m_utf8_needed = 0;
+        EmitItem(bytes, out);
+    }
+
+    FlushFrames(out);
+    m_lex = m_options.delimited ? Lex::Text : Lex::Math;
+}
+
+void MathConverter::ConvertText(std::string_view chunk, size_t& i, std::string& out) {
+    // Copy plain text up to the next possible math delimiter in one go
+    const size_t next = chunk.find_first_of("$\\", i);
+    const size_t end = next == std::string_view::npos ? chunk.size() : next;
+    out.append(chunk.data() + i, end - i);
+    i = end;
+    if (i == chunk.size()) {
+        return;
+    }
+
+    m_lex = chunk[i] == '$' ? Lex::TextDollar : Lex::TextBackslash;
+    ++i;
+}
+
+void MathConverter::BeginMath(char close) {
+    m_math_close = close;
+    m_lex = Lex::Math;
+    m_newlines = 0;
+}
+
+void MathConverter::EndMath(std::string& out) {
+    FlushFrames(out);
+    m_lex = Lex::Text;
+    m_drop_dot = false;
+    ++m_spans;
+}
+
+void MathConverter::MathByte(char ch, std::string& out) {
+    switch (m_lex) {
+    case Lex::TextDollar:
+        if (ch == '$') {
+            BeginMath('D');
+            return;
+        }
+        BeginMath('$');
+        break;  // ch is the first byte of the math span
+
+    case Lex::TextBackslash:
+        if (ch == '(' || ch == '[') {
+            BeginMath(ch == '(' ? ')' : ']');
+        } else {
+            // Any other escape, including \$, is plain text
+            out += '\\';
+            out += ch;
+            m_lex = Lex::Text;
+        }
+        return;
+
+    case Lex::MathBackslash:
+        if (IsAsciiLetter(ch)) {
+            m_word.assign(1, ch);
+            m_lex = Lex::MathWord;
+        } else {
+            m_lex = Lex::Math;
+            OnControlSymbol(ch, out);
+        }
+        return;
+
+    case Lex::MathWord:
+        if (IsAsciiLetter(ch)) {
+            m_word += ch;
+            return;
+        }
+        m_lex = Lex::Math;
+        OnControlWord(m_word, out);
+        break;  // The terminating byte is processed as usual
+
+    case Lex::MathDollar:
+        EndMath(out);
+        if (ch == '$') {
+            return;
+        }
+        // A single '$' closed the $$ span; ch belongs to the text after it
+        Convert(std::string_view(&ch, 1), out);
+        return;
+
+    default:
+        break;
+    }
+
+    // Continuation of a multi-byte character
+    if (m_utf8_needed > 0) {
+        if ((static_cast<unsigned char>(ch) & 0xC0) == 0x80) {
+            m_utf8[m_utf8_length++] = ch;
+            if (m_utf8_length == m_utf8_needed) {
+                const std::string_view item(m_utf8, m_utf8_length);
+                m_utf8_length = 0;
+                m_utf8_needed = 0;
+                EmitItem(item, out);
+            }
+            return;
+        }
+        // Malformed: pass the partial sequence through and handle ch normally
+        const std::string_view bytes(m_utf8, m_utf8_length);
+        m_utf8_length = 0;
+        m_utf8_needed = 0;
+        EmitItem(bytes, out);
+    }
+
+    // Blank line: LaTeX doesn't allow one inside math, so an unbalanced
+    // delimiter or brace can't swallow the rest of the document
+    if (ch == '\n') {
+        if (++m_newlines >= 2) {
+            if (m_options.delimited) {
+                EndMath(out);
+                out += ch;
+                return;
+            }
+            FlushFrames(out);
+        }
+    } else if (ch != ' ' && ch != '\t' && ch != '\r') {
+        m_newlines = 0;
+    }
+
+    if (IsSpace(ch)) {
+        // Spaces between a command and its argument are not part of it
+        if (!AwaitingArgument()) {
+            AppendText(std::string_view(&ch, 1), out);
+        }
+        return;
+    }
+
+    const bool drop_dot = m_drop_dot;
+    m_drop_dot = false;
+
+    const unsigned char byte = static_cast<unsigned char>(ch);
+    if (byte >= 0xC0) {
+        m_utf8[0] = ch;
+        m_utf8_length = 1;
+        m_utf8_needed = byte >= 0xF0 ? 4 : byte >= 0xE0 ? 3 : 2;
+        return;
+    }
+
+    switch (ch) {
+    case '\\':
+        m_lex = Lex::MathBackslash;
+        return;
+    case '$':
+        if (m_math_close == '$') {
+            EndMath(out);
+        } else if (m_math_close == 'D') {
+            m_lex = Lex::MathDollar;
+        } else {
+            EmitItem("$", out);
+        }
+        return;
+    case '{':
+        OnOpenBrace();
+        return;
+    case '}':
+        OnCloseBrace(out);
+        return;
+    case '^':
+    case '_':
+        if (Top().literal || AwaitingArgument()) {
+            EmitItem(std::string_view(&ch, 1), out);
+        } else {
+            PushCommand(ch == '^' ? Kind::Superscript : Kind::Subscript, 1);
+        }
+        return;
+    case '[':
+        if (Top().kind == Kind::Sqrt && Top().arg_count == 0 && !Top().has_option) {
+            BeginArgument(']');
+        } else {
+            EmitItem("[", out);
+        }
+        return;
+    case ']':
+        if (Top().kind == Kind::Arg && Top().close == ']') {
+            CompleteArgument(out);
+        } else {
+            EmitItem("]", out);
+        }
+        return;
+    case '\'':
+        EmitItem(Top().literal ? "'" : "′", out);
+        return;
+    case '.':
+        if (!drop_dot) {
+            EmitItem(".", out);
+        }
+        return;
+    default:
+        EmitItem(std::string_view(&ch, 1), out);
+        return;
+    }
+}
+
+void MathConverter::OnControlWord(std::string_view name, std::string& out) {
+    if (const LatexCommand* command = FindLatexCommand(name)) {
+        switch (command->type) {
+        case LatexCommand::Type::Symbol:
+            EmitItem(command->text, out);
+            return;
+        case LatexCommand::Type::Operator:
+            EmitItem(name, out);
+            return;
+        case LatexCommand::Type::Accent:
+        case LatexCommand::Type::Style:
+            if (const SymbolFamily* family = FindSymbolFamily(name)) {
+                PushCommand(Kind::Family, 1);
+                if (Top().kind == Kind::Family) {
+                    Top().family = family;
+                }
+            } else {
+                PushCommand(Kind::Wrap, 1);
+            }
+            return;
+        case LatexCommand::Type::Fraction:
+            PushCommand(Kind::Frac, 2);
+            return;
+        case LatexCommand::Type::Root:
+            PushCommand(Kind::Sqrt, 1);
+            return;
+        case LatexCommand::Type::Text:
+            PushCommand(Kind::Text, 1);
+            return;
+        case LatexCommand::Type::Delimiter:
+            m_drop_dot = true;
+            return;
+        case LatexCommand::Type::Ignore:
+            return;
+        }
+    }
+
+    std::string key;
+    key.reserve(name.size() + 1);
+    key += '\\';
+    key.append(name.data(), name.size());
+
+    // Dictionary short forms (\al, \tim, ...); ASCII replacements are URLs, not symbols
+    const ShortcutsDict::Entry* entry = m_dict.FindEntry(key);
+    if (entry && !IsAsciiOnly(entry->replacement)) {
+        EmitItem(entry->replacement, out);
+        return;
+    }
+
+    EmitItem(key, out);
+}
+
+void MathConverter::OnControlSymbol(char ch, std::string& out) {
+    switch (ch) {
+    case '{': case '}': case '_': case '$': case '%': case '&': case '#': case '^':
+        EmitItem(std::string_view(&ch, 1), out);
+        return;
+    case ',':
+        EmitItem(" ", out);  // Thin space
+        return;
+    case ':': case ';': case ' ':
+        EmitItem(" ", out);
+        return;
+    case '!':
+        return;
+    case '|':
+        EmitItem("‖", out);
+        return;
+    case '\\':
+        AppendText(m_depth == 0 ? "\n" : " ", out);
+        return;
+    case ')': case ']':
+        if (m_options.delimited && m_math_close == ch) {
+            EndMath(out);
+        }
+        return;
+    case '(': case '[':
+        return;
+    default: {
+        const char item[2] = {'\\', ch};
+        EmitItem(std::string_view(item, 2), out);
+        return;
+    }
+    }
+}
+
+void MathConverter::OnOpenBrace() {
+    if (AwaitingArgument()) {
+        BeginArgument('}');
+        return;
+    }
+    if (m_depth + 1 > MAX_DEPTH) {
+        return;  // Too deep: the group's braces are dropped, its content kept
+    }
+
+    const bool literal = Top().literal;
+    Frame& frame = m_frames[++m_depth];
+    frame.kind = Kind::Group;
+    frame.close = '}';
+    frame.literal = literal;
+    frame.text.clear();
+}
+
+void MathConverter::OnCloseBrace(std::string& out) {
+    size_t target = m_depth;
+    while (target > 0 && m_frames[target].close != '}') {
+        --target;
+    }
+    if (target == 0) {
+        return;  // Stray '}'
+    }
+
+    // Close anything left open inside the group
+    while (m_depth > target) {
+        if (Top().kind == Kind::Arg) {
+            CompleteArgument(out);
+        } else {
+            CompleteFrame(out);
+        }
+    }
+
+    if (Top().kind == Kind::Arg) {
+        CompleteArgument(out);
+    } else {
+        CompleteFrame(out);
+    }
+}
+
+void MathConverter::EmitItem(std::string_view item, std::string& out) {
+    if (AwaitingArgument()) {
+        BeginArgument(0);
+    }
+    AppendText(item, out);
+
+    if (Top().kind == Kind::Arg && Top().close == 0) {
+        CompleteArgument(out);
+    }
+}
+
+void MathConverter::AppendText(std::string_view text, std::string& out) {
+    if (m_depth == 0) {
+        out.append(text.data(), text.size());
+    } else {
+        Top().text.append(text.data(), text.size());
+    }
+}
+
+void MathConverter::PushCommand(Kind kind, uint8_t args_needed) {
+    // Room for the command, its argument and an argument wrapping the command itself
+    if (m_depth + 3 > MAX_DEPTH) {
+        return;
+    }
+    if (AwaitingArgument()) {
+        BeginArgument(0);
+    }
+
+    const bool literal = Top().literal;
+    Frame& frame = m_frames[++m_depth];
+    frame.kind = kind;
+    frame.close = 0;
+    frame.literal = literal;
+    frame.args_needed = args_needed;
+    frame.arg_count = 0;
+    frame.has_option = false;
+    frame.family = nullptr;
+    frame.args[0].clear();
+    frame.args[1].clear();
+    frame.option.clear();
+}
+
+void MathConverter::BeginArgument(char close) {
+    const bool literal = Top().literal || Top().kind == Kind::Text;
+    Frame& frame = m_frames[++m_depth];
+    frame.kind = Kind::Arg;
+    frame.close = close;
+    frame.literal = literal;
+    frame.text.clear();
+}
+
+bool MathConverter::AwaitingArgument() const {
+    // Kinds after Arg are the constructs that take arguments
+    const Frame& top = Top();
+    return top.kind > Kind::Arg && top.arg_count < top.args_needed;
+}
+
+void MathConverter::CompleteArgument(std::string& out) {
+    Frame& arg = Top();
+    const bool option = arg.close == ']';
+    --m_depth;
+
+    Frame& command = Top();
+    if (option) {
+        command.option.swap(arg.text);
+        command.has_option = true;
+        return;
+    }
+
+    command.args[command.arg_count++].swap(arg.text);
+    if (command.arg_count == command.args_needed) {
+        CompleteFrame(out);
+    }
+}
+
+void MathConverter::CompleteFrame(std::string& out) {
+    const std::string rendered = Render(Top());
+    --m_depth;
+    EmitItem(rendered, out);
+}
+
+void MathConverter::FlushFrames(std::string& out) {
+    while (m_depth > 0) {
+        if (Top().kind == Kind::Arg) {
+            CompleteArgument(out);
+        } else {
+            CompleteFrame(out);
+        }
+    }
+}
+
+std::string MathConverter::Render(Frame& frame) const {
+    switch (frame.kind) {
+    case Kind::Superscript:
+    case Kind::Subscript:
+        if (frame.arg_count == 0) {
+            return frame.kind == Kind::Superscript ? "^" : "_";
+        }
+        return RenderScript(frame.args[0], frame.kind == Kind::Superscript);
+    case Kind::Frac:
+        return RenderFrac(frame.args[0], frame.args[1]);
+    case Kind::Sqrt:
+        return RenderSqrt(frame);
+    case Kind::Family:
+        return RenderFamily(frame);
+    case Kind::Text:
+    case Kind::Wrap:
+        return frame.args[0];
+    default:
+        return frame.text;
+    }
+}
+
+std::string MathConverter::RenderScript(const std::string& text, bool superscript) const {
+    std::string result;
+    result.reserve(text.size() * 3);
+
+    bool complete = true;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const char32_t cp = DecodeUtf8(text, pos);
+        if (cp == ' ' || cp == '\t' || cp == '\n' || cp == '\r') {
+            continue;  // Math mode ignores spaces
+        }
+        const char32_t script = superscript ? ToSuperscript(cp) : ToSubscript(cp);
+        if (script == 0) {
+            complete = false;
+            break;
+        }
+        AppendUtf8(result, script);
+    }
+    if (complete) {
+        return result;
+    }
+
+    // No Unicode form for some character: keep the script readable as ^(...) / _(...)
+    const std::string_view body = Trim(text);
+    result.assign(1, superscript ? '^' : '_');
+    if (CountCodePoints(body) == 1) {
+        result.append(body.data(), body.size());
+    } else {
+        result += '(';
+        result.append(body.data(), body.size());
+        result += ')';
+    }
+    return result;
+}
+
+std::string MathConverter::RenderFrac(const std::string& numerator, const std::string& denominator) const {
+    const std::string_view top = Trim(numerator);
+    const std::string_view bottom = Trim(denominator);
+
+    if (const char* vulgar = FindVulgarFraction(top, bottom)) {
+        return vulgar;
+    }
+
+    std::string result;
+    if (IsDigits(top) && IsDigits(bottom)) {
+        // ¹²⁄₃₅
+        result = RenderScript(std::string(top), true);
+        result += "⁄";
+        result += RenderScript(std::string(bottom), false);
+        return result;
+    }
+
+    AppendOperand(result, top);
+    result += '/';
+    AppendOperand(result, bottom);
+    return result;
+}
+
+std::string MathConverter::RenderSqrt(const Frame& frame) const {
+    std::string result;
+    const std::string_view index = Trim(frame.option);
+    if (!frame.has_option || index.empty() || index == "2") {
+        result = "√";
+    } else if (index == "3") {
+        result = "∛";
+    } else if (index == "4") {
+        result = "∜";
+    } else {
+        result = RenderScript(std::string(index), true);
+        result += "√";
+    }
+
+    AppendOperand(result, Trim(frame.args[0]));
+    return result;
+}
+
+std::string MathConverter::RenderFamily(const Frame& frame) const {
+    const std::string& text = frame.args[0];
+    std::string result;
+    result.reserve(text.size() * 4);
+
+    // Characters without a form in the family (operators, spaces) stay as they are
+    size_t pos = 0;
+    while (pos < text.size()) {
+        const size_t start = pos;
+        const char32_t cp = DecodeUtf8(text, pos);
+        if (!AppendSymbolFamilyChar(*frame.family, cp, result)) {
+            result.append(text, start, pos - start);
+        }
+    }
+    return result;
+}
+
+} // namespace UniLang
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace UniLang {
+
+class ShortcutsDict;
+struct SymbolFamily;
+
+/**
+ * @brief Streaming LaTeX math to Unicode converter
+ *
+ * Handles what the live matcher can't: grouped scripts (\sum_{i=1}^{n}),
+ * nested structure (\frac{1}{2}, \sqrt[3]{x}, \hat{x}) and full LaTeX
+ * command names. Output is the closest plain Unicode approximation:
+ * x^{2n} -> x²ⁿ, \frac{1}{2} -> ½, \frac{a+b}{c} -> (a+b)/c, and scripts
+ * with no Unicode form fall back to ^(...) / _(...).
+ *
+ * There is no syntax tree. A tokenizer state machine feeds a stack of open
+ * constructs; text only waits in the stack while a command still needs
+ * arguments, and everything else goes straight to the output. Each input
+ * byte is handled once per open nesting level, so conversion is linear in
+ * the input for bounded nesting (MAX_DEPTH). A blank line closes any
+ * constructs left open, so malformed input can't hold back a document.
+ *
+ * Symbols resolve through the built-in LaTeX names first (\inf and \deg
+ * are operators in LaTeX, not the dictionary's ∞ and °), then through the
+ * shortcuts dictionary; unknown commands are copied unchanged.
+ */
+class MathConverter {
+public:
+    struct Options {
+        bool delimited = false;     // Only convert inside $...$, $$...$$, \(...\) and \[...\]
+    };
+
+    static const size_t MAX_DEPTH = 64;
+
+    MathConverter(const ShortcutsDict& dict, const Options& options);
+
+    /**
+     * @brief Convert the next chunk of input (chunks may split anywhere)
+     * @param chunk Input bytes (UTF-8)
+     * @param out Converted text is appended here
+     */
+    void Convert(std::string_view chunk, std::string& out);
+
+    /**
+     * @brief Close anything still open at end of input
+     */
+    void Finish(std::string& out);
+
+    /**
+     * @brief Start over with a new stream
+     */
+    void Reset();
+
+    /**
+     * @brief Number of math spans converted (delimited mode)
+     */
+    uint64_t GetSpanCount() const { return m_spans; }
+
+private:
+    enum class Lex : uint8_t {
+        Text,               // Outside math (delimited mode)
+        TextBackslash,      // Outside math, after '\'
+        TextDollar,         // Outside math, after '$'
+        Math,
+        MathBackslash,      // After '\' in math
+        MathWord,           // Reading a control word
+        MathDollar,         // After '$' inside $$...$$
+    };
+
+    enum class Kind : uint8_t {
+        Root,
+        Group,              // {...} that is not an argument
+        Arg,                // Argument being collected for the frame below
+        // Constructs that take arguments (must stay after Arg)
+        Superscript,
+        Subscript,
+        Frac,
+        Sqrt,
+        Text,               // \text{...}: no script handling inside
+        Wrap,               // \mathrm{...} and friends: content as is
+        Family,             // \mathbb{...}, \hat{...}: each character mapped by a SymbolFamily
+    };
+
+    struct Frame {
+        Kind kind = Kind::Root;
+        char close = 0;             // Arg: '}' or ']' when delimited, 0 for a single token
+        bool literal = false;       // Inside \text: ^ and _ are plain characters
+        uint8_t args_needed = 0;
+        uint8_t arg_count = 0;
+        bool has_option = false;    // \sqrt[n]
+        const SymbolFamily* family = nullptr;  // Family: character mapping
+        std::string text;
+        std::string args[2];
+        std::string option;
+    };
+
+    void ConvertText(std::string_view chunk, size_t& i, std::string& out);
+    void MathByte(char ch, std::string& out);
+    void BeginMath(char close);
+    void EndMath(std::string& out);
+
+    void OnControlWord(std::string_view name, std::string& out);
+    void OnControlSymbol(char ch, std::string& out);
+    void OnOpenBrace();
+    void OnCloseBrace(std::string& out);
+
+    /**
+     * @brief Deliver one complete item (character, symbol or finished construct)
+     */
+    void EmitItem(std::string_view item, std::string& out);
+
+    /**
+     * @brief Append text that is not an item (whitespace) to the innermost frame
+     */
+    void AppendText(std::string_view text, std::string& out);
+
+    /**
+     * @brief Open a construct that takes arguments
+     */
+    void PushCommand(Kind kind, uint8_t args_needed);
+
+    /**
+     * @brief Open an argument frame if the top construct is waiting for one
+     */
+    void BeginArgument(char close);
+
+    bool AwaitingArgument() const;
+
+    /**
+     * @brief Pop the top frame (an argument) and hand its text to its construct
+     */
+    void CompleteArgument(std::string& out);
+
+    /**
+     * @brief Render the top frame, pop it and emit the result to the frame below
+     */
+    void CompleteFrame(std::string& out);
+
+    /**
+     * @brief Close every open frame with whatever it has (end of math or blank line)
+     */
+    void FlushFrames(std::string& out);
+
+    std::string Render(Frame& frame) const;
+    std::string RenderScript(const std::string& text, bool superscript) const;
+    std::string RenderFrac(const std::string& numerator, const std::string& denominator) const;
+    std::string RenderSqrt(const Frame& frame) const;
+    std::string RenderFamily(const Frame& frame) const;
+
+    Frame& Top() { return m_frames[m_depth]; }
+    const Frame& Top() const { return m_frames[m_depth]; }
+
+    const ShortcutsDict& m_dict;
+    Options m_options;
+
+    Lex m_lex = Lex::Math;
+    char m_math_close = 0;              // '$', 'D' ($$), ')' or ']' in delimited mode
+    std::string m_word;                 // Control word being read
+    char m_utf8[4] = {};                // Multi-byte character being read
+    uint8_t m_utf8_length = 0;
+    uint8_t m_utf8_needed = 0;
+    uint8_t m_newlines = 0;             // Consecutive line breaks (blank line closes frames)
+    bool m_drop_dot = false;            // After \left or \right, '.' is an empty delimiter
+
+    std::vector<Frame> m_frames;        // [0] is the root; reused to keep string capacity
+    size_t m_depth = 0;
+    uint64_t m_spans = 0;
+};
+
+} // namespace UniLang
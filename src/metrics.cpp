@@ -0,0 +1,75 @@
+#include "metrics.h"
+#include <thread>
+
+namespace UniLang {
+
+double TickClock::GetNanosecondsPerTick() {
+#ifdef UNILANG_HAVE_RDTSC
+    static const double ns_per_tick = []() {
+        const auto start_time = std::chrono::steady_clock::now();
+        const uint64_t start_ticks = Now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        const uint64_t ticks = Now() - start_ticks;
+        const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start_time).count());
+        return ticks == 0 ? 1.0 : ns / static_cast<double>(ticks);
+    }();
+    return ns_per_tick;
+#else
+    return 1.0;
+#endif
+}
+
+uint64_t LatencyHistogram::BucketHighestValue(size_t index) {
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    if (index >= BUCKET_COUNT - 1) {
+        return UINT64_MAX;
+    }
+    const uint32_t shift = static_cast<uint32_t>(index >> SUB_BUCKET_BITS) - 1;
+    const uint64_t lowest = (SUB_BUCKET_COUNT + (index & (SUB_BUCKET_COUNT - 1))) << shift;
+    return lowest + (uint64_t(1) << shift) - 1;
+}
+
+LatencyHistogram::Summary LatencyHistogram::GetSummary() const {
+    Summary summary;
+    summary.sum = m_sum.load(std::memory_order_relaxed);
+    summary.max = m_max.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+        const uint64_t count = m_counts[i].load(std::memory_order_relaxed);
+        if (count != 0) {
+            summary.buckets.emplace_back(BucketHighestValue(i), count);
+            summary.count += count;
+        }
+    }
+    return summary;
+}
+
+uint64_t LatencyHistogram::Summary::Percentile(double percentile) const {
+    if (count == 0) {
+        return 0;
+    }
+    // Rank of the value, 1-based; the last bucket is reported as the true maximum
+    const double rank = percentile / 100.0 * static_cast<double>(count);
+    uint64_t seen = 0;
+    for (const auto& [highest, bucket_count] : buckets) {
+        seen += bucket_count;
+        if (static_cast<double>(seen) >= rank) {
+            return highest < max ? highest : max;
+        }
+    }
+    return max;
+}
+
+uint64_t LatencyHistogram::Summary::CountAbove(uint64_t value) const {
+    uint64_t above = 0;
+    for (const auto& [highest, bucket_count] : buckets) {
+        if (highest >= value) {
+            above += bucket_count;
+        }
+    }
+    return above;
+}
+
+} // namespace UniLang
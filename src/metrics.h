@@ -0,0 +1,157 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define UNILANG_HAVE_RDTSC 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace UniLang {
+
+/**
+ * @brief Cheapest monotonic timestamp the CPU offers
+ *
+ * The time-stamp counter on x86 (a few ns to read, no system call),
+ * steady_clock nanoseconds elsewhere. Ticks are converted to nanoseconds
+ * only when results are reported.
+ */
+class TickClock {
+public:
+    static uint64_t Now() {
+#ifdef UNILANG_HAVE_RDTSC
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    /**
+     * @brief Nanoseconds per tick (measured against steady_clock once, ~10 ms on first call)
+     */
+    static double GetNanosecondsPerTick();
+};
+
+/**
+ * @brief Event counter with a single writing thread
+ *
+ * Add() is a relaxed load and store, not a locked read-modify-write; any
+ * thread may read the value.
+ */
+class Counter {
+public:
+    void Add(uint64_t n = 1) { m_value.store(m_value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    void Set(uint64_t value) { m_value.store(value, std::memory_order_relaxed); }
+    uint64_t Get() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> m_value{0};
+};
+
+/**
+ * @brief HDR-style latency histogram with a single writing thread
+ *
+ * Buckets are log-linear: values below 2^SUB_BUCKET_BITS get one bucket
+ * each, and every power of two above is split into 2^SUB_BUCKET_BITS
+ * equal buckets, so any recorded value is known to within 1/16 (6.25%)
+ * up to 2^MAX_BITS ticks (minutes), in a fixed 5 KB of counters. Record()
+ * is a bit scan and a handful of relaxed loads and stores, with no
+ * allocation; GetSummary() may run on any thread while recording goes on.
+ */
+class LatencyHistogram {
+public:
+    static const uint32_t SUB_BUCKET_BITS = 4;
+    static const uint32_t SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+    static const uint32_t MAX_BITS = 42;    // Larger values land in the last bucket
+    static const size_t BUCKET_COUNT = (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    struct Summary {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t max = 0;
+        std::vector<std::pair<uint64_t, uint64_t>> buckets;  // (highest value, count), non-empty buckets only
+
+        /**
+         * @brief Highest value of the bucket holding the given percentile (0-100)
+         */
+        uint64_t Percentile(double percentile) const;
+
+        /**
+         * @brief Number of values that may be at least `value` (whole buckets)
+         */
+        uint64_t CountAbove(uint64_t value) const;
+    };
+
+    void Record(uint64_t value) {
+        Bump(m_counts[BucketIndex(value)], 1);
+        Bump(m_count, 1);
+        Bump(m_sum, value);
+        if (value > m_max.load(std::memory_order_relaxed)) {
+            m_max.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t GetCount() const { return m_count.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Consistent-enough copy of the counters (exact once recording stops)
+     */
+    Summary GetSummary() const;
+
+    static size_t BucketIndex(uint64_t value) {
+        if (value < SUB_BUCKET_COUNT) {
+            return static_cast<size_t>(value);
+        }
+        if (value >> MAX_BITS) {
+            return BUCKET_COUNT - 1;
+        }
+        const uint32_t shift = HighestBit(value) - SUB_BUCKET_BITS;
+        return ((shift + 1) << SUB_BUCKET_BITS) + static_cast<size_t>((value >> shift) & (SUB_BUCKET_COUNT - 1));
+    }
+
+    /**
+     * @brief Highest value counted in a bucket
+     */
+    static uint64_t BucketHighestValue(size_t index);
+
+private:
+    static void Bump(std::atomic<uint64_t>& counter, uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    static uint32_t HighestBit(uint64_t value) {
+#ifdef _MSC_VER
+        unsigned long index;
+#ifdef _M_X64
+        _BitScanReverse64(&index, value);
+#else
+        if (!_BitScanReverse(&index, static_cast<unsigned long>(value >> 32))) {
+            _BitScanReverse(&index, static_cast<unsigned long>(value));
+            return index;
+        }
+        index += 32;
+#endif
+        return index;
+#else
+        return 63 - static_cast<uint32_t>(__builtin_clzll(value));
+#endif
+    }
+
+private:
+    std::atomic<uint64_t> m_counts[BUCKET_COUNT] = {};
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+} // namespace UniLang
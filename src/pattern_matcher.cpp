@@ -1,185 +1,551 @@
 #include "pattern_matcher.h"
+#include "rule_set.h"
+#include "shortcuts_dict.h"
+#include "symbol_families.h"
+#include "trigger_scan.h"
+#include "word_automaton.h"
 #include <algorithm>
 #include <cctype>
+#include <cstring>
 
 namespace UniLang {
 
+namespace {
+
+// Autocorrect walk states besides automaton states (WordAutomaton::NO_STATE: no word)
+const uint32_t WORD_MISS = WordAutomaton::NO_STATE - 1;    // Letters that no typo starts with
+const uint32_t WORD_STALE = WordAutomaton::NO_STATE - 2;   // Backspace: walk the buffer again
+
+} // namespace
+
 PatternMatcher::PatternMatcher() {
-    m_buffer.reserve(MAX_BUFFER_SIZE);
 }
 
 std::optional<PatternMatcher::Match> PatternMatcher::AddChar(char ch) {
-    // Add character to buffer
-    m_buffer += ch;
+    MatchView view;
+    if (!AddChar(ch, view)) {
+        return std::nullopt;
+    }
+
+    Match match;
+    match.pattern = std::string(view.Key());
+    match.start_pos = m_length - view.length;
+    match.length = view.length;
+    return match;
+}
+
+bool PatternMatcher::AddChar(char ch, MatchView& match) {
+    return AddChar(ch, match, TriggerGrammars::Default());
+}
+
+bool PatternMatcher::AddChar(char ch, MatchView& match, const TriggerGrammars& grammars) {
+    // Add character to buffer, keeping only the most recent MAX_BUFFER_SIZE bytes
+    if (m_length == MAX_BUFFER_SIZE) {
+        std::memmove(m_buffer, m_buffer + 1, MAX_BUFFER_SIZE - 1);
+        --m_length;
+    }
+    m_buffer[m_length++] = ch;
+
+    // A name opened under another dictionary's grammars can't continue
+    if (m_grammar >= grammars.GetCount()) {
+        m_grammar = TriggerGrammars::NO_GRAMMAR;
+        m_in_group = false;
+    }
 
-    // Keep buffer size limited
-    if (m_buffer.size() > MAX_BUFFER_SIZE) {
-        m_buffer = m_buffer.substr(m_buffer.size() - MAX_BUFFER_SIZE);
+    // Argument of \word{arg}: letters and digits until the closing brace
+    if (m_in_group) {
+        if (ch == '}') {
+            m_in_group = false;
+            const TriggerGrammars::Grammar& grammar = grammars.Get(m_grammar);
+            m_grammar = TriggerGrammars::NO_GRAMMAR;
+            return CheckFamilyPattern(match, grammar);
+        }
+        if (std::isalnum(static_cast<unsigned char>(ch))) {
+            return false;
+        }
+        m_in_group = false;  // Not a family argument: back to normal matching
+    } else if (ch == '{' && m_grammar != TriggerGrammars::NO_GRAMMAR && grammars.Get(m_grammar).symbol_families &&
+               !m_in_superscript_mode && !m_in_subscript_mode &&
+               m_length >= 3 && std::isalpha(static_cast<unsigned char>(m_buffer[m_length - 2]))) {
+        m_in_group = true;   // Stays in LaTeX mode until the closing brace
+        return false;
     }
 
-    // Enter LaTeX mode when backslash is typed
-    if (ch == '\\') {
-        m_in_latex_mode = true;
+    // Leave name mode on anything but a name character or the terminator
+    if (m_grammar != TriggerGrammars::NO_GRAMMAR && !grammars.ContinuesName(m_grammar, ch)) {
+        m_grammar = TriggerGrammars::NO_GRAMMAR;
     }
-    // Exit LaTeX mode if a non-alphabetic and non-space character is typed while in LaTeX mode
-    else if (m_in_latex_mode && !std::isalpha(static_cast<unsigned char>(ch)) && ch != ' ') {
-        m_in_latex_mode = false;
+    // Enter name mode when an opener is complete (one table lookup for most bytes)
+    if (m_grammar == TriggerGrammars::NO_GRAMMAR) {
+        m_grammar = grammars.FindOpener(m_buffer, m_length);
     }
 
     // Special handling for mode control
     // Check if entering superscript/subscript mode with ^( or _(
-    if (m_buffer.size() >= 2) {
-        std::string last_two = m_buffer.substr(m_buffer.size() - 2);
-        if (last_two == "^(") {
+    if (m_length >= 2 && ch == '(') {
+        const char prev = m_buffer[m_length - 2];
+        if (prev == '^') {
             m_in_superscript_mode = true;
             // Return match for ^( to convert it to ⁽
-            Match match;
-            match.pattern = "^(";
-            match.start_pos = m_buffer.size() - 2;
-            match.length = 2;
-            return match;
-        } else if (last_two == "_(") {
+            SetMatchFromBuffer(match, 2, 2);
+            return true;
+        } else if (prev == '_') {
             m_in_subscript_mode = true;
             // Return match for _( to convert it to ₍
-            Match match;
-            match.pattern = "_(";
-            match.start_pos = m_buffer.size() - 2;
-            match.length = 2;
-            return match;
+            SetMatchFromBuffer(match, 2, 2);
+            return true;
         }
     }
 
     // If we're in superscript/subscript mode, handle closing parenthesis
     if (ch == ')' && (m_in_superscript_mode || m_in_subscript_mode)) {
         // Create a synthetic pattern to convert ) to ⁾ or ₎
-        Match match;
-        match.pattern = m_in_superscript_mode ? "^)" : "_)";
-        match.start_pos = m_buffer.size() - 1;
+        match.key[0] = m_in_superscript_mode ? '^' : '_';
+        match.key[1] = ')';
+        match.key_length = 2;
         match.length = 1;
 
         // Exit mode
         m_in_superscript_mode = false;
         m_in_subscript_mode = false;
 
-        return match;
+        return true;
     }
 
     // If we're in superscript/subscript mode, auto-convert characters
     if (m_in_superscript_mode || m_in_subscript_mode) {
         // Create synthetic pattern for auto-conversion
-        std::string prefix = m_in_superscript_mode ? "^" : "_";
-        Match match;
-        match.pattern = prefix + std::string(1, ch);
-        match.start_pos = m_buffer.size() - 1;
+        match.key[0] = m_in_superscript_mode ? '^' : '_';
+        match.key[1] = ch;
+        match.key_length = 2;
         match.length = 1;
-        return match;
+        return true;
     }
 
     // Check for pattern matches (normal mode)
-    return CheckForMatch();
+    return CheckForMatch(match, grammars);
+}
+
+PatternMatcher::FeedResult PatternMatcher::Feed(
+    std::string_view text,
+    const ShortcutsDict& dict,
+    FeedMatch* out,
+    size_t capacity,
+    uint64_t categories
+) {
+    FeedResult result;
+    MatchView view;
+    const RuleSet& rules = dict.GetRules();
+    const TriggerGrammars& grammars = dict.GetGrammars();
+    const std::string_view trigger_bytes = grammars.GetTriggerBytes();
+    const WordAutomaton& words = dict.GetWords();
+    const bool has_rules = !rules.Empty();
+    const bool has_words = !words.Empty();
+    const bool has_families = ShortcutsDict::IsEnabled(categories, dict.GetFamilyCategory());
+
+    size_t next_trigger = 0;        // Next trigger byte at or after the last search
+    bool trigger_known = false;
+
+    size_t i = 0;
+    for (; i < text.size(); ++i) {
+        // Each byte yields at most one match; stop while a slot is still guaranteed
+        if (result.match_count == capacity) {
+            break;
+        }
+
+        // Nothing in progress: no match is possible before the next trigger byte,
+        // and the skipped text can't be part of any later pattern
+        if (IsIdle()) {
+            // Rules and words stop the skip early, so the search result is reused until passed
+            if (!trigger_known || next_trigger < i) {
+                next_trigger = i + FindTriggerByte(text.data() + i, text.size() - i, trigger_bytes);
+                trigger_known = true;
+            }
+            size_t next = next_trigger;
+            if (has_words && next != i) {
+                // Words and rules still see every byte; a byte where one fires takes the slow path
+                next = i + ScanWords(words, has_rules ? &rules : nullptr, text.substr(i, next - i), categories);
+            } else if (has_rules && next != i) {
+                next = i + ScanRules(rules, text.substr(i, next - i), categories);
+            }
+            if (next != i) {
+                m_length = 0;
+                i = next;
+                if (i == text.size()) {
+                    break;
+                }
+            }
+        }
+
+        const char ch = text[i];
+
+        // Line breaks and tabs reset the buffer, like Enter/Tab while typing
+        if (ch == '\n' || ch == '\r' || ch == '\t') {
+            Reset();
+            continue;
+        }
+
+        // Non-ASCII bytes can never be part of a pattern (same as live typing)
+        const char fed = static_cast<unsigned char>(ch) < 0x80 ? ch : '\x7F';
+        uint32_t entry_id = ShortcutsDict::INVALID_ENTRY_ID;
+        if (AddChar(fed, view, grammars)) {
+            entry_id = dict.FindEntryId(view.Key(), categories);
+            if (entry_id == ShortcutsDict::INVALID_ENTRY_ID && has_families && IsSymbolFamilyKey(view.Key())) {
+                entry_id = FAMILY_ENTRY_ID;
+            }
+        }
+
+        if (entry_id != ShortcutsDict::INVALID_ENTRY_ID) {
+            FeedMatch& match = out[result.match_count++];
+            match.position = m_stream_pos + i + 1 - view.length;
+            match.length = view.length;
+            match.entry_id = entry_id;
+
+            // Don't reset if we're still in a ^( or _( group
+            if (!m_in_superscript_mode && !m_in_subscript_mode) {
+                ResetPattern();
+            }
+            continue;
+        }
+
+        if (has_rules) {
+            const uint32_t rule = StepRules(rules, grammars, fed, categories);
+            if (rule != RuleSet::NO_RULE) {
+                // A trigger character is not part of the replaced text
+                const uint64_t end = m_stream_pos + i + (rules.HasTrigger(rule) ? 0 : 1);
+                FeedMatch& match = out[result.match_count++];
+                match.position = end - rules.GetMatchLength(rule);
+                match.length = rules.GetMatchLength(rule);
+                match.entry_id = dict.GetRuleEntryId(rule);
+                continue;
+            }
+        }
+
+        if (has_words && StepWords(words, grammars, fed, view, categories) != WordAutomaton::NO_WORD) {
+            // The boundary is not part of the replaced word
+            FeedMatch& match = out[result.match_count++];
+            match.position = m_stream_pos + i - view.length;
+            match.length = view.length;
+            match.entry_id = WORD_ENTRY_ID;
+        }
+    }
+
+    m_stream_pos += i;
+    result.consumed = i;
+    return result;
 }
 
 void PatternMatcher::Reset() {
-    m_buffer.clear();
+    ResetPattern();
+    m_rule_state = RuleSet::START_STATE;
+    m_word_state = WordAutomaton::ROOT;  // A line start is a word boundary
+}
+
+void PatternMatcher::ResetPattern() {
+    m_length = 0;
     m_in_superscript_mode = false;
     m_in_subscript_mode = false;
-    m_in_latex_mode = false;
+    m_grammar = TriggerGrammars::NO_GRAMMAR;
+    m_in_group = false;
+    m_rule_state = RuleSet::GetResumeState(m_rule_state);
+    // The replacement may end in letters: no word starts before the next boundary
+    m_word_state = WordAutomaton::NO_STATE;
+    m_word_length = 0;
 }
 
 void PatternMatcher::RemoveLastChar() {
-    if (!m_buffer.empty()) {
-        m_buffer.pop_back();
+    if (m_length > 0) {
+        if (m_buffer[m_length - 1] == '{') {
+            m_in_group = false;
+        }
+        --m_length;
+    }
+    // The DFA can't step back; continue without left context
+    m_rule_state = RuleSet::GetResumeState(m_rule_state);
+
+    // The word walk can: it is walked again over the buffer on the next character
+    if (m_word_state == WordAutomaton::NO_STATE) {
+        return;
+    }
+    if (m_word_length == 0) {
+        m_word_state = WordAutomaton::NO_STATE;  // The boundary is gone; the word before it is unknown
+    } else if (--m_word_length == 0) {
+        m_word_state = WordAutomaton::ROOT;
+    } else {
+        m_word_state = WORD_STALE;
     }
 }
 
-std::optional<PatternMatcher::Match> PatternMatcher::CheckForMatch() {
-    // Try different pattern types in priority order
+uint32_t PatternMatcher::StepRules(const RuleSet& rules, const TriggerGrammars& grammars, char ch,
+                                   uint64_t categories) {
+    const uint32_t previous = m_rule_state;
+    const uint32_t state = rules.Step(previous, static_cast<unsigned char>(ch));
+    const uint32_t rule = FiringRule(rules, state, categories);
+    if (rule == RuleSet::NO_RULE) {
+        m_rule_state = state;
+        return rule;
+    }
 
-    // 1. LaTeX-style patterns: \word (highest priority)
-    auto latex_match = CheckLatexPattern();
-    if (latex_match) return latex_match;
+    // The replaced text is gone: patterns restart after it
+    ResetPattern();
+    if (rules.HasTrigger(rule)) {
+        // The trigger is typed again after the replacement
+        m_rule_state = rules.Step(RuleSet::GetResumeState(previous), static_cast<unsigned char>(ch));
+        m_buffer[m_length++] = ch;
+        m_grammar = grammars.FindOpener(m_buffer, m_length);
+        RestartWord(ch);
+    } else {
+        m_rule_state = RuleSet::GetResumeState(state);
+    }
+    return rule;
+}
 
-    // 2. Superscript: ^digit
-    auto super_match = CheckSuperscriptPattern();
-    if (super_match) return super_match;
+uint32_t PatternMatcher::StepWords(const WordAutomaton& words, const TriggerGrammars& grammars, char ch,
+                                   MatchView& match, uint64_t categories) {
+    if (m_word_state == WORD_STALE) {
+        RefreshWord(words, m_length - 1);  // AddChar already buffered ch
+    }
+    if (!WordFiresOn(words, ch, categories)) {
+        AdvanceWord(words, ch);
+        return WordAutomaton::NO_WORD;
+    }
 
-    // 3. Subscript: _digit
-    auto sub_match = CheckSubscriptPattern();
-    if (sub_match) return sub_match;
+    const uint32_t index = m_word_index;
+    const size_t length = m_word_length;
+    match.key_length = 0;
+    match.length = static_cast<uint8_t>(length);
+    if (length < m_length) {
+        std::memcpy(match.key, m_buffer + m_length - 1 - length, length);
+        match.key_length = static_cast<uint8_t>(length);
+    }
 
-    return std::nullopt;
+    // The replaced word is gone; the boundary is typed again after the correction.
+    // The rules already stepped past it, and a correction is still a word.
+    const uint32_t rule_state = m_rule_state;
+    ResetPattern();
+    m_rule_state = rule_state;
+    m_buffer[m_length++] = ch;
+    m_grammar = grammars.FindOpener(m_buffer, m_length);
+    RestartWord(ch);
+    return index;
 }
 
-std::optional<PatternMatcher::Match> PatternMatcher::CheckLatexPattern() {
-    // Look for pattern: \<alphabetic_characters> + SPACE
-    // SIMPLE SPACE-TRIGGERED: Only trigger when user presses space
-    // Examples: \alpha + space → α, \int + space → ∫
+size_t PatternMatcher::GetWordLength() const {
+    return m_word_state == WordAutomaton::NO_STATE ? 0 : m_word_length;
+}
 
-    if (m_buffer.empty()) {
-        return std::nullopt;
+bool PatternMatcher::WordFiresOn(const WordAutomaton& words, char ch, uint64_t categories) const {
+    // The walk goes on while autocorrect is switched off, so switching it back on mid-word works
+    return WordAutomaton::IsBoundary(ch) && m_word_length > 0 && m_word_state < WORD_STALE &&
+           words.IsFinal(m_word_state) && static_cast<WordAutomaton::Case>(m_word_case) != WordAutomaton::Case::Mixed &&
+           ShortcutsDict::IsEnabled(categories, words.GetCategory());
+}
+
+uint32_t PatternMatcher::FiringRule(const RuleSet& rules, uint32_t state, uint64_t categories) {
+    // A switched-off rule doesn't fire; the DFA keeps only the earliest rule per state,
+    // so a later rule completing on the same byte doesn't fire in its place
+    const uint32_t rule = rules.GetFiringRule(state);
+    if (rule != RuleSet::NO_RULE && !ShortcutsDict::IsEnabled(categories, rules.GetRule(rule).category)) {
+        return RuleSet::NO_RULE;
     }
+    return rule;
+}
 
-    char last_char = m_buffer.back();
+void PatternMatcher::AdvanceWord(const WordAutomaton& words, char ch) {
+    // Line breaks and tabs reset like Enter/Tab: a new word may start, nothing fires
+    if (WordAutomaton::IsBoundary(ch) || ch == '\n' || ch == '\r' || ch == '\t') {
+        m_word_state = WordAutomaton::ROOT;
+        m_word_length = 0;
+        return;
+    }
+    if (m_word_state == WordAutomaton::NO_STATE) {
+        return;  // Until the next boundary
+    }
+    if (!WordAutomaton::IsWordChar(ch)) {
+        m_word_state = WordAutomaton::NO_STATE;  // Digits, '^', '_', non-ASCII: not a word
+        return;
+    }
 
-    // ONLY trigger on SPACE
-    if (last_char != ' ') {
-        return std::nullopt;
+    if (m_word_length == 0) {
+        if (ch == '\'') {
+            return;  // Opening quote: still at the boundary
+        }
+        if (m_grammar != TriggerGrammars::NO_GRAMMAR) {
+            m_word_state = WordAutomaton::NO_STATE;  // A shortcut name, not a word
+            return;
+        }
+        m_word_index = 0;
     }
 
-    // Find backslash before the space
-    size_t backslash_pos = m_buffer.rfind('\\');
-    if (backslash_pos == std::string::npos) {
-        return std::nullopt;
+    if (m_word_length == WordAutomaton::MAX_WORD_LENGTH) {
+        m_word_state = WordAutomaton::NO_STATE;  // Longer than any typo
+        return;
+    }
+    m_word_case = static_cast<uint8_t>(
+        WordAutomaton::StepCase(static_cast<WordAutomaton::Case>(m_word_case), m_word_length, ch));
+    ++m_word_length;
+    // Keep counting letters after a miss, so Backspace can bring the word back
+    if (m_word_state != WORD_MISS) {
+        m_word_state = words.Step(m_word_state, ch, m_word_index);
+        if (m_word_state == WordAutomaton::NO_STATE) {
+            m_word_state = WORD_MISS;
+        }
     }
+}
 
-    // Must have at least \xx + space (minimum: "\in " = 4 chars)
-    if (m_buffer.size() - backslash_pos < 4) {
-        // Exit LaTeX mode - pattern too short or invalid
-        m_in_latex_mode = false;
-        return std::nullopt;
+void PatternMatcher::RefreshWord(const WordAutomaton& words, size_t end) {
+    // Walk the letters left after Backspace again; they are still in the buffer
+    const size_t length = m_word_length;
+    if (length > end) {
+        m_word_state = WordAutomaton::NO_STATE;
+        return;
     }
+    m_word_state = WordAutomaton::ROOT;
+    m_word_index = 0;
+    for (size_t i = 0; i < length && m_word_state != WORD_MISS; ++i) {
+        const char typed = m_buffer[end - length + i];
+        m_word_case = static_cast<uint8_t>(
+            WordAutomaton::StepCase(static_cast<WordAutomaton::Case>(m_word_case), i, typed));
+        m_word_state = words.Step(m_word_state, typed, m_word_index);
+        if (m_word_state == WordAutomaton::NO_STATE) {
+            m_word_state = WORD_MISS;
+        }
+    }
+}
 
-    // Extract pattern WITHOUT the space
-    std::string potential_pattern = m_buffer.substr(backslash_pos, m_buffer.size() - backslash_pos - 1);
+void PatternMatcher::RestartWord(char ch) {
+    m_word_state = WordAutomaton::IsBoundary(ch) ? WordAutomaton::ROOT : WordAutomaton::NO_STATE;
+    m_word_length = 0;
+}
 
-    // Verify all chars after backslash are alphabetic
-    for (size_t i = 1; i < potential_pattern.size(); ++i) {
-        if (!std::isalpha(static_cast<unsigned char>(potential_pattern[i]))) {
-            // Exit LaTeX mode - invalid pattern
-            m_in_latex_mode = false;
-            return std::nullopt; // Invalid pattern
+size_t PatternMatcher::ScanRules(const RuleSet& rules, std::string_view text, uint64_t categories) {
+    uint32_t state = m_rule_state;
+    size_t i = 0;
+    for (; i < text.size(); ++i) {
+        const uint32_t next = rules.Step(state, static_cast<unsigned char>(text[i]));
+        if (FiringRule(rules, next, categories) != RuleSet::NO_RULE) {
+            break;
         }
+        state = next;
     }
+    m_rule_state = state;
+    return i;
+}
 
-    // Valid LaTeX pattern found!
-    if (potential_pattern.size() >= 3) {  // At least \xx
-        // Exit LaTeX mode - pattern matched
-        m_in_latex_mode = false;
+size_t PatternMatcher::ScanWords(const WordAutomaton& words, const RuleSet* rules, std::string_view text,
+                                 uint64_t categories) {
+    uint32_t rule_state = m_rule_state;
+    size_t i = 0;
+    for (; i < text.size(); ++i) {
+        const char ch = text[i];
+        uint32_t next = rule_state;
+        if (rules != nullptr) {
+            next = rules->Step(rule_state, static_cast<unsigned char>(ch));
+            if (FiringRule(*rules, next, categories) != RuleSet::NO_RULE) {
+                break;
+            }
+        }
+        if (WordFiresOn(words, ch, categories)) {
+            break;
+        }
+        rule_state = next;
+        AdvanceWord(words, ch);
+    }
+    m_rule_state = rule_state;
+    return i;
+}
 
-        Match match;
-        match.pattern = potential_pattern;
-        match.start_pos = backslash_pos;
-        // Length includes the space trigger
-        match.length = potential_pattern.size() + 1;
-        return match;
+bool PatternMatcher::IsIdle() const {
+    if (m_in_superscript_mode || m_in_subscript_mode || m_grammar != TriggerGrammars::NO_GRAMMAR) {
+        return false;
     }
+    // A trailing ^ or _ still waits for its argument
+    return m_length == 0 || (m_buffer[m_length - 1] != '^' && m_buffer[m_length - 1] != '_');
+}
 
-    // Exit LaTeX mode - pattern too short
-    m_in_latex_mode = false;
-    return std::nullopt;
+void PatternMatcher::SetMatchFromBuffer(MatchView& match, size_t key_length, size_t length) const {
+    std::memcpy(match.key, m_buffer + m_length - length, key_length);
+    match.key_length = static_cast<uint8_t>(key_length);
+    match.length = static_cast<uint8_t>(length);
 }
 
-std::optional<PatternMatcher::Match> PatternMatcher::CheckSuperscriptPattern() {
+bool PatternMatcher::SetGrammarMatch(MatchView& match, const TriggerGrammars::Grammar& grammar,
+                                     size_t name_start, size_t name_end) const {
+    const size_t prefix_length = grammar.key_prefix.size();
+    const size_t name_length = name_end - name_start;
+    if (prefix_length + name_length > MAX_BUFFER_SIZE) {
+        return false;
+    }
+
+    std::memcpy(match.key, grammar.key_prefix.data(), prefix_length);
+    std::memcpy(match.key + prefix_length, m_buffer + name_start, name_length);
+    match.key_length = static_cast<uint8_t>(prefix_length + name_length);
+    // Everything typed from the opener on, including a terminator after the name
+    match.length = static_cast<uint8_t>(m_length - name_start + grammar.opener.size());
+    return true;
+}
+
+bool PatternMatcher::CheckForMatch(MatchView& match, const TriggerGrammars& grammars) {
+    // Try different pattern types in priority order
+
+    // 1. Named patterns: \word, :name:, ... (highest priority)
+    if (CheckGrammarPattern(match, grammars)) return true;
+
+    // 2. Superscript: ^digit
+    if (CheckSuperscriptPattern(match)) return true;
+
+    // 3. Subscript: _digit
+    if (CheckSubscriptPattern(match)) return true;
+
+    return false;
+}
+
+bool PatternMatcher::CheckGrammarPattern(MatchView& match, const TriggerGrammars& grammars) {
+    // Look for pattern: <opener><name characters><terminator>
+    // Examples: \alpha + space → α, :smile: → 😄, ;;addr + space → snippet
+    // Only terminator bytes get past the table lookup
+
+    if (!grammars.IsTerminator(m_buffer[m_length - 1])) {
+        return false;
+    }
+
+    // Name mode ends here, though the terminator may open the next name (":a:b:")
+    m_grammar = grammars.FindOpener(m_buffer, m_length);
+
+    size_t name_start = 0;
+    const uint8_t grammar = grammars.FindName(m_buffer, m_length, name_start);
+    if (grammar == TriggerGrammars::NO_GRAMMAR) {
+        return false;
+    }
+
+    // Length includes the terminator
+    return SetGrammarMatch(match, grammars.Get(grammar), name_start, m_length - 1);
+}
+
+bool PatternMatcher::CheckFamilyPattern(MatchView& match, const TriggerGrammars::Grammar& grammar) {
+    // Look for pattern: \<alphabetic_characters>{<letters and digits>}
+    // Examples: \mathbb{R} → ℝ, \hat{a} → â (IsSymbolFamilyKey decides which names are families)
+
+    const std::string_view buffer = GetBuffer();
+    const size_t opener_pos = buffer.rfind(grammar.opener);
+    if (opener_pos == std::string::npos) {
+        return false;  // Start of the pattern scrolled out of the buffer
+    }
+
+    return SetGrammarMatch(match, grammar, opener_pos + grammar.opener.size(), m_length);
+}
+
+bool PatternMatcher::CheckSuperscriptPattern(MatchView& match) {
     // Look for pattern: ^<digit, letter, or special char>
     // Examples: ^2, ^3, ^n, ^a, ^b, ^+, ^-, ^/
 
-    if (m_buffer.size() < 2) {
-        return std::nullopt;
+    if (m_length < 2) {
+        return false;
     }
 
     // Check last 2 characters
-    if (m_buffer[m_buffer.size() - 2] == '^') {
-        char last_char = m_buffer.back();
+    if (m_buffer[m_length - 2] == '^') {
+        char last_char = m_buffer[m_length - 1];
 
         // Valid superscript chars: 0-9, a-z, A-Z, +, -, =, (, ), /
         if (std::isalnum(static_cast<unsigned char>(last_char)) ||
@@ -190,28 +556,25 @@ std::optional<PatternMatcher::Match> PatternMatcher::CheckSuperscriptPattern() {
             last_char == ')' ||
             last_char == '/') {
 
-            Match match;
-            match.pattern = m_buffer.substr(m_buffer.size() - 2);
-            match.start_pos = m_buffer.size() - 2;
-            match.length = 2;
-            return match;
+            SetMatchFromBuffer(match, 2, 2);
+            return true;
         }
     }
 
-    return std::nullopt;
+    return false;
 }
 
-std::optional<PatternMatcher::Match> PatternMatcher::CheckSubscriptPattern() {
+bool PatternMatcher::CheckSubscriptPattern(MatchView& match) {
     // Look for pattern: _<digit, letter, or special char>
     // Examples: _1, _2, _a, _e, _+, _-, _/
 
-    if (m_buffer.size() < 2) {
-        return std::nullopt;
+    if (m_length < 2) {
+        return false;
     }
 
     // Check last 2 characters
-    if (m_buffer[m_buffer.size() - 2] == '_') {
-        char last_char = m_buffer.back();
+    if (m_buffer[m_length - 2] == '_') {
+        char last_char = m_buffer[m_length - 1];
 
         // Valid subscript chars: 0-9, a-z, +, -, =, (, ), /
         if (std::isalnum(static_cast<unsigned char>(last_char)) ||
@@ -222,15 +585,12 @@ std::optional<PatternMatcher::Match> PatternMatcher::CheckSubscriptPattern() {
             last_char == ')' ||
             last_char == '/') {
 
-            Match match;
-            match.pattern = m_buffer.substr(m_buffer.size() - 2);
-            match.start_pos = m_buffer.size() - 2;
-            match.length = 2;
-            return match;
+            SetMatchFromBuffer(match, 2, 2);
+            return true;
         }
     }
 
-    return std::nullopt;
+    return false;
 }
 
 } // namespace UniLang
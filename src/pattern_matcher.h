@@ -1,26 +1,91 @@
 #pragma once
 
+#include "trigger_grammar.h"
 #include <string>
+#include <string_view>
 #include <optional>
+#include <cstdint>
 
 namespace UniLang {
 
+class ShortcutsDict;
+class RuleSet;
+class WordAutomaton;
+
 /**
  * @brief Detects patterns in typed text that should be converted
  *
  * Patterns:
- * - LaTeX-style: \alpha, \beta, etc.
+ * - Named shortcuts: \alpha, :smile:, ;;addr, etc. (see TriggerGrammars)
  * - Superscript: x^2, y^a, x^n, etc. (digits and letters)
  * - Subscript: x_1, y_a, x_n, etc. (digits and letters)
+ * - Symbol family: \mathbb{R}, \hat{a}, etc. (triggered by the closing brace)
+ * - Context rules: 90deg, 1/2, etc. (see RuleSet; the DFA state lives here)
+ * - Autocorrect: teh -> the at a word boundary (see WordAutomaton; the walk lives here)
+ *
+ * The state is a fixed-size value (no heap allocation), so many matchers
+ * can live in a flat arena and be switched between cheaply.
+ *
+ * Replacements are accepted only if their category is set in the caller's
+ * mask (see ShortcutsDict categories). A switched-off pattern behaves like
+ * one the dictionary doesn't have; rules and words keep stepping, so
+ * switching a category back on takes effect on the next keystroke.
  */
 class PatternMatcher {
 public:
+    static const size_t MAX_BUFFER_SIZE = 32;  // Maximum pattern length
+
     struct Match {
         std::string pattern;        // The matched pattern (e.g., "\\alpha")
         size_t start_pos;           // Position in buffer where pattern starts
         size_t length;              // Length of pattern
     };
 
+    /**
+     * @brief Allocation-free match result used on hot paths
+     */
+    struct MatchView {
+        char key[MAX_BUFFER_SIZE] = {};  // Dictionary key (e.g., "\\al", "^2")
+        uint8_t key_length = 0;
+        uint8_t length = 0;              // Typed characters covered, including the trigger
+
+        std::string_view Key() const { return std::string_view(key, key_length); }
+    };
+
+    /**
+     * @brief One replacement reported by Feed
+     */
+    struct FeedMatch {
+        uint64_t position;          // Stream offset of the first replaced byte
+        uint32_t length;            // Bytes replaced (pattern plus trigger)
+        uint32_t entry_id;          // ShortcutsDict entry ID (rule entries too), FAMILY_ENTRY_ID or WORD_ENTRY_ID
+    };
+
+    /**
+     * @brief FeedMatch::entry_id of a symbol family pattern (\mathbb{R})
+     *
+     * The replacement is not a dictionary entry; expand the matched bytes
+     * with ExpandSymbolFamily.
+     */
+    static constexpr uint32_t FAMILY_ENTRY_ID = UINT32_MAX - 1;
+
+    /**
+     * @brief FeedMatch::entry_id of an autocorrected word
+     *
+     * The replacement is not a dictionary entry; correct the matched bytes
+     * with WordAutomaton::Correct. The boundary after the word is not part
+     * of the match.
+     */
+    static constexpr uint32_t WORD_ENTRY_ID = UINT32_MAX - 2;
+
+    /**
+     * @brief Result of a Feed call
+     */
+    struct FeedResult {
+        size_t consumed = 0;        // Bytes of the span processed
+        size_t match_count = 0;     // Matches written to the output buffer
+    };
+
     PatternMatcher();
     ~PatternMatcher() = default;
 
@@ -31,11 +96,96 @@ public:
      */
     std::optional<Match> AddChar(char ch);
 
+    /**
+     * @brief Allocation-free variant of AddChar (LaTeX grammar only)
+     * @param ch The character typed by user
+     * @param match Filled in when a pattern is detected
+     * @return true if a pattern is detected
+     */
+    bool AddChar(char ch, MatchView& match);
+
+    /**
+     * @brief Allocation-free variant of AddChar for a dictionary's grammars
+     * @param ch The character typed by user
+     * @param match Filled in when a pattern is detected
+     * @param grammars Shortcut delimiters (see ShortcutsDict::GetGrammars)
+     * @return true if a pattern is detected
+     */
+    bool AddChar(char ch, MatchView& match, const TriggerGrammars& grammars);
+
+    /**
+     * @brief Advance the context rules by one character
+     *
+     * Call for every character the patterns did not replace. When a rule
+     * fires, the pattern buffer restarts and the rule context continues
+     * after the replacement (after the trigger, if the rule has one).
+     *
+     * @param rules Compiled rules (must not be empty)
+     * @param grammars Shortcut delimiters (a replayed trigger may open a name)
+     * @param ch The character typed by user
+     * @param categories Mask of enabled categories (see ShortcutsDict)
+     * @return Index of the rule that fires, or RuleSet::NO_RULE
+     */
+    uint32_t StepRules(const RuleSet& rules, const TriggerGrammars& grammars, char ch, uint64_t categories);
+
+    /**
+     * @brief Advance the autocorrect walk by one character
+     *
+     * Call for every character neither the patterns nor the rules replaced.
+     * A word starts after a boundary (not after an opener, '^' or '_') and
+     * fires on the next boundary if it is a typo. The boundary is not
+     * replaced: it is typed again after the correction.
+     *
+     * @param words Compiled word list (must not be empty)
+     * @param grammars Shortcut delimiters (a replayed boundary may open a name)
+     * @param ch The character typed by user
+     * @param match Filled in when a word fires: the typed word (if still in
+     *              the buffer; Feed skips ahead) and its length
+     * @param categories Mask of enabled categories (see ShortcutsDict)
+     * @return Typo index, or WordAutomaton::NO_WORD
+     */
+    uint32_t StepWords(const WordAutomaton& words, const TriggerGrammars& grammars, char ch, MatchView& match,
+                       uint64_t categories);
+
+    /**
+     * @brief Advance the matcher over a span of text
+     *
+     * Semantics are those of live typing: '\n', '\r' and '\t' reset the
+     * buffer like Enter/Tab, and after a replacement the buffer is reset
+     * unless a ^( or _( group is still open. The dictionary's context rules
+     * and autocorrect words run on every byte; dictionary patterns win over
+     * rules, and rules over words. Positions are offsets in the
+     * stream of all bytes passed to Feed, so matches that started in a
+     * previous span are reported correctly.
+     *
+     * @param text Span to process
+     * @param dict Dictionary that decides which patterns are replacements
+     * @param out Caller-supplied buffer for matches
+     * @param capacity Size of the output buffer
+     * @param categories Mask of enabled categories (see ShortcutsDict)
+     * @return Bytes consumed (less than text.size() only if out filled up) and matches written
+     */
+    FeedResult Feed(std::string_view text, const ShortcutsDict& dict, FeedMatch* out, size_t capacity,
+                    uint64_t categories);
+
+    /**
+     * @brief Stream offset of the next byte passed to Feed
+     */
+    uint64_t GetStreamPosition() const { return m_stream_pos; }
+
     /**
      * @brief Reset the buffer (e.g., when switching windows)
      */
     void Reset();
 
+    /**
+     * @brief Clear the pattern buffer after a replacement
+     *
+     * Unlike Reset, the line goes on: rules see no line start and an open
+     * `code` span stays open.
+     */
+    void ResetPattern();
+
     /**
      * @brief Remove last character from buffer (e.g., when user presses Backspace)
      */
@@ -44,7 +194,7 @@ public:
     /**
      * @brief Get current buffer content (for debugging)
      */
-    const std::string& GetBuffer() const { return m_buffer; }
+    std::string_view GetBuffer() const { return std::string_view(m_buffer, m_length); }
 
     /**
      * @brief Check if currently in superscript or subscript mode
@@ -53,38 +203,110 @@ public:
     bool IsInSubscriptMode() const { return m_in_subscript_mode; }
 
     /**
-     * @brief Check if currently in LaTeX mode (typing \word pattern)
+     * @brief Check if currently in LaTeX mode (typing \word, :name, ... pattern)
      * This is used to block Unikey from interfering with LaTeX patterns
      */
-    bool IsInLatexMode() const { return m_in_latex_mode; }
+    bool IsInLatexMode() const { return m_grammar != TriggerGrammars::NO_GRAMMAR; }
+
+    /**
+     * @brief Letters of the word being typed that autocorrect may still replace
+     */
+    size_t GetWordLength() const;
 
 private:
     /**
      * @brief Check if current buffer matches any pattern
      */
-    std::optional<Match> CheckForMatch();
+    bool CheckForMatch(MatchView& match, const TriggerGrammars& grammars);
 
     /**
-     * @brief Check for LaTeX-style pattern: \word
+     * @brief Check for a named pattern: opener, name, terminator (e.g., \word + space)
      */
-    std::optional<Match> CheckLatexPattern();
+    bool CheckGrammarPattern(MatchView& match, const TriggerGrammars& grammars);
 
     /**
      * @brief Check for superscript pattern: ^digit
      */
-    std::optional<Match> CheckSuperscriptPattern();
+    bool CheckSuperscriptPattern(MatchView& match);
 
     /**
      * @brief Check for subscript pattern: _digit
      */
-    std::optional<Match> CheckSubscriptPattern();
+    bool CheckSubscriptPattern(MatchView& match);
+
+    /**
+     * @brief Check for symbol family pattern: \name{arg}
+     */
+    bool CheckFamilyPattern(MatchView& match, const TriggerGrammars::Grammar& grammar);
+
+    /**
+     * @brief Check that no pattern is in progress, so only a trigger byte can start one
+     */
+    bool IsIdle() const;
+
+    /**
+     * @brief Run the rules over text the patterns skip, stopping before a byte where one fires
+     * @return Bytes consumed
+     */
+    size_t ScanRules(const RuleSet& rules, std::string_view text, uint64_t categories);
+
+    /**
+     * @brief Run the words (and rules, if any) over text the patterns skip,
+     *        stopping before a byte where either fires
+     * @return Bytes consumed
+     */
+    size_t ScanWords(const WordAutomaton& words, const RuleSet* rules, std::string_view text, uint64_t categories);
+
+    /**
+     * @brief Check whether a character ends a typo that is being typed (and autocorrect is on)
+     */
+    bool WordFiresOn(const WordAutomaton& words, char ch, uint64_t categories) const;
+
+    /**
+     * @brief Rule that fires in a DFA state, if its category is enabled
+     */
+    static uint32_t FiringRule(const RuleSet& rules, uint32_t state, uint64_t categories);
+
+    /**
+     * @brief Advance the autocorrect walk by a character that does not fire
+     */
+    void AdvanceWord(const WordAutomaton& words, char ch);
+
+    /**
+     * @brief Walk the word again after Backspace, over the buffer bytes before `end`
+     */
+    void RefreshWord(const WordAutomaton& words, size_t end);
+
+    /**
+     * @brief Continue the autocorrect walk after a replacement, from the character typed again
+     */
+    void RestartWord(char ch);
+
+    /**
+     * @brief Fill a match from the last `length` buffer bytes
+     */
+    void SetMatchFromBuffer(MatchView& match, size_t key_length, size_t length) const;
+
+    /**
+     * @brief Fill a match whose key is the grammar's key prefix plus buffer[name_start, name_end)
+     * @return false if the key does not fit
+     */
+    bool SetGrammarMatch(MatchView& match, const TriggerGrammars::Grammar& grammar,
+                         size_t name_start, size_t name_end) const;
 
 private:
-    std::string m_buffer;           // Buffer of recent keystrokes
+    char m_buffer[MAX_BUFFER_SIZE] = {};  // Buffer of recent keystrokes
+    uint8_t m_length = 0;                 // Number of valid bytes in m_buffer
     bool m_in_superscript_mode = false;  // True when inside ^(...)
     bool m_in_subscript_mode = false;    // True when inside _(...)
-    bool m_in_latex_mode = false;        // True when typing \word (to block Unikey)
-    static const size_t MAX_BUFFER_SIZE = 32;  // Maximum pattern length
+    uint8_t m_grammar = TriggerGrammars::NO_GRAMMAR;  // Grammar of the name being typed (to block Unikey)
+    bool m_in_group = false;             // True inside the {arg} of \word{arg}
+    uint32_t m_rule_state = 0;           // RuleSet DFA state
+    uint32_t m_word_state = 0;           // WordAutomaton state, or NO_STATE until the next boundary
+    uint32_t m_word_index = 0;           // Output labels summed along the walk
+    uint8_t m_word_length = 0;           // Letters walked since the boundary
+    uint8_t m_word_case = 0;             // WordAutomaton::Case of those letters
+    uint64_t m_stream_pos = 0;           // Bytes passed to Feed so far
 };
 
 } // namespace UniLang
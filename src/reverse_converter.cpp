@@ -0,0 +1,229 @@
+#include "reverse_converter.h"
+#include "shortcuts_dict.h"
+#include "trigger_scan.h"
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+
+namespace UniLang {
+
+namespace {
+
+bool IsAsciiOnly(const std::string& text) {
+    for (char ch : text) {
+        if (static_cast<unsigned char>(ch) >= 0x80) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Canonical shortcut among several with the same output: shortest, then smallest
+bool IsPreferredKey(const std::string& candidate, const std::string& current) {
+    if (candidate.size() != current.size()) {
+        return candidate.size() < current.size();
+    }
+    return candidate < current;
+}
+
+} // namespace
+
+size_t ReverseIndex::Build(const ShortcutsDict& dict) {
+    // Pick the canonical entry for each distinct replacement
+    std::unordered_map<std::string, uint32_t> canonical;
+    for (uint32_t id = 0; id < dict.GetEntryCount(); ++id) {
+        const ShortcutsDict::Entry& entry = dict.GetEntry(id);
+        if (entry.replacement.empty() || IsAsciiOnly(entry.replacement)) {
+            continue;
+        }
+        auto result = canonical.emplace(entry.replacement, id);
+        if (!result.second &&
+            IsPreferredKey(entry.shortcut, dict.GetEntry(result.first->second).shortcut)) {
+            result.first->second = id;
+        }
+    }
+
+    // Build a pointer trie, then flatten it so each node's edges are contiguous
+    struct BuildNode {
+        std::map<uint8_t, uint32_t> children;
+        uint32_t entry_id = ShortcutsDict::INVALID_ENTRY_ID;
+    };
+    std::vector<BuildNode> build(1);  // [0] is the root
+
+    m_max_length = 0;
+    m_ascii_starts = false;
+    for (const auto& pair : canonical) {
+        const std::string& text = pair.first;
+        uint32_t node = 0;
+        for (char ch : text) {
+            const uint8_t byte = static_cast<uint8_t>(ch);
+            auto it = build[node].children.find(byte);
+            if (it == build[node].children.end()) {
+                build.push_back(BuildNode());
+                it = build[node].children.emplace(byte, static_cast<uint32_t>(build.size() - 1)).first;
+            }
+            node = it->second;
+        }
+        build[node].entry_id = pair.second;
+        m_max_length = std::max(m_max_length, text.size());
+        m_ascii_starts |= static_cast<unsigned char>(text[0]) < 0x80;
+    }
+
+    m_nodes.assign(build.size(), Node());
+    m_edge_bytes.clear();
+    m_edge_targets.clear();
+    m_root.fill(0);
+    for (const auto& child : build[0].children) {
+        m_root[child.first] = child.second;
+    }
+    for (size_t i = 1; i < build.size(); ++i) {
+        Node& node = m_nodes[i];
+        node.entry_id = build[i].entry_id;
+        node.first_edge = static_cast<uint32_t>(m_edge_bytes.size());
+        node.edge_count = static_cast<uint32_t>(build[i].children.size());
+        for (const auto& child : build[i].children) {
+            m_edge_bytes.push_back(child.first);
+            m_edge_targets.push_back(child.second);
+        }
+    }
+
+    return canonical.size();
+}
+
+ReverseIndex::Match ReverseIndex::Find(const char* data, size_t size) const {
+    Match match = {ShortcutsDict::INVALID_ENTRY_ID, 0, false};
+    if (size == 0) {
+        return match;
+    }
+
+    uint32_t node = m_root[static_cast<uint8_t>(data[0])];
+    size_t length = 1;
+    while (node != 0) {
+        const Node& current = m_nodes[node];
+        if (current.entry_id != ShortcutsDict::INVALID_ENTRY_ID) {
+            match.entry_id = current.entry_id;
+            match.length = static_cast<uint32_t>(length);
+        }
+        if (current.edge_count == 0) {
+            break;
+        }
+        if (length == size) {
+            match.incomplete = true;
+            break;
+        }
+
+        // Nodes have few children (the next UTF-8 byte); a linear scan wins
+        const uint8_t byte = static_cast<uint8_t>(data[length]);
+        uint32_t next = 0;
+        for (uint32_t e = current.first_edge; e < current.first_edge + current.edge_count; ++e) {
+            if (m_edge_bytes[e] == byte) {
+                next = m_edge_targets[e];
+                break;
+            }
+        }
+        node = next;
+        ++length;
+    }
+    return match;
+}
+
+ReverseConverter::ReverseConverter(const ShortcutsDict& dict, const ReverseIndex& index)
+    : m_dict(dict)
+    , m_index(index) {
+}
+
+void ReverseConverter::Convert(std::string_view chunk, std::string& out) {
+    if (!m_carry.empty()) {
+        // Settle the carried bytes using just enough of the new chunk
+        const size_t carried = m_carry.size();
+        const size_t borrowed = std::min(chunk.size(), m_index.GetMaxLength());
+        m_carry.append(chunk.data(), borrowed);
+
+        const size_t consumed = Process(m_carry, false, out);
+        if (consumed < carried) {
+            // Only possible when the whole chunk was borrowed
+            m_carry.erase(0, consumed);
+            return;
+        }
+        chunk.remove_prefix(consumed - carried);
+        m_carry.clear();
+    }
+
+    const size_t consumed = Process(chunk, false, out);
+    m_carry.assign(chunk.data() + consumed, chunk.size() - consumed);
+}
+
+void ReverseConverter::Finish(std::string& out) {
+    Process(m_carry, true, out);
+    m_carry.clear();
+    m_open_name = nullptr;
+}
+
+std::string ReverseConverter::ConvertAll(std::string_view text) {
+    std::string out;
+    out.reserve(text.size() + text.size() / 2);
+    Convert(text, out);
+    Finish(out);
+    return out;
+}
+
+void ReverseConverter::Reset() {
+    m_carry.clear();
+    m_open_name = nullptr;
+    m_replacements = 0;
+}
+
+size_t ReverseConverter::Process(std::string_view data, bool final, std::string& out) {
+    const bool ascii_skip = !m_index.HasAsciiStarts();
+
+    size_t pos = 0;
+    while (pos < data.size()) {
+        if (m_open_name != nullptr) {
+            // The space terminates the name, as when typing it
+            if (TriggerGrammars::IsNameChar(*m_open_name, data[pos])) {
+                out += ' ';
+            }
+            m_open_name = nullptr;
+        }
+
+        // Nothing starts with an ASCII byte: copy the whole run at once
+        if (ascii_skip) {
+            const size_t run = FindNonAsciiByte(data.data() + pos, data.size() - pos);
+            out.append(data.data() + pos, run);
+            pos += run;
+            if (pos == data.size()) {
+                break;
+            }
+        }
+
+        const ReverseIndex::Match match = m_index.Find(data.data() + pos, data.size() - pos);
+        if (match.incomplete && !final) {
+            break;  // A longer replacement may continue in the next chunk
+        }
+
+        if (match.entry_id == ShortcutsDict::INVALID_ENTRY_ID) {
+            out += data[pos++];
+            continue;
+        }
+
+        // Typed form of the key: the grammar's opener, the name and a terminator
+        const ShortcutsDict::Entry& entry = m_dict.GetEntry(match.entry_id);
+        pos += match.length;
+        ++m_replacements;
+        if (entry.grammar == TriggerGrammars::NO_GRAMMAR) {
+            out += entry.shortcut;
+            continue;
+        }
+        const TriggerGrammars::Grammar& grammar = m_dict.GetGrammars().Get(entry.grammar);
+        out += grammar.opener;
+        out.append(entry.shortcut, grammar.key_prefix.size(), std::string::npos);
+        if (grammar.terminator == ' ') {
+            m_open_name = &grammar;  // A space only where the next character would join the name
+        } else {
+            out += grammar.terminator;
+        }
+    }
+    return pos;
+}
+
+} // namespace UniLang
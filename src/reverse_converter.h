@@ -0,0 +1,121 @@
+#pragma once
+
+#include "trigger_grammar.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace UniLang {
+
+class ShortcutsDict;
+
+/**
+ * @brief Maps replacement text back to the shortcut that produces it
+ *
+ * A byte trie over the UTF-8 replacements of a dictionary snapshot, so
+ * multi-code-point replacements are found by longest match. When several
+ * shortcuts produce the same text, the canonical one is the shortest key
+ * (then the lexicographically smallest): \Om rather than \ohm for Ω.
+ * All-ASCII replacements (URLs) are not indexed. The index is immutable
+ * after Build and can be shared between threads.
+ */
+class ReverseIndex {
+public:
+    struct Match {
+        uint32_t entry_id;          // ShortcutsDict entry, or INVALID_ENTRY_ID
+        uint32_t length;            // Bytes matched
+        bool incomplete;            // Input ended while a longer match was still possible
+    };
+
+    /**
+     * @brief Index all replacements of a dictionary
+     * @return Number of distinct replacement texts indexed
+     */
+    size_t Build(const ShortcutsDict& dict);
+
+    /**
+     * @brief Longest replacement starting at data[0]
+     */
+    Match Find(const char* data, size_t size) const;
+
+    /**
+     * @brief Check whether an ASCII byte can start a replacement
+     *
+     * False for the shipped dictionary: every replacement starts with a
+     * non-ASCII character, so ASCII runs can be copied without lookups.
+     */
+    bool HasAsciiStarts() const { return m_ascii_starts; }
+
+    /**
+     * @brief Length in bytes of the longest indexed replacement
+     */
+    size_t GetMaxLength() const { return m_max_length; }
+
+private:
+    struct Node {
+        uint32_t first_edge = 0;    // Children: m_edge_bytes/m_edge_targets[first_edge, +edge_count)
+        uint32_t edge_count = 0;
+        uint32_t entry_id;          // Replacement ending here, or INVALID_ENTRY_ID
+    };
+
+    std::array<uint32_t, 256> m_root = {};     // First byte -> node (0 = none)
+    std::vector<Node> m_nodes;                  // m_nodes[0] is unused
+    std::vector<uint8_t> m_edge_bytes;          // Sorted within each node
+    std::vector<uint32_t> m_edge_targets;
+    size_t m_max_length = 0;
+    bool m_ascii_starts = false;
+};
+
+/**
+ * @brief Streams text through a ReverseIndex: "α ≤ ∑" -> "\al \leq \sum"
+ *
+ * ASCII runs are copied in bulk (SIMD scan for the next non-ASCII byte).
+ * A space is inserted after a backslash shortcut only when an ASCII letter
+ * follows, which would otherwise continue the command name (αx -> \al x).
+ * Chunks may split anywhere; a replacement cut by a chunk boundary is
+ * carried over (at most GetMaxLength() bytes).
+ */
+class ReverseConverter {
+public:
+    ReverseConverter(const ShortcutsDict& dict, const ReverseIndex& index);
+
+    /**
+     * @brief Convert the next chunk of input
+     */
+    void Convert(std::string_view chunk, std::string& out);
+
+    /**
+     * @brief Flush bytes held back at end of input
+     */
+    void Finish(std::string& out);
+
+    /**
+     * @brief Convert a complete text in one call
+     */
+    std::string ConvertAll(std::string_view text);
+
+    void Reset();
+
+    /**
+     * @brief Number of replacements reversed so far
+     */
+    uint64_t GetReplacementCount() const { return m_replacements; }
+
+private:
+    /**
+     * @brief Convert as much of data as can be decided without more input
+     * @param final True at end of input (nothing more will follow)
+     * @return Bytes consumed
+     */
+    size_t Process(std::string_view data, bool final, std::string& out);
+
+    const ShortcutsDict& m_dict;
+    const ReverseIndex& m_index;
+    std::string m_carry;            // Undecided bytes from the previous chunk
+    const TriggerGrammars::Grammar* m_open_name = nullptr;  // Last output was a \word key; a name character must not follow directly
+    uint64_t m_replacements = 0;
+};
+
+} // namespace UniLang
@@ -0,0 +1,602 @@
+#include "rule_set.h"
+#include "trace.h"
+#include <algorithm>
+#include <bitset>
+#include <map>
+#include <string_view>
+
+namespace UniLang {
+
+namespace {
+
+const uint32_t NONE = UINT32_MAX;
+const uint32_t UNBOUNDED = UINT32_MAX;
+
+using ByteSet = std::bitset<256>;
+
+/**
+ * @brief Thompson NFA node
+ */
+struct NfaNode {
+    enum class Type : uint8_t {
+        Set,        // Consume one byte in sets[set], go to out
+        Split,      // Epsilon to out and out2 (out2 may be NONE)
+        Begin,      // Epsilon to out, only at the start of a line (^)
+        Accept,     // Rule `rule` matched
+    };
+
+    Type type = Type::Split;
+    uint32_t out = NONE;
+    uint32_t out2 = NONE;
+    uint32_t set = 0;
+    uint32_t rule = 0;
+};
+
+struct Nfa {
+    std::vector<NfaNode> nodes;
+    std::vector<ByteSet> sets;
+
+    uint32_t Add(NfaNode::Type type) {
+        NfaNode node;
+        node.type = type;
+        nodes.push_back(node);
+        return static_cast<uint32_t>(nodes.size() - 1);
+    }
+
+    uint32_t AddSet(const ByteSet& set) {
+        const uint32_t id = Add(NfaNode::Type::Set);
+        nodes[id].set = static_cast<uint32_t>(sets.size());
+        sets.push_back(set);
+        return id;
+    }
+};
+
+/**
+ * @brief Partially built automaton: entry node plus dangling exits
+ */
+struct Fragment {
+    uint32_t start = NONE;
+    std::vector<uint32_t> holes;    // node * 2 + (0: out, 1: out2)
+    uint32_t min_length = 0;
+    uint32_t max_length = 0;        // UNBOUNDED for * and +
+};
+
+void Patch(Nfa& nfa, const std::vector<uint32_t>& holes, uint32_t target) {
+    for (uint32_t hole : holes) {
+        NfaNode& node = nfa.nodes[hole / 2];
+        (hole % 2 == 0 ? node.out : node.out2) = target;
+    }
+}
+
+int FirstByte(const ByteSet& set) {
+    for (int c = 0; c < 256; ++c) {
+        if (set[c]) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+uint32_t AddLengths(uint32_t a, uint32_t b) {
+    return a == UNBOUNDED || b == UNBOUNDED ? UNBOUNDED : a + b;
+}
+
+/**
+ * @brief Recursive-descent parser from the limited regex syntax to NFA fragments
+ */
+class RegexParser {
+public:
+    RegexParser(Nfa& nfa, std::string_view pattern, std::string& error)
+        : m_nfa(nfa), m_pattern(pattern), m_error(error) {}
+
+    bool Parse(Fragment& fragment) {
+        if (!ParseAlternation(fragment)) {
+            return false;
+        }
+        if (m_pos != m_pattern.size()) {
+            return Fail("unexpected ')'");
+        }
+        return true;
+    }
+
+private:
+    bool Fail(const char* message) {
+        m_error = std::string(message) + " at offset " + std::to_string(m_pos) +
+                  " in \"" + std::string(m_pattern) + "\"";
+        return false;
+    }
+
+    bool AtEnd() const { return m_pos >= m_pattern.size(); }
+    char Peek() const { return m_pattern[m_pos]; }
+
+    Fragment Empty() {
+        Fragment fragment;
+        fragment.start = m_nfa.Add(NfaNode::Type::Split);
+        fragment.holes.push_back(fragment.start * 2);
+        return fragment;
+    }
+
+    bool ParseAlternation(Fragment& fragment) {
+        if (!ParseConcat(fragment)) {
+            return false;
+        }
+        while (!AtEnd() && Peek() == '|') {
+            ++m_pos;
+            Fragment right;
+            if (!ParseConcat(right)) {
+                return false;
+            }
+            const uint32_t split = m_nfa.Add(NfaNode::Type::Split);
+            m_nfa.nodes[split].out = fragment.start;
+            m_nfa.nodes[split].out2 = right.start;
+            fragment.start = split;
+            fragment.holes.insert(fragment.holes.end(), right.holes.begin(), right.holes.end());
+            fragment.min_length = std::min(fragment.min_length, right.min_length);
+            fragment.max_length = std::max(fragment.max_length, right.max_length);
+        }
+        return true;
+    }
+
+    bool ParseConcat(Fragment& fragment) {
+        fragment = Empty();
+        while (!AtEnd() && Peek() != '|' && Peek() != ')') {
+            Fragment next;
+            if (!ParseRepeat(next)) {
+                return false;
+            }
+            Patch(m_nfa, fragment.holes, next.start);
+            fragment.holes = std::move(next.holes);
+            fragment.min_length += next.min_length;
+            fragment.max_length = AddLengths(fragment.max_length, next.max_length);
+        }
+        return true;
+    }
+
+    bool ParseRepeat(Fragment& fragment) {
+        if (!ParseAtom(fragment)) {
+            return false;
+        }
+        while (!AtEnd() && (Peek() == '*' || Peek() == '+' || Peek() == '?')) {
+            const char op = m_pattern[m_pos++];
+            const uint32_t split = m_nfa.Add(NfaNode::Type::Split);
+            m_nfa.nodes[split].out = fragment.start;
+
+            if (op == '?') {
+                fragment.start = split;
+                fragment.holes.push_back(split * 2 + 1);
+                fragment.min_length = 0;
+                continue;
+            }
+
+            // * and +: loop back through the split
+            Patch(m_nfa, fragment.holes, split);
+            fragment.holes.assign(1, split * 2 + 1);
+            if (op == '*') {
+                fragment.start = split;
+                fragment.min_length = 0;
+            }
+            fragment.max_length = UNBOUNDED;
+        }
+        return true;
+    }
+
+    bool ParseAtom(Fragment& fragment) {
+        const char ch = m_pattern[m_pos++];
+        if (static_cast<unsigned char>(ch) >= 0x80) {
+            return Fail("non-ASCII character");
+        }
+
+        ByteSet set;
+        switch (ch) {
+        case '(':
+            if (!ParseAlternation(fragment)) {
+                return false;
+            }
+            if (AtEnd() || Peek() != ')') {
+                return Fail("missing ')'");
+            }
+            ++m_pos;
+            return true;
+        case '^':
+            fragment.start = m_nfa.Add(NfaNode::Type::Begin);
+            fragment.holes.assign(1, fragment.start * 2);
+            fragment.min_length = fragment.max_length = 0;
+            return true;
+        case '*':
+        case '+':
+        case '?':
+            return Fail("nothing to repeat");
+        case ')':
+            return Fail("unexpected ')'");
+        case '[':
+            if (!ParseClass(set)) {
+                return false;
+            }
+            break;
+        case '.':
+            set.set();
+            set.reset('\n');
+            set.reset('\r');
+            break;
+        case '\\':
+            if (!ParseEscape(set)) {
+                return false;
+            }
+            break;
+        default:
+            set.set(static_cast<unsigned char>(ch));
+            break;
+        }
+
+        fragment.start = m_nfa.AddSet(set);
+        fragment.holes.assign(1, fragment.start * 2);
+        fragment.min_length = fragment.max_length = 1;
+        return true;
+    }
+
+    bool ParseEscape(ByteSet& set) {
+        if (AtEnd()) {
+            return Fail("trailing backslash");
+        }
+        const char ch = m_pattern[m_pos++];
+        switch (ch) {
+        case 'd': case 'D':
+            for (int c = '0'; c <= '9'; ++c) set.set(c);
+            break;
+        case 'w': case 'W':
+            for (int c = '0'; c <= '9'; ++c) set.set(c);
+            for (int c = 'a'; c <= 'z'; ++c) set.set(c);
+            for (int c = 'A'; c <= 'Z'; ++c) set.set(c);
+            set.set('_');
+            break;
+        case 's': case 'S':
+            set.set(' ');
+            set.set('\t');
+            set.set('\r');
+            set.set('\n');
+            set.set('\f');
+            set.set('\v');
+            break;
+        case 't':
+            set.set('\t');
+            return true;
+        case 'n':
+            set.set('\n');
+            return true;
+        default:
+            if ((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+                static_cast<unsigned char>(ch) >= 0x80) {
+                --m_pos;
+                return Fail("unknown escape");
+            }
+            set.set(static_cast<unsigned char>(ch));
+            return true;
+        }
+        if (ch == 'D' || ch == 'W' || ch == 'S') {
+            set.flip();
+        }
+        return true;
+    }
+
+    bool ParseClass(ByteSet& set) {
+        const bool negated = !AtEnd() && Peek() == '^';
+        if (negated) {
+            ++m_pos;
+        }
+
+        bool first = true;
+        while (!AtEnd() && (Peek() != ']' || first)) {
+            first = false;
+            ByteSet item;
+            int low = static_cast<unsigned char>(m_pattern[m_pos++]);
+            if (low >= 0x80) {
+                return Fail("non-ASCII character");
+            }
+            if (low == '\\') {
+                if (!ParseEscape(item)) {
+                    return false;
+                }
+                if (item.count() != 1) {
+                    set |= item;    // \d, \w, \s inside a class
+                    continue;
+                }
+                low = static_cast<int>(FirstByte(item));
+            }
+
+            int high = low;
+            if (m_pos + 1 < m_pattern.size() && Peek() == '-' && m_pattern[m_pos + 1] != ']') {
+                ++m_pos;
+                high = static_cast<unsigned char>(m_pattern[m_pos++]);
+                if (high == '\\') {
+                    ByteSet escaped;
+                    if (!ParseEscape(escaped) || escaped.count() != 1) {
+                        return Fail("bad range end");
+                    }
+                    high = static_cast<int>(FirstByte(escaped));
+                }
+                if (high < low || high >= 0x80) {
+                    return Fail("bad range");
+                }
+            }
+            for (int c = low; c <= high; ++c) {
+                set.set(c);
+            }
+        }
+        if (AtEnd()) {
+            return Fail("missing ']'");
+        }
+        ++m_pos;
+
+        if (negated) {
+            set.flip();
+        }
+        return true;
+    }
+
+    Nfa& m_nfa;
+    std::string_view m_pattern;
+    std::string& m_error;
+    size_t m_pos = 0;
+};
+
+/**
+ * @brief Epsilon closure over the NFA, keeping only Set and Accept nodes
+ */
+class Closure {
+public:
+    explicit Closure(const Nfa& nfa) : m_nfa(nfa), m_mark(nfa.nodes.size(), 0) {}
+
+    void Compute(const std::vector<uint32_t>& seeds, bool at_line_start, std::vector<uint32_t>& result) {
+        ++m_generation;
+        result.clear();
+        m_stack.assign(seeds.begin(), seeds.end());
+        while (!m_stack.empty()) {
+            const uint32_t id = m_stack.back();
+            m_stack.pop_back();
+            if (id == NONE || m_mark[id] == m_generation) {
+                continue;
+            }
+            m_mark[id] = m_generation;
+
+            const NfaNode& node = m_nfa.nodes[id];
+            switch (node.type) {
+            case NfaNode::Type::Set:
+            case NfaNode::Type::Accept:
+                result.push_back(id);
+                break;
+            case NfaNode::Type::Split:
+                m_stack.push_back(node.out2);
+                m_stack.push_back(node.out);
+                break;
+            case NfaNode::Type::Begin:
+                if (at_line_start) {
+                    m_stack.push_back(node.out);
+                }
+                break;
+            }
+        }
+        std::sort(result.begin(), result.end());
+    }
+
+private:
+    const Nfa& m_nfa;
+    std::vector<uint32_t> m_mark;
+    uint32_t m_generation = 0;
+    std::vector<uint32_t> m_stack;
+};
+
+bool IsLineBreak(unsigned char ch) {
+    return ch == '\n' || ch == '\r' || ch == '\t';
+}
+
+} // namespace
+
+void RuleSet::Clear() {
+    m_rules.clear();
+    m_match_lengths.clear();
+    m_max_length = 0;
+    std::fill(std::begin(m_classes), std::end(m_classes), 0);
+    m_class_count = 1;
+    m_table.clear();
+    m_accept.clear();
+}
+
+bool RuleSet::Compile(const std::vector<Rule>& rules) {
+    UNILANG_TRACE_SCOPE("matcher", "RuleSet::Compile");
+    Clear();
+    m_last_error.clear();
+    if (rules.empty()) {
+        return true;
+    }
+
+    // Unanchored search: S loops over any byte and starts every rule at every position
+    Nfa nfa;
+    const uint32_t loop = nfa.Add(NfaNode::Type::Split);
+    ByteSet any;
+    any.set();
+    for (int c = 0; c < 256; ++c) {
+        if (IsLineBreak(static_cast<unsigned char>(c))) {
+            any.reset(c);
+        }
+    }
+    const uint32_t any_byte = nfa.AddSet(any);
+    nfa.nodes[any_byte].out = loop;
+    nfa.nodes[loop].out = any_byte;
+
+    std::vector<uint32_t> match_lengths;
+    uint32_t chain = loop;
+    for (size_t i = 0; i < rules.size(); ++i) {
+        const Rule& rule = rules[i];
+        std::string error;
+
+        Fragment before, match, after;
+        if (!RegexParser(nfa, rule.before, error).Parse(before) ||
+            !RegexParser(nfa, rule.match, error).Parse(match) ||
+            !RegexParser(nfa, rule.after, error).Parse(after)) {
+            m_last_error = "rule " + std::to_string(i + 1) + ": " + error;
+            return false;
+        }
+        if (match.min_length == 0 || match.min_length != match.max_length) {
+            m_last_error = "rule " + std::to_string(i + 1) + ": match must have a fixed, non-zero length";
+            return false;
+        }
+        if (!rule.after.empty() && (after.min_length != 1 || after.max_length != 1)) {
+            m_last_error = "rule " + std::to_string(i + 1) + ": after must match exactly one character";
+            return false;
+        }
+
+        const uint32_t accept = nfa.Add(NfaNode::Type::Accept);
+        nfa.nodes[accept].rule = static_cast<uint32_t>(i);
+        Patch(nfa, before.holes, match.start);
+        Patch(nfa, match.holes, after.start);
+        Patch(nfa, after.holes, accept);
+
+        const uint32_t split = nfa.Add(NfaNode::Type::Split);
+        nfa.nodes[split].out = before.start;
+        nfa.nodes[chain].out2 = split;
+        chain = split;
+
+        match_lengths.push_back(match.min_length);
+        m_max_length = std::max<size_t>(m_max_length, match.min_length + (rule.after.empty() ? 0 : 1));
+    }
+
+    // Byte equivalence classes: bytes no set tells apart share a column.
+    // Line breaks and the backtick get columns of their own (state changes).
+    uint16_t classes[256] = {};
+    uint32_t class_count = 1;
+    auto refine = [&](const ByteSet& set) {
+        std::map<std::pair<uint16_t, bool>, uint16_t> split;
+        for (int c = 0; c < 0x80; ++c) {
+            const auto key = std::make_pair(classes[c], static_cast<bool>(set[c]));
+            auto it = split.emplace(key, static_cast<uint16_t>(split.size())).first;
+            classes[c] = it->second;
+        }
+        class_count = static_cast<uint32_t>(split.size());
+    };
+    for (const ByteSet& set : nfa.sets) {
+        refine(set);
+    }
+    ByteSet special;
+    special.set('`');
+    refine(special);
+    for (unsigned char ch : {'\n', '\r', '\t'}) {
+        special.reset();
+        special.set(ch);
+        refine(special);
+    }
+    for (int c = 0x80; c < 256; ++c) {
+        classes[c] = classes[0x7F];     // The matcher feeds non-ASCII as 0x7F
+    }
+
+    std::vector<unsigned char> representative(class_count);
+    for (int c = 0x7F; c >= 0; --c) {
+        representative[classes[c]] = static_cast<unsigned char>(c);
+    }
+    const uint32_t line_break_class = classes['\n'];
+    const uint32_t backtick_class = classes['`'];
+
+    // Subset construction. Every state after the first byte contains the
+    // closure of the loop node, so states are keyed by what they add to it.
+    Closure closure(nfa);
+    std::vector<uint32_t> base;
+    closure.Compute({loop}, false, base);
+    std::vector<bool> in_base(nfa.nodes.size(), false);
+    for (uint32_t id : base) {
+        in_base[id] = true;
+    }
+    auto without_base = [&](std::vector<uint32_t>& set) {
+        set.erase(std::remove_if(set.begin(), set.end(), [&](uint32_t id) { return in_base[id]; }), set.end());
+    };
+    auto move = [&](const std::vector<uint32_t>& set, unsigned char byte, std::vector<uint32_t>& next) {
+        for (uint32_t id : set) {
+            const NfaNode& node = nfa.nodes[id];
+            if (node.type == NfaNode::Type::Set && nfa.sets[node.set][byte]) {
+                next.push_back(node.out);
+            }
+        }
+    };
+
+    std::vector<std::vector<uint32_t>> base_moves(class_count);
+    std::vector<uint32_t> seeds;
+    for (uint32_t c = 0; c < class_count; ++c) {
+        seeds.clear();
+        move(base, representative[c], seeds);
+        closure.Compute(seeds, false, base_moves[c]);
+        without_base(base_moves[c]);
+    }
+
+    std::vector<std::vector<uint32_t>> states;
+    std::map<std::vector<uint32_t>, uint32_t> ids;
+    std::vector<uint32_t> start;
+    closure.Compute({loop}, true, start);
+    without_base(start);
+    states.push_back(start);
+    states.push_back({});
+    ids[std::vector<uint32_t>{}] = 1;   // The start state is never reached again by key
+
+    std::vector<uint32_t> table;
+    std::vector<uint32_t> next;
+    std::vector<uint32_t> moved;
+    for (uint32_t state = 0; state < states.size(); ++state) {
+        for (uint32_t c = 0; c < class_count; ++c) {
+            if (c == line_break_class) {
+                table.push_back(0);
+                continue;
+            }
+
+            seeds.clear();
+            move(states[state], representative[c], seeds);
+            closure.Compute(seeds, false, moved);
+            without_base(moved);
+            next.clear();
+            std::set_union(moved.begin(), moved.end(), base_moves[c].begin(), base_moves[c].end(),
+                           std::back_inserter(next));
+
+            auto it = ids.find(next);
+            if (it == ids.end()) {
+                if (states.size() * 2 >= MAX_STATES) {
+                    m_last_error = "rules need more than " + std::to_string(MAX_STATES) + " DFA states";
+                    return false;
+                }
+                it = ids.emplace(next, static_cast<uint32_t>(states.size())).first;
+                states.push_back(next);
+            }
+            table.push_back(it->second);
+        }
+    }
+
+    // Final table: state * 2 + (inside a code span)
+    m_table.resize(states.size() * 2 * class_count);
+    m_accept.assign(states.size() * 2, NO_RULE);
+    for (uint32_t state = 0; state < states.size(); ++state) {
+        for (uint32_t code = 0; code < 2; ++code) {
+            const uint32_t id = state * 2 + code;
+            for (uint32_t c = 0; c < class_count; ++c) {
+                const uint32_t target = table[state * class_count + c];
+                const uint32_t target_code = c == line_break_class ? 0 : c == backtick_class ? !code : code;
+                m_table[id * class_count + c] = target * 2 + target_code;
+            }
+
+            for (uint32_t node_id : states[state]) {
+                const NfaNode& node = nfa.nodes[node_id];
+                if (node.type != NfaNode::Type::Accept || node.rule >= m_accept[id]) {
+                    continue;
+                }
+                const Context context = rules[node.rule].context;
+                if (context == Context::Any || (context == Context::Code) == (code == 1)) {
+                    m_accept[id] = node.rule;
+                }
+            }
+        }
+    }
+
+    for (int c = 0; c < 256; ++c) {
+        m_classes[c] = static_cast<uint8_t>(classes[c]);
+    }
+    m_class_count = class_count;
+    m_rules = rules;
+    m_match_lengths = std::move(match_lengths);
+    return true;
+}
+
+} // namespace UniLang
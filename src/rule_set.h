@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace UniLang {
+
+/**
+ * @brief Context rules compiled into one DFA
+ *
+ * A rule replaces text only in a given context: "deg" after a digit
+ * (90deg -> 90°), "->" outside `code` spans, "1/2" between word
+ * boundaries. Each rule is three limited regexes around the replaced text:
+ *
+ *   before   must precede the match (not replaced; ^ is the start of a line)
+ *   match    the replaced text; fixed length
+ *   after    one character that must follow it (the trigger; kept and
+ *            typed again after the replacement)
+ *
+ * Regex syntax (ASCII): literals, ".", [classes] with ranges and ^,
+ * \d \w \s and their negations, escapes, (groups), |, *, + and ?.
+ * No backreferences or lookaround, so every rule compiles into the same
+ * DFA: all rules run together in one table lookup per character,
+ * whatever their number, and nothing is ever backtracked.
+ *
+ * The DFA also tracks whether the text is inside a `code` span (an odd
+ * number of backticks on the current line): state IDs carry that as
+ * their lowest bit. Line breaks go back to the start state.
+ */
+class RuleSet {
+public:
+    enum class Context : uint8_t {
+        Any,
+        Text,       // Outside `code` spans only
+        Code,       // Inside `code` spans only
+    };
+
+    struct Rule {
+        std::string before;         // Regex for the required left context ("" = anything)
+        std::string match;          // Regex for the replaced text (fixed length)
+        std::string after;          // Regex for the one-character trigger ("" = none)
+        std::string replacement;    // UTF-8 replacement text
+        Context context = Context::Any;
+        uint8_t category = 0;       // Owner's category tag (see ShortcutsDict); not part of the DFA
+    };
+
+    static constexpr uint32_t NO_RULE = UINT32_MAX;
+    static const uint32_t START_STATE = 0;      // Start of a line, outside code
+    static const uint32_t RESUME_STATE = 2;     // Context unknown (after Backspace or a replacement)
+    static const size_t MAX_STATES = 1 << 16;   // Compile fails beyond this many DFA states
+
+    RuleSet() = default;
+
+    /**
+     * @brief Compile rules, replacing any previous ones
+     * @return false if a rule is invalid or the DFA grows too large (see GetLastError)
+     */
+    bool Compile(const std::vector<Rule>& rules);
+
+    /**
+     * @brief Drop all rules
+     */
+    void Clear();
+
+    /**
+     * @brief Check whether there are no rules (Step must not be called then)
+     */
+    bool Empty() const { return m_rules.empty(); }
+
+    /**
+     * @brief Advance the DFA by one input byte (non-ASCII bytes count as 0x7F)
+     */
+    uint32_t Step(uint32_t state, unsigned char ch) const {
+        return m_table[state * m_class_count + m_classes[ch]];
+    }
+
+    /**
+     * @brief Rule that completes in a state (the earliest rule wins ties)
+     * @return Rule index, or NO_RULE
+     */
+    uint32_t GetFiringRule(uint32_t state) const { return m_accept[state]; }
+
+    /**
+     * @brief State to continue from after a replacement (keeps the code-span bit)
+     */
+    static uint32_t GetResumeState(uint32_t state) { return RESUME_STATE | (state & 1); }
+
+    const Rule& GetRule(uint32_t rule) const { return m_rules[rule]; }
+    size_t GetRuleCount() const { return m_rules.size(); }
+
+    /**
+     * @brief Length of the text a rule replaces
+     */
+    uint32_t GetMatchLength(uint32_t rule) const { return m_match_lengths[rule]; }
+
+    /**
+     * @brief Check whether a rule fires on a trigger character that follows the match
+     */
+    bool HasTrigger(uint32_t rule) const { return !m_rules[rule].after.empty(); }
+
+    /**
+     * @brief Longest match plus trigger, i.e. how far back a rule can reach
+     */
+    size_t GetMaxLength() const { return m_max_length; }
+
+    /**
+     * @brief DFA size (states include the code-span bit)
+     */
+    size_t GetStateCount() const { return m_accept.size(); }
+    size_t GetClassCount() const { return m_class_count; }
+    size_t GetTableBytes() const { return m_table.size() * sizeof(uint32_t) + m_accept.size() * sizeof(uint32_t); }
+
+    const std::string& GetLastError() const { return m_last_error; }
+
+private:
+    std::vector<Rule> m_rules;
+    std::vector<uint32_t> m_match_lengths;
+    size_t m_max_length = 0;
+
+    uint8_t m_classes[256] = {};        // Byte -> equivalence class
+    uint32_t m_class_count = 1;
+    std::vector<uint32_t> m_table;      // state * m_class_count + class -> state
+    std::vector<uint32_t> m_accept;     // state -> firing rule
+
+    std::string m_last_error;
+};
+
+} // namespace UniLang
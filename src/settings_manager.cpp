@@ -13,6 +13,7 @@ SettingsManager::SettingsManager() {
 
 SettingsManager::~SettingsManager() {
     RemoveTray();
+    // m_writer writes anything still queued as it is destroyed
 }
 
 bool SettingsManager::InitializeTray(HWND hwnd) {
@@ -64,6 +65,7 @@ bool SettingsManager::LoadSettings(const std::string& filepath) {
 
         json j;
         file >> j;
+        m_settings_path = filepath;
 
         if (j.contains("settings")) {
             auto settings = j["settings"];
@@ -83,43 +85,43 @@ bool SettingsManager::LoadSettings(const std::string& filepath) {
             if (settings.contains("case_sensitive")) {
                 m_settings.case_sensitive = settings["case_sensitive"];
             }
+            if (settings.contains("autocorrect_list")) {
+                m_settings.autocorrect_list = settings["autocorrect_list"];
+            }
+            if (settings.contains("disabled_categories")) {
+                m_settings.disabled_categories = settings["disabled_categories"].get<std::vector<std::string>>();
+            }
+            if (settings.contains("app_disabled_categories")) {
+                m_settings.app_disabled_categories =
+                    settings["app_disabled_categories"].get<std::map<std::string, std::vector<std::string>>>();
+            }
         }
 
 //         std::cout << "Settings loaded successfully" << std::endl;
+        NotifySettingsChanged();
         return true;
 
     } catch (const std::exception& e) {
 //         std::cerr << "Error loading settings: " << e.what() << std::endl;
+        NotifySettingsChanged();    // Values read before the error stay
         return false;
     }
 }
 
 bool SettingsManager::SaveSettings(const std::string& filepath) {
     try {
-        // Read existing file to preserve shortcuts
-        json j;
-        std::ifstream file_in(filepath);
-        if (file_in.is_open()) {
-            file_in >> j;
-            file_in.close();
-        }
-
-        // Update settings section
-        j["settings"]["enabled"] = m_settings.enabled;
-        j["settings"]["show_popup"] = m_settings.show_popup;
-        j["settings"]["popup_duration_ms"] = m_settings.popup_duration_ms;
-        j["settings"]["trigger_key"] = m_settings.trigger_key;
-        j["settings"]["case_sensitive"] = m_settings.case_sensitive;
-
-        // Write back to file
-        std::ofstream file_out(filepath);
-        if (!file_out.is_open()) {
-//             std::cerr << "Failed to open settings file for writing: " << filepath << std::endl;
-            return false;
-        }
-
-        file_out << j.dump(2) << std::endl;
-//         std::cout << "Settings saved successfully" << std::endl;
+        // Only the settings section; the writer merges it into the file as text
+        json settings;
+        settings["enabled"] = m_settings.enabled;
+        settings["show_popup"] = m_settings.show_popup;
+        settings["popup_duration_ms"] = m_settings.popup_duration_ms;
+        settings["trigger_key"] = m_settings.trigger_key;
+        settings["case_sensitive"] = m_settings.case_sensitive;
+        settings["autocorrect_list"] = m_settings.autocorrect_list;
+        settings["disabled_categories"] = m_settings.disabled_categories;
+        settings["app_disabled_categories"] = m_settings.app_disabled_categories;
+
+        m_writer.Post(filepath, "settings", settings.dump(2));
         return true;
 
     } catch (const std::exception& e) {
@@ -131,6 +133,10 @@ bool SettingsManager::SaveSettings(const std::string& filepath) {
 void SettingsManager::ToggleEnabled() {
     m_settings.enabled = !m_settings.enabled;
     UpdateTrayTooltip();
+    NotifySettingsChanged();
+    if (!m_settings_path.empty()) {
+        SaveSettings(m_settings_path);
+    }
 
 //     std::cout << "UniLang " << (m_settings.enabled ? "ENABLED" : "DISABLED") << std::endl;
 }
@@ -149,6 +155,7 @@ void SettingsManager::ShowContextMenu(HWND hwnd, POINT pt) {
     AppendMenuW(hMenu, MF_SEPARATOR, 0, nullptr);
     AppendMenuW(hMenu, MF_STRING, ID_TRAY_SETTINGS, L"Settings...");
     AppendMenuW(hMenu, MF_STRING, ID_TRAY_UPDATE, L"Check for Updates...");
+    AppendMenuW(hMenu, MF_STRING, ID_TRAY_DIAGNOSTICS, L"Save Diagnostics");
     AppendMenuW(hMenu, MF_SEPARATOR, 0, nullptr);
     AppendMenuW(hMenu, MF_STRING, ID_TRAY_EXIT, L"Exit");
 
@@ -190,4 +197,10 @@ void SettingsManager::UpdateTrayTooltip() {
     Shell_NotifyIcon(NIM_MODIFY, &m_nid);
 }
 
+void SettingsManager::NotifySettingsChanged() {
+    if (m_on_settings_changed) {
+        m_on_settings_changed(m_settings);
+    }
+}
+
 } // namespace UniLang
@@ -1,7 +1,10 @@
 #pragma once
 
+#include "settings_writer.h"
 #include <string>
 #include <functional>
+#include <map>
+#include <vector>
 #include <Windows.h>
 
 namespace UniLang {
@@ -13,6 +16,10 @@ namespace UniLang {
  * - Create system tray icon
  * - Show context menu (Enable/Disable, Settings, Exit)
  * - Load/save settings from JSON
+ *
+ * Saving never touches the disk on the caller's thread: the "settings"
+ * section is handed to a SettingsWriter, which coalesces changes and
+ * replaces the file atomically in the background.
  */
 class SettingsManager {
 public:
@@ -22,9 +29,14 @@ public:
         int popup_duration_ms = 1000;
         std::string trigger_key = "\\";
         bool case_sensitive = true;
+        std::string autocorrect_list;  // Typo word list file; empty turns autocorrect off
+        std::vector<std::string> disabled_categories;  // Dictionary categories switched off everywhere
+        // Executable name (lowercase, e.g., "code.exe") -> categories also switched off in that app
+        std::map<std::string, std::vector<std::string>> app_disabled_categories;
     };
 
     using OnHelpRequestCallback = std::function<void()>;
+    using OnSettingsChangedCallback = std::function<void(const Settings& settings)>;
 
     SettingsManager();
     ~SettingsManager();
@@ -42,15 +54,22 @@ public:
     void RemoveTray();
 
     /**
-     * @brief Load settings from JSON file
+     * @brief Load settings from JSON file (later changes are saved back to it)
      */
     bool LoadSettings(const std::string& filepath);
 
     /**
-     * @brief Save settings to JSON file
+     * @brief Queue the settings for writing to a JSON file (other sections are kept)
+     * @return false if the settings can't be serialized
      */
     bool SaveSettings(const std::string& filepath);
 
+    /**
+     * @brief Wait until queued settings are on disk
+     * @return false if a write failed
+     */
+    bool FlushSettings() { return m_writer.Flush(); }
+
     /**
      * @brief Get current settings
      */
@@ -78,23 +97,36 @@ public:
         m_on_help_request = callback;
     }
 
+    /**
+     * @brief Set callback run (on the caller's thread) whenever settings are loaded or changed
+     */
+    void SetOnSettingsChangedCallback(OnSettingsChangedCallback callback) {
+        m_on_settings_changed = callback;
+    }
+
 private:
     /**
      * @brief Update tray icon tooltip
      */
     void UpdateTrayTooltip();
 
+    void NotifySettingsChanged();
+
 private:
     Settings m_settings;
+    std::string m_settings_path;    // File loaded from; empty keeps changes in memory
+    SettingsWriter m_writer;
     NOTIFYICONDATA m_nid = {};
     bool m_tray_initialized = false;
     OnHelpRequestCallback m_on_help_request;
+    OnSettingsChangedCallback m_on_settings_changed;
 
     // Menu item IDs
     static const UINT ID_TRAY_ENABLE = 1001;
     static const UINT ID_TRAY_SETTINGS = 1002;
     static const UINT ID_TRAY_UPDATE = 1003;
     static const UINT ID_TRAY_EXIT = 1004;
+    static const UINT ID_TRAY_DIAGNOSTICS = 1005;
 
     static const UINT WM_TRAYICON = WM_USER + 1;
 };
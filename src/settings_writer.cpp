@@ -0,0 +1,377 @@
+#include "settings_writer.h"
+#include "trace.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace UniLang {
+
+namespace {
+
+const size_t NPOS = std::string_view::npos;
+
+size_t SkipSpace(std::string_view text, size_t pos) {
+    while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+        ++pos;
+    }
+    return pos;
+}
+
+/**
+ * @brief End of the string whose opening quote is at pos, or NPOS
+ */
+size_t SkipString(std::string_view text, size_t pos) {
+    for (++pos; pos < text.size(); ++pos) {
+        if (text[pos] == '\\') {
+            ++pos;
+        } else if (text[pos] == '"') {
+            return pos + 1;
+        }
+    }
+    return NPOS;
+}
+
+/**
+ * @brief End of the value starting at pos, or NPOS
+ *
+ * Checks strings and bracket nesting only; that is enough to find where
+ * the value ends without parsing it.
+ */
+size_t SkipValue(std::string_view text, size_t pos) {
+    if (pos >= text.size()) {
+        return NPOS;
+    }
+    if (text[pos] == '"') {
+        return SkipString(text, pos);
+    }
+    if (text[pos] == '{' || text[pos] == '[') {
+        std::string closers;
+        while (pos < text.size()) {
+            const char ch = text[pos];
+            if (ch == '"') {
+                pos = SkipString(text, pos);
+                if (pos == NPOS) {
+                    return NPOS;
+                }
+                continue;
+            }
+            if (ch == '{') {
+                closers.push_back('}');
+            } else if (ch == '[') {
+                closers.push_back(']');
+            } else if (ch == '}' || ch == ']') {
+                if (closers.empty() || closers.back() != ch) {
+                    return NPOS;
+                }
+                closers.pop_back();
+                if (closers.empty()) {
+                    return pos + 1;
+                }
+            }
+            ++pos;
+        }
+        return NPOS;
+    }
+
+    // Number, true, false or null
+    size_t end = pos;
+    while (end < text.size() && (std::isalnum(static_cast<unsigned char>(text[end])) ||
+                                 text[end] == '-' || text[end] == '+' || text[end] == '.')) {
+        ++end;
+    }
+    return end == pos ? NPOS : end;
+}
+
+/**
+ * @brief Append a value, indenting its continuation lines
+ */
+void AppendIndented(std::string& out, std::string_view value, std::string_view indent) {
+    for (char ch : value) {
+        out += ch;
+        if (ch == '\n') {
+            out.append(indent);
+        }
+    }
+}
+
+} // namespace
+
+SettingsWriter::SettingsWriter()
+    : SettingsWriter(Options()) {
+}
+
+SettingsWriter::SettingsWriter(const Options& options)
+    : m_options(options) {
+}
+
+SettingsWriter::~SettingsWriter() {
+    Stop();
+}
+
+void SettingsWriter::Post(const std::string& filepath, const std::string& section, std::string value) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const Clock::time_point now = Clock::now();
+        if (m_pending.empty()) {
+            m_first_post = now;
+        }
+        m_last_post = now;
+        m_pending[Key(filepath, section)] = std::move(value);
+        ++m_posted;
+        ++m_stats.posts;
+
+        if (!m_thread.joinable()) {
+            m_stop = false;
+            m_thread = std::thread(&SettingsWriter::WorkerLoop, this);
+        }
+    }
+    m_wake.notify_one();
+}
+
+bool SettingsWriter::Flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const uint64_t target = m_posted;
+    if (m_written < target) {
+        m_flush = true;
+        m_wake.notify_one();
+        m_done.wait(lock, [this, target]() { return m_written >= target; });
+    }
+    const bool ok = !m_failed;
+    m_failed = false;
+    return ok;
+}
+
+void SettingsWriter::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable()) {
+            return;
+        }
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+SettingsWriter::Stats SettingsWriter::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+std::string SettingsWriter::GetLastError() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_last_error;
+}
+
+void SettingsWriter::WorkerLoop() {
+    UNILANG_TRACE_THREAD("SettingsWriter");
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        if (m_pending.empty()) {
+            if (m_stop) {
+                return;
+            }
+            m_wake.wait(lock);
+            continue;
+        }
+
+        // Wait for the changes to settle, unless someone is waiting for them
+        if (!m_flush && !m_stop) {
+            const Clock::time_point due = std::min(m_last_post + std::chrono::milliseconds(m_options.debounce_ms),
+                                                   m_first_post + std::chrono::milliseconds(m_options.max_delay_ms));
+            if (Clock::now() < due) {
+                m_wake.wait_until(lock, due);
+                continue;
+            }
+        }
+
+        std::map<Key, std::string> batch;
+        batch.swap(m_pending);
+        const uint64_t sequence = m_posted;
+        m_flush = false;
+        lock.unlock();
+
+        uint64_t writes = 0;
+        std::string error;
+        for (const auto& [key, value] : batch) {
+            std::string write_error;
+            if (WriteSection(key.first, key.second, value, write_error)) {
+                ++writes;
+            } else {
+                error = write_error;
+            }
+        }
+
+        lock.lock();
+        m_stats.writes += writes;
+        m_stats.failures += batch.size() - writes;
+        if (!error.empty()) {
+            m_last_error = error;
+            m_failed = true;
+        }
+        m_written = sequence;
+        m_done.notify_all();
+    }
+}
+
+bool SettingsWriter::WriteSection(const std::string& filepath, const std::string& section, std::string_view value,
+                                  std::string& error) {
+    UNILANG_TRACE_SCOPE("settings", "SettingsWriter::WriteSection");
+    std::string document;
+    {
+        std::ifstream file(filepath, std::ios::binary);
+        if (file.is_open()) {
+            std::stringstream contents;
+            contents << file.rdbuf();
+            document = contents.str();
+        } else {
+            // Only a missing file may start from scratch
+            std::error_code ec;
+            if (fs::exists(filepath, ec) || ec) {
+                error = "Failed to read " + filepath;
+                return false;
+            }
+        }
+    }
+
+    std::string merged;
+    if (!MergeSection(document, section, value, merged)) {
+        error = "Not a JSON object, left as it is: " + filepath;
+        return false;
+    }
+    return WriteFileAtomic(filepath, merged, error);
+}
+
+bool SettingsWriter::MergeSection(std::string_view document, std::string_view section, std::string_view value,
+                                  std::string& merged) {
+    merged.clear();
+
+    size_t pos = document.compare(0, 3, "\xEF\xBB\xBF") == 0 ? 3 : 0;
+    pos = SkipSpace(document, pos);
+    if (pos == document.size()) {
+        merged.append("{\n  \"").append(section).append("\": ");
+        AppendIndented(merged, value, "  ");
+        merged.append("\n}\n");
+        return true;
+    }
+    if (document[pos] != '{') {
+        return false;
+    }
+
+    const size_t open = pos;
+    size_t value_begin = NPOS;      // Of the section's member (the last one if repeated, as parsers do)
+    size_t value_end = NPOS;
+    size_t last_end = NPOS;         // End of the last member's value
+    pos = SkipSpace(document, pos + 1);
+    if (pos < document.size() && document[pos] != '}') {
+        for (;;) {
+            if (pos >= document.size() || document[pos] != '"') {
+                return false;
+            }
+            const size_t key_end = SkipString(document, pos);
+            if (key_end == NPOS) {
+                return false;
+            }
+            const std::string_view key = document.substr(pos + 1, key_end - pos - 2);
+            pos = SkipSpace(document, key_end);
+            if (pos >= document.size() || document[pos] != ':') {
+                return false;
+            }
+            pos = SkipSpace(document, pos + 1);
+            const size_t end = SkipValue(document, pos);
+            if (end == NPOS) {
+                return false;
+            }
+            if (key == section) {
+                value_begin = pos;
+                value_end = end;
+            }
+            last_end = end;
+
+            pos = SkipSpace(document, end);
+            if (pos < document.size() && document[pos] == ',') {
+                pos = SkipSpace(document, pos + 1);
+                continue;
+            }
+            break;
+        }
+    }
+    if (pos >= document.size() || document[pos] != '}' || SkipSpace(document, pos + 1) != document.size()) {
+        return false;
+    }
+
+    merged.reserve(document.size() + value.size() + section.size() + 8);
+    if (value_begin != NPOS) {
+        // Indent like the line the member is on
+        const size_t line = document.rfind('\n', value_begin) == NPOS ? 0 : document.rfind('\n', value_begin) + 1;
+        size_t indent_end = line;
+        while (indent_end < value_begin && (document[indent_end] == ' ' || document[indent_end] == '\t')) {
+            ++indent_end;
+        }
+        merged.append(document.substr(0, value_begin));
+        AppendIndented(merged, value, document.substr(line, indent_end - line));
+        merged.append(document.substr(value_end));
+    } else {
+        const size_t insert = last_end != NPOS ? last_end : open + 1;
+        merged.append(document.substr(0, insert));
+        merged.append(last_end != NPOS ? ",\n  \"" : "\n  \"").append(section).append("\": ");
+        AppendIndented(merged, value, "  ");
+        if (last_end == NPOS) {
+            merged += '\n';
+        }
+        merged.append(document.substr(insert));
+    }
+    return true;
+}
+
+bool SettingsWriter::WriteFileAtomic(const std::string& filepath, std::string_view data, std::string& error) {
+    const std::string temp_path = filepath + ".tmp";
+    FILE* file = std::fopen(temp_path.c_str(), "wb");
+    if (!file) {
+        error = "Failed to create " + temp_path;
+        return false;
+    }
+
+    // On disk before the rename, so the rename never exposes a file still in the page cache
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size() && std::fflush(file) == 0;
+#ifdef _WIN32
+    ok = ok && _commit(_fileno(file)) == 0;
+#else
+    ok = ok && fsync(fileno(file)) == 0;
+#endif
+    ok = std::fclose(file) == 0 && ok;
+
+    std::error_code ec;
+    if (ok) {
+        fs::rename(temp_path, filepath, ec);
+    }
+    if (!ok || ec) {
+        fs::remove(temp_path, ec);
+        error = "Failed to write " + filepath;
+        return false;
+    }
+
+#ifndef _WIN32
+    // Persist the rename itself
+    const fs::path parent = fs::path(filepath).parent_path();
+    const int dir = open(parent.empty() ? "." : parent.c_str(), O_RDONLY);
+    if (dir >= 0) {
+        fsync(dir);
+        close(dir);
+    }
+#endif
+    return true;
+}
+
+} // namespace UniLang
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <condition_variable>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace UniLang {
+
+/**
+ * @brief Write-behind persistence for one section of JSON config files
+ *
+ * Post() only records the section's new value in memory and returns; a
+ * background thread writes it once changes have settled for
+ * Options::debounce_ms (or at the latest after Options::max_delay_ms), so
+ * a burst of toggles costs one write. Only the latest value per file and
+ * section is kept.
+ *
+ * A write reads the file as text and splices the new value in place of
+ * the section's top-level member (MergeSection); the rest of the document
+ * is copied byte for byte, never parsed into a DOM and dumped again. The
+ * result goes to a temporary file next to the target, is flushed to disk
+ * and renamed over it, so a crash leaves either the old or the new file,
+ * never a torn one.
+ */
+class SettingsWriter {
+public:
+    struct Options {
+        uint32_t debounce_ms = 500;     // Quiet time before a write
+        uint32_t max_delay_ms = 5000;   // Longest a posted change waits under constant updates
+    };
+
+    struct Stats {
+        uint64_t posts = 0;             // Post() calls
+        uint64_t writes = 0;            // Files replaced
+        uint64_t failures = 0;          // Writes that failed (see GetLastError)
+    };
+
+    SettingsWriter();
+    explicit SettingsWriter(const Options& options);
+
+    /**
+     * @brief Write what is pending and stop the thread
+     */
+    ~SettingsWriter();
+
+    SettingsWriter(const SettingsWriter&) = delete;
+    SettingsWriter& operator=(const SettingsWriter&) = delete;
+
+    /**
+     * @brief Queue a new value for a section (any thread; starts the writer on first use)
+     * @param filepath JSON file holding the section (created if missing)
+     * @param section Top-level member name, e.g., "settings"
+     * @param value Serialized JSON value of the member
+     */
+    void Post(const std::string& filepath, const std::string& section, std::string value);
+
+    /**
+     * @brief Write everything posted so far now and wait for it
+     * @return false if a write since the last Flush failed
+     */
+    bool Flush();
+
+    /**
+     * @brief Flush and join the thread (Post restarts it)
+     */
+    void Stop();
+
+    Stats GetStats() const;
+    std::string GetLastError() const;
+
+    /**
+     * @brief Replace (or add) a top-level member of a JSON object, keeping the rest verbatim
+     *
+     * Continuation lines of `value` are indented like the member's line.
+     * An empty document becomes an object with just this member.
+     *
+     * @param document Text of a JSON object
+     * @param merged Receives the new text
+     * @return false if document is not a well-formed JSON object at the top level
+     */
+    static bool MergeSection(std::string_view document, std::string_view section, std::string_view value,
+                             std::string& merged);
+
+    /**
+     * @brief Replace a file with new contents through a flushed temporary file and a rename
+     * @return false on any I/O error (the old file is left untouched)
+     */
+    static bool WriteFileAtomic(const std::string& filepath, std::string_view data, std::string& error);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    using Key = std::pair<std::string, std::string>;  // File, section
+
+    void WorkerLoop();
+
+    /**
+     * @brief Merge one section into its file and replace the file
+     */
+    static bool WriteSection(const std::string& filepath, const std::string& section, std::string_view value,
+                             std::string& error);
+
+private:
+    Options m_options;
+    std::thread m_thread;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;     // Worker: new posts, flush or stop
+    std::condition_variable m_done;     // Flush(): a batch was written
+    std::map<Key, std::string> m_pending;   // Latest value per file and section (guarded by m_mutex)
+    Clock::time_point m_first_post;     // Oldest unwritten post (guarded by m_mutex)
+    Clock::time_point m_last_post;      // Newest post (guarded by m_mutex)
+    uint64_t m_posted = 0;              // Sequence number of the newest post (guarded by m_mutex)
+    uint64_t m_written = 0;             // Newest post written or failed (guarded by m_mutex)
+    bool m_flush = false;               // Write now, skipping the debounce (guarded by m_mutex)
+    bool m_stop = false;                // Guarded by m_mutex
+    bool m_failed = false;              // A write failed since the last Flush (guarded by m_mutex)
+    Stats m_stats;                      // Guarded by m_mutex
+    std::string m_last_error;           // Guarded by m_mutex
+};
+
+} // namespace UniLang
@@ -0,0 +1,140 @@
+#include "sha256.h"
+#include <algorithm>
+#include <cstring>
+
+namespace UniLang {
+
+namespace {
+
+const uint32_t ROUND_CONSTANTS[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+inline uint32_t RotateRight(uint32_t value, int bits) {
+    return (value >> bits) | (value << (32 - bits));
+}
+
+} // namespace
+
+void Sha256::Reset() {
+    static const uint32_t INITIAL_STATE[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    std::memcpy(m_state, INITIAL_STATE, sizeof(m_state));
+    m_block_size = 0;
+    m_length = 0;
+}
+
+void Sha256::Update(const void* data, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    m_length += size;
+
+    // Top up a partial block first, then hash whole blocks in place
+    if (m_block_size > 0) {
+        const size_t take = std::min(size, sizeof(m_block) - m_block_size);
+        std::memcpy(m_block + m_block_size, bytes, take);
+        m_block_size += take;
+        bytes += take;
+        size -= take;
+        if (m_block_size < sizeof(m_block)) {
+            return;
+        }
+        Transform(m_block);
+        m_block_size = 0;
+    }
+    for (; size >= sizeof(m_block); bytes += sizeof(m_block), size -= sizeof(m_block)) {
+        Transform(bytes);
+    }
+    std::memcpy(m_block, bytes, size);
+    m_block_size = size;
+}
+
+Sha256::Digest Sha256::Final() {
+    const uint64_t bit_length = m_length * 8;
+
+    // 0x80, zeros up to 56 mod 64, then the length big-endian
+    const uint8_t padding[64] = {0x80};
+    const size_t pad = (m_block_size < 56 ? 56 : 120) - m_block_size;
+    Update(padding, pad);
+    uint8_t length[8];
+    for (int i = 0; i < 8; ++i) {
+        length[i] = static_cast<uint8_t>(bit_length >> (56 - 8 * i));
+    }
+    Update(length, sizeof(length));
+
+    Digest digest;
+    for (int i = 0; i < 8; ++i) {
+        digest[4 * i] = static_cast<uint8_t>(m_state[i] >> 24);
+        digest[4 * i + 1] = static_cast<uint8_t>(m_state[i] >> 16);
+        digest[4 * i + 2] = static_cast<uint8_t>(m_state[i] >> 8);
+        digest[4 * i + 3] = static_cast<uint8_t>(m_state[i]);
+    }
+    return digest;
+}
+
+void Sha256::Transform(const uint8_t* block) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; ++i) {
+        w[i] = (uint32_t(block[4 * i]) << 24) | (uint32_t(block[4 * i + 1]) << 16) |
+               (uint32_t(block[4 * i + 2]) << 8) | uint32_t(block[4 * i + 3]);
+    }
+    for (int i = 16; i < 64; ++i) {
+        const uint32_t s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        const uint32_t s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+    uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+    for (int i = 0; i < 64; ++i) {
+        const uint32_t s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+        const uint32_t choose = (e & f) ^ (~e & g);
+        const uint32_t t1 = h + s1 + choose + ROUND_CONSTANTS[i] + w[i];
+        const uint32_t s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+        const uint32_t majority = (a & b) ^ (a & c) ^ (b & c);
+        const uint32_t t2 = s0 + majority;
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+
+    m_state[0] += a;
+    m_state[1] += b;
+    m_state[2] += c;
+    m_state[3] += d;
+    m_state[4] += e;
+    m_state[5] += f;
+    m_state[6] += g;
+    m_state[7] += h;
+}
+
+std::string Sha256::ToHex(const Digest& digest) {
+    static const char HEX[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(digest.size() * 2);
+    for (uint8_t byte : digest) {
+        hex += HEX[byte >> 4];
+        hex += HEX[byte & 0xF];
+    }
+    return hex;
+}
+
+std::string Sha256::Hash(std::string_view data) {
+    Sha256 hasher;
+    hasher.Update(data);
+    return ToHex(hasher.Final());
+}
+
+} // namespace UniLang
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace UniLang {
+
+/**
+ * @brief Incremental SHA-256 (FIPS 180-4)
+ *
+ * Fed as bytes arrive, so a download is verified the moment its last
+ * byte is written, without reading the file back.
+ */
+class Sha256 {
+public:
+    using Digest = std::array<uint8_t, 32>;
+
+    Sha256() { Reset(); }
+
+    void Reset();
+
+    /**
+     * @brief Hash more data
+     */
+    void Update(const void* data, size_t size);
+    void Update(std::string_view data) { Update(data.data(), data.size()); }
+
+    /**
+     * @brief Finish and return the digest (call Reset() before reusing)
+     */
+    Digest Final();
+
+    /**
+     * @brief Lowercase hex of a digest
+     */
+    static std::string ToHex(const Digest& digest);
+
+    /**
+     * @brief Hex digest of a whole buffer
+     */
+    static std::string Hash(std::string_view data);
+
+private:
+    void Transform(const uint8_t* block);
+
+    uint32_t m_state[8];
+    uint8_t m_block[64];
+    size_t m_block_size = 0;    // Bytes waiting in m_block
+    uint64_t m_length = 0;      // Total bytes hashed
+};
+
+} // namespace UniLang
@@ -1,49 +1,181 @@
 #include "shortcuts_dict.h"
+#include "trace.h"
+#include "unicode_utils.h"
 #include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <fstream>
+#include <sstream>
 #include <iostream>
+#ifdef _WIN32
 #include <Windows.h>
 #include "resource.h"
+#endif
 
 using json = nlohmann::json;
 
 namespace UniLang {
 
-ShortcutsDict::ShortcutsDict() {
+namespace {
+
+// FNV-1a; shortcuts are short ASCII keys, so this is cheap and spreads well
+uint32_t HashKey(std::string_view key) {
+    uint32_t hash = 2166136261u;
+    for (char ch : key) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 16777619u;
+    }
+    return hash;
 }
 
-bool ShortcutsDict::LoadFromResource() {
-    try {
-        // Find the JSON resource
-        HRSRC hResource = FindResourceW(nullptr, MAKEINTRESOURCEW(IDR_SHORTCUTS_JSON), L"JSON");
-        if (!hResource) {
-            return false;
+/**
+ * @brief Hash of one shortcut for the content hash
+ *
+ * FNV-1a over the NUL-separated fields, finished with the splitmix64
+ * mixer so that sums of entry hashes stay evenly spread.
+ */
+uint64_t HashEntry(std::string_view shortcut, std::string_view replacement, std::string_view category) {
+    uint64_t hash = 14695981039346656037ull;
+    for (std::string_view field : {shortcut, replacement, category}) {
+        for (char ch : field) {
+            hash ^= static_cast<unsigned char>(ch);
+            hash *= 1099511628211ull;
         }
+        hash *= 1099511628211ull;   // NUL separator
+    }
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+    return hash;
+}
 
-        // Load the resource
-        HGLOBAL hLoadedResource = LoadResource(nullptr, hResource);
-        if (!hLoadedResource) {
-            return false;
-        }
+/**
+ * @brief Fill in the output form of an entry's replacement
+ */
+void EncodeEntry(ShortcutsDict::Entry& entry) {
+    entry.utf16 = Utf8ToUtf16(entry.replacement);
+    entry.input_events = entry.utf16.size() * 2;
+}
 
-        // Lock the resource to get a pointer to the data
-        LPVOID pResourceData = LockResource(hLoadedResource);
-        if (!pResourceData) {
-            return false;
+bool ParseHash(const json& value, uint64_t& hash) {
+    const std::string text = value.get<std::string>();
+    if (text.size() != 16 || text.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+        return false;
+    }
+    hash = std::strtoull(text.c_str(), nullptr, 16);
+    return true;
+}
+
+/**
+ * @brief Grammar whose opener, name and terminator type a key, if any
+ */
+uint8_t FindGrammar(const TriggerGrammars& grammars, std::string_view key) {
+    for (size_t i = 0; i < grammars.GetCount(); ++i) {
+        const TriggerGrammars::Grammar& grammar = grammars.Get(static_cast<uint8_t>(i));
+        if (key.size() < grammar.key_prefix.size() + grammar.min_name ||
+            key.compare(0, grammar.key_prefix.size(), grammar.key_prefix) != 0) {
+            continue;
+        }
+        const std::string_view name = key.substr(grammar.key_prefix.size());
+        if (std::all_of(name.begin(), name.end(),
+                        [&grammar](char ch) { return TriggerGrammars::IsNameChar(grammar, ch); })) {
+            return static_cast<uint8_t>(i);
         }
+    }
+    return TriggerGrammars::NO_GRAMMAR;
+}
 
-        // Get resource size
-        DWORD dwResourceSize = SizeofResource(nullptr, hResource);
-        if (dwResourceSize == 0) {
-            return false;
+/**
+ * @brief Index of a category, added if new
+ * @return Category index, or NO_CATEGORY if a mask has no bit left for it
+ */
+uint8_t AddCategory(std::vector<std::string>& categories, std::string_view name) {
+    for (size_t i = 0; i < categories.size(); ++i) {
+        if (categories[i] == name) {
+            return static_cast<uint8_t>(i);
         }
+    }
+    if (categories.size() == ShortcutsDict::MAX_CATEGORIES) {
+        return ShortcutsDict::NO_CATEGORY;
+    }
+    categories.emplace_back(name);
+    return static_cast<uint8_t>(categories.size() - 1);
+}
 
-        // Parse JSON from memory
-        std::string jsonData(static_cast<const char*>(pResourceData), dwResourceSize);
-        json j = json::parse(jsonData);
+} // namespace
 
-        // Clear existing shortcuts
-        m_shortcuts.clear();
+ShortcutsDict::ShortcutsDict() {
+}
+
+#ifdef _WIN32
+bool ShortcutsDict::LoadFromResource() {
+    UNILANG_TRACE_SCOPE("dict", "ShortcutsDict::LoadFromResource");
+    // Find the JSON resource
+    HRSRC hResource = FindResourceW(nullptr, MAKEINTRESOURCEW(IDR_SHORTCUTS_JSON), L"JSON");
+    if (!hResource) {
+        return false;
+    }
+
+    // Load the resource
+    HGLOBAL hLoadedResource = LoadResource(nullptr, hResource);
+    if (!hLoadedResource) {
+        return false;
+    }
+
+    // Lock the resource to get a pointer to the data
+    LPVOID pResourceData = LockResource(hLoadedResource);
+    if (!pResourceData) {
+        return false;
+    }
+
+    // Get resource size
+    DWORD dwResourceSize = SizeofResource(nullptr, hResource);
+    if (dwResourceSize == 0) {
+        return false;
+    }
+
+    // Parse JSON from memory
+    std::string jsonData(static_cast<const char*>(pResourceData), dwResourceSize);
+    return ParseJson(jsonData);
+}
+#endif
+
+bool ShortcutsDict::LoadFromFile(const std::string& filepath) {
+    UNILANG_TRACE_SCOPE("dict", "ShortcutsDict::LoadFromFile");
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        // std::cerr << "Failed to open shortcuts file: " << filepath << std::endl;
+        return false;
+    }
+
+    std::stringstream contents;
+    contents << file.rdbuf();
+    return ParseJson(contents.str());
+}
+
+bool ShortcutsDict::LoadFromString(const std::string& json_text) {
+    return ParseJson(json_text);
+}
+
+bool ShortcutsDict::ParseJson(const std::string& json_text) {
+    UNILANG_TRACE_SCOPE("dict", "ShortcutsDict::ParseJson");
+    try {
+        json j;
+        {
+            UNILANG_TRACE_SCOPE("dict", "json::parse");
+            j = json::parse(json_text);
+        }
+
+        // Everything is parsed into locals and moved in at the end, so a
+        // document that fails anywhere leaves the dictionary as it was
+        std::unordered_map<std::string, std::string> shortcuts;
+        TriggerGrammars grammars = m_grammars;
+        grammars.Reset();
+        std::vector<std::string> categories;
+        std::unordered_map<std::string, uint8_t> shortcut_categories;
 
         // Load all shortcuts from nested structure
         if (j.contains("shortcuts")) {
@@ -55,68 +187,357 @@ bool ShortcutsDict::LoadFromResource() {
 
                 if (category.value().is_object()) {
                     // This is a category like "greek_lowercase", "math_operators", etc.
+                    const uint8_t index = AddCategory(categories, category.key());
+                    if (index == NO_CATEGORY) {
+                        // std::cerr << "Too many categories: " << category.key() << std::endl;
+                        return false;
+                    }
+
+                    // Keys of a category with its own grammar are bare names
+                    std::string prefix;
+                    if (category.value().contains("_grammar")) {
+                        const auto& declared = category.value()["_grammar"];
+                        TriggerGrammars::Grammar grammar;
+                        grammar.opener = declared.at("opener").get<std::string>();
+                        const std::string terminator = declared.value("terminator", " ");
+                        if (terminator.size() != 1) {
+                            // std::cerr << "Invalid terminator in " << category.key() << std::endl;
+                            return false;
+                        }
+                        grammar.terminator = terminator[0];
+                        grammar.key_prefix = grammar.opener;
+                        if (grammars.Add(grammar) == TriggerGrammars::NO_GRAMMAR) {
+                            // std::cerr << "Invalid grammar: " << grammars.GetLastError() << std::endl;
+                            return false;
+                        }
+                        prefix = grammar.key_prefix;
+                    }
+
                     for (auto& item : category.value().items()) {
-                        std::string shortcut = item.key();
+                        if (item.key() == "_grammar") continue;
+                        std::string shortcut = prefix + item.key();
                         std::string replacement = item.value();
-                        m_shortcuts[shortcut] = replacement;
+                        shortcuts[shortcut] = replacement;
+                        shortcut_categories[shortcut] = index;
                     }
                 }
             }
         }
 
+        // Context rules
+        std::vector<RuleSet::Rule> rules;
+        if (j.contains("rules")) {
+            for (const auto& item : j["rules"]) {
+                RuleSet::Rule rule;
+                rule.before = item.value("before", "");
+                rule.match = item.at("match").get<std::string>();
+                rule.after = item.value("after", "");
+                rule.replacement = item.at("replace").get<std::string>();
+                const std::string context = item.value("context", "");
+                if (context == "text") {
+                    rule.context = RuleSet::Context::Text;
+                } else if (context == "code") {
+                    rule.context = RuleSet::Context::Code;
+                }
+                const std::string category = item.value("category", "rules");
+                rule.category = AddCategory(categories, category);
+                if (rule.category == NO_CATEGORY) {
+                    // std::cerr << "Too many categories: " << category << std::endl;
+                    return false;
+                }
+                rules.push_back(std::move(rule));
+            }
+        }
+        RuleSet rule_set;
+        if (!rule_set.Compile(rules)) {
+            // std::cerr << "Invalid rules: " << rule_set.GetLastError() << std::endl;
+            return false;
+        }
+
+        // Autocorrect pairs
+        std::vector<WordAutomaton::Pair> word_pairs;
+        if (j.contains("autocorrect")) {
+            for (auto& item : j["autocorrect"].items()) {
+                word_pairs.emplace_back(item.key(), item.value().get<std::string>());
+            }
+        }
+        WordAutomaton words;
+        if (!words.Build(word_pairs)) {
+            // std::cerr << "Invalid autocorrect pair: " << words.GetLastError() << std::endl;
+            return false;
+        }
+
+        // Computed replacements have a category of their own
+        const uint8_t word_category = AddCategory(categories, "autocorrect");
+        const uint8_t family_category = AddCategory(categories, "symbol_families");
+        if (word_category == NO_CATEGORY || family_category == NO_CATEGORY) {
+            // std::cerr << "Too many categories" << std::endl;
+            return false;
+        }
+        words.SetCategory(word_category);
+
+        m_shortcuts = std::move(shortcuts);
+        m_rules = std::move(rule_set);
+        m_grammars = grammars;
+        m_words = std::move(words);
+        m_word_pairs = std::move(word_pairs);
+        m_categories = std::move(categories);
+        m_family_category = family_category;
+        BuildSnapshot(shortcut_categories);
+
         m_loaded = true;
-        // std::cout << "Loaded " << m_shortcuts.size() << " shortcuts from resource" << std::endl;
+        // std::cout << "Loaded " << m_shortcuts.size() << " shortcuts" << std::endl;
         return true;
 
     } catch (const std::exception& e) {
-        // std::cerr << "Error loading shortcuts from resource: " << e.what() << std::endl;
+        // std::cerr << "Error loading shortcuts: " << e.what() << std::endl;
         return false;
     }
 }
 
-bool ShortcutsDict::LoadFromFile(const std::string& filepath) {
-    try {
-        std::ifstream file(filepath);
-        if (!file.is_open()) {
-            // std::cerr << "Failed to open shortcuts file: " << filepath << std::endl;
+void ShortcutsDict::BuildSnapshot(const std::unordered_map<std::string, uint8_t>& categories) {
+    UNILANG_TRACE_SCOPE("dict", "ShortcutsDict::BuildSnapshot");
+    m_entries.clear();
+    m_entries.reserve(m_shortcuts.size() + m_rules.GetRuleCount());
+    m_content_hash = 0;
+
+    for (const auto& [shortcut, replacement] : m_shortcuts) {
+        Entry entry;
+        entry.shortcut = shortcut;
+        entry.replacement = replacement;
+        EncodeEntry(entry);
+        entry.grammar = FindGrammar(m_grammars, shortcut);
+        entry.category = categories.at(shortcut);
+        m_content_hash += HashEntry(shortcut, replacement, m_categories[entry.category]);
+
+        m_entries.push_back(std::move(entry));
+    }
+
+    m_rule_entry_base = static_cast<uint32_t>(m_entries.size());
+
+    // Rule replacements are reached by rule index, not by key
+    for (size_t rule = 0; rule < m_rules.GetRuleCount(); ++rule) {
+        Entry entry;
+        entry.shortcut = m_rules.GetRule(static_cast<uint32_t>(rule)).match;
+        entry.replacement = m_rules.GetRule(static_cast<uint32_t>(rule)).replacement;
+        EncodeEntry(entry);
+        entry.category = m_rules.GetRule(static_cast<uint32_t>(rule)).category;
+        m_entries.push_back(std::move(entry));
+    }
+
+    BuildIndex();
+}
+
+void ShortcutsDict::BuildIndex() {
+    UNILANG_TRACE_SCOPE("dict", "ShortcutsDict::BuildIndex");
+    // Index at <= 50% load so probes stay short
+    size_t capacity = 16;
+    while (capacity < m_rule_entry_base * size_t(2)) {
+        capacity *= 2;
+    }
+    m_index.assign(capacity, INVALID_ENTRY_ID);
+
+    const size_t mask = capacity - 1;
+    for (uint32_t id = 0; id < m_rule_entry_base; ++id) {
+        size_t slot = HashKey(m_entries[id].shortcut) & mask;
+        while (m_index[slot] != INVALID_ENTRY_ID) {
+            slot = (slot + 1) & mask;
+        }
+        m_index[slot] = id;
+    }
+}
+
+bool ShortcutsDict::LoadFromDiff(const ShortcutsDict& base, const Diff& diff) {
+    UNILANG_TRACE_SCOPE("dict", "ShortcutsDict::LoadFromDiff");
+    if (!base.m_loaded || base.m_content_hash != diff.base_hash) {
+        // std::cerr << "Diff doesn't apply to the loaded shortcuts" << std::endl;
+        return false;
+    }
+
+    std::unordered_map<std::string, std::string> shortcuts = base.m_shortcuts;
+    std::vector<std::string> categories = base.m_categories;
+    uint64_t content_hash = base.m_content_hash;
+
+    // Unchanged entries are copied as encoded; removed ones are skipped
+    std::vector<uint8_t> removed(base.m_rule_entry_base, 0);
+    for (const std::string& shortcut : diff.removed) {
+        const uint32_t id = base.FindEntryId(shortcut);
+        if (id == INVALID_ENTRY_ID || removed[id]) {
+            // std::cerr << "Diff removes a missing shortcut: " << shortcut << std::endl;
             return false;
         }
+        removed[id] = 1;
+        const Entry& entry = base.m_entries[id];
+        content_hash -= HashEntry(entry.shortcut, entry.replacement, base.m_categories[entry.category]);
+        shortcuts.erase(shortcut);
+    }
 
-        json j;
-        file >> j;
+    std::vector<Entry> entries;
+    entries.reserve(base.m_entries.size() - diff.removed.size() + diff.added.size());
+    std::vector<uint32_t> new_ids(base.m_rule_entry_base, INVALID_ENTRY_ID);
+    for (uint32_t id = 0; id < base.m_rule_entry_base; ++id) {
+        if (!removed[id]) {
+            new_ids[id] = static_cast<uint32_t>(entries.size());
+            entries.push_back(base.m_entries[id]);
+        }
+    }
 
-        // Clear existing shortcuts
-        m_shortcuts.clear();
+    auto set_category = [&categories](Entry& entry, const std::string& name) {
+        entry.category = AddCategory(categories, name);
+        return entry.category != NO_CATEGORY;
+    };
 
-        // Load all shortcuts from nested structure
-        if (j.contains("shortcuts")) {
-            auto shortcuts_obj = j["shortcuts"];
+    for (const Diff::Item& item : diff.changed) {
+        const uint32_t id = base.FindEntryId(item.shortcut);
+        if (id == INVALID_ENTRY_ID || removed[id]) {
+            // std::cerr << "Diff changes a missing shortcut: " << item.shortcut << std::endl;
+            return false;
+        }
+        Entry& entry = entries[new_ids[id]];
+        content_hash -= HashEntry(entry.shortcut, entry.replacement, categories[entry.category]);
+        entry.replacement = item.replacement;
+        EncodeEntry(entry);
+        if (!set_category(entry, item.category)) {
+            return false;
+        }
+        content_hash += HashEntry(item.shortcut, item.replacement, item.category);
+        shortcuts[item.shortcut] = item.replacement;
+    }
 
-            // Iterate through all categories
-            for (auto& category : shortcuts_obj.items()) {
-                if (category.key() == "_comment") continue;
+    for (const Diff::Item& item : diff.added) {
+        if (!shortcuts.emplace(item.shortcut, item.replacement).second) {
+            // std::cerr << "Diff adds an existing shortcut: " << item.shortcut << std::endl;
+            return false;
+        }
+        Entry entry;
+        entry.shortcut = item.shortcut;
+        entry.replacement = item.replacement;
+        EncodeEntry(entry);
+        entry.grammar = FindGrammar(base.m_grammars, item.shortcut);
+        if (!set_category(entry, item.category)) {
+            return false;
+        }
+        content_hash += HashEntry(item.shortcut, item.replacement, item.category);
+        entries.push_back(std::move(entry));
+    }
 
-                if (category.value().is_object()) {
-                    // This is a category like "greek_lowercase", "math_operators", etc.
-                    for (auto& item : category.value().items()) {
-                        std::string shortcut = item.key();
-                        std::string replacement = item.value();
-                        m_shortcuts[shortcut] = replacement;
-                    }
-                }
+    if (content_hash != diff.target_hash) {
+        // std::cerr << "Shortcuts don't match the diff's target hash" << std::endl;
+        return false;
+    }
+
+    const uint32_t rule_entry_base = static_cast<uint32_t>(entries.size());
+    entries.insert(entries.end(), base.m_entries.begin() + base.m_rule_entry_base, base.m_entries.end());
+
+    // Everything checked; nothing below can fail
+    if (this != &base) {
+        m_rules = base.m_rules;
+        m_grammars = base.m_grammars;
+        m_words = base.m_words;
+        m_word_pairs = base.m_word_pairs;
+        m_family_category = base.m_family_category;
+    }
+    m_shortcuts = std::move(shortcuts);
+    m_entries = std::move(entries);
+    m_categories = std::move(categories);
+    m_rule_entry_base = rule_entry_base;
+    m_content_hash = content_hash;
+    BuildIndex();
+    m_loaded = true;
+    return true;
+}
+
+ShortcutsDict::Diff ShortcutsDict::ComputeDiff(const ShortcutsDict& from, const ShortcutsDict& to) {
+    UNILANG_TRACE_SCOPE("dict", "ShortcutsDict::ComputeDiff");
+    Diff diff;
+    diff.base_hash = from.m_content_hash;
+    diff.target_hash = to.m_content_hash;
+
+    for (uint32_t id = 0; id < to.m_rule_entry_base; ++id) {
+        const Entry& entry = to.m_entries[id];
+        const std::string& category = to.m_categories[entry.category];
+        const uint32_t old_id = from.FindEntryId(entry.shortcut);
+        if (old_id == INVALID_ENTRY_ID) {
+            diff.added.push_back({entry.shortcut, entry.replacement, category});
+            continue;
+        }
+        const Entry& old = from.m_entries[old_id];
+        if (old.replacement != entry.replacement || from.m_categories[old.category] != category) {
+            diff.changed.push_back({entry.shortcut, entry.replacement, category});
+        }
+    }
+    for (uint32_t id = 0; id < from.m_rule_entry_base; ++id) {
+        if (to.FindEntryId(from.m_entries[id].shortcut) == INVALID_ENTRY_ID) {
+            diff.removed.push_back(from.m_entries[id].shortcut);
+        }
+    }
+
+    // Entry order follows hashing, so sort for diffs that are stable between builds
+    auto by_key = [](const Diff::Item& a, const Diff::Item& b) { return a.shortcut < b.shortcut; };
+    std::sort(diff.added.begin(), diff.added.end(), by_key);
+    std::sort(diff.changed.begin(), diff.changed.end(), by_key);
+    std::sort(diff.removed.begin(), diff.removed.end());
+    return diff;
+}
+
+std::string ShortcutsDict::DiffToJson(const Diff& diff) {
+    auto items = [](const std::vector<Diff::Item>& list) {
+        json array = json::array();
+        for (const Diff::Item& item : list) {
+            array.push_back({{"shortcut", item.shortcut}, {"replace", item.replacement}, {"category", item.category}});
+        }
+        return array;
+    };
+
+    json j;
+    j["base"] = FormatHash(diff.base_hash);
+    j["target"] = FormatHash(diff.target_hash);
+    j["added"] = items(diff.added);
+    j["changed"] = items(diff.changed);
+    j["removed"] = diff.removed;
+    return j.dump(1);
+}
+
+bool ShortcutsDict::ParseDiff(const std::string& json_text, Diff& diff) {
+    UNILANG_TRACE_SCOPE("dict", "ShortcutsDict::ParseDiff");
+    try {
+        json j = json::parse(json_text);
+
+        Diff parsed;
+        if (!ParseHash(j.at("base"), parsed.base_hash) || !ParseHash(j.at("target"), parsed.target_hash)) {
+            // std::cerr << "Invalid hash in shortcuts diff" << std::endl;
+            return false;
+        }
+        auto items = [&j](const char* name, std::vector<Diff::Item>& list) {
+            if (!j.contains(name)) {
+                return;
+            }
+            for (const auto& item : j[name]) {
+                list.push_back({item.at("shortcut").get<std::string>(), item.at("replace").get<std::string>(),
+                                item.at("category").get<std::string>()});
             }
+        };
+        items("added", parsed.added);
+        items("changed", parsed.changed);
+        if (j.contains("removed")) {
+            parsed.removed = j["removed"].get<std::vector<std::string>>();
         }
 
-        m_loaded = true;
-        // std::cout << "Loaded " << m_shortcuts.size() << " shortcuts from " << filepath << std::endl;
+        diff = std::move(parsed);
         return true;
 
     } catch (const std::exception& e) {
-        // std::cerr << "Error loading shortcuts: " << e.what() << std::endl;
+        // std::cerr << "Error parsing shortcuts diff: " << e.what() << std::endl;
         return false;
     }
 }
 
+std::string ShortcutsDict::FormatHash(uint64_t hash) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+    return text;
+}
+
 std::optional<std::string> ShortcutsDict::FindReplacement(const std::string& shortcut) const {
     auto it = m_shortcuts.find(shortcut);
     if (it != m_shortcuts.end()) {
@@ -125,6 +546,94 @@ std::optional<std::string> ShortcutsDict::FindReplacement(const std::string& sho
     return std::nullopt;
 }
 
+const ShortcutsDict::Entry* ShortcutsDict::FindEntry(std::string_view shortcut) const {
+    uint32_t entry_id = FindEntryId(shortcut);
+    if (entry_id != INVALID_ENTRY_ID) {
+        return &m_entries[entry_id];
+    }
+    return nullptr;
+}
+
+uint32_t ShortcutsDict::FindEntryId(std::string_view shortcut) const {
+    if (m_index.empty()) {
+        return INVALID_ENTRY_ID;
+    }
+
+    const size_t mask = m_index.size() - 1;
+    size_t slot = HashKey(shortcut) & mask;
+    while (m_index[slot] != INVALID_ENTRY_ID) {
+        if (m_entries[m_index[slot]].shortcut == shortcut) {
+            return m_index[slot];
+        }
+        slot = (slot + 1) & mask;
+    }
+    return INVALID_ENTRY_ID;
+}
+
+bool ShortcutsDict::LoadWordList(const std::string& filepath) {
+    UNILANG_TRACE_SCOPE("dict", "ShortcutsDict::LoadWordList");
+    std::ifstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        // std::cerr << "Failed to open word list: " << filepath << std::endl;
+        return false;
+    }
+
+    // The list's pairs come after the dictionary's, so they win for repeated typos
+    std::vector<WordAutomaton::Pair> pairs = m_word_pairs;
+    {
+        std::stringstream contents;
+        contents << file.rdbuf();
+        WordAutomaton::ParseWordList(contents.str(), pairs);
+    }
+    WordAutomaton words;
+    if (!words.Build(std::move(pairs))) {
+        // std::cerr << "Invalid word list: " << words.GetLastError() << std::endl;
+        return false;
+    }
+    words.SetCategory(m_words.GetCategory());
+    m_words = std::move(words);
+    return true;
+}
+
+bool ShortcutsDict::SetTriggerKey(std::string_view trigger_key) {
+    return m_grammars.SetOpener(TriggerGrammars::LATEX, trigger_key);
+}
+
+std::string ShortcutsDict::GetTypedForm(std::string_view shortcut) const {
+    const uint8_t index = FindGrammar(m_grammars, shortcut);
+    if (index == TriggerGrammars::NO_GRAMMAR) {
+        return std::string(shortcut);
+    }
+
+    const TriggerGrammars::Grammar& grammar = m_grammars.Get(index);
+    std::string typed = grammar.opener;
+    typed.append(shortcut.substr(grammar.key_prefix.size()));
+    if (grammar.terminator != ' ') {
+        typed += grammar.terminator;
+    }
+    return typed;
+}
+
+uint8_t ShortcutsDict::FindCategory(std::string_view name) const {
+    for (size_t i = 0; i < m_categories.size(); ++i) {
+        if (m_categories[i] == name) {
+            return static_cast<uint8_t>(i);
+        }
+    }
+    return NO_CATEGORY;
+}
+
+uint64_t ShortcutsDict::GetCategoryMask(const std::vector<std::string>& disabled) const {
+    uint64_t mask = ALL_CATEGORIES;
+    for (const std::string& name : disabled) {
+        const uint8_t category = FindCategory(name);
+        if (category != NO_CATEGORY) {
+            mask &= ~(uint64_t(1) << category);
+        }
+    }
+    return mask;
+}
+
 const std::unordered_map<std::string, std::string>& ShortcutsDict::GetAllShortcuts() const {
     return m_shortcuts;
 }
@@ -1,8 +1,14 @@
 #pragma once
 
+#include "rule_set.h"
+#include "trigger_grammar.h"
+#include "word_automaton.h"
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <optional>
+#include <vector>
 
 namespace UniLang {
 
@@ -11,17 +17,87 @@ namespace UniLang {
  *
  * Loads shortcuts from JSON config file and provides lookup functionality.
  * Example: "\alpha" -> "α"
+ *
+ * After loading, every entry is encoded once into the form the output path
+ * needs (UTF-16 code units for SendInput), so firing a replacement never
+ * transcodes text on the keystroke path.
+ *
+ * An optional top-level "rules" array holds context rules (see RuleSet):
+ *   {"before": "[0-9]", "match": "deg", "replace": "°"}
+ *   {"match": "->", "replace": "→", "context": "text"}
+ * Their replacements are entries too, after the shortcut entries.
+ *
+ * A category may declare its own trigger grammar; its keys are then bare
+ * names, typed between the opener and the terminator (see TriggerGrammars):
+ *   "emoji": {"_grammar": {"opener": ":", "terminator": ":"}, "smile": "😄"}
+ * Categories without one are LaTeX shortcuts, keyed as typed ("\\al").
+ *
+ * An optional top-level "autocorrect" object holds typo corrections fired
+ * at word boundaries, without any opener (see WordAutomaton):
+ *   "autocorrect": {"teh": "the", "recieve": "receive"}
+ * Large lists live in a separate word list file (see LoadWordList).
+ *
+ * Every entry keeps the category it was listed in ("greek_lowercase",
+ * "superscript", "urls", ...) as a bit index. Rules are in the "rules"
+ * category unless they name one ("category": "arrows"), corrections are
+ * in "autocorrect" and computed \mathbb{R}-style patterns in
+ * "symbol_families". Matching takes a mask of enabled categories, so
+ * switching categories off (per app, say) is a single store of a new
+ * mask: nothing is rebuilt.
+ *
+ * The shortcut set has a content hash (GetContentHash): the sum of one
+ * hash per shortcut, replacement and category name, so it doesn't depend
+ * on load order and a change updates it without rehashing the rest.
+ * Updates can be shipped as a Diff between two hashes. LoadFromDiff builds
+ * a new snapshot from a loaded dictionary plus the diff: unchanged entries
+ * are copied with their encoded form, only new and changed replacements
+ * are encoded, and rules, grammars and autocorrect are taken over as they
+ * are. The old dictionary is untouched and can keep serving lookups (and
+ * the entries of queued output) until the caller swaps the new one in.
  */
 class ShortcutsDict {
 public:
+    struct Entry {
+        std::string shortcut;       // e.g., "\\al"
+        std::string replacement;    // UTF-8 replacement, e.g., "α"
+        std::u16string utf16;       // Pre-transcoded replacement for SendInput
+        size_t input_events = 0;    // Key down + key up per UTF-16 code unit
+        uint8_t grammar = TriggerGrammars::NO_GRAMMAR;  // Grammar that types the shortcut, if any
+        uint8_t category = 0;       // Bit index in a category mask (see GetCategoryName)
+    };
+
+    static constexpr uint32_t INVALID_ENTRY_ID = UINT32_MAX;
+    static const size_t MAX_CATEGORIES = 64;        // One bit each in a category mask
+    static constexpr uint64_t ALL_CATEGORIES = UINT64_MAX;
+    static const uint8_t NO_CATEGORY = 0xFF;
+
+    /**
+     * @brief Added, changed and removed shortcuts between two content hashes
+     */
+    struct Diff {
+        struct Item {
+            std::string shortcut;       // Key as stored, e.g., "\\al" or ":smile"
+            std::string replacement;
+            std::string category;       // Category name, created if the base lacks it
+        };
+
+        uint64_t base_hash = 0;         // Content hash the diff applies to
+        uint64_t target_hash = 0;       // Content hash after applying it
+        std::vector<Item> added;
+        std::vector<Item> changed;      // New replacement or category of an existing key
+        std::vector<std::string> removed;
+    };
+
     ShortcutsDict();
     ~ShortcutsDict() = default;
 
+#ifdef _WIN32
     /**
      * @brief Load shortcuts from embedded Windows resource
      * @return true if loaded successfully
      */
     bool LoadFromResource();
+#endif
 
     /**
      * @brief Load shortcuts from JSON file
@@ -30,6 +106,58 @@ public:
      */
     bool LoadFromFile(const std::string& filepath);
 
+    /**
+     * @brief Load shortcuts from JSON text already in memory
+     * @param json_text Contents of a shortcuts.json document
+     * @return true if loaded successfully
+     */
+    bool LoadFromString(const std::string& json_text);
+
+    /**
+     * @brief Build this dictionary from a loaded one plus a diff, without re-parsing
+     *
+     * Fails, leaving this dictionary as it was, if the base's content hash
+     * isn't diff.base_hash, a changed or removed key is missing, an added
+     * key already exists, or the result doesn't hash to diff.target_hash.
+     * `base` may be this dictionary.
+     *
+     * @param base Dictionary the diff was computed against
+     * @param diff Diff from ComputeDiff or ParseDiff
+     * @return true if applied
+     */
+    bool LoadFromDiff(const ShortcutsDict& base, const Diff& diff);
+
+    /**
+     * @brief Shortcut changes that turn `from` into `to` (keys sorted)
+     */
+    static Diff ComputeDiff(const ShortcutsDict& from, const ShortcutsDict& to);
+
+    /**
+     * @brief Serialize a diff as JSON (see ParseDiff)
+     */
+    static std::string DiffToJson(const Diff& diff);
+
+    /**
+     * @brief Parse a diff document:
+     *   {"base": "<hash>", "target": "<hash>",
+     *    "added": [{"shortcut": "\\al", "replace": "α", "category": "greek_lowercase"}],
+     *    "changed": [...], "removed": ["\\old"]}
+     * @return false if the document is malformed
+     */
+    static bool ParseDiff(const std::string& json_text, Diff& diff);
+
+    /**
+     * @brief Format a content hash as 16 lowercase hex digits (as in diffs and asset names)
+     */
+    static std::string FormatHash(uint64_t hash);
+
+    /**
+     * @brief Order-independent hash of the shortcuts, replacements and their category names
+     *
+     * Rules, autocorrect, the word list and the trigger key are not part of it.
+     */
+    uint64_t GetContentHash() const { return m_content_hash; }
+
     /**
      * @brief Find replacement for a shortcut
      * @param shortcut The shortcut to look up (e.g., "\\alpha")
@@ -37,6 +165,117 @@ public:
      */
     std::optional<std::string> FindReplacement(const std::string& shortcut) const;
 
+    /**
+     * @brief Find the pre-encoded entry for a shortcut
+     * @param shortcut The shortcut to look up (e.g., "\\alpha")
+     * @return Pointer to the entry, or nullptr if not found
+     */
+    const Entry* FindEntry(std::string_view shortcut) const;
+
+    /**
+     * @brief Find the entry ID for a shortcut without allocating
+     * @param shortcut The shortcut to look up (e.g., "\\al")
+     * @return Entry ID, or INVALID_ENTRY_ID if not found
+     */
+    uint32_t FindEntryId(std::string_view shortcut) const;
+
+    /**
+     * @brief Find the entry ID for a shortcut whose category is enabled
+     * @param categories Mask of enabled categories
+     * @return Entry ID, or INVALID_ENTRY_ID if not found or switched off
+     */
+    uint32_t FindEntryId(std::string_view shortcut, uint64_t categories) const {
+        const uint32_t entry_id = FindEntryId(shortcut);
+        if (entry_id != INVALID_ENTRY_ID && !IsEnabled(categories, m_entries[entry_id].category)) {
+            return INVALID_ENTRY_ID;
+        }
+        return entry_id;
+    }
+
+    /**
+     * @brief Get an entry by ID (IDs are stable until the next load)
+     */
+    const Entry& GetEntry(uint32_t entry_id) const { return m_entries[entry_id]; }
+
+    /**
+     * @brief Number of shortcut entries (rule entries follow at higher IDs)
+     */
+    size_t GetEntryCount() const { return m_rule_entry_base; }
+
+    /**
+     * @brief Context rules compiled from the "rules" array
+     */
+    const RuleSet& GetRules() const { return m_rules; }
+
+    /**
+     * @brief Entry ID holding a rule's replacement
+     */
+    uint32_t GetRuleEntryId(uint32_t rule) const { return m_rule_entry_base + rule; }
+
+    /**
+     * @brief Autocorrect words from the "autocorrect" object and the word list
+     */
+    const WordAutomaton& GetWords() const { return m_words; }
+
+    /**
+     * @brief Add a word list file (see WordAutomaton::ParseWordList) to autocorrect
+     *
+     * The list is compiled together with the dictionary's "autocorrect"
+     * pairs; only the compiled automaton is kept. Loading the dictionary
+     * again drops the list.
+     *
+     * @param filepath Path to the word list
+     * @return false if the file can't be read or a correction is invalid
+     */
+    bool LoadWordList(const std::string& filepath);
+
+    /**
+     * @brief Trigger grammars of the loaded categories (LaTeX first)
+     */
+    const TriggerGrammars& GetGrammars() const { return m_grammars; }
+
+    /**
+     * @brief Set the key typed to start a LaTeX shortcut (Settings::trigger_key)
+     *
+     * Dictionary keys keep their "\\" prefix: with ";" as the trigger key,
+     * typing ";al " still finds "\\al". Applies to later loads too.
+     *
+     * @return false if the key can't be an opener or another category uses it
+     */
+    bool SetTriggerKey(std::string_view trigger_key);
+
+    /**
+     * @brief Text typed for a shortcut, without a space terminator (e.g., ":smile" -> ":smile:")
+     */
+    std::string GetTypedForm(std::string_view shortcut) const;
+
+    /**
+     * @brief Check whether a category is enabled in a mask
+     */
+    static bool IsEnabled(uint64_t categories, uint8_t category) { return ((categories >> category) & 1) != 0; }
+
+    /**
+     * @brief Find a category by name
+     * @return Category index, or NO_CATEGORY
+     */
+    uint8_t FindCategory(std::string_view name) const;
+
+    size_t GetCategoryCount() const { return m_categories.size(); }
+    const std::string& GetCategoryName(uint8_t category) const { return m_categories[category]; }
+
+    /**
+     * @brief Category of computed symbol family patterns (\mathbb{R}, \hat{a})
+     */
+    uint8_t GetFamilyCategory() const { return m_family_category; }
+
+    /**
+     * @brief Mask enabling every category but the named ones
+     *
+     * Unknown names are ignored, so settings written for another
+     * dictionary still apply.
+     */
+    uint64_t GetCategoryMask(const std::vector<std::string>& disabled) const;
+
     /**
      * @brief Get all shortcuts (for UI display)
      * @return Map of shortcuts to replacements
@@ -53,8 +292,35 @@ public:
      */
     size_t GetShortcutCount() const { return m_shortcuts.size(); }
 
+private:
+    /**
+     * @brief Parse a shortcuts.json document and rebuild the snapshot
+     */
+    bool ParseJson(const std::string& json_text);
+
+    /**
+     * @brief Encode every shortcut into its output form (called once per load)
+     * @param categories Category of each shortcut
+     */
+    void BuildSnapshot(const std::unordered_map<std::string, uint8_t>& categories);
+
+    /**
+     * @brief Rebuild the lookup index over the shortcut entries
+     */
+    void BuildIndex();
+
 private:
     std::unordered_map<std::string, std::string> m_shortcuts;
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_index;  // Open-addressing hash table of entry IDs (power-of-two size)
+    RuleSet m_rules;
+    TriggerGrammars m_grammars;
+    WordAutomaton m_words;
+    std::vector<WordAutomaton::Pair> m_word_pairs;  // The dictionary's own "autocorrect" pairs
+    std::vector<std::string> m_categories;          // Category index -> name
+    uint8_t m_family_category = 0;
+    uint32_t m_rule_entry_base = 0;
+    uint64_t m_content_hash = 0;
     bool m_loaded = false;
 };
 
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace UniLang {
+
+/**
+ * @brief Bounded single-producer/single-consumer ring buffer
+ *
+ * Lock-free and allocation-free: TryPush and TryPop never block, so the
+ * producer side is safe to call from the low-level keyboard hook.
+ * Capacity must be a power of two.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * @brief Enqueue an item (producer thread only)
+     * @return false if the queue is full
+     */
+    bool TryPush(const T& item) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cached_head == Capacity) {
+            m_cached_head = m_head.load(std::memory_order_acquire);
+            if (tail - m_cached_head == Capacity) {
+                return false;
+            }
+        }
+        m_items[tail & (Capacity - 1)] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Free slots (producer thread only); the consumer can only add to them
+     */
+    size_t FreeSlots() {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        m_cached_head = m_head.load(std::memory_order_acquire);
+        return Capacity - (tail - m_cached_head);
+    }
+
+    /**
+     * @brief Dequeue an item (consumer thread only)
+     * @return false if the queue is empty
+     */
+    bool TryPop(T& item) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cached_tail) {
+            m_cached_tail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cached_tail) {
+                return false;
+            }
+        }
+        item = m_items[head & (Capacity - 1)];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Check for pending items (either thread; result may be stale)
+     */
+    bool Empty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t GetCapacity() { return Capacity; }
+
+private:
+    static const size_t CACHE_LINE = 64;
+
+    // Consumer-owned
+    alignas(CACHE_LINE) std::atomic<size_t> m_head{0};
+    size_t m_cached_tail = 0;
+
+    // Producer-owned
+    alignas(CACHE_LINE) std::atomic<size_t> m_tail{0};
+    size_t m_cached_head = 0;
+
+    alignas(CACHE_LINE) std::array<T, Capacity> m_items{};
+};
+
+} // namespace UniLang
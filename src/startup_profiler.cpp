@@ -0,0 +1,45 @@
+#include "startup_profiler.h"
+#include "metrics.h"
+#include "trace.h"
+#include <nlohmann/json.hpp>
+
+namespace UniLang {
+
+StartupProfiler::StartupProfiler()
+    : m_origin(TickClock::Now()), m_phase_start(m_origin) {
+    m_phases.reserve(16);
+}
+
+void StartupProfiler::Mark(const char* name) {
+    const uint64_t now = TickClock::Now();
+    m_phases.push_back(Phase{name, m_phase_start, now});
+    UNILANG_TRACE_SPAN("startup", name, m_phase_start, now);
+    m_phase_start = now;
+}
+
+void StartupProfiler::Restart() {
+    m_phase_start = TickClock::Now();
+}
+
+std::string StartupProfiler::ToJson() const {
+    const double ms_per_tick = TickClock::GetNanosecondsPerTick() / 1e6;
+
+    nlohmann::json phases = nlohmann::json::array();
+    double total_ms = 0.0;
+    for (const Phase& phase : m_phases) {
+        const double ms = static_cast<double>(phase.end - phase.start) * ms_per_tick;
+        phases.push_back({
+            {"name", phase.name},
+            {"start_ms", static_cast<double>(phase.start - m_origin) * ms_per_tick},
+            {"ms", ms}
+        });
+        total_ms += ms;
+    }
+
+    nlohmann::json report;
+    report["phases"] = std::move(phases);
+    report["total_ms"] = total_ms;
+    return report.dump(2);
+}
+
+} // namespace UniLang
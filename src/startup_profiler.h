@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace UniLang {
+
+/**
+ * @brief Times the phases of application startup
+ *
+ * Each Mark() ends the running phase under the given name and starts the
+ * next one, so a startup sequence reads as a list of marks. Work deferred
+ * until later (e.g., after the first key press) calls Restart() first,
+ * leaving the idle time before it out. Phases keep their offset from
+ * construction, so the report shows when deferred work ran, too.
+ *
+ * Marks are also emitted as "startup" trace spans in builds with tracing.
+ */
+class StartupProfiler {
+public:
+    struct Phase {
+        const char* name;           // String literal
+        uint64_t start = 0;         // TickClock values
+        uint64_t end = 0;
+    };
+
+    /**
+     * @brief Start the first phase
+     */
+    StartupProfiler();
+
+    /**
+     * @brief End the running phase and start the next one
+     * @param name String literal
+     */
+    void Mark(const char* name);
+
+    /**
+     * @brief Start the next phase now, without recording the time since the last mark
+     */
+    void Restart();
+
+    const std::vector<Phase>& GetPhases() const { return m_phases; }
+
+    /**
+     * @brief Phases as JSON: name, start offset and duration in milliseconds, and their total
+     */
+    std::string ToJson() const;
+
+private:
+    uint64_t m_origin;
+    uint64_t m_phase_start;
+    std::vector<Phase> m_phases;
+};
+
+} // namespace UniLang
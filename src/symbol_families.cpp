@@ -0,0 +1,213 @@
+#include "symbol_families.h"
+#include "unicode_utils.h"
+#include <cstring>
+
+namespace UniLang {
+
+/**
+ * @brief One family: offset ranges, exceptions and an optional combining mark
+ */
+struct SymbolFamily {
+    struct Range {
+        char32_t first;             // First source code point
+        char32_t last;              // Last source code point
+        char32_t target;            // Code point for `first`; the rest follow in order
+    };
+
+    std::string_view name;
+    const Range* ranges;
+    size_t range_count;
+    const char* exception_chars;    // ASCII characters with an exceptional form
+    const char* exception_text;     // Their forms, one code point each, in the same order
+    char32_t mark;                  // Accents: combining mark for anything else
+};
+
+namespace {
+
+using Range = SymbolFamily::Range;
+
+// Mathematical Alphanumeric Symbols (U+1D400-1D7FF): each style has a run
+// for A-Z, a-z and, for some styles, Greek and digits. Greek runs follow the
+// order of U+0391-03A9 / U+03B1-03C9, so one offset covers each case.
+#define LATIN(upper) {U'A', U'Z', upper}, {U'a', U'z', upper + 26}
+#define GREEK(upper) {U'\u0391', U'\u03A9', upper}, {U'\u03B1', U'\u03C9', upper + 26}
+#define DIGITS(zero) {U'0', U'9', zero}
+
+const Range kBold[] = {LATIN(0x1D400), GREEK(0x1D6A8), DIGITS(0x1D7CE)};
+const Range kItalic[] = {LATIN(0x1D434), GREEK(0x1D6E2)};
+const Range kBoldItalic[] = {LATIN(0x1D468), GREEK(0x1D71C), DIGITS(0x1D7CE)};
+const Range kScript[] = {LATIN(0x1D49C)};
+const Range kFraktur[] = {LATIN(0x1D504)};
+const Range kDoubleStruck[] = {LATIN(0x1D538), DIGITS(0x1D7D8)};
+const Range kSans[] = {LATIN(0x1D5A0), DIGITS(0x1D7E2)};
+const Range kSansBold[] = {LATIN(0x1D5D4), GREEK(0x1D756), DIGITS(0x1D7EC)};
+const Range kSansItalic[] = {LATIN(0x1D608)};
+const Range kMonospace[] = {LATIN(0x1D670), DIGITS(0x1D7F6)};
+
+#undef LATIN
+#undef GREEK
+#undef DIGITS
+
+#define RANGES(table) table, sizeof(table) / sizeof(table[0])
+
+// Holes in the math alphabets: these letters were encoded earlier in
+// Letterlike Symbols. Accents: precomposed Latin letters (NFC of letter + mark).
+const SymbolFamily kFamilies[] = {
+    // Math alphabets
+    {"mathbf", RANGES(kBold), "", "", 0},
+    {"mathit", RANGES(kItalic), "h", "ℎ", 0},
+    {"boldsymbol", RANGES(kBoldItalic), "", "", 0},
+    {"bm", RANGES(kBoldItalic), "", "", 0},
+    {"mathbfit", RANGES(kBoldItalic), "", "", 0},
+    {"mathcal", RANGES(kScript), "BEFHILMRego", "ℬℰℱℋℐℒℳℛℯℊℴ", 0},
+    {"mathscr", RANGES(kScript), "BEFHILMRego", "ℬℰℱℋℐℒℳℛℯℊℴ", 0},
+    {"mathfrak", RANGES(kFraktur), "CHIRZ", "ℭℌℑℜℨ", 0},
+    {"mathbb", RANGES(kDoubleStruck), "CHNPQRZ", "ℂℍℕℙℚℝℤ", 0},
+    {"mathsf", RANGES(kSans), "", "", 0},
+    {"mathbfsf", RANGES(kSansBold), "", "", 0},
+    {"mathsfit", RANGES(kSansItalic), "", "", 0},
+    {"mathtt", RANGES(kMonospace), "", "", 0},
+
+    // Short forms in the style of the shortcuts dictionary (\bb{R})
+    {"bf", RANGES(kBold), "", "", 0},
+    {"bb", RANGES(kDoubleStruck), "CHNPQRZ", "ℂℍℕℙℚℝℤ", 0},
+    {"cal", RANGES(kScript), "BEFHILMRego", "ℬℰℱℋℐℒℳℛℯℊℴ", 0},
+    {"frak", RANGES(kFraktur), "CHIRZ", "ℭℌℑℜℨ", 0},
+
+    // Accents
+    {"grave", nullptr, 0, "aeinouwyAEINOUWY", "àèìǹòùẁỳÀÈÌǸÒÙẀỲ", U'\u0300'},
+    {"acute", nullptr, 0, "acegiklmnoprsuwyzACEGIKLMNOPRSUWYZ",
+     "áćéǵíḱĺḿńóṕŕśúẃýźÁĆÉǴÍḰĹḾŃÓṔŔŚÚẂÝŹ", U'\u0301'},
+    {"hat", nullptr, 0, "aceghijosuwyzACEGHIJOSUWYZ", "âĉêĝĥîĵôŝûŵŷẑÂĈÊĜĤÎĴÔŜÛŴŶẐ", U'\u0302'},
+    {"widehat", nullptr, 0, "aceghijosuwyzACEGHIJOSUWYZ", "âĉêĝĥîĵôŝûŵŷẑÂĈÊĜĤÎĴÔŜÛŴŶẐ", U'\u0302'},
+    {"tilde", nullptr, 0, "aeinouvyAEINOUVY", "ãẽĩñõũṽỹÃẼĨÑÕŨṼỸ", U'\u0303'},
+    {"widetilde", nullptr, 0, "aeinouvyAEINOUVY", "ãẽĩñõũṽỹÃẼĨÑÕŨṼỸ", U'\u0303'},
+    {"bar", nullptr, 0, "aegiouyAEGIOUY", "āēḡīōūȳĀĒḠĪŌŪȲ", U'\u0304'},
+    {"breve", nullptr, 0, "aegiouAEGIOU", "ăĕğĭŏŭĂĔĞĬŎŬ", U'\u0306'},
+    {"dot", nullptr, 0, "abcdefghmnoprstwxyzABCDEFGHIMNOPRSTWXYZ",
+     "ȧḃċḋėḟġḣṁṅȯṗṙṡṫẇẋẏżȦḂĊḊĖḞĠḢİṀṄȮṖṘṠṪẆẊẎŻ", U'\u0307'},
+    {"ddot", nullptr, 0, "aehiotuwxyAEHIOUWXY", "äëḧïöẗüẅẍÿÄËḦÏÖÜẄẌŸ", U'\u0308'},
+    {"check", nullptr, 0, "acdeghijklnorstuzACDEGHIKLNORSTUZ",
+     "ǎčďěǧȟǐǰǩľňǒřšťǔžǍČĎĚǦȞǏǨĽŇǑŘŠŤǓŽ", U'\u030C'},
+    {"overline", nullptr, 0, "", "", U'\u0305'},
+    {"underline", nullptr, 0, "", "", U'\u0332'},
+    {"vec", nullptr, 0, "", "", U'\u20D7'},
+};
+
+#undef RANGES
+
+bool IsAsciiAlnum(char ch) {
+    return (ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+}
+
+bool IsAsciiLetter(char ch) {
+    return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+}
+
+/**
+ * @brief Split "\name{arg}" into family and argument
+ */
+const SymbolFamily* ParseKey(std::string_view key, std::string_view& argument) {
+    if (key.size() < 4 || key.front() != '\\' || key.back() != '}') {
+        return nullptr;
+    }
+    const size_t open = key.find('{');
+    if (open == std::string_view::npos || open < 2 || open + 2 >= key.size()) {
+        return nullptr;
+    }
+    for (size_t i = 1; i < open; ++i) {
+        if (!IsAsciiLetter(key[i])) {
+            return nullptr;
+        }
+    }
+
+    argument = key.substr(open + 1, key.size() - open - 2);
+    return FindSymbolFamily(key.substr(1, open - 1));
+}
+
+bool HasForm(const SymbolFamily& family, char ch) {
+    if (!IsAsciiAlnum(ch)) {
+        return false;
+    }
+    if (family.mark != 0 || std::strchr(family.exception_chars, ch) != nullptr) {
+        return true;
+    }
+    for (size_t i = 0; i < family.range_count; ++i) {
+        if (static_cast<char32_t>(ch) >= family.ranges[i].first &&
+            static_cast<char32_t>(ch) <= family.ranges[i].last) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+const SymbolFamily* FindSymbolFamily(std::string_view name) {
+    // Few enough names that a linear scan beats sorting on first use
+    for (const SymbolFamily& family : kFamilies) {
+        if (family.name == name) {
+            return &family;
+        }
+    }
+    return nullptr;
+}
+
+bool AppendSymbolFamilyChar(const SymbolFamily& family, char32_t cp, std::string& out) {
+    if (cp != 0 && cp < 0x80) {
+        if (const char* hit = std::strchr(family.exception_chars, static_cast<char>(cp))) {
+            // Exception forms are one code point each, in the order of exception_chars
+            const std::string_view text(family.exception_text);
+            size_t pos = 0;
+            for (const char* p = family.exception_chars; p != hit; ++p) {
+                DecodeUtf8(text, pos);
+            }
+            AppendUtf8(out, DecodeUtf8(text, pos));
+            return true;
+        }
+    }
+
+    for (size_t i = 0; i < family.range_count; ++i) {
+        const Range& range = family.ranges[i];
+        if (cp >= range.first && cp <= range.last) {
+            AppendUtf8(out, range.target + (cp - range.first));
+            return true;
+        }
+    }
+
+    if (family.mark != 0 && cp != ' ') {
+        AppendUtf8(out, cp);
+        AppendUtf8(out, family.mark);
+        return true;
+    }
+    return false;
+}
+
+bool IsSymbolFamilyKey(std::string_view key) {
+    std::string_view argument;
+    const SymbolFamily* family = ParseKey(key, argument);
+    if (family == nullptr) {
+        return false;
+    }
+    for (char ch : argument) {
+        if (!HasForm(*family, ch)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ExpandSymbolFamily(std::string_view key, std::string& out) {
+    if (!IsSymbolFamilyKey(key)) {
+        return false;
+    }
+
+    std::string_view argument;
+    const SymbolFamily* family = ParseKey(key, argument);
+    for (char ch : argument) {
+        AppendSymbolFamilyChar(*family, static_cast<unsigned char>(ch), out);
+    }
+    return true;
+}
+
+} // namespace UniLang
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace UniLang {
+
+/**
+ * @brief Symbol families: \mathbb{R} -> ℝ, \hat{a} -> â, ...
+ *
+ * A family maps the characters of its argument through code point offset
+ * ranges (the Mathematical Alphanumeric Symbols block is laid out in
+ * parallel A-Z / a-z / 0-9 / Greek runs), a short exception list for the
+ * letters Unicode encoded earlier in Letterlike Symbols (ℂ, ℋ, ℎ, ...) or as
+ * precomposed Latin letters, and for accents a combining mark for
+ * everything else. Thousands of outputs come from a few KB of tables
+ * instead of one dictionary entry each.
+ */
+struct SymbolFamily;
+
+/**
+ * @brief Look up a family by command name (without the backslash)
+ * @return Family, or nullptr if the name is not a family (e.g., "mathrm")
+ */
+const SymbolFamily* FindSymbolFamily(std::string_view name);
+
+/**
+ * @brief Append the family form of one code point
+ * @return false (nothing appended) if the family has no form for it
+ */
+bool AppendSymbolFamilyChar(const SymbolFamily& family, char32_t cp, std::string& out);
+
+/**
+ * @brief Check that a typed key is a complete family pattern: \name{arg}
+ *
+ * The argument must be non-empty ASCII letters or digits that all have a
+ * form in the family. Does not allocate.
+ */
+bool IsSymbolFamilyKey(std::string_view key);
+
+/**
+ * @brief Expand a family pattern (e.g., "\\mathbb{R}" -> "ℝ")
+ * @param key Pattern as typed
+ * @param out Receives the UTF-8 result (appended)
+ * @return false if the key is not a valid family pattern (see IsSymbolFamilyKey)
+ */
+bool ExpandSymbolFamily(std::string_view key, std::string& out);
+
+} // namespace UniLang
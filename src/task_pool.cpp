@@ -0,0 +1,125 @@
+#include "task_pool.h"
+#include "trace.h"
+
+namespace UniLang {
+
+namespace {
+
+// Identifies the pool worker running on this thread, so nested submits
+// go to the submitting worker's own deque
+thread_local const TaskPool* t_pool = nullptr;
+thread_local size_t t_worker_index = 0;
+
+} // namespace
+
+TaskPool::TaskPool(size_t thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+        if (thread_count == 0) {
+            thread_count = 1;
+        }
+    }
+
+    for (size_t i = 0; i < thread_count; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        m_threads.emplace_back(&TaskPool::Run, this, i);
+    }
+}
+
+TaskPool::~TaskPool() {
+    Wait();
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_stop = true;
+    }
+    m_wake_cv.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void TaskPool::Submit(Task task) {
+    const size_t index = t_pool == this
+        ? t_worker_index
+        : m_next_worker.fetch_add(1, std::memory_order_relaxed) % m_workers.size();
+
+    // Count before publishing so m_queued never underflows when the task is taken at once
+    m_unfinished.fetch_add(1, std::memory_order_relaxed);
+    m_queued.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mutex);
+        m_workers[index]->tasks.push_back(std::move(task));
+    }
+
+    // Taking the wake mutex orders this notify after any sleeper's predicate check
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+    }
+    m_wake_cv.notify_one();
+}
+
+void TaskPool::Wait() {
+    std::unique_lock<std::mutex> lock(m_wake_mutex);
+    m_done_cv.wait(lock, [this]() { return m_unfinished.load(std::memory_order_acquire) == 0; });
+}
+
+bool TaskPool::TakeTask(size_t index, Task& task) {
+    // Own deque: newest first
+    {
+        Worker& own = *m_workers[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // Steal: oldest first, starting with the next worker to spread contention
+    for (size_t offset = 1; offset < m_workers.size(); ++offset) {
+        Worker& victim = *m_workers[(index + offset) % m_workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_queued.fetch_sub(1, std::memory_order_relaxed);
+            m_steals.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void TaskPool::Run(size_t index) {
+    UNILANG_TRACE_THREAD("TaskPool worker");
+    t_pool = this;
+    t_worker_index = index;
+
+    Task task;
+    for (;;) {
+        if (TakeTask(index, task)) {
+            task();
+            task = nullptr;
+
+            if (m_unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                std::lock_guard<std::mutex> lock(m_wake_mutex);
+                m_done_cv.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_wake_mutex);
+        m_wake_cv.wait(lock, [this]() {
+            return m_stop || m_queued.load(std::memory_order_acquire) != 0;
+        });
+        if (m_stop) {
+            return;
+        }
+    }
+}
+
+} // namespace UniLang
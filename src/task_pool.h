@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace UniLang {
+
+/**
+ * @brief Fixed-size thread pool with per-worker deques and work stealing
+ *
+ * Each worker owns a deque: it pushes and pops its own tasks at the back
+ * (LIFO, cache-warm), and idle workers steal from the front of other deques
+ * (FIFO, oldest and usually largest work first). Tasks may submit further
+ * tasks, which land in the submitting worker's own deque - this is how a
+ * large file fans out into chunk tasks that other cores pick up.
+ */
+class TaskPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @param thread_count Number of workers (0 = one per hardware thread)
+     */
+    explicit TaskPool(size_t thread_count = 0);
+    ~TaskPool();
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    /**
+     * @brief Queue a task (callable from any thread, including tasks)
+     */
+    void Submit(Task task);
+
+    /**
+     * @brief Block until every submitted task, including nested ones, has run
+     */
+    void Wait();
+
+    size_t GetThreadCount() const { return m_threads.size(); }
+
+    /**
+     * @brief Number of tasks taken from another worker's deque
+     */
+    uint64_t GetStealCount() const { return m_steals.load(std::memory_order_relaxed); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    /**
+     * @brief Worker thread main loop
+     */
+    void Run(size_t index);
+
+    /**
+     * @brief Take a task from our own deque, or steal one from another worker
+     */
+    bool TakeTask(size_t index, Task& task);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+
+    std::atomic<size_t> m_queued{0};        // Tasks sitting in deques
+    std::atomic<size_t> m_unfinished{0};    // Tasks submitted but not yet finished
+    std::atomic<size_t> m_next_worker{0};   // Round robin for external submits
+    std::atomic<uint64_t> m_steals{0};
+    bool m_stop = false;
+
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake_cv;      // Work available or stopping
+    std::condition_variable m_done_cv;      // m_unfinished reached zero
+};
+
+} // namespace UniLang
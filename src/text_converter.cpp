@@ -0,0 +1,95 @@
+#include "text_converter.h"
+#include "shortcuts_dict.h"
+#include "symbol_families.h"
+#include "trace.h"
+#include <algorithm>
+
+namespace UniLang {
+
+TextConverter::TextConverter(const ShortcutsDict& dict)
+    : m_dict(dict) {
+}
+
+void TextConverter::Convert(std::string_view chunk, std::string& out) {
+    UNILANG_TRACE_SCOPE("convert", "TextConverter::Convert");
+    const uint64_t chunk_start = m_matcher.GetStreamPosition();
+
+    size_t offset = 0;
+    while (offset < chunk.size()) {
+        const PatternMatcher::FeedResult result =
+            m_matcher.Feed(chunk.substr(offset), m_dict, m_matches, MATCH_BATCH, m_categories);
+
+        for (size_t i = 0; i < result.match_count; ++i) {
+            const PatternMatcher::FeedMatch& match = m_matches[i];
+            EmitTo(match.position, chunk, chunk_start, out);
+            if (match.entry_id == PatternMatcher::FAMILY_ENTRY_ID) {
+                // Computed from the matched text itself (\mathbb{R})
+                m_family_key.clear();
+                EmitTo(match.position + match.length, chunk, chunk_start, m_family_key);
+                ExpandSymbolFamily(m_family_key, out);
+            } else if (match.entry_id == PatternMatcher::WORD_ENTRY_ID) {
+                // Corrected in the case it was typed in (Teh -> The)
+                m_family_key.clear();
+                EmitTo(match.position + match.length, chunk, chunk_start, m_family_key);
+                m_dict.GetWords().Correct(m_family_key, out);
+            } else {
+                out += m_dict.GetEntry(match.entry_id).replacement;
+            }
+            m_emitted = match.position + match.length;
+        }
+        m_replacements += result.match_count;
+        offset += result.consumed;
+    }
+
+    // Bytes still in the matcher buffer may yet become part of a pattern,
+    // the last bytes may yet be replaced by a context rule, and the word
+    // being typed may yet be autocorrected
+    const uint64_t stream_end = m_matcher.GetStreamPosition();
+    const uint64_t held_back = std::max<uint64_t>({m_matcher.GetBuffer().size(), m_dict.GetRules().GetMaxLength(),
+                                                   m_matcher.GetWordLength()});
+    EmitTo(stream_end > held_back ? stream_end - held_back : 0, chunk, chunk_start, out);
+
+    // Carry the held-back tail to the next chunk
+    const size_t held = static_cast<size_t>(stream_end - m_emitted);
+    if (held > chunk.size()) {
+        m_pending.erase(0, m_pending.size() - (held - chunk.size()));
+        m_pending.append(chunk.data(), chunk.size());
+    } else {
+        m_pending.assign(chunk.data() + chunk.size() - held, held);
+    }
+}
+
+void TextConverter::Finish(std::string& out) {
+    out += m_pending;
+    m_pending.clear();
+    m_emitted = m_matcher.GetStreamPosition();
+}
+
+void TextConverter::Reset() {
+    m_matcher = PatternMatcher();
+    m_pending.clear();
+    m_emitted = 0;
+    m_replacements = 0;
+}
+
+void TextConverter::EmitTo(uint64_t end, std::string_view chunk, uint64_t chunk_start, std::string& out) {
+    if (end <= m_emitted) {
+        return;
+    }
+
+    // Part still pending from earlier chunks: m_pending covers [chunk_start - size, chunk_start)
+    if (m_emitted < chunk_start) {
+        const uint64_t pending_start = chunk_start - m_pending.size();
+        const uint64_t pending_end = end < chunk_start ? end : chunk_start;
+        out.append(m_pending, static_cast<size_t>(m_emitted - pending_start),
+                   static_cast<size_t>(pending_end - m_emitted));
+        m_emitted = pending_end;
+    }
+
+    if (end > m_emitted) {
+        out.append(chunk.data() + (m_emitted - chunk_start), static_cast<size_t>(end - m_emitted));
+        m_emitted = end;
+    }
+}
+
+} // namespace UniLang
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "pattern_matcher.h"
+#include "shortcuts_dict.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace UniLang {
+
+/**
+ * @brief Applies shortcut replacements to a stream of text
+ *
+ * Input arrives in chunks of any size; output is appended to a caller-owned
+ * string. Matching uses PatternMatcher::Feed, so the result is what typing
+ * the text with UniLang enabled would produce. A pattern can straddle a
+ * chunk boundary: only the bytes still held by the matcher (at most
+ * PatternMatcher::MAX_BUFFER_SIZE, the longest context rule, or the word
+ * autocorrect may still replace) are carried
+ * over to the next chunk, everything else is copied straight through.
+ */
+class TextConverter {
+public:
+    explicit TextConverter(const ShortcutsDict& dict);
+
+    /**
+     * @brief Convert the next chunk of input
+     * @param chunk Input bytes (UTF-8)
+     * @param out Converted text is appended here
+     */
+    void Convert(std::string_view chunk, std::string& out);
+
+    /**
+     * @brief Flush text held back for a possible pattern at end of input
+     * @param out Remaining text is appended here
+     */
+    void Finish(std::string& out);
+
+    /**
+     * @brief Set the categories whose replacements apply (see ShortcutsDict::GetCategoryMask)
+     */
+    void SetCategoryMask(uint64_t categories) { m_categories = categories; }
+
+    /**
+     * @brief Start over with a new stream
+     */
+    void Reset();
+
+    /**
+     * @brief Number of replacements made so far
+     */
+    uint64_t GetReplacementCount() const { return m_replacements; }
+
+private:
+    /**
+     * @brief Append input from the last emitted byte up to stream offset `end`
+     */
+    void EmitTo(uint64_t end, std::string_view chunk, uint64_t chunk_start, std::string& out);
+
+    static const size_t MATCH_BATCH = 256;
+
+    const ShortcutsDict& m_dict;
+    PatternMatcher m_matcher;
+    PatternMatcher::FeedMatch m_matches[MATCH_BATCH];
+    std::string m_pending;          // Unemitted input from previous chunks
+    std::string m_family_key;       // Scratch for symbol family and autocorrect matches
+    uint64_t m_emitted = 0;         // Stream offset of the first unemitted byte
+    uint64_t m_replacements = 0;
+    uint64_t m_categories = ShortcutsDict::ALL_CATEGORIES;
+};
+
+} // namespace UniLang
@@ -1,92 +1,97 @@
 #include "text_replacer.h"
-#include <vector>
+#include "unicode_utils.h"
 #include <iostream>
 
 namespace UniLang {
 
 bool TextReplacer::Replace(size_t pattern_length, const std::string& replacement) {
-    // Step 1: Send backspaces to delete the pattern
-    SendBackspaces(pattern_length);
+    return Replace(pattern_length, Utf8ToUtf16(replacement));
+}
 
-    // Delay to ensure backspaces are processed before sending Unicode
-    // Increased for VSCode/Claude CLI compatibility (50ms is critical)
-    Sleep(50);
+bool TextReplacer::Replace(size_t pattern_length, const std::u16string& utf16) {
+    // Backspaces and replacement go out as one batch: SendInput inserts a
+    // batch without interleaving other input, so the target always sees the
+    // deletions before the new text and no delay between them is needed
+    m_inputs.clear();
+    m_inputs.reserve((pattern_length + utf16.size()) * 2);
+    AppendBackspaces(pattern_length);
+    AppendUnicodeText(utf16);
+    return Flush();
+}
 
-    // Step 2: Send the Unicode replacement
-    SendUnicodeText(replacement);
+void TextReplacer::SendBackspaces(size_t count) {
+    m_inputs.clear();
+    m_inputs.reserve(count * 2); // Each key press needs key down + key up
+    AppendBackspaces(count);
+    Flush();
+}
 
-    return true;
+void TextReplacer::SendUnicodeText(const std::string& text) {
+    SendUnicodeText(Utf8ToUtf16(text));
 }
 
-void TextReplacer::SendBackspaces(size_t count) {
-    std::vector<INPUT> inputs;
-    inputs.reserve(count * 2); // Each key press needs key down + key up
+void TextReplacer::SendUnicodeText(const std::u16string& utf16) {
+    m_inputs.clear();
+    m_inputs.reserve(utf16.size() * 2);
+    AppendUnicodeText(utf16);
+    Flush();
+}
 
+void TextReplacer::AppendBackspaces(size_t count) {
     for (size_t i = 0; i < count; ++i) {
         // Key down
         INPUT input_down = {};
         input_down.type = INPUT_KEYBOARD;
         input_down.ki.wVk = VK_BACK;
         input_down.ki.dwFlags = 0;
-        inputs.push_back(input_down);
+        input_down.ki.dwExtraInfo = KeyEvent::OWN_INJECTION_TAG;
+        m_inputs.push_back(input_down);
 
         // Key up
         INPUT input_up = {};
         input_up.type = INPUT_KEYBOARD;
         input_up.ki.wVk = VK_BACK;
         input_up.ki.dwFlags = KEYEVENTF_KEYUP;
-        inputs.push_back(input_up);
-    }
-
-    if (!inputs.empty()) {
-        SendInput(static_cast<UINT>(inputs.size()), inputs.data(), sizeof(INPUT));
+        input_up.ki.dwExtraInfo = KeyEvent::OWN_INJECTION_TAG;
+        m_inputs.push_back(input_up);
     }
 }
 
-void TextReplacer::SendUnicodeText(const std::string& text) {
-    // Convert UTF-8 to UTF-16
-    std::wstring wtext = Utf8ToUtf16(text);
-
-    // Send each character
-    for (wchar_t ch : wtext) {
-        SendUnicodeChar(ch);
+void TextReplacer::AppendUnicodeText(const std::u16string& utf16) {
+    // One key down + key up pair per UTF-16 code unit
+    for (char16_t ch : utf16) {
+        INPUT input_down = {};
+        input_down.type = INPUT_KEYBOARD;
+        input_down.ki.wVk = 0;
+        input_down.ki.wScan = static_cast<WORD>(ch);
+        input_down.ki.dwFlags = KEYEVENTF_UNICODE;
+        input_down.ki.dwExtraInfo = KeyEvent::OWN_INJECTION_TAG;
+        m_inputs.push_back(input_down);
+
+        INPUT input_up = input_down;
+        input_up.ki.dwFlags = KEYEVENTF_UNICODE | KEYEVENTF_KEYUP;
+        m_inputs.push_back(input_up);
     }
 }
 
-std::wstring TextReplacer::Utf8ToUtf16(const std::string& utf8) {
-    if (utf8.empty()) {
-        return std::wstring();
+bool TextReplacer::Flush() {
+    if (m_inputs.empty()) {
+        return true;
     }
-
-    int size_needed = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(),
-                                          static_cast<int>(utf8.size()),
-                                          nullptr, 0);
-    if (size_needed <= 0) {
-        return std::wstring();
-    }
-
-    std::wstring result(size_needed, 0);
-    MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(),
-                       static_cast<int>(utf8.size()),
-                       &result[0], size_needed);
-
-    return result;
+    // Fewer events inserted means input was blocked (UIPI, secure desktop)
+    const UINT sent = SendInput(static_cast<UINT>(m_inputs.size()), m_inputs.data(), sizeof(INPUT));
+    return sent == m_inputs.size();
 }
 
-void TextReplacer::SendUnicodeChar(wchar_t ch) {
+void TextReplacer::SendKey(WORD vk) {
     INPUT inputs[2] = {};
 
-    // Key down
     inputs[0].type = INPUT_KEYBOARD;
-    inputs[0].ki.wVk = 0;
-    inputs[0].ki.wScan = ch;
-    inputs[0].ki.dwFlags = KEYEVENTF_UNICODE;
-
-    // Key up
-    inputs[1].type = INPUT_KEYBOARD;
-    inputs[1].ki.wVk = 0;
-    inputs[1].ki.wScan = ch;
-    inputs[1].ki.dwFlags = KEYEVENTF_UNICODE | KEYEVENTF_KEYUP;
+    inputs[0].ki.wVk = vk;
+    inputs[0].ki.dwExtraInfo = KeyEvent::OWN_INJECTION_TAG;
+
+    inputs[1] = inputs[0];
+    inputs[1].ki.dwFlags = KEYEVENTF_KEYUP;
 
     SendInput(2, inputs, sizeof(INPUT));
 }
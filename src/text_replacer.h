@@ -1,7 +1,9 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <Windows.h>
+#include "key_event.h"
 
 namespace UniLang {
 
@@ -11,6 +13,10 @@ namespace UniLang {
  * Uses Windows SendInput API to:
  * 1. Delete the shortcut pattern (e.g., send 6 backspaces for "\alpha")
  * 2. Insert Unicode character (e.g., "α")
+ * Both go out in one SendInput batch, so nothing can land in between.
+ *
+ * Every injected event carries KeyEvent::OWN_INJECTION_TAG in dwExtraInfo
+ * so the keyboard hook can recognize UniLang's own output.
  */
 class TextReplacer {
 public:
@@ -25,6 +31,14 @@ public:
      */
     bool Replace(size_t pattern_length, const std::string& replacement);
 
+    /**
+     * @brief Replace text using a replacement already encoded as UTF-16
+     * @param pattern_length Number of characters to delete (backspace)
+     * @param utf16 Pre-transcoded replacement (see ShortcutsDict::Entry)
+     * @return false if the system did not accept every event
+     */
+    bool Replace(size_t pattern_length, const std::u16string& utf16);
+
     /**
      * @brief Send backspace key presses
      * @param count Number of backspaces to send
@@ -37,16 +51,29 @@ public:
      */
     void SendUnicodeText(const std::string& text);
 
-private:
     /**
-     * @brief Convert UTF-8 string to UTF-16 (for Windows API)
+     * @brief Send Unicode text already encoded as UTF-16
+     * @param utf16 UTF-16 code units to send
      */
-    std::wstring Utf8ToUtf16(const std::string& utf8);
+    void SendUnicodeText(const std::u16string& utf16);
 
     /**
-     * @brief Send a single Unicode character using SendInput
+     * @brief Send a single key press (key down + key up)
+     * @param vk Virtual-key code
      */
-    void SendUnicodeChar(wchar_t ch);
+    void SendKey(WORD vk);
+
+private:
+    void AppendBackspaces(size_t count);
+    void AppendUnicodeText(const std::u16string& utf16);
+
+    /**
+     * @brief Send the events in m_inputs as one batch
+     * @return false if the system did not accept every event
+     */
+    bool Flush();
+
+    std::vector<INPUT> m_inputs;    // Reused event buffer, grows to the longest replacement
 };
 
 } // namespace UniLang
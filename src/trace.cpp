@@ -0,0 +1,116 @@
+#include "trace.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace UniLang {
+
+namespace {
+
+struct Span {
+    const char* category;
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+};
+
+struct ThreadBuffer {
+    std::unique_ptr<Span[]> spans{new Span[Tracer::THREAD_CAPACITY]};
+    std::atomic<size_t> count{0};               // Spans published (written by the owner only)
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<const char*> name{nullptr};
+    uint32_t tid = 0;
+};
+
+// Buffers outlive their threads, so spans of finished threads are still exported
+std::mutex g_buffers_mutex;
+std::vector<std::unique_ptr<ThreadBuffer>> g_buffers;  // Guarded by g_buffers_mutex
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+
+ThreadBuffer& GetThreadBuffer() {
+    if (t_buffer == nullptr) {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(g_buffers_mutex);
+        buffer->tid = static_cast<uint32_t>(g_buffers.size() + 1);
+        t_buffer = buffer.get();
+        g_buffers.push_back(std::move(buffer));
+    }
+    return *t_buffer;
+}
+
+} // namespace
+
+void Tracer::AddSpan(const char* category, const char* name, uint64_t start, uint64_t end) {
+    ThreadBuffer& buffer = GetThreadBuffer();
+    const size_t count = buffer.count.load(std::memory_order_relaxed);
+    if (count == THREAD_CAPACITY) {
+        buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.spans[count] = Span{category, name, start, end};
+    buffer.count.store(count + 1, std::memory_order_release);
+}
+
+void Tracer::SetThreadName(const char* name) {
+    GetThreadBuffer().name.store(name, std::memory_order_relaxed);
+}
+
+std::string Tracer::ToChromeJson() {
+    const double us_per_tick = TickClock::GetNanosecondsPerTick() / 1000.0;
+
+    std::lock_guard<std::mutex> lock(g_buffers_mutex);
+
+    // Time zero is the earliest span
+    uint64_t epoch = std::numeric_limits<uint64_t>::max();
+    for (const auto& buffer : g_buffers) {
+        const size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            epoch = std::min(epoch, buffer->spans[i].start);
+        }
+    }
+
+    nlohmann::json events = nlohmann::json::array();
+    uint64_t dropped = 0;
+    for (const auto& buffer : g_buffers) {
+        if (const char* name = buffer->name.load(std::memory_order_relaxed)) {
+            events.push_back({{"name", "thread_name"}, {"ph", "M"}, {"pid", 1}, {"tid", buffer->tid},
+                              {"args", {{"name", name}}}});
+        }
+        const size_t count = buffer->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            const Span& span = buffer->spans[i];
+            events.push_back({
+                {"name", span.name},
+                {"cat", span.category},
+                {"ph", "X"},
+                {"ts", static_cast<double>(span.start - epoch) * us_per_tick},
+                {"dur", static_cast<double>(span.end - span.start) * us_per_tick},
+                {"pid", 1},
+                {"tid", buffer->tid}
+            });
+        }
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+
+    nlohmann::json trace;
+    trace["traceEvents"] = std::move(events);
+    trace["displayTimeUnit"] = "ns";
+    trace["otherData"] = {{"dropped_spans", dropped}};
+    return trace.dump();
+}
+
+uint64_t Tracer::GetDroppedCount() {
+    std::lock_guard<std::mutex> lock(g_buffers_mutex);
+    uint64_t dropped = 0;
+    for (const auto& buffer : g_buffers) {
+        dropped += buffer->dropped.load(std::memory_order_relaxed);
+    }
+    return dropped;
+}
+
+} // namespace UniLang
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "metrics.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace UniLang {
+
+/**
+ * @brief Spans of work on every thread, exported as a Chrome trace
+ *
+ * Code marks spans with the UNILANG_TRACE_* macros below. They compile to
+ * nothing unless the build defines UNILANG_TRACING (CMake option of the
+ * same name), so release builds carry no trace code at all.
+ *
+ * Each thread appends its spans to a buffer of its own, allocated on the
+ * thread's first span, and publishes them with a release store of the
+ * count: no lock and no allocation per span. A full buffer drops further
+ * spans (counted) rather than growing. ToChromeJson() may run on any
+ * thread at any time; the result opens in chrome://tracing or Perfetto.
+ */
+class Tracer {
+public:
+    static const size_t THREAD_CAPACITY = 1 << 16;   // Spans kept per thread
+
+    static constexpr bool IsCompiledIn() {
+#ifdef UNILANG_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Record a finished span on the calling thread
+     * @param category, name String literals (only the pointers are kept)
+     * @param start, end TickClock values
+     */
+    static void AddSpan(const char* category, const char* name, uint64_t start, uint64_t end);
+
+    /**
+     * @brief Name the calling thread in the trace
+     * @param name String literal
+     */
+    static void SetThreadName(const char* name);
+
+    /**
+     * @brief All spans so far in Chrome trace-event JSON (complete events, microseconds)
+     */
+    static std::string ToChromeJson();
+
+    /**
+     * @brief Spans dropped because a thread's buffer was full
+     */
+    static uint64_t GetDroppedCount();
+};
+
+/**
+ * @brief Span from construction to destruction (use UNILANG_TRACE_SCOPE)
+ */
+class TraceScope {
+public:
+    TraceScope(const char* category, const char* name)
+        : m_category(category), m_name(name), m_start(TickClock::Now()) {
+    }
+
+    ~TraceScope() {
+        Tracer::AddSpan(m_category, m_name, m_start, TickClock::Now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* m_category;
+    const char* m_name;
+    uint64_t m_start;
+};
+
+} // namespace UniLang
+
+#ifdef UNILANG_TRACING
+#define UNILANG_TRACE_CONCAT_INNER(a, b) a##b
+#define UNILANG_TRACE_CONCAT(a, b) UNILANG_TRACE_CONCAT_INNER(a, b)
+// Trace the rest of the enclosing block
+#define UNILANG_TRACE_SCOPE(category, name) \
+    ::UniLang::TraceScope UNILANG_TRACE_CONCAT(unilang_trace_scope_, __LINE__)(category, name)
+// Trace a span whose TickClock values were taken anyway
+#define UNILANG_TRACE_SPAN(category, name, start, end) ::UniLang::Tracer::AddSpan(category, name, start, end)
+#define UNILANG_TRACE_THREAD(name) ::UniLang::Tracer::SetThreadName(name)
+#else
+#define UNILANG_TRACE_SCOPE(category, name) ((void)0)
+#define UNILANG_TRACE_SPAN(category, name, start, end) ((void)0)
+#define UNILANG_TRACE_THREAD(name) ((void)0)
+#endif
@@ -0,0 +1,204 @@
+#include "trigger_grammar.h"
+#include "trace.h"
+#include <algorithm>
+
+namespace UniLang {
+
+namespace {
+
+TriggerGrammars::Grammar LatexGrammar() {
+    TriggerGrammars::Grammar grammar;
+    grammar.opener = "\\";
+    grammar.terminator = ' ';
+    grammar.key_prefix = "\\";
+    grammar.min_name = 2;          // "\in" is the shortest LaTeX shortcut
+    grammar.letters_only = true;
+    grammar.symbol_families = true;
+    return grammar;
+}
+
+std::string Quote(std::string_view text) {
+    return "'" + std::string(text) + "'";
+}
+
+} // namespace
+
+TriggerGrammars::TriggerGrammars() {
+    m_grammars[LATEX] = LatexGrammar();
+    m_count = 1;
+    Compile();
+}
+
+const TriggerGrammars& TriggerGrammars::Default() {
+    static const TriggerGrammars grammars;
+    return grammars;
+}
+
+uint8_t TriggerGrammars::Add(const Grammar& grammar) {
+    for (size_t i = 0; i < m_count; ++i) {
+        if (m_grammars[i].key_prefix != grammar.key_prefix) {
+            continue;
+        }
+        // Several layers may share a grammar, but only with the same delimiters
+        if (m_grammars[i].terminator != grammar.terminator) {
+            m_last_error = "opener " + Quote(grammar.key_prefix) + " is already used with terminator " +
+                           Quote(std::string(1, m_grammars[i].terminator));
+            return NO_GRAMMAR;
+        }
+        return static_cast<uint8_t>(i);
+    }
+
+    if (m_count == MAX_GRAMMARS) {
+        m_last_error = "too many trigger grammars (at most " + std::to_string(MAX_GRAMMARS) + ")";
+        return NO_GRAMMAR;
+    }
+    if (grammar.terminator != ' ' && !IsValidDelimiter(grammar.terminator)) {
+        m_last_error = "invalid terminator " + Quote(std::string(1, grammar.terminator));
+        return NO_GRAMMAR;
+    }
+    if (grammar.min_name == 0 || grammar.key_prefix.empty()) {
+        m_last_error = "invalid grammar for opener " + Quote(grammar.opener);
+        return NO_GRAMMAR;
+    }
+
+    const uint8_t index = static_cast<uint8_t>(m_count);
+    m_grammars[index] = grammar;
+    m_grammars[index].opener.clear();
+    ++m_count;
+    if (!SetOpener(index, grammar.opener)) {
+        m_grammars[index] = Grammar();
+        --m_count;
+        Compile();
+        return NO_GRAMMAR;
+    }
+    return index;
+}
+
+bool TriggerGrammars::SetOpener(uint8_t index, std::string_view opener) {
+    if (opener.empty() || opener.size() > MAX_OPENER_LENGTH) {
+        m_last_error = "opener " + Quote(opener) + " must be 1 to " +
+                       std::to_string(MAX_OPENER_LENGTH) + " characters";
+        return false;
+    }
+    for (char ch : opener) {
+        if (!IsValidDelimiter(ch)) {
+            m_last_error = "invalid opener " + Quote(opener);
+            return false;
+        }
+    }
+    for (size_t i = 0; i < m_count; ++i) {
+        if (i != index && m_grammars[i].opener == opener) {
+            m_last_error = "opener " + Quote(opener) + " is already used";
+            return false;
+        }
+    }
+
+    std::string previous = std::move(m_grammars[index].opener);
+    m_grammars[index].opener = std::string(opener);
+    if (!Compile()) {
+        m_grammars[index].opener = std::move(previous);
+        Compile();
+        return false;
+    }
+    return true;
+}
+
+void TriggerGrammars::Reset() {
+    const std::string opener = m_grammars[LATEX].opener;
+    for (size_t i = 0; i < MAX_GRAMMARS; ++i) {
+        m_grammars[i] = Grammar();
+    }
+    m_grammars[LATEX] = LatexGrammar();
+    m_grammars[LATEX].opener = opener;
+    m_count = 1;
+    Compile();
+}
+
+uint8_t TriggerGrammars::FindName(const char* text, size_t length, size_t& name_start) const {
+    const uint8_t candidates = m_terminates[static_cast<unsigned char>(text[length - 1])];
+    if (candidates == 0) {
+        return NO_GRAMMAR;
+    }
+
+    for (size_t i = 0; i < m_count; ++i) {
+        const uint8_t index = m_by_length[i];
+        if ((candidates & (1u << index)) == 0) {
+            continue;
+        }
+
+        const Grammar& grammar = m_grammars[index];
+        const uint8_t bit = static_cast<uint8_t>(1u << index);
+        const size_t name_end = length - 1;
+        size_t start = name_end;
+        while (start > 0 && (m_name_chars[static_cast<unsigned char>(text[start - 1])] & bit) != 0) {
+            --start;
+        }
+
+        // The opener must still be in the text, right before the name
+        const std::string& opener = grammar.opener;
+        if (name_end - start >= grammar.min_name && start >= opener.size() &&
+            std::memcmp(text + start - opener.size(), opener.data(), opener.size()) == 0) {
+            name_start = start;
+            return index;
+        }
+    }
+    return NO_GRAMMAR;
+}
+
+bool TriggerGrammars::IsValidDelimiter(char ch) const {
+    // Printable punctuation that no other pattern or name uses
+    if (ch <= ' ' || ch > '~') {
+        return false;
+    }
+    if ((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z')) {
+        return false;
+    }
+    return std::string_view("^_{}()+-").find(ch) == std::string_view::npos;
+}
+
+bool TriggerGrammars::Compile() {
+    UNILANG_TRACE_SCOPE("matcher", "TriggerGrammars::Compile");
+    std::fill(std::begin(m_opener_ends), std::end(m_opener_ends), 0);
+    std::fill(std::begin(m_terminates), std::end(m_terminates), 0);
+    std::fill(std::begin(m_name_chars), std::end(m_name_chars), 0);
+    m_trigger_bytes[0] = '^';
+    m_trigger_bytes[1] = '_';
+    m_trigger_byte_count = 2;
+
+    for (size_t i = 0; i < m_count; ++i) {
+        const std::string& opener = m_grammars[i].opener;
+        if (opener.empty()) {
+            continue;  // Being added
+        }
+        m_opener_ends[static_cast<unsigned char>(opener.back())] |= static_cast<uint8_t>(1u << i);
+        m_terminates[static_cast<unsigned char>(m_grammars[i].terminator)] |= static_cast<uint8_t>(1u << i);
+        for (int byte = 0; byte < 0x80; ++byte) {
+            if (IsNameChar(m_grammars[i], static_cast<char>(byte))) {
+                m_name_chars[byte] |= static_cast<uint8_t>(1u << i);
+            }
+        }
+
+        // Every opener byte, so skipping plain text never jumps into an opener
+        for (char ch : opener) {
+            if (GetTriggerBytes().find(ch) != std::string_view::npos) {
+                continue;
+            }
+            if (m_trigger_byte_count == MAX_TRIGGER_BYTES) {
+                m_last_error = "openers use too many different characters (at most " +
+                               std::to_string(MAX_TRIGGER_BYTES - 2) + ")";
+                return false;
+            }
+            m_trigger_bytes[m_trigger_byte_count++] = ch;
+        }
+    }
+
+    for (size_t i = 0; i < m_count; ++i) {
+        m_by_length[i] = static_cast<uint8_t>(i);
+    }
+    std::stable_sort(m_by_length, m_by_length + m_count, [this](uint8_t a, uint8_t b) {
+        return m_grammars[a].opener.size() > m_grammars[b].opener.size();
+    });
+    return true;
+}
+
+} // namespace UniLang
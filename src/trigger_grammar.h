@@ -0,0 +1,161 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace UniLang {
+
+/**
+ * @brief Trigger grammars: how shortcut names are delimited while typing
+ *
+ * Each dictionary layer declares an opener typed before the name and a
+ * terminator typed after it:
+ *
+ *   LaTeX     \al<space>    opener "\" (Settings::trigger_key), terminator ' '
+ *   Emoji     :smile:       opener ":", terminator ':'
+ *   Snippets  ;;addr<space> opener ";;", terminator ' '
+ *
+ * All grammars compile into per-byte tables, so the matcher does one table
+ * lookup per keystroke however many grammars are active; opener and name
+ * checks only run on the bytes that can end an opener or a name. Names are
+ * checked on the terminator by looking back over the buffer, so they fire
+ * even after Backspace took back a stray character. When openers overlap
+ * (";" and ";;") the longest one that was typed wins.
+ *
+ * Dictionary keys are key_prefix + name. For the LaTeX layer the prefix
+ * stays "\" when the typed opener changes, so the same dictionary works
+ * with any trigger key.
+ */
+class TriggerGrammars {
+public:
+    struct Grammar {
+        std::string opener;             // Typed before the name (e.g., "\\", ":", ";;")
+        char terminator = ' ';          // Typed after the name; fires the replacement
+        std::string key_prefix;         // Dictionary keys are key_prefix + name
+        uint8_t min_name = 1;           // Shortest name that can fire
+        bool letters_only = false;      // Names: letters only, or letters, digits, '+' and '-'
+        bool symbol_families = false;   // Also accept \name{arg} (see symbol_families.h)
+    };
+
+    static const size_t MAX_GRAMMARS = 8;
+    static const size_t MAX_OPENER_LENGTH = 3;
+    static const size_t MAX_TRIGGER_BYTES = 16;   // '^', '_' and every opener byte
+    static const uint8_t NO_GRAMMAR = 0xFF;
+    static const uint8_t LATEX = 0;               // Index of the built-in LaTeX grammar
+
+    /**
+     * @brief Grammar set holding only the LaTeX grammar ("\" name ' ')
+     */
+    TriggerGrammars();
+
+    /**
+     * @brief Shared default set (LaTeX only)
+     */
+    static const TriggerGrammars& Default();
+
+    /**
+     * @brief Add a grammar, or find the one with the same key prefix
+     * @return Grammar index, or NO_GRAMMAR if it is invalid, conflicts with
+     *         another grammar or there are too many (see GetLastError)
+     */
+    uint8_t Add(const Grammar& grammar);
+
+    /**
+     * @brief Change the typed opener of a grammar (e.g., Settings::trigger_key)
+     * @return false if the opener is invalid or taken (see GetLastError)
+     */
+    bool SetOpener(uint8_t index, std::string_view opener);
+
+    /**
+     * @brief Drop every grammar but LaTeX, keeping its opener
+     */
+    void Reset();
+
+    size_t GetCount() const { return m_count; }
+    const Grammar& Get(uint8_t index) const { return m_grammars[index]; }
+
+    /**
+     * @brief Grammar whose opener ends the text, the longest if several do
+     * @return Grammar index, or NO_GRAMMAR
+     */
+    uint8_t FindOpener(const char* text, size_t length) const {
+        const uint8_t candidates = m_opener_ends[static_cast<unsigned char>(text[length - 1])];
+        if (candidates == 0) {
+            return NO_GRAMMAR;
+        }
+        for (size_t i = 0; i < m_count; ++i) {
+            const uint8_t index = m_by_length[i];
+            const std::string& opener = m_grammars[index].opener;
+            if ((candidates & (1u << index)) != 0 && opener.size() <= length &&
+                std::memcmp(text + length - opener.size(), opener.data(), opener.size()) == 0) {
+                return index;
+            }
+        }
+        return NO_GRAMMAR;
+    }
+
+    /**
+     * @brief Check whether a byte terminates names in any grammar
+     */
+    bool IsTerminator(char ch) const { return m_terminates[static_cast<unsigned char>(ch)] != 0; }
+
+    /**
+     * @brief Check whether a byte continues a name of a grammar (a name character or its terminator)
+     */
+    bool ContinuesName(uint8_t index, char ch) const {
+        const unsigned char byte = static_cast<unsigned char>(ch);
+        return ((m_name_chars[byte] | m_terminates[byte]) & (1u << index)) != 0;
+    }
+
+    /**
+     * @brief Grammar whose opener, name and terminator end the text, the longest opener first
+     * @param name_start Receives the offset of the name
+     * @return Grammar index, or NO_GRAMMAR
+     */
+    uint8_t FindName(const char* text, size_t length, size_t& name_start) const;
+
+    /**
+     * @brief Check whether a character can be part of a name in a grammar
+     */
+    static bool IsNameChar(const Grammar& grammar, char ch) {
+        const bool letter = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z');
+        if (grammar.letters_only) {
+            return letter;
+        }
+        return letter || (ch >= '0' && ch <= '9') || ch == '+' || ch == '-';
+    }
+
+    /**
+     * @brief Bytes that can start a pattern: '^', '_' and every opener byte
+     */
+    std::string_view GetTriggerBytes() const { return std::string_view(m_trigger_bytes, m_trigger_byte_count); }
+
+    const std::string& GetLastError() const { return m_last_error; }
+
+private:
+    /**
+     * @brief Check that an opener or terminator can delimit names
+     */
+    bool IsValidDelimiter(char ch) const;
+
+    /**
+     * @brief Rebuild the per-byte tables after a change
+     */
+    bool Compile();
+
+private:
+    Grammar m_grammars[MAX_GRAMMARS];
+    size_t m_count = 0;
+    uint8_t m_by_length[MAX_GRAMMARS] = {};     // Grammar indices, longest opener first
+    uint8_t m_opener_ends[256] = {};            // Byte -> grammars whose opener ends with it (bit mask)
+    uint8_t m_terminates[256] = {};             // Byte -> grammars it terminates (bit mask)
+    uint8_t m_name_chars[256] = {};             // Byte -> grammars whose names may contain it (bit mask)
+    char m_trigger_bytes[MAX_TRIGGER_BYTES] = {};
+    size_t m_trigger_byte_count = 0;
+    std::string m_last_error;
+};
+
+} // namespace UniLang
@@ -0,0 +1,158 @@
+#include "trigger_scan.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UNILANG_HAVE_SSE2 1
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace UniLang {
+
+namespace {
+
+#ifdef UNILANG_HAVE_SSE2
+/**
+ * @brief One broadcast vector per byte to look for
+ *
+ * N is fixed so the compares unroll; larger sets are padded by repeating a byte.
+ */
+template <size_t N>
+struct Needles {
+    __m128i bytes[N];
+
+    explicit Needles(std::string_view set) {
+        for (size_t i = 0; i < N; ++i) {
+            bytes[i] = _mm_set1_epi8(set[i < set.size() ? i : 0]);
+        }
+    }
+
+    int Mask(__m128i block) const {
+        __m128i hits = _mm_cmpeq_epi8(block, bytes[0]);
+        for (size_t i = 1; i < N; ++i) {
+            hits = _mm_or_si128(hits, _mm_cmpeq_epi8(block, bytes[i]));
+        }
+        return _mm_movemask_epi8(hits);
+    }
+};
+
+inline size_t LowestBit(unsigned int mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return index;
+#else
+    return static_cast<size_t>(__builtin_ctz(mask));
+#endif
+}
+
+/**
+ * @brief Vector part of FindTriggerByte
+ * @param i Receives the match offset, or where the scalar tail starts
+ * @return true if a byte was found
+ */
+template <size_t N>
+bool FindNeedle(const char* data, size_t size, std::string_view bytes, size_t& i) {
+    const Needles<N> needles(bytes);
+
+    // 32 bytes per iteration; plain text rarely contains a trigger
+    for (; i + 32 <= size; i += 32) {
+        const int lo = needles.Mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        const int hi = needles.Mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16)));
+        const unsigned int mask = static_cast<unsigned int>(lo) | (static_cast<unsigned int>(hi) << 16);
+        if (mask != 0) {
+            i += LowestBit(mask);
+            return true;
+        }
+    }
+    for (; i + 16 <= size; i += 16) {
+        const int mask = needles.Mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        if (mask != 0) {
+            i += LowestBit(static_cast<unsigned int>(mask));
+            return true;
+        }
+    }
+
+    // Tail: the last 16 bytes again, ignoring the ones already checked
+    if (i < size && size >= 16) {
+        const size_t base = size - 16;
+        const unsigned int mask = static_cast<unsigned int>(
+            needles.Mask(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + base)))) >> (i - base);
+        if (mask != 0) {
+            i += LowestBit(mask);
+            return true;
+        }
+        i = size;
+    }
+    return false;
+}
+#endif
+
+} // namespace
+
+size_t FindTriggerByte(const char* data, size_t size, std::string_view bytes) {
+    size_t i = 0;
+    if (bytes.empty()) {
+        return size;
+    }
+
+#ifdef UNILANG_HAVE_SSE2
+    // One instance per set size: every compare counts on long plain-text runs
+    bool found = false;
+    switch (bytes.size()) {
+    case 1: found = FindNeedle<1>(data, size, bytes, i); break;
+    case 2: found = FindNeedle<2>(data, size, bytes, i); break;
+    case 3: found = FindNeedle<3>(data, size, bytes, i); break;
+    case 4: found = FindNeedle<4>(data, size, bytes, i); break;
+    case 5: found = FindNeedle<5>(data, size, bytes, i); break;
+    case 6: found = FindNeedle<6>(data, size, bytes, i); break;
+    case 7: found = FindNeedle<7>(data, size, bytes, i); break;
+    case 8: found = FindNeedle<8>(data, size, bytes, i); break;
+    default: found = FindNeedle<16>(data, size, bytes.substr(0, 16), i); break;
+    }
+    if (found) {
+        return i;
+    }
+#endif
+
+    for (; i < size; ++i) {
+        for (char byte : bytes) {
+            if (data[i] == byte) {
+                return i;
+            }
+        }
+    }
+    return size;
+}
+
+size_t FindNonAsciiByte(const char* data, size_t size) {
+    size_t i = 0;
+
+#ifdef UNILANG_HAVE_SSE2
+    // The sign bit of each byte is exactly what movemask collects
+    for (; i + 32 <= size; i += 32) {
+        const int lo = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        const int hi = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 16)));
+        const unsigned int mask = static_cast<unsigned int>(lo) | (static_cast<unsigned int>(hi) << 16);
+        if (mask != 0) {
+            return i + LowestBit(mask);
+        }
+    }
+    for (; i + 16 <= size; i += 16) {
+        const int mask = _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)));
+        if (mask != 0) {
+            return i + LowestBit(static_cast<unsigned int>(mask));
+        }
+    }
+#endif
+
+    for (; i < size; ++i) {
+        if (static_cast<unsigned char>(data[i]) >= 0x80) {
+            return i;
+        }
+    }
+    return size;
+}
+
+} // namespace UniLang
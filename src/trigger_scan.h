@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace UniLang {
+
+/**
+ * @brief Find the first byte that can start a pattern
+ *
+ * Used to skip plain text while the matcher has nothing in progress.
+ * Vectorized with SSE2 where available.
+ *
+ * @param bytes Bytes to look for (at most 16; see TriggerGrammars::GetTriggerBytes)
+ * @return Offset of the first such byte, or size if there is none
+ */
+size_t FindTriggerByte(const char* data, size_t size, std::string_view bytes);
+
+/**
+ * @brief Find the first byte outside ASCII (>= 0x80)
+ *
+ * Used to copy ASCII runs when reversing replacements, which are all
+ * non-ASCII. Vectorized with SSE2 where available.
+ *
+ * @return Offset of the first such byte, or size if there is none
+ */
+size_t FindNonAsciiByte(const char* data, size_t size);
+
+} // namespace UniLang
@@ -0,0 +1,84 @@
+#include "unicode_utils.h"
+
+namespace UniLang {
+
+char32_t DecodeUtf8(std::string_view text, size_t& pos) {
+    const unsigned char lead = static_cast<unsigned char>(text[pos++]);
+    if (lead < 0x80) {
+        return lead;
+    }
+
+    // Determine sequence length from the lead byte
+    size_t extra;
+    char32_t cp;
+    if ((lead & 0xE0) == 0xC0) {
+        extra = 1;
+        cp = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        extra = 2;
+        cp = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        extra = 3;
+        cp = lead & 0x07;
+    } else {
+        return 0xFFFD;
+    }
+
+    for (size_t i = 0; i < extra; ++i) {
+        if (pos >= text.size()) {
+            return 0xFFFD;
+        }
+        const unsigned char cont = static_cast<unsigned char>(text[pos]);
+        if ((cont & 0xC0) != 0x80) {
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (cont & 0x3F);
+        ++pos;
+    }
+
+    if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        return 0xFFFD;
+    }
+    return cp;
+}
+
+void AppendUtf8(std::string& out, char32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+void AppendUtf16(std::u16string& out, char32_t cp) {
+    if (cp < 0x10000) {
+        out += static_cast<char16_t>(cp);
+    } else {
+        cp -= 0x10000;
+        out += static_cast<char16_t>(0xD800 | (cp >> 10));
+        out += static_cast<char16_t>(0xDC00 | (cp & 0x3FF));
+    }
+}
+
+std::u16string Utf8ToUtf16(std::string_view utf8) {
+    std::u16string result;
+    result.reserve(utf8.size());
+
+    size_t pos = 0;
+    while (pos < utf8.size()) {
+        AppendUtf16(result, DecodeUtf8(utf8, pos));
+    }
+    return result;
+}
+
+} // namespace UniLang
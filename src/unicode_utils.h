@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace UniLang {
+
+/**
+ * @brief Portable UTF-8 / UTF-16 helpers
+ *
+ * Used when building the shortcuts snapshot so that no Windows API
+ * (MultiByteToWideChar) is needed on the keystroke path.
+ */
+
+/**
+ * @brief Decode one code point from UTF-8
+ * @param text Input text
+ * @param pos Byte offset, advanced past the decoded sequence
+ * @return Code point, or U+FFFD for malformed input
+ */
+char32_t DecodeUtf8(std::string_view text, size_t& pos);
+
+/**
+ * @brief Append a code point to a UTF-8 string
+ */
+void AppendUtf8(std::string& out, char32_t cp);
+
+/**
+ * @brief Append a code point to a UTF-16 string (surrogate pairs above U+FFFF)
+ */
+void AppendUtf16(std::u16string& out, char32_t cp);
+
+/**
+ * @brief Convert UTF-8 text to UTF-16
+ */
+std::u16string Utf8ToUtf16(std::string_view utf8);
+
+} // namespace UniLang
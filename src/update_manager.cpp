@@ -1,68 +1,158 @@
 #include "update_manager.h"
+#include "settings_writer.h"
+#include "trace.h"
 #include <nlohmann/json.hpp>
-#include <wininet.h>
 #include <sstream>
+#include <fstream>
 #include <algorithm>
-
-#pragma comment(lib, "wininet.lib")
+#include <chrono>
+#include <cstdlib>
+#include <tuple>
 
 using json = nlohmann::json;
 
 namespace UniLang {
 
-UpdateManager::UpdateManager() {
+UpdateManager::UpdateManager(HttpClient& http)
+    : m_http(http) {
 }
 
 UpdateManager::~UpdateManager() {
 }
 
-std::string UpdateManager::HttpGet(const std::string& url) {
-    m_last_error.clear();
+bool UpdateManager::HttpGet(const std::string& url, const std::atomic<bool>* cancel, HttpClient::Response& response) {
+    UNILANG_TRACE_SCOPE("update", "UpdateManager::HttpGet");
+    HttpClient::Request request;
+    request.url = url;
+    request.headers.emplace_back("Accept", "application/vnd.github+json");
+    request.timeout_ms = REQUEST_TIMEOUT_MS;
+    request.cancel = cancel;
+
+    // Validators only match the release URL they came from
+    if (m_cache.has_info && m_cache.url == url) {
+        if (!m_cache.etag.empty()) {
+            request.headers.emplace_back("If-None-Match", m_cache.etag);
+        }
+        if (!m_cache.last_modified.empty()) {
+            request.headers.emplace_back("If-Modified-Since", m_cache.last_modified);
+        }
+    }
 
-    // Initialize WinINet
-    HINTERNET hInternet = InternetOpenA(
-        "UniLang/1.0",
-        INTERNET_OPEN_TYPE_DIRECT,
-        nullptr,
-        nullptr,
-        0
-    );
-
-    if (!hInternet) {
-        m_last_error = "Failed to initialize WinINet";
-        return "";
+    if (!m_http.Get(request, response)) {
+        m_last_error = "Update check failed: " + m_http.GetLastError();
+        return false;
     }
+    m_last_status = response.status;
+    return true;
+}
 
-    // Open URL
-    HINTERNET hUrl = InternetOpenUrlA(
-        hInternet,
-        url.c_str(),
-        nullptr,
-        0,
-        INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE,
-        0
-    );
-
-    if (!hUrl) {
-        m_last_error = "Failed to open URL: " + url;
-        InternetCloseHandle(hInternet);
-        return "";
+void UpdateManager::Backoff(const HttpClient::Response* response) {
+    const int64_t now = Now();
+    m_cache.failures++;
+
+    // Equal jitter: half the exponential delay, plus up to as much again at random,
+    // so a fleet that failed together doesn't retry together
+    const uint32_t exponent = std::min<uint32_t>(m_cache.failures - 1, 16);
+    const int64_t delay = std::min<int64_t>(static_cast<int64_t>(BACKOFF_BASE_S) << exponent, BACKOFF_MAX_S);
+    int64_t wait = delay / 2 + static_cast<int64_t>(m_rng() % static_cast<uint32_t>(delay / 2 + 1));
+
+    // The server may know better (rate limits, maintenance)
+    if (response != nullptr) {
+        const std::string retry_after(response->GetHeader("retry-after"));
+        if (!retry_after.empty() && retry_after.find_first_not_of("0123456789") == std::string::npos) {
+            wait = std::max<int64_t>(wait, std::strtoll(retry_after.c_str(), nullptr, 10));
+        }
+        const std::string remaining(response->GetHeader("x-ratelimit-remaining"));
+        const std::string reset(response->GetHeader("x-ratelimit-reset"));
+        if (remaining == "0" && !reset.empty()) {
+            wait = std::max<int64_t>(wait, std::strtoll(reset.c_str(), nullptr, 10) - now);
+        }
     }
 
-    // Read response
-    std::string response;
-    char buffer[4096];
-    DWORD bytesRead = 0;
+    m_cache.retry_after = now + std::min<int64_t>(wait, BACKOFF_MAX_S);
+}
+
+int64_t UpdateManager::Now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool UpdateManager::LoadCache(const std::string& filepath, CacheState& cache) {
+    UNILANG_TRACE_SCOPE("update", "UpdateManager::LoadCache");
+    cache = CacheState();
+    try {
+        std::ifstream file(filepath);
+        if (!file.is_open()) {
+            return false;
+        }
+
+        json j;
+        file >> j;
+
+        cache.url = j.value("url", "");
+        cache.etag = j.value("etag", "");
+        cache.last_modified = j.value("last_modified", "");
+        cache.failures = j.value("failures", 0u);
+        cache.retry_after = j.value("retry_after", static_cast<int64_t>(0));
+        if (j.contains("release")) {
+            const json& release = j["release"];
+            cache.info.version = release.value("version", "");
+            cache.info.download_url = release.value("download_url", "");
+            cache.info.shortcuts_url = release.value("shortcuts_url", "");
+            cache.info.download_sha256 = release.value("download_sha256", "");
+            cache.info.shortcuts_sha256 = release.value("shortcuts_sha256", "");
+            cache.info.download_size = release.value("download_size", static_cast<uint64_t>(0));
+            cache.info.shortcuts_size = release.value("shortcuts_size", static_cast<uint64_t>(0));
+            cache.info.delta_url = release.value("delta_url", "");
+            if (release.contains("shortcuts_diffs")) {
+                cache.info.shortcuts_diffs = release["shortcuts_diffs"].get<std::map<std::string, std::string>>();
+            }
+            cache.info.release_notes = release.value("release_notes", "");
+            cache.has_info = true;
+        }
+        return true;
 
-    while (InternetReadFile(hUrl, buffer, sizeof(buffer), &bytesRead) && bytesRead > 0) {
-        response.append(buffer, bytesRead);
+    } catch (const std::exception& e) {
+//         std::cerr << "Error loading update cache: " << e.what() << std::endl;
+        cache = CacheState();
+        return false;
     }
+}
+
+bool UpdateManager::SaveCache(const std::string& filepath, const CacheState& cache) {
+    UNILANG_TRACE_SCOPE("update", "UpdateManager::SaveCache");
+    try {
+        json j;
+        j["url"] = cache.url;
+        j["etag"] = cache.etag;
+        j["last_modified"] = cache.last_modified;
+        j["failures"] = cache.failures;
+        j["retry_after"] = cache.retry_after;
+        if (cache.has_info) {
+            j["release"]["version"] = cache.info.version;
+            j["release"]["download_url"] = cache.info.download_url;
+            j["release"]["shortcuts_url"] = cache.info.shortcuts_url;
+            j["release"]["download_sha256"] = cache.info.download_sha256;
+            j["release"]["shortcuts_sha256"] = cache.info.shortcuts_sha256;
+            j["release"]["download_size"] = cache.info.download_size;
+            j["release"]["shortcuts_size"] = cache.info.shortcuts_size;
+            j["release"]["delta_url"] = cache.info.delta_url;
+            j["release"]["shortcuts_diffs"] = cache.info.shortcuts_diffs;
+            j["release"]["release_notes"] = cache.info.release_notes;
+        }
 
-    // Cleanup
-    InternetCloseHandle(hUrl);
-    InternetCloseHandle(hInternet);
+        // A crash mid-write must not leave a truncated cache behind
+        std::string error;
+        if (!SettingsWriter::WriteFileAtomic(filepath, j.dump(2) + "\n", error)) {
+//             std::cerr << "Failed to write update cache: " << error << std::endl;
+            return false;
+        }
+        return true;
 
-    return response;
+    } catch (const std::exception& e) {
+//         std::cerr << "Error saving update cache: " << e.what() << std::endl;
+        return false;
+    }
 }
 
 bool UpdateManager::IsVersionNewer(const std::string& version1, const std::string& version2) {
@@ -107,6 +197,7 @@ UpdateManager::VersionInfo UpdateManager::ParseGitHubResponse(
     const std::string& json_response,
     const std::string& current_version
 ) {
+    UNILANG_TRACE_SCOPE("update", "UpdateManager::ParseGitHubResponse");
     VersionInfo info;
 
     try {
@@ -122,6 +213,13 @@ UpdateManager::VersionInfo UpdateManager::ParseGitHubResponse(
             info.release_notes = j["body"].get<std::string>();
         }
 
+        // A delta from our own version is published as "UniLang.exe.1.2.0.delta"
+        std::string current = current_version;
+        if (!current.empty() && current[0] == 'v') {
+            current = current.substr(1);
+        }
+        const std::string delta_suffix = ".exe." + current + ".delta";
+
         // Find download URLs in assets
         if (j.contains("assets") && j["assets"].is_array()) {
             for (const auto& asset : j["assets"]) {
@@ -132,14 +230,48 @@ UpdateManager::VersionInfo UpdateManager::ParseGitHubResponse(
                 std::string name = asset["name"].get<std::string>();
                 std::string download_url = asset["browser_download_url"].get<std::string>();
 
+                // "sha256:<hex>", verified while downloading
+                std::string digest;
+                if (asset.contains("digest") && asset["digest"].is_string()) {
+                    digest = asset["digest"].get<std::string>();
+                    digest = digest.compare(0, 7, "sha256:") == 0 ? digest.substr(7) : "";
+                }
+                const uint64_t size = asset.contains("size") && asset["size"].is_number_unsigned()
+                    ? asset["size"].get<uint64_t>() : 0;
+
+                // Deltas from other versions are of no use
+                if (name.size() > 6 && name.compare(name.size() - 6, 6, ".delta") == 0) {
+                    if (name.size() > delta_suffix.size() &&
+                        name.compare(name.size() - delta_suffix.size(), delta_suffix.size(), delta_suffix) == 0) {
+                        info.delta_url = download_url;
+                    }
+                    continue;
+                }
+
+                // Dictionary diffs are kept by base hash; the app picks the one for its dictionary
+                const std::string diff_prefix = "shortcuts.";
+                const std::string diff_suffix = ".diff.json";
+                if (name.size() > diff_prefix.size() + diff_suffix.size() &&
+                    name.compare(0, diff_prefix.size(), diff_prefix) == 0 &&
+                    name.compare(name.size() - diff_suffix.size(), diff_suffix.size(), diff_suffix) == 0) {
+                    const std::string hash = name.substr(diff_prefix.size(),
+                                                         name.size() - diff_prefix.size() - diff_suffix.size());
+                    info.shortcuts_diffs[hash] = download_url;
+                    continue;
+                }
+
                 // Look for .exe file
                 if (name.find(".exe") != std::string::npos) {
                     info.download_url = download_url;
+                    info.download_sha256 = digest;
+                    info.download_size = size;
                 }
 
                 // Look for shortcuts.json
                 if (name == "shortcuts.json") {
                     info.shortcuts_url = download_url;
+                    info.shortcuts_sha256 = digest;
+                    info.shortcuts_size = size;
                 }
             }
         }
@@ -157,25 +289,64 @@ UpdateManager::VersionInfo UpdateManager::ParseGitHubResponse(
 UpdateManager::VersionInfo UpdateManager::CheckForUpdates(
     const std::string& repo_owner,
     const std::string& repo_name,
-    const std::string& current_version
+    const std::string& current_version,
+    const std::atomic<bool>* cancel
 ) {
+    UNILANG_TRACE_SCOPE("update", "UpdateManager::CheckForUpdates");
     VersionInfo info;
 
     // Build GitHub API URL
-    std::string api_url = "https://api.github.com/repos/"
+    std::string api_url = m_api_url + "/repos/"
                         + repo_owner + "/" + repo_name
                         + "/releases/latest";
 
+    m_last_error.clear();
+    m_last_status = 0;
+
     // Make HTTP request
-    std::string response = HttpGet(api_url);
+    HttpClient::Response response;
+    if (!HttpGet(api_url, cancel, response)) {
+        // A cancelled check says nothing about the server
+        if (cancel == nullptr || !cancel->load(std::memory_order_relaxed)) {
+            Backoff(nullptr);
+        }
+        return info;
+    }
+
+    if (response.status == 304 && m_cache.has_info && m_cache.url == api_url) {
+        // Unchanged since the last check: no body was sent
+        info = m_cache.info;
+        info.is_newer = IsVersionNewer(current_version, info.version);
+        m_cache.failures = 0;
+        m_cache.retry_after = 0;
+        return info;
+    }
 
-    if (response.empty()) {
-        // Error already set in HttpGet
+    if (response.status != 200) {
+        m_last_error = "HTTP " + std::to_string(response.status) + " from " + api_url;
+        if ((response.status == 403 || response.status == 429) &&
+            (response.GetHeader("x-ratelimit-remaining") == "0" || !response.GetHeader("retry-after").empty())) {
+            m_last_error = "Rate limited by " + m_api_url + " (HTTP " + std::to_string(response.status) + ")";
+        }
+        Backoff(&response);
         return info;
     }
 
     // Parse response
-    info = ParseGitHubResponse(response, current_version);
+    info = ParseGitHubResponse(response.body, current_version);
+    if (!m_last_error.empty()) {
+        Backoff(nullptr);
+        return info;
+    }
+
+    m_cache.url = api_url;
+    m_cache.etag = std::string(response.GetHeader("etag"));
+    m_cache.last_modified = std::string(response.GetHeader("last-modified"));
+    m_cache.info = info;
+    m_cache.info.is_newer = false;
+    m_cache.has_info = true;
+    m_cache.failures = 0;
+    m_cache.retry_after = 0;
 
     return info;
 }
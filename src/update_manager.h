@@ -1,7 +1,11 @@
 #pragma once
 
+#include "http_client.h"
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <random>
 #include <string>
-#include <Windows.h>
 
 namespace UniLang {
 
@@ -12,6 +16,15 @@ namespace UniLang {
  * - Query GitHub API for latest release
  * - Compare versions
  * - Parse release information (version, download URL, release notes)
+ *
+ * Requests go through an HttpClient and block the calling thread; the app
+ * runs them on an UpdateWorker.
+ *
+ * The last response's validators (ETag, Last-Modified) and parsed release
+ * are kept in a CacheState. Checks are conditional, so an unchanged release
+ * costs a 304 with no body, and failed checks (network errors, rate limits,
+ * server errors) push the next automatic check back with jittered
+ * exponential backoff.
  */
 class UpdateManager {
 public:
@@ -19,24 +32,58 @@ public:
         std::string version;           // e.g., "1.0.1"
         std::string download_url;      // URL to .exe file
         std::string shortcuts_url;     // URL to shortcuts.json
+        std::string download_sha256;   // Asset digests published by GitHub (empty if none)
+        std::string shortcuts_sha256;
+        uint64_t download_size = 0;    // Asset sizes in bytes (0 if unknown)
+        uint64_t shortcuts_size = 0;
+        std::string delta_url;         // Binary delta from the current version's .exe (optional)
+        std::map<std::string, std::string> shortcuts_diffs;  // Content hash -> URL of a shortcuts diff from it
         std::string release_notes;     // Description from GitHub release
         bool is_newer = false;         // True if newer than current version
     };
 
-    UpdateManager();
+    /**
+     * @brief What survives between checks (persisted with SaveCache)
+     */
+    struct CacheState {
+        std::string url;               // Release URL the validators belong to
+        std::string etag;              // Sent back as If-None-Match
+        std::string last_modified;     // Sent back as If-Modified-Since
+        VersionInfo info;              // Latest release seen (is_newer is recomputed)
+        bool has_info = false;
+        uint32_t failures = 0;         // Consecutive failed checks
+        int64_t retry_after = 0;       // Unix time before which automatic checks are skipped
+    };
+
+    static const uint32_t BACKOFF_BASE_S = 15 * 60;
+    static const uint32_t BACKOFF_MAX_S = 24 * 60 * 60;
+
+    static const uint32_t REQUEST_TIMEOUT_MS = 15000;
+
+    /**
+     * @param http Client used for requests (must outlive the manager)
+     */
+    explicit UpdateManager(HttpClient& http);
     ~UpdateManager();
 
+    /**
+     * @brief Use another API server (e.g., a local stand-in), default https://api.github.com
+     */
+    void SetApiUrl(const std::string& api_url) { m_api_url = api_url; }
+
     /**
      * @brief Check GitHub API for latest release
      * @param repo_owner GitHub repository owner (e.g., "aicua")
      * @param repo_name GitHub repository name (e.g., "unilang")
      * @param current_version Current version to compare against
-     * @return VersionInfo with latest release details
+     * @param cancel Set by another thread to abort the request (optional)
+     * @return VersionInfo with latest release details (from the cache on 304)
      */
     VersionInfo CheckForUpdates(
         const std::string& repo_owner,
         const std::string& repo_name,
-        const std::string& current_version
+        const std::string& current_version,
+        const std::atomic<bool>* cancel = nullptr
     );
 
     /**
@@ -44,13 +91,51 @@ public:
      */
     std::string GetLastError() const { return m_last_error; }
 
+    /**
+     * @brief HTTP status of the last check (0 if no response arrived)
+     */
+    int GetLastStatus() const { return m_last_status; }
+
+    void SetCache(const CacheState& cache) { m_cache = cache; }
+    const CacheState& GetCache() const { return m_cache; }
+
+    /**
+     * @brief Check whether automatic checks should wait (after failures)
+     * @param now Unix time in seconds
+     */
+    bool IsBackingOff(int64_t now) const { return now < m_cache.retry_after; }
+
+    /**
+     * @brief Current Unix time in seconds
+     */
+    static int64_t Now();
+
+    /**
+     * @brief Load a cache saved by SaveCache
+     * @return false if the file is missing or malformed (cache is reset)
+     */
+    static bool LoadCache(const std::string& filepath, CacheState& cache);
+
+    /**
+     * @brief Save the cache as JSON (atomically, see SettingsWriter::WriteFileAtomic)
+     */
+    static bool SaveCache(const std::string& filepath, const CacheState& cache);
+
 private:
     /**
-     * @brief Make HTTP GET request to GitHub API
+     * @brief Make a conditional HTTP GET request to GitHub API
      * @param url Full API URL
-     * @return JSON response as string
+     * @param cancel Set by another thread to abort the request
+     * @param response Filled with the status, headers and JSON body
+     * @return false if no response arrived
+     */
+    bool HttpGet(const std::string& url, const std::atomic<bool>* cancel, HttpClient::Response& response);
+
+    /**
+     * @brief Record a failed check and schedule the next one
+     * @param response Failed response, if any, for Retry-After and rate limit headers
      */
-    std::string HttpGet(const std::string& url);
+    void Backoff(const HttpClient::Response* response);
 
     /**
      * @brief Compare two semantic versions (e.g., "1.0.1" vs "1.0.2")
@@ -64,7 +149,12 @@ private:
     VersionInfo ParseGitHubResponse(const std::string& json_response, const std::string& current_version);
 
 private:
+    HttpClient& m_http;
+    std::string m_api_url = "https://api.github.com";
     std::string m_last_error;
+    int m_last_status = 0;
+    CacheState m_cache;
+    std::minstd_rand m_rng{std::random_device{}()};
 };
 
 } // namespace UniLang
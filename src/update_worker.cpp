@@ -0,0 +1,176 @@
+#include "update_worker.h"
+#include "trace.h"
+#include <algorithm>
+
+namespace UniLang {
+
+UpdateWorker::~UpdateWorker() {
+    Stop();
+}
+
+bool UpdateWorker::Start(std::unique_ptr<HttpClient> http, const Config& config, ResultHandler handler) {
+    if (m_thread.joinable()) {
+        return false;
+    }
+    m_http = std::move(http);
+    m_config = config;
+    m_handler = std::move(handler);
+    m_stop = false;
+    m_cancel.store(false, std::memory_order_relaxed);
+    m_thread = std::thread(&UpdateWorker::WorkerLoop, this);
+    return true;
+}
+
+void UpdateWorker::Stop() {
+    if (!m_thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+        m_jobs.clear();
+        m_cancel.store(true, std::memory_order_relaxed);
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+bool UpdateWorker::QueueCheck(Mode mode) {
+    Job job;
+    job.type = Result::Type::Check;
+    job.mode = mode;
+    return Queue(std::move(job));
+}
+
+bool UpdateWorker::QueueDownload(std::vector<Download> downloads, Mode mode) {
+    Job job;
+    job.type = Result::Type::Download;
+    job.mode = mode;
+    job.downloads = std::move(downloads);
+    return Queue(std::move(job));
+}
+
+bool UpdateWorker::QueueShortcutsDiff(Download download, Mode mode) {
+    Job job;
+    job.type = Result::Type::ShortcutsDiff;
+    job.mode = mode;
+    job.downloads.push_back(std::move(download));
+    return Queue(std::move(job));
+}
+
+bool UpdateWorker::Queue(Job job) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_thread.joinable() || m_stop) {
+            return false;
+        }
+        // One waiting check answers them all; keep the most visible mode
+        if (job.type == Result::Type::Check) {
+            for (Job& queued : m_jobs) {
+                if (queued.type == Result::Type::Check) {
+                    queued.mode = std::max(queued.mode, job.mode);
+                    return true;
+                }
+            }
+        }
+        m_jobs.push_back(std::move(job));
+    }
+    m_wake.notify_one();
+    return true;
+}
+
+void UpdateWorker::Cancel() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.clear();
+    if (m_running_job) {
+        m_cancel.store(true, std::memory_order_relaxed);
+    }
+}
+
+bool UpdateWorker::IsBusy() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_running_job || !m_jobs.empty();
+}
+
+void UpdateWorker::WorkerLoop() {
+    UNILANG_TRACE_THREAD("UpdateWorker");
+    if (!m_config.cache_path.empty()) {
+        UpdateManager::LoadCache(m_config.cache_path, m_cache);
+    }
+
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_running_job = false;
+            m_wake.wait(lock, [this]() { return m_stop || !m_jobs.empty(); });
+            if (m_stop) {
+                return;
+            }
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            m_running_job = true;
+            // A Cancel() from now on is meant for this job
+            m_cancel.store(false, std::memory_order_relaxed);
+        }
+
+        auto result = std::make_unique<Result>();
+        result->type = job.type;
+        result->mode = job.mode;
+        if (job.type == Result::Type::Check) {
+            RunCheck(*result);
+        } else {
+            RunDownloads(job.downloads, *result);
+        }
+        result->cancelled = m_cancel.load(std::memory_order_relaxed);
+
+        if (m_handler) {
+            m_handler(std::move(result));
+        }
+    }
+}
+
+void UpdateWorker::RunCheck(Result& result) {
+    UNILANG_TRACE_SCOPE("update", "UpdateWorker::RunCheck");
+    UpdateManager manager(*m_http);
+    if (!m_config.api_url.empty()) {
+        manager.SetApiUrl(m_config.api_url);
+    }
+    manager.SetCache(m_cache);
+
+    // Only the user may override the backoff
+    const int64_t now = UpdateManager::Now();
+    if (result.mode != Mode::Interactive && manager.IsBackingOff(now)) {
+        result.error = "Skipped: retrying in " + std::to_string(m_cache.retry_after - now) + " s";
+        return;
+    }
+
+    result.info = manager.CheckForUpdates(m_config.repo_owner, m_config.repo_name, m_config.current_version, &m_cancel);
+    result.error = manager.GetLastError();
+    result.status = manager.GetLastStatus();
+
+    m_cache = manager.GetCache();
+    if (!m_config.cache_path.empty()) {
+        UpdateManager::SaveCache(m_config.cache_path, m_cache);
+    }
+}
+
+void UpdateWorker::RunDownloads(const std::vector<Download>& downloads, Result& result) {
+    UNILANG_TRACE_SCOPE("update", "UpdateWorker::RunDownloads");
+    Downloader::Options options;
+    options.timeout_ms = m_config.download_timeout_ms;
+    options.cancel = &m_cancel;
+    Downloader downloader(options);
+
+    if (!downloader.Download(downloads)) {
+        result.error = downloader.GetLastError();
+    }
+    const std::vector<Downloader::Outcome>& outcomes = downloader.GetOutcomes();
+    for (size_t i = 0; i < downloads.size(); ++i) {
+        if (outcomes[i].ok) {
+            result.files.push_back(downloads[i].path);
+        }
+    }
+}
+
+} // namespace UniLang
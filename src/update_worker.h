@@ -0,0 +1,146 @@
+#pragma once
+
+#include "downloader.h"
+#include "http_client.h"
+#include "update_manager.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace UniLang {
+
+/**
+ * @brief Runs update checks and downloads on a background thread
+ *
+ * The UI thread only queues jobs; every request runs here with a
+ * deadline, so a slow or captive network never stalls the message loop
+ * (and with it the keyboard hook). Each finished job is handed to the
+ * ResultHandler on the worker thread; the app posts it back to its window
+ * as a message and shows any UI from there.
+ *
+ * Release metadata is cached in Config::cache_path, so repeated checks are
+ * conditional requests. After a failed check, Silent and Notify checks are
+ * skipped until the backoff expires; Interactive checks always go out.
+ *
+ * Cancel() aborts the running request within HttpClient::CANCEL_POLL_MS
+ * and drops queued jobs; Stop() does the same and
+ * joins the thread, so exiting never waits for the network.
+ */
+class UpdateWorker {
+public:
+    /**
+     * @brief How the app reports a job's outcome
+     */
+    enum class Mode : uint8_t {
+        Silent,         // Startup check: nothing to show
+        Notify,         // Periodic check: a balloon if an update is available
+        Interactive,    // Tray menu: report every outcome
+    };
+
+    struct Config {
+        std::string repo_owner;
+        std::string repo_name;
+        std::string current_version;
+        std::string api_url;                        // Empty uses GitHub
+        std::string cache_path;                     // Empty keeps the cache in memory only
+        uint32_t download_timeout_ms = 5 * 60 * 1000;
+    };
+
+    using Download = Downloader::File;
+
+    struct Result {
+        enum class Type : uint8_t { Check, Download, ShortcutsDiff };
+
+        Type type = Type::Check;
+        Mode mode = Mode::Silent;
+        bool cancelled = false;
+        std::string error;                  // Empty on success
+        UpdateManager::VersionInfo info;    // Check: latest release
+        int status = 0;                     // Check: HTTP status (304 = unchanged, 0 = no request)
+        std::vector<std::string> files;     // Download, ShortcutsDiff: paths written
+    };
+
+    using ResultHandler = std::function<void(std::unique_ptr<Result> result)>;
+
+    UpdateWorker() = default;
+    ~UpdateWorker();
+
+    UpdateWorker(const UpdateWorker&) = delete;
+    UpdateWorker& operator=(const UpdateWorker&) = delete;
+
+    /**
+     * @brief Start the worker thread
+     * @param http Client for every request (owned by the worker)
+     * @param handler Called on the worker thread with each finished job
+     * @return false if already running
+     */
+    bool Start(std::unique_ptr<HttpClient> http, const Config& config, ResultHandler handler);
+
+    /**
+     * @brief Cancel everything and join the thread
+     */
+    void Stop();
+
+    /**
+     * @brief Queue a check for the latest release (a check already waiting is reused)
+     * @return false if the worker is not running
+     */
+    bool QueueCheck(Mode mode);
+
+    /**
+     * @brief Queue downloads, fetched concurrently as one job (see Downloader)
+     * @return false if the worker is not running
+     */
+    bool QueueDownload(std::vector<Download> downloads, Mode mode);
+
+    /**
+     * @brief Queue the download of a shortcuts diff (applied by the app, no restart)
+     * @return false if the worker is not running
+     */
+    bool QueueShortcutsDiff(Download download, Mode mode);
+
+    /**
+     * @brief Abort the running job (its result reports cancelled) and drop queued ones
+     */
+    void Cancel();
+
+    /**
+     * @brief Check whether a job is queued or running
+     */
+    bool IsBusy() const;
+
+private:
+    struct Job {
+        Result::Type type = Result::Type::Check;
+        Mode mode = Mode::Silent;
+        std::vector<Download> downloads;
+    };
+
+    bool Queue(Job job);
+    void WorkerLoop();
+    void RunCheck(Result& result);
+    void RunDownloads(const std::vector<Download>& downloads, Result& result);
+
+private:
+    std::unique_ptr<HttpClient> m_http;     // Worker thread only
+    Config m_config;
+    ResultHandler m_handler;
+    UpdateManager::CacheState m_cache;      // Worker thread only
+    std::thread m_thread;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::deque<Job> m_jobs;                 // Guarded by m_mutex
+    bool m_running_job = false;             // Guarded by m_mutex
+    bool m_stop = false;                    // Guarded by m_mutex
+    std::atomic<bool> m_cancel{false};      // Aborts the running request
+};
+
+} // namespace UniLang
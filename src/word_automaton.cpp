@@ -0,0 +1,371 @@
+#include "word_automaton.h"
+#include "trace.h"
+#include <algorithm>
+
+namespace UniLang {
+
+namespace {
+
+/**
+ * @brief Incremental construction of a minimal automaton from sorted words (Daciuk et al.)
+ *
+ * Only the states along the last word are open. Every other state is
+ * frozen into flat arrays as soon as no later word can change it, or merged
+ * into an equivalent frozen state, so building never holds the whole trie.
+ * Frozen states come out in post-order (targets first).
+ */
+class Builder {
+public:
+    // Frozen states: the transitions of state s are [first[s], first[s + 1])
+    std::vector<uint32_t> first = {0};
+    std::vector<uint8_t> labels;
+    std::vector<uint32_t> targets;
+    std::vector<uint32_t> below;        // Words accepted from each state
+    std::vector<bool> final;
+
+    Builder() : m_open(1), m_registry(1024, WordAutomaton::NO_STATE) {}
+
+    /**
+     * @brief Add a word; words must come in sorted order without repeats
+     */
+    void Add(std::string_view word) {
+        size_t common = 0;
+        while (common < m_previous.size() && common < word.size() && m_previous[common] == word[common]) {
+            ++common;
+        }
+        Close(common);
+
+        for (size_t i = common; i < word.size(); ++i) {
+            m_open[m_open_count - 1].transitions.emplace_back(static_cast<uint8_t>(word[i]), WordAutomaton::NO_STATE);
+            if (m_open_count == m_open.size()) {
+                m_open.emplace_back();
+            }
+            m_open[m_open_count].transitions.clear();
+            m_open[m_open_count].final = false;
+            ++m_open_count;
+        }
+        m_open[m_open_count - 1].final = true;
+        m_previous.assign(word.data(), word.size());
+    }
+
+    /**
+     * @brief Freeze the remaining states
+     * @return Frozen root state
+     */
+    uint32_t Finish() {
+        Close(0);
+        return Freeze(m_open[0]);
+    }
+
+private:
+    struct OpenState {
+        std::vector<std::pair<uint8_t, uint32_t>> transitions;  // The last one leads to the next open state
+        bool final = false;
+    };
+
+    /**
+     * @brief Freeze the open states below `depth`, deepest first
+     */
+    void Close(size_t depth) {
+        while (m_open_count > depth + 1) {
+            const uint32_t state = Freeze(m_open[m_open_count - 1]);
+            --m_open_count;
+            m_open[m_open_count - 1].transitions.back().second = state;
+        }
+    }
+
+    /**
+     * @brief Append a state, or find the frozen state with the same transitions and finality
+     */
+    uint32_t Freeze(const OpenState& open) {
+        const uint32_t state = static_cast<uint32_t>(first.size() - 1);
+        uint32_t words = open.final ? 1 : 0;
+        for (const auto& [label, target] : open.transitions) {
+            labels.push_back(label);
+            targets.push_back(target);
+            words += below[target];
+        }
+        first.push_back(static_cast<uint32_t>(labels.size()));
+        below.push_back(words);
+        final.push_back(open.final);
+
+        const size_t mask = m_registry.size() - 1;
+        size_t slot = Hash(state) & mask;
+        while (m_registry[slot] != WordAutomaton::NO_STATE) {
+            if (Equal(m_registry[slot], state)) {
+                // Equivalent state: drop the copy
+                labels.resize(first[state]);
+                targets.resize(first[state]);
+                first.pop_back();
+                below.pop_back();
+                final.pop_back();
+                return m_registry[slot];
+            }
+            slot = (slot + 1) & mask;
+        }
+        m_registry[slot] = state;
+        if (++m_registered * 2 > m_registry.size()) {
+            Grow();
+        }
+        return state;
+    }
+
+    size_t Hash(uint32_t state) const {
+        size_t hash = final[state] ? 0x9E3779B9u : 0;
+        for (uint32_t t = first[state]; t < first[state + 1]; ++t) {
+            hash = (hash ^ (size_t(labels[t]) << 32 | targets[t])) * 0x100000001B3ull;
+        }
+        return hash ^ (hash >> 29);
+    }
+
+    bool Equal(uint32_t a, uint32_t b) const {
+        const uint32_t count = first[a + 1] - first[a];
+        if (final[a] != final[b] || count != first[b + 1] - first[b]) {
+            return false;
+        }
+        return std::equal(labels.begin() + first[a], labels.begin() + first[a + 1], labels.begin() + first[b]) &&
+               std::equal(targets.begin() + first[a], targets.begin() + first[a + 1], targets.begin() + first[b]);
+    }
+
+    /**
+     * @brief Double the registry, keeping it at most half full so probes stay short
+     */
+    void Grow() {
+        std::vector<uint32_t> registry(m_registry.size() * 2, WordAutomaton::NO_STATE);
+        const size_t mask = registry.size() - 1;
+        for (uint32_t state : m_registry) {
+            if (state == WordAutomaton::NO_STATE) {
+                continue;
+            }
+            size_t slot = Hash(state) & mask;
+            while (registry[slot] != WordAutomaton::NO_STATE) {
+                slot = (slot + 1) & mask;
+            }
+            registry[slot] = state;
+        }
+        m_registry.swap(registry);
+    }
+
+    std::vector<OpenState> m_open;      // States along the last word; m_open[0] is the root
+    size_t m_open_count = 1;
+    std::string m_previous;
+    std::vector<uint32_t> m_registry;   // Open-addressing hash set of frozen states
+    size_t m_registered = 0;
+};
+
+std::string_view Trim(std::string_view text) {
+    while (!text.empty() && (text.front() == ' ' || text.front() == '\t' || text.front() == '\r')) {
+        text.remove_prefix(1);
+    }
+    while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) {
+        text.remove_suffix(1);
+    }
+    return text;
+}
+
+char ToUpper(char ch) {
+    return ch >= 'a' && ch <= 'z' ? static_cast<char>(ch - 'a' + 'A') : ch;
+}
+
+} // namespace
+
+bool WordAutomaton::Build(std::vector<Pair> pairs) {
+    UNILANG_TRACE_SCOPE("matcher", "WordAutomaton::Build");
+    Clear();
+
+    for (Pair& pair : pairs) {
+        std::string& typo = pair.first;
+        if (typo.empty() || typo.size() > MAX_WORD_LENGTH || typo.front() == '\'' ||
+            !std::all_of(typo.begin(), typo.end(), IsWordChar)) {
+            m_last_error = "invalid typo '" + typo + "'";
+            return false;
+        }
+        if (pair.second.empty() || pair.second.size() > MAX_CORRECTION_LENGTH) {
+            m_last_error = "invalid correction for '" + typo + "'";
+            return false;
+        }
+        for (char& ch : typo) {
+            ch = ch >= 'A' && ch <= 'Z' ? static_cast<char>(ch - 'A' + 'a') : ch;
+        }
+    }
+
+    // Sorted input builds the minimal automaton in one pass; for repeated
+    // typos only the last pair is kept
+    std::stable_sort(pairs.begin(), pairs.end(),
+                     [](const Pair& a, const Pair& b) { return a.first < b.first; });
+    size_t count = 0;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (i + 1 < pairs.size() && pairs[i + 1].first == pairs[i].first) {
+            continue;
+        }
+        if (count != i) {
+            pairs[count] = std::move(pairs[i]);
+        }
+        ++count;
+    }
+    pairs.resize(count);
+
+    Builder builder;
+    for (const Pair& pair : pairs) {
+        builder.Add(pair.first);
+    }
+    const uint32_t root = builder.Finish();
+
+    // Lay the states out breadth-first from the root, so the states every
+    // word walks through first share cache lines. A state is the offset of
+    // its first transition; leaves all share the sentinel at the end.
+    const size_t state_count = builder.first.size() - 1;
+    std::vector<uint32_t> offset(state_count, NO_STATE);
+    std::vector<uint32_t> order = {root};
+    uint32_t next_offset = 0;
+    offset[root] = 0;
+    for (size_t n = 0; n < order.size(); ++n) {
+        const uint32_t state = order[n];
+        next_offset += builder.first[state + 1] - builder.first[state];
+        for (uint32_t t = builder.first[state]; t < builder.first[state + 1]; ++t) {
+            const uint32_t target = builder.targets[t];
+            if (offset[target] == NO_STATE && builder.first[target + 1] != builder.first[target]) {
+                offset[target] = 0;  // Placed when dequeued
+                order.push_back(target);
+            }
+        }
+    }
+    const uint32_t sentinel = next_offset;
+    if (sentinel >= (1u << 30) || pairs.size() > MAX_OUTPUT) {
+        m_last_error = "word list is too large";
+        return false;
+    }
+    next_offset = 0;
+    for (uint32_t state : order) {
+        offset[state] = next_offset;
+        next_offset += builder.first[state + 1] - builder.first[state];
+    }
+
+    // A transition's output is the number of typos ordered before its target
+    m_transitions.reserve(sentinel + 1);
+    for (uint32_t state : order) {
+        uint32_t skipped = builder.final[state] ? 1 : 0;
+        for (uint32_t t = builder.first[state]; t < builder.first[state + 1]; ++t) {
+            const uint32_t target = builder.targets[t];
+            const uint32_t target_offset = builder.first[target + 1] != builder.first[target] ? offset[target] : sentinel;
+            Transition transition;
+            transition.target = target_offset << 1 | (builder.final[target] ? 1 : 0);
+            transition.label_output = uint32_t(builder.labels[t]) << 24 | skipped;
+            if (t + 1 == builder.first[state + 1]) {
+                transition.label_output |= LAST_TRANSITION;
+            }
+            m_transitions.push_back(transition);
+            skipped += builder.below[target];
+        }
+    }
+    m_transitions.push_back(Transition{0, LAST_TRANSITION});
+    m_state_count = order.size() + 1;
+
+    // Corrections in sorted typo order, which is the order of the indices
+    m_offsets.reserve(pairs.size() + 1);
+    for (const Pair& pair : pairs) {
+        m_offsets.push_back(static_cast<uint32_t>(m_corrections.size()));
+        m_corrections += pair.second;
+    }
+    m_offsets.push_back(static_cast<uint32_t>(m_corrections.size()));
+    m_corrections.shrink_to_fit();
+    m_word_count = pairs.size();
+    return true;
+}
+
+size_t WordAutomaton::ParseWordList(std::string_view text, std::vector<Pair>& pairs) {
+    size_t skipped = 0;
+    while (!text.empty()) {
+        const size_t end = text.find('\n');
+        const std::string_view line = Trim(text.substr(0, end));
+        text.remove_prefix(end == std::string_view::npos ? text.size() : end + 1);
+        if (line.empty() || line.front() == '#') {
+            continue;
+        }
+
+        size_t separator = line.find("->");
+        size_t separator_length = 2;
+        if (separator == std::string_view::npos) {
+            separator = line.find('\t');
+            separator_length = 1;
+        }
+        if (separator == std::string_view::npos) {
+            ++skipped;
+            continue;
+        }
+
+        const std::string_view typo = Trim(line.substr(0, separator));
+        const std::string_view correction = Trim(line.substr(separator + separator_length));
+        if (typo.empty() || typo.size() > MAX_WORD_LENGTH || typo.front() == '\'' ||
+            !std::all_of(typo.begin(), typo.end(), IsWordChar) ||
+            correction.empty() || correction.size() > MAX_CORRECTION_LENGTH ||
+            correction.find(',') != std::string_view::npos) {
+            ++skipped;  // Not a word, or ambiguous ("a, b")
+            continue;
+        }
+        pairs.emplace_back(std::string(typo), std::string(correction));
+    }
+    return skipped;
+}
+
+void WordAutomaton::Clear() {
+    m_transitions.clear();
+    m_state_count = 0;
+    m_corrections.clear();
+    m_offsets.clear();
+    m_word_count = 0;
+}
+
+uint32_t WordAutomaton::Find(std::string_view word) const {
+    if (Empty()) {
+        return NO_WORD;
+    }
+
+    uint32_t state = ROOT;
+    uint32_t index = 0;
+    for (char ch : word) {
+        if (!IsWordChar(ch)) {
+            return NO_WORD;
+        }
+        state = Step(state, ch, index);
+        if (state == NO_STATE) {
+            return NO_WORD;
+        }
+    }
+    return IsFinal(state) ? index : NO_WORD;
+}
+
+bool WordAutomaton::Correct(std::string_view word, std::string& out) const {
+    const Case word_case = GetCase(word);
+    const uint32_t index = word_case == Case::Mixed ? NO_WORD : Find(word);
+    if (index == NO_WORD) {
+        return false;
+    }
+    AppendInCase(GetCorrection(index), word_case, out);
+    return true;
+}
+
+WordAutomaton::Case WordAutomaton::GetCase(std::string_view word) {
+    Case word_case = Case::Lower;
+    for (size_t i = 0; i < word.size(); ++i) {
+        word_case = StepCase(word_case, i, word[i]);
+    }
+    return word_case;
+}
+
+void WordAutomaton::AppendInCase(std::string_view correction, Case word_case, std::string& out) {
+    const size_t start = out.size();
+    out.append(correction.data(), correction.size());
+    if (word_case == Case::Upper) {
+        std::transform(out.begin() + start, out.end(), out.begin() + start, ToUpper);
+    } else if (word_case == Case::Capitalized && start < out.size()) {
+        out[start] = ToUpper(out[start]);
+    }
+}
+
+size_t WordAutomaton::GetMemoryBytes() const {
+    return m_transitions.capacity() * sizeof(Transition) + m_corrections.capacity() +
+           m_offsets.capacity() * sizeof(uint32_t);
+}
+
+} // namespace UniLang
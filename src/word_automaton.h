@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace UniLang {
+
+/**
+ * @brief Autocorrect word list compiled into a minimal acyclic automaton
+ *
+ * Typos (lowercase ASCII letters and apostrophes) are the paths of a
+ * minimal DAWG: common prefixes and common suffixes are shared, so a list
+ * of 50k+ misspellings takes a few hundred KB instead of a hash map of
+ * strings. Each transition carries an output label; summed along a path
+ * they give the typo's rank in sorted order, which indexes the
+ * corrections (a minimal perfect hash, so nothing else is stored per word).
+ *
+ * The automaton is walked one typed letter at a time (see
+ * PatternMatcher::StepWords), so a word costs nothing extra when its
+ * boundary is typed. Typed case carries over: "Teh" -> "The", "TEH" -> "THE".
+ *
+ * Word lists are plain text, one pair per line:
+ *   teh->the
+ *   recieve<TAB>receive
+ */
+class WordAutomaton {
+public:
+    using Pair = std::pair<std::string, std::string>;   // Typo, correction
+
+    enum class Case : uint8_t {
+        Lower,          // teh
+        Capitalized,    // Teh
+        Upper,          // TEH
+        Mixed,          // tEh (never corrected)
+    };
+
+    static const uint32_t ROOT = 0;
+    static constexpr uint32_t NO_STATE = UINT32_MAX;
+    static constexpr uint32_t NO_WORD = UINT32_MAX;
+    static const size_t MAX_WORD_LENGTH = 31;           // Fits the matcher buffer with its boundary
+    static const size_t MAX_CORRECTION_LENGTH = 128;    // Bytes of UTF-8
+
+    WordAutomaton() = default;
+
+    /**
+     * @brief Compile typo/correction pairs, replacing any previous list
+     *
+     * Typos are matched case-insensitively; when a typo is listed twice,
+     * the later pair wins.
+     *
+     * @return false if a typo or correction is invalid (see GetLastError)
+     */
+    bool Build(std::vector<Pair> pairs);
+
+    /**
+     * @brief Parse a word list ("typo->correction" or "typo<TAB>correction" lines)
+     *
+     * Blank lines and lines starting with '#' are ignored, as are pairs
+     * that can't be autocorrected (several corrections, typos with other
+     * characters than letters and apostrophes).
+     *
+     * @return Number of lines skipped
+     */
+    static size_t ParseWordList(std::string_view text, std::vector<Pair>& pairs);
+
+    /**
+     * @brief Drop the word list
+     */
+    void Clear();
+
+    /**
+     * @brief Check whether there are no words (Step must not be called then)
+     */
+    bool Empty() const { return m_word_count == 0; }
+
+    /**
+     * @brief Follow the transition for a typed letter or apostrophe
+     * @param index Accumulates the output labels along the path
+     * @return Next state, or NO_STATE if no typo continues this way
+     */
+    uint32_t Step(uint32_t state, char ch, uint32_t& index) const {
+        const uint32_t label = static_cast<uint32_t>(ch >= 'A' && ch <= 'Z' ? ch - 'A' + 'a' : ch);
+        for (const Transition* t = &m_transitions[state >> 1];; ++t) {
+            const uint32_t t_label = (t->label_output >> 24) & 0x7F;
+            if (t_label == label) {
+                index += t->label_output & MAX_OUTPUT;
+                return t->target;
+            }
+            // Labels are sorted, so a larger one ends the search
+            if (t_label > label || (t->label_output & LAST_TRANSITION) != 0) {
+                return NO_STATE;
+            }
+        }
+    }
+
+    /**
+     * @brief Check whether a state ends a typo
+     */
+    static bool IsFinal(uint32_t state) { return (state & 1) != 0; }
+
+    /**
+     * @brief Walk a whole typed word
+     * @return Typo index, or NO_WORD if the word is not a typo
+     */
+    uint32_t Find(std::string_view word) const;
+
+    /**
+     * @brief Correction of a typo, as listed
+     */
+    std::string_view GetCorrection(uint32_t index) const {
+        return std::string_view(m_corrections.data() + m_offsets[index], m_offsets[index + 1] - m_offsets[index]);
+    }
+
+    /**
+     * @brief Append the correction of a typed word, in the case it was typed in
+     * @return false if the word is not a typo or is typed in mixed case
+     */
+    bool Correct(std::string_view word, std::string& out) const;
+
+    /**
+     * @brief Case of a word after one more letter
+     * @param position Letters before this one
+     */
+    static Case StepCase(Case word_case, size_t position, char ch) {
+        const bool upper = ch >= 'A' && ch <= 'Z';
+        if (!upper && !(ch >= 'a' && ch <= 'z')) {
+            return word_case;   // Apostrophe
+        }
+        if (position == 0) {
+            return upper ? Case::Capitalized : Case::Lower;
+        }
+        switch (word_case) {
+            case Case::Lower:
+                return upper ? Case::Mixed : Case::Lower;
+            case Case::Capitalized:
+                // "TE" is the start of "TEH"; "TeH" is mixed
+                if (upper) {
+                    return position == 1 ? Case::Upper : Case::Mixed;
+                }
+                return Case::Capitalized;
+            case Case::Upper:
+                return upper ? Case::Upper : Case::Mixed;
+            default:
+                return Case::Mixed;
+        }
+    }
+
+    /**
+     * @brief Case of a typed word
+     */
+    static Case GetCase(std::string_view word);
+
+    /**
+     * @brief Append a correction in the case the typo was typed in (ASCII letters only)
+     */
+    static void AppendInCase(std::string_view correction, Case word_case, std::string& out);
+
+    /**
+     * @brief Check whether a character is part of words (ASCII letters and apostrophes)
+     */
+    static bool IsWordChar(char ch) {
+        return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '\'';
+    }
+
+    /**
+     * @brief Check whether a character ends a word and can fire a correction
+     *
+     * Spaces and punctuation do; digits, '^', '_', control characters and
+     * non-ASCII text don't, so identifiers, numbers and words in other
+     * scripts are left alone.
+     */
+    static bool IsBoundary(char ch) {
+        if (ch < ' ' || ch >= 0x7F || ch == '^' || ch == '_' || ch == '\'') {
+            return false;
+        }
+        return !((ch >= '0' && ch <= '9') || (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z'));
+    }
+
+    /**
+     * @brief Owner's category tag (see ShortcutsDict); Build and Clear keep it
+     */
+    uint8_t GetCategory() const { return m_category; }
+    void SetCategory(uint8_t category) { m_category = category; }
+
+    /**
+     * @brief Automaton size
+     */
+    size_t GetWordCount() const { return m_word_count; }
+    size_t GetStateCount() const { return m_state_count; }
+    size_t GetTransitionCount() const { return m_transitions.empty() ? 0 : m_transitions.size() - 1; }
+    size_t GetMemoryBytes() const;
+
+    const std::string& GetLastError() const { return m_last_error; }
+
+private:
+    /**
+     * @brief One transition; a state's transitions are consecutive, in label order
+     */
+    struct Transition {
+        uint32_t target;        // Target state: offset of its first transition << 1 | final
+        uint32_t label_output;  // LAST_TRANSITION | label << 24 | typos skipped by taking it
+    };
+
+    static const uint32_t LAST_TRANSITION = 0x80000000u;
+    static const uint32_t MAX_OUTPUT = 0x00FFFFFFu;
+
+    // State 0 is the root; the sentinel at the end has no label, for states without transitions
+    std::vector<Transition> m_transitions;
+    size_t m_state_count = 0;
+
+    std::string m_corrections;          // All corrections, in typo order
+    std::vector<uint32_t> m_offsets;    // Typo index -> offset in m_corrections (one extra at the end)
+    size_t m_word_count = 0;
+    uint8_t m_category = 0;
+
+    std::string m_last_error;
+};
+
+} // namespace UniLang
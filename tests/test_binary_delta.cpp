@@ -0,0 +1,238 @@
+#include "test_framework.h"
+#include "binary_delta.h"
+#include <cstdint>
+#include <string>
+
+using namespace UniLang;
+
+namespace {
+
+std::string RandomBytes(size_t size, uint32_t seed) {
+    std::string data(size, '\0');
+    for (char& ch : data) {
+        seed = seed * 1664525u + 1013904223u;
+        ch = static_cast<char>(seed >> 24);
+    }
+    return data;
+}
+
+// A new release: code moved around, a few bytes patched, a section added
+std::string Edit(const std::string& old_data) {
+    std::string data = old_data.substr(old_data.size() / 3) + old_data.substr(0, old_data.size() / 3);
+    for (size_t i = 1000; i < data.size(); i += 9973) {
+        data[i] = static_cast<char>(data[i] + 1);
+    }
+    data.insert(data.size() / 2, RandomBytes(5000, 7));
+    return data;
+}
+
+/**
+ * @brief Apply a delta fed in pieces of chunk bytes
+ */
+bool Apply(const std::string& old_data, const std::string& delta, size_t chunk, std::string& out,
+           std::string* error = nullptr) {
+    out.clear();
+    DeltaApplier applier(old_data, [&out](std::string_view data) {
+        out.append(data);
+        return true;
+    });
+    bool ok = true;
+    for (size_t pos = 0; ok && pos < delta.size(); pos += chunk) {
+        ok = applier.Feed(std::string_view(delta).substr(pos, chunk));
+    }
+    ok = ok && applier.Finish();
+    if (error != nullptr) {
+        *error = applier.GetLastError();
+    }
+    return ok;
+}
+
+void PutLittleEndian(std::string& data, size_t offset, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        data[offset + i] = static_cast<char>(value >> (8 * i));
+    }
+}
+
+void PutVarint(std::string& out, uint64_t value) {
+    for (; value >= 0x80; value >>= 7) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+    }
+    out += static_cast<char>(value);
+}
+
+// Header field offsets (see BinaryDelta)
+const size_t NEW_SIZE_OFFSET = BinaryDelta::MAGIC_SIZE + 8;
+const size_t BLOCK_SIZE_OFFSET = BinaryDelta::MAGIC_SIZE + 80;
+const size_t BLOCK_COUNT_OFFSET = BinaryDelta::MAGIC_SIZE + 84;
+
+} // namespace
+
+TEST(DeltaRoundTripsInAnyPieceSize) {
+    const std::string old_data = RandomBytes(300 * 1000, 1);
+    const std::string new_data = Edit(old_data);
+    const std::string delta = BinaryDelta::Create(old_data, new_data);
+    CHECK(delta.compare(0, BinaryDelta::MAGIC_SIZE, BinaryDelta::MAGIC) == 0);
+    CHECK(delta.size() < new_data.size() / 10);
+
+    for (size_t chunk : {delta.size(), size_t(1), size_t(7), size_t(4096)}) {
+        std::string out;
+        CHECK(Apply(old_data, delta, chunk, out));
+        CHECK(out == new_data);
+    }
+}
+
+TEST(HeaderDescribesBothFiles) {
+    const std::string old_data = RandomBytes(1000, 2);
+    const std::string new_data = RandomBytes(BinaryDelta::BLOCK_SIZE * 2 + 10, 3);
+    const std::string delta = BinaryDelta::Create(old_data, new_data);
+
+    DeltaApplier applier(old_data, [](std::string_view) { return true; });
+    CHECK(!applier.HasHeader());
+    REQUIRE(applier.Feed(std::string_view(delta).substr(0, BinaryDelta::HEADER_SIZE + 3 * 32)));
+    REQUIRE(applier.HasHeader());
+    CHECK(applier.GetHeader().old_size == old_data.size());
+    CHECK(applier.GetHeader().new_size == new_data.size());
+    CHECK(applier.GetHeader().block_sha256.size() == 3);
+    CHECK(Sha256::ToHex(applier.GetHeader().new_sha256) == Sha256::Hash(new_data));
+}
+
+TEST(EmptyFiles) {
+    const std::string data = RandomBytes(5000, 4);
+    std::string out;
+    CHECK(Apply("", BinaryDelta::Create("", data), 100, out));
+    CHECK(out == data);
+    CHECK(Apply(data, BinaryDelta::Create(data, ""), 100, out));
+    CHECK(out.empty());
+}
+
+TEST(WrongBaseFailsBeforeAnyOutput) {
+    const std::string old_data = RandomBytes(400 * 1000, 5);
+    const std::string new_data = Edit(old_data);
+    const std::string delta = BinaryDelta::Create(old_data, new_data);
+
+    std::string other = old_data;
+    other[other.size() / 2] ^= 1;
+    uint64_t written = 0;
+    DeltaApplier applier(other, [&written](std::string_view data) {
+        written += data.size();
+        return true;
+    });
+    CHECK(!applier.Feed(delta));
+    CHECK(applier.GetLastError().find("different base") != std::string::npos);
+    CHECK(written == 0);
+}
+
+TEST(CorruptOrTruncatedDeltasAreRejected) {
+    const std::string old_data = RandomBytes(200 * 1000, 6);
+    const std::string new_data = Edit(old_data);
+    const std::string delta = BinaryDelta::Create(old_data, new_data);
+    std::string out;
+    std::string error;
+
+    std::string corrupt = delta;
+    corrupt[corrupt.size() - 100] ^= 0x40;
+    CHECK(!Apply(old_data, corrupt, 4096, out, &error));
+    CHECK(!error.empty());
+
+    CHECK(!Apply(old_data, delta.substr(0, delta.size() - 1), 4096, out));
+    CHECK(!Apply(old_data, delta + "x", 4096, out));
+
+    std::string bad_magic = delta;
+    bad_magic[0] = 'X';
+    CHECK(!Apply(old_data, bad_magic, 4096, out));
+}
+
+TEST(OversizedHeadersAreRejectedBeforeAllocating) {
+    const std::string old_data = RandomBytes(1000, 10);
+    const std::string new_data = RandomBytes(1000, 11);
+    const std::string delta = BinaryDelta::Create(old_data, new_data);
+    std::string out;
+    std::string error;
+
+    // A block count that matches a huge size (formerly 128 GB of block hashes)
+    std::string corrupt = delta;
+    PutLittleEndian(corrupt, NEW_SIZE_OFFSET, uint64_t(1) << 45, 8);
+    PutLittleEndian(corrupt, BLOCK_COUNT_OFFSET, (uint64_t(1) << 45) / BinaryDelta::BLOCK_SIZE, 4);
+    CHECK(!Apply(old_data, corrupt, 4096, out, &error));
+    CHECK(error == "malformed delta header");
+
+    // Few large blocks, but still past the size limit
+    PutLittleEndian(corrupt, BLOCK_SIZE_OFFSET, uint64_t(1) << 31, 4);
+    PutLittleEndian(corrupt, BLOCK_COUNT_OFFSET, uint64_t(1) << 14, 4);
+    CHECK(!Apply(old_data, corrupt, 4096, out, &error));
+    CHECK(error == "delta describes a file larger than expected");
+
+    // A size where size + block size - 1 wraps around to a small block count
+    corrupt = delta;
+    PutLittleEndian(corrupt, NEW_SIZE_OFFSET, UINT64_MAX, 8);
+    PutLittleEndian(corrupt, BLOCK_COUNT_OFFSET, 0, 4);
+    CHECK(!Apply(old_data, corrupt, 4096, out, &error));
+    CHECK(error == "malformed delta header");
+
+    // The caller's limit, e.g. the release asset's size
+    DeltaApplier exact(old_data, [](std::string_view) { return true; }, new_data.size());
+    CHECK(exact.Feed(delta) && exact.Finish());
+    DeltaApplier smaller(old_data, [](std::string_view) { return true; }, new_data.size() - 1);
+    CHECK(!smaller.Feed(delta));
+    CHECK(smaller.GetLastError() == "delta describes a file larger than expected");
+}
+
+TEST(RecordsThatWrapAroundAreRejected) {
+    const std::string old_data = RandomBytes(1000, 12);
+    const std::string new_data = RandomBytes(1000, 13);
+    const std::string header = BinaryDelta::Create(old_data, new_data).substr(0, BinaryDelta::HEADER_SIZE + 32);
+    std::string out;
+    std::string error;
+
+    // A zero run of 2^64 - 1 plus 2 literals sums to 1
+    std::string delta = header;
+    PutVarint(delta, 10);
+    PutVarint(delta, 0);
+    PutVarint(delta, 0);
+    PutVarint(delta, UINT64_MAX);
+    PutVarint(delta, 2);
+    CHECK(!Apply(old_data, delta, 4096, out, &error));
+    CHECK(error == "malformed delta record");
+    CHECK(out.empty());
+
+    // A seek further than the base is long
+    delta = header;
+    PutVarint(delta, 0);
+    PutVarint(delta, 0);
+    PutVarint(delta, UINT64_MAX);
+    CHECK(!Apply(old_data, delta, 4096, out, &error));
+    CHECK(error == "malformed delta record");
+
+    // Truncated inside a record
+    const std::string valid = BinaryDelta::Create(old_data, new_data);
+    for (size_t size : {BinaryDelta::HEADER_SIZE - 1, BinaryDelta::HEADER_SIZE + 32, valid.size() / 2}) {
+        CHECK(!Apply(old_data, valid.substr(0, size), 4096, out, &error));
+        CHECK(error == "delta ended early");
+    }
+}
+
+TEST(BadBlockFailsBeforeTheDeltaEnds) {
+    const std::string old_data = RandomBytes(400 * 1000, 9);
+    const std::string delta = BinaryDelta::Create(old_data, Edit(old_data));
+
+    // Block 1's hash no longer matches what the records produce
+    std::string corrupt = delta;
+    corrupt[BinaryDelta::HEADER_SIZE + 32 + 5] ^= 1;
+    DeltaApplier applier(old_data, [](std::string_view) { return true; });
+    size_t fed = 0;
+    while (fed < corrupt.size() && applier.Feed(std::string_view(corrupt).substr(fed, 256))) {
+        fed += 256;
+    }
+    CHECK(fed < corrupt.size());
+    CHECK(applier.GetLastError().find("block 1 ") != std::string::npos);
+    CHECK(applier.GetOutputSize() < applier.GetHeader().new_size);
+}
+
+TEST(OutputCanAbort) {
+    const std::string old_data = RandomBytes(100 * 1000, 8);
+    const std::string delta = BinaryDelta::Create(old_data, Edit(old_data));
+    DeltaApplier applier(old_data, [](std::string_view) { return false; });
+    CHECK(!applier.Feed(delta));
+}
+
+UNILANG_TEST_MAIN()
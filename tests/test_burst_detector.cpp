@@ -0,0 +1,134 @@
+#include "test_framework.h"
+#include "burst_detector.h"
+#include <cstdint>
+
+using namespace UniLang;
+
+namespace {
+
+using Class = BurstDetector::Class;
+
+const uint32_t VK_A = 0x41;
+const uint32_t VK_SHIFT = 0x10;
+
+KeyEvent KeyDown(uint32_t time_ms, uint32_t vk = VK_A, bool injected = false) {
+    KeyEvent event;
+    event.vk = vk;
+    event.ch = vk == VK_SHIFT ? 0 : u'a';
+    event.is_key_down = true;
+    event.is_injected = injected;
+    event.time_ms = time_ms;
+    return event;
+}
+
+// Key-down then key-up, so nothing looks like autorepeat
+Class Press(BurstDetector& detector, uint32_t time_ms, bool injected = false) {
+    const Class result = detector.OnKeyDown(KeyDown(time_ms, VK_A, injected));
+    detector.OnKeyUp(VK_A);
+    return result;
+}
+
+} // namespace
+
+TEST(HumanTypingIsNormal) {
+    BurstDetector detector;
+    for (uint32_t t = 1000; t < 3000; t += 120) {
+        CHECK(Press(detector, t) == Class::Normal);
+    }
+    // Fast for a person, but still above max_gap_ms
+    for (uint32_t t = 5000; t < 5100; t += 9) {
+        CHECK(Press(detector, t) == Class::Normal);
+    }
+    CHECK(!detector.InBurst());
+    CHECK(detector.GetBurstCount() == 0);
+}
+
+TEST(PhysicalBurstStartsAtMinRun) {
+    BurstDetector detector;
+    CHECK(Press(detector, 1000) == Class::Normal);
+    CHECK(Press(detector, 1008) == Class::Normal);     // Gap == max_gap_ms still counts
+    CHECK(Press(detector, 1016) == Class::Burst);      // Third of the run
+    CHECK(detector.InBurst());
+    CHECK(detector.GetBurstCount() == 1);
+
+    // A gap of max_gap_ms + 1 breaks a run that has not become a burst yet
+    BurstDetector slower;
+    CHECK(Press(slower, 1000) == Class::Normal);
+    CHECK(Press(slower, 1009) == Class::Normal);
+    CHECK(Press(slower, 1018) == Class::Normal);
+    CHECK(slower.GetBurstCount() == 0);
+}
+
+TEST(InjectedInputNeedsOnlyTwoEvents) {
+    BurstDetector detector;
+    CHECK(Press(detector, 1000, true) == Class::Normal);
+    CHECK(Press(detector, 1005, true) == Class::Burst);
+    CHECK(detector.GetBurstCount() == 1);
+}
+
+TEST(BurstLastsUntilQuiet) {
+    BurstDetector detector;
+    Press(detector, 1000);
+    Press(detector, 1001);
+    CHECK(Press(detector, 1002) == Class::Burst);
+
+    // Slower than a run but within quiet_ms: still the same burst
+    CHECK(Press(detector, 1050) == Class::Burst);
+    CHECK(Press(detector, 1110) == Class::Burst);      // Gap == quiet_ms
+    CHECK(detector.GetBurstCount() == 1);
+
+    // quiet_ms + 1 ends it, and the event starts a new run
+    CHECK(Press(detector, 1171) == Class::Normal);
+    CHECK(!detector.InBurst());
+    CHECK(Press(detector, 1172) == Class::Normal);
+    CHECK(Press(detector, 1173) == Class::Burst);
+    CHECK(detector.GetBurstCount() == 2);
+}
+
+TEST(HeldKeyIsRepeat) {
+    BurstDetector detector;
+    CHECK(detector.OnKeyDown(KeyDown(1000)) == Class::Normal);
+    CHECK(detector.OnKeyDown(KeyDown(1500)) == Class::Repeat);
+    CHECK(detector.OnKeyDown(KeyDown(1533)) == Class::Repeat);
+    detector.OnKeyUp(VK_A);
+    CHECK(detector.OnKeyDown(KeyDown(2000)) == Class::Normal);
+}
+
+TEST(ModifiersNeverBurst) {
+    BurstDetector detector;
+    // Shift+A pressed together: the modifier is not part of any run
+    CHECK(detector.OnKeyDown(KeyDown(1000, VK_SHIFT)) == Class::Normal);
+    CHECK(Press(detector, 1001) == Class::Normal);
+    CHECK(detector.OnKeyDown(KeyDown(1002, VK_SHIFT)) == Class::Normal);
+    CHECK(Press(detector, 1100) == Class::Normal);
+    CHECK(detector.GetBurstCount() == 0);
+}
+
+TEST(TickWrapAroundKeepsGaps) {
+    BurstDetector detector;
+    CHECK(Press(detector, UINT32_MAX - 3) == Class::Normal);
+    CHECK(Press(detector, UINT32_MAX) == Class::Normal);
+    CHECK(Press(detector, 2) == Class::Burst);         // 3 ms after the previous one
+
+    BurstDetector human;
+    CHECK(Press(human, UINT32_MAX - 50) == Class::Normal);
+    CHECK(Press(human, 100) == Class::Normal);
+    CHECK(Press(human, 250) == Class::Normal);
+}
+
+TEST(ThresholdsComeFromTheConfig) {
+    BurstDetector::Config config;
+    config.max_gap_ms = 20;
+    config.min_run = 5;
+    config.quiet_ms = 200;
+    BurstDetector detector(config);
+
+    for (uint32_t i = 0; i < 4; ++i) {
+        CHECK(Press(detector, 1000 + i * 20) == Class::Normal);
+    }
+    CHECK(Press(detector, 1080) == Class::Burst);
+    CHECK(Press(detector, 1280) == Class::Burst);
+    CHECK(Press(detector, 1481) == Class::Normal);
+}
+
+UNILANG_TEST_MAIN()
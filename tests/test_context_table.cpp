@@ -0,0 +1,97 @@
+#include "test_framework.h"
+#include "context_table.h"
+#include <string>
+
+using namespace UniLang;
+
+namespace {
+
+void Type(PatternMatcher& matcher, const std::string& text) {
+    for (char ch : text) {
+        matcher.AddChar(ch);
+    }
+}
+
+} // namespace
+
+TEST(StartsWithTheAnonymousContext) {
+    ContextTable table;
+    CHECK(table.GetSize() == 1);
+    CHECK(table.GetCurrentId() == 0);
+    CHECK(&table.Activate(0) == &table.Current());
+    CHECK(table.GetSize() == 1);
+}
+
+TEST(EachContextKeepsItsOwnBuffer) {
+    ContextTable table;
+    Type(table.Activate(100), "\\alp");
+    Type(table.Activate(200), "\\be");
+    CHECK(table.GetSize() == 3);
+
+    // Switching back finds the half-typed shortcut where it was left
+    CHECK(table.Activate(100).GetBuffer() == "\\alp");
+    CHECK(table.GetCurrentId() == 100);
+    Type(table.Current(), "ha");
+    CHECK(table.Current().GetBuffer() == "\\alpha");
+    CHECK(table.Activate(200).GetBuffer() == "\\be");
+    CHECK(table.Activate(0).GetBuffer().empty());
+
+    // Activating the current context again is the same state
+    PatternMatcher& current = table.Activate(200);
+    CHECK(&table.Activate(200) == &current);
+    CHECK(table.GetSize() == 3);
+}
+
+TEST(FullTableRecyclesTheLeastRecentlyUsed) {
+    ContextTable table;
+    for (ContextTable::ContextId id = 1; id < ContextTable::MAX_CONTEXTS; ++id) {
+        Type(table.Activate(id), "\\" + std::to_string(id));
+    }
+    CHECK(table.GetSize() == ContextTable::MAX_CONTEXTS);
+
+    // Touch 0 and 1, so 2 is now the least recently used
+    table.Activate(0);
+    table.Activate(1);
+    Type(table.Activate(1000), "\\new");
+    CHECK(table.GetSize() == ContextTable::MAX_CONTEXTS);
+    CHECK(table.Activate(2).GetBuffer().empty());   // Recycled, then recreated blank
+
+    // Recreating 2 evicted 3; the touched ones survived
+    CHECK(table.Activate(1).GetBuffer() == "\\1");
+    CHECK(table.Activate(1000).GetBuffer() == "\\new");
+    CHECK(table.Activate(3).GetBuffer().empty());
+    CHECK(table.Activate(ContextTable::MAX_CONTEXTS - 1).GetBuffer() == "\\15");
+}
+
+TEST(EvictionFollowsUseOrderOverManyRounds) {
+    ContextTable table;
+    const ContextTable::ContextId LIVE = ContextTable::MAX_CONTEXTS;
+
+    // A context used between every new one is never the least recently used
+    Type(table.Activate(LIVE), "\\keep");
+    for (ContextTable::ContextId id = 1000; id < 1100; ++id) {
+        Type(table.Activate(id), "\\" + std::to_string(id));
+        CHECK(table.Activate(LIVE).GetBuffer() == "\\keep");
+    }
+    CHECK(table.GetSize() == ContextTable::MAX_CONTEXTS);
+
+    // The last MAX_CONTEXTS - 1 new ones are still there, older ones are gone
+    for (ContextTable::ContextId id = 1100 - (ContextTable::MAX_CONTEXTS - 1); id < 1100; ++id) {
+        CHECK(table.Activate(id).GetBuffer() == "\\" + std::to_string(id));
+    }
+    CHECK(table.Activate(1000).GetBuffer().empty());
+    CHECK(table.Activate(1084).GetBuffer().empty());
+}
+
+TEST(ClearDropsEveryContext) {
+    ContextTable table;
+    Type(table.Activate(7), "\\al");
+    Type(table.Activate(8), "\\be");
+    table.Clear();
+    CHECK(table.GetSize() == 1);
+    CHECK(table.GetCurrentId() == 0);
+    CHECK(table.Activate(7).GetBuffer().empty());
+    CHECK(table.GetSize() == 2);
+}
+
+UNILANG_TEST_MAIN()
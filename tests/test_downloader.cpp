@@ -0,0 +1,336 @@
+#include "test_framework.h"
+#include "test_server.h"
+#include "binary_delta.h"
+#include "downloader.h"
+#include "sha256.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace UniLang;
+using Test::TestServer;
+
+namespace {
+
+std::string MakeContent(size_t size, char seed) {
+    std::string content(size, '\0');
+    for (size_t i = 0; i < size; ++i) {
+        content[i] = static_cast<char>(seed + i * 7 % 251);
+    }
+    return content;
+}
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+
+bool FileExists(const std::string& path) {
+    return std::ifstream(path).good();
+}
+
+void RemoveFiles(const std::string& path) {
+    std::remove(path.c_str());
+    std::remove((path + ".download").c_str());
+    std::remove((path + ".download.meta").c_str());
+}
+
+Downloader::File FileAt(const std::string& url, const std::string& path, const std::string& sha256 = "") {
+    Downloader::File file;
+    file.url = url;
+    file.path = path;
+    file.sha256 = sha256;
+    return file;
+}
+
+/**
+ * @brief Serve a file with an ETag and byte ranges; a full response stops after cut_at bytes if set
+ */
+TestServer::Reply ServeFile(const std::string& content, const TestServer::Request& request, size_t cut_at = 0) {
+    const std::string range = request.GetHeader("range");
+    const std::string if_range = request.GetHeader("if-range");
+    if (range.compare(0, 6, "bytes=") == 0 && (if_range.empty() || if_range == "\"f1\"")) {
+        const size_t start = std::stoul(range.substr(6));
+        if (start >= content.size()) {
+            return TestServer::Reply{TestServer::Response(416, "")};
+        }
+        return TestServer::Reply{TestServer::Response(206, content.substr(start),
+            "ETag: \"f1\"\r\nContent-Range: bytes " + std::to_string(start) + "-" +
+            std::to_string(content.size() - 1) + "/" + std::to_string(content.size()) + "\r\n")};
+    }
+    std::string data = TestServer::Response(200, content, "ETag: \"f1\"\r\n");
+    if (cut_at > 0) {
+        data.resize(data.size() - content.size() + cut_at);
+    }
+    return TestServer::Reply{data};
+}
+
+Downloader::Options FastRetries() {
+    Downloader::Options options;
+    options.timeout_ms = 5000;
+    options.retry_delay_ms = 1;
+    return options;
+}
+
+} // namespace
+
+TEST(DigestMatchesIgnoresCaseAndPrefix) {
+    CHECK(Downloader::DigestMatches("abcd", "ABCD"));
+    CHECK(Downloader::DigestMatches("abcd", "sha256:abcd"));
+    CHECK(!Downloader::DigestMatches("abcd", "abce"));
+    CHECK(!Downloader::DigestMatches("abcd", "abc"));
+}
+
+TEST(DroppedConnectionResumesWithARange) {
+    const std::string content = MakeContent(300 * 1000, 'a');
+    std::atomic<int> responses{0};
+    TestServer server;
+    REQUIRE(server.Start([&](const TestServer::Request& request) {
+        return ServeFile(content, request, responses++ == 0 ? 120 * 1000 : 0);
+    }));
+    const std::string path = "resume.test.bin";
+    RemoveFiles(path);
+
+    Downloader downloader(FastRetries());
+    REQUIRE(downloader.Download({FileAt(server.Url("/file"), path, Sha256::Hash(content))}));
+    const Downloader::Outcome& outcome = downloader.GetOutcomes()[0];
+    CHECK(outcome.ok);
+    CHECK(outcome.attempts == 2);
+    CHECK(outcome.resumed_bytes == 120 * 1000);
+    CHECK(outcome.size == content.size());
+    CHECK(ReadFile(path) == content);
+    CHECK(!FileExists(path + ".download"));
+
+    const auto requests = server.GetRequests();
+    REQUIRE(requests.size() == 2);
+    CHECK(requests[1].GetHeader("range") == "bytes=120000-");
+    CHECK(requests[1].GetHeader("if-range") == "\"f1\"");
+    RemoveFiles(path);
+}
+
+TEST(PartialFileFromAnEarlierRunIsResumed) {
+    const std::string content = MakeContent(50 * 1000, 'b');
+    std::atomic<int> responses{0};
+    TestServer server;
+    REQUIRE(server.Start([&](const TestServer::Request& request) {
+        return ServeFile(content, request, responses++ == 0 ? 20 * 1000 : 0);
+    }));
+    const std::string path = "partial.test.bin";
+    RemoveFiles(path);
+    const Downloader::File file = FileAt(server.Url("/file"), path, Sha256::Hash(content));
+
+    // The first run gives up after the connection drops
+    Downloader::Options options = FastRetries();
+    options.max_attempts = 1;
+    CHECK(!Downloader(options).Download({file}));
+    REQUIRE(FileExists(path + ".download"));
+    CHECK(FileExists(path + ".download.meta"));
+
+    // The next one asks for the rest, pinned to the ETag it was started with
+    Downloader downloader(FastRetries());
+    REQUIRE(downloader.Download({file}));
+    CHECK(downloader.GetOutcomes()[0].resumed_bytes == 20 * 1000);
+    CHECK(downloader.GetOutcomes()[0].attempts == 1);
+    CHECK(ReadFile(path) == content);
+    CHECK(!FileExists(path + ".download.meta"));
+    const auto requests = server.GetRequests();
+    REQUIRE(requests.size() == 2);
+    CHECK(requests[1].GetHeader("range") == "bytes=20000-");
+    CHECK(requests[1].GetHeader("if-range") == "\"f1\"");
+    RemoveFiles(path);
+}
+
+TEST(StalePartialFilesAreNotResumed) {
+    const std::string old_release = MakeContent(50 * 1000, 'o');
+    const std::string new_release = MakeContent(50 * 1000, 'n');
+    std::atomic<int> responses{0};
+    TestServer server;
+    REQUIRE(server.Start([&](const TestServer::Request& request) {
+        if (request.target == "/v1/file") {
+            return ServeFile(old_release, request, responses++ == 0 ? 20 * 1000 : 0);
+        }
+        return ServeFile(new_release, request);
+    }));
+    const std::string path = "stale.test.bin";
+    RemoveFiles(path);
+
+    // A cancelled download of the previous release under the same staged name
+    Downloader::Options options = FastRetries();
+    options.max_attempts = 1;
+    CHECK(!Downloader(options).Download({FileAt(server.Url("/v1/file"), path, Sha256::Hash(old_release))}));
+    REQUIRE(FileExists(path + ".download"));
+
+    Downloader downloader(FastRetries());
+    REQUIRE(downloader.Download({FileAt(server.Url("/v2/file"), path, Sha256::Hash(new_release))}));
+    CHECK(downloader.GetOutcomes()[0].resumed_bytes == 0);
+    CHECK(ReadFile(path) == new_release);
+    auto requests = server.GetRequests();
+    REQUIRE(requests.size() == 2);
+    CHECK(requests[1].GetHeader("range").empty());
+    RemoveFiles(path);
+
+    // Nor is a partial file with nothing saying where it came from
+    std::ofstream(path + ".download", std::ios::binary) << new_release.substr(0, 20 * 1000);
+    Downloader bare(FastRetries());
+    REQUIRE(bare.Download({FileAt(server.Url("/v2/file"), path, Sha256::Hash(new_release))}));
+    CHECK(bare.GetOutcomes()[0].resumed_bytes == 0);
+    CHECK(ReadFile(path) == new_release);
+    requests = server.GetRequests();
+    REQUIRE(requests.size() == 3);
+    CHECK(requests[2].GetHeader("range").empty());
+    RemoveFiles(path);
+}
+
+TEST(DigestMismatchStartsOverAndFails) {
+    const std::string content = MakeContent(10 * 1000, 'c');
+    TestServer server;
+    REQUIRE(server.Start([&](const TestServer::Request& request) { return ServeFile(content, request); }));
+    const std::string path = "mismatch.test.bin";
+    RemoveFiles(path);
+
+    Downloader::Options options = FastRetries();
+    options.max_attempts = 2;
+    Downloader downloader(options);
+    CHECK(!downloader.Download({FileAt(server.Url("/file"), path, Sha256::Hash("something else"))}));
+    CHECK(downloader.GetLastError().find("SHA-256 mismatch") != std::string::npos);
+    CHECK(downloader.GetOutcomes()[0].attempts == 2);
+    CHECK(!FileExists(path));
+    CHECK(!FileExists(path + ".download"));
+
+    // Each attempt fetched the whole file again
+    const auto requests = server.GetRequests();
+    REQUIRE(requests.size() == 2);
+    CHECK(requests[1].GetHeader("range").empty());
+    RemoveFiles(path);
+}
+
+TEST(ClientErrorsAreNotRetriedAndOptionalFilesDontFail) {
+    const std::string content = MakeContent(1000, 'd');
+    TestServer server;
+    REQUIRE(server.Start([&](const TestServer::Request& request) {
+        return request.target == "/missing" ? TestServer::Reply{TestServer::Response(404, "")}
+                                            : ServeFile(content, request);
+    }));
+    const std::string path = "required.test.bin";
+    const std::string optional_path = "optional.test.bin";
+    RemoveFiles(path);
+    RemoveFiles(optional_path);
+
+    Downloader::File optional = FileAt(server.Url("/missing"), optional_path);
+    optional.required = false;
+    Downloader downloader(FastRetries());
+    REQUIRE(downloader.Download({FileAt(server.Url("/file"), path), optional}));
+    CHECK(downloader.GetOutcomes()[0].ok);
+    CHECK(!downloader.GetOutcomes()[1].ok);
+    CHECK(downloader.GetOutcomes()[1].attempts == 1);
+    CHECK(downloader.GetOutcomes()[1].error.find("HTTP 404") != std::string::npos);
+    RemoveFiles(path);
+    RemoveFiles(optional_path);
+}
+
+TEST(ProgressNeverGoesBackwards) {
+    const std::string large = MakeContent(400 * 1000, 'e');
+    const std::string small = MakeContent(40 * 1000, 'f');
+    std::atomic<int> responses{0};
+    TestServer server;
+    REQUIRE(server.Start([&](const TestServer::Request& request) {
+        if (request.target == "/small") {
+            return ServeFile(small, request);
+        }
+        return ServeFile(large, request, responses++ == 0 ? 100 * 1000 : 0);
+    }));
+    const std::string large_path = "large.test.bin";
+    const std::string small_path = "small.test.bin";
+    RemoveFiles(large_path);
+    RemoveFiles(small_path);
+
+    std::mutex mutex;
+    std::vector<int> percentages;
+    Downloader::Options options = FastRetries();
+    options.progress = [&](int percentage, const std::string&) {
+        std::lock_guard<std::mutex> lock(mutex);
+        percentages.push_back(percentage);
+    };
+    Downloader::File large_file = FileAt(server.Url("/large"), large_path);
+    large_file.size = large.size();
+    Downloader downloader(options);
+    REQUIRE(downloader.Download({large_file, FileAt(server.Url("/small"), small_path)}));
+
+    REQUIRE(!percentages.empty());
+    for (size_t i = 1; i < percentages.size(); ++i) {
+        CHECK(percentages[i] >= percentages[i - 1]);
+    }
+    CHECK(percentages.back() == 100);
+    RemoveFiles(large_path);
+    RemoveFiles(small_path);
+}
+
+TEST(DeltaIsAppliedInsteadOfTheFullDownload) {
+    const std::string old_data = MakeContent(200 * 1000, 'g');
+    std::string new_data = old_data;
+    new_data.insert(1000, "new section");
+    const std::string delta = BinaryDelta::Create(old_data, new_data);
+    TestServer server;
+    REQUIRE(server.Start([&](const TestServer::Request& request) {
+        return request.target == "/file.delta" ? TestServer::Reply{TestServer::Response(200, delta)}
+                                               : ServeFile(new_data, request);
+    }));
+    const std::string base_path = "base.test.bin";
+    const std::string path = "patched.test.bin";
+    RemoveFiles(path);
+    std::ofstream(base_path, std::ios::binary) << old_data;
+
+    Downloader::File file = FileAt(server.Url("/file"), path, Sha256::Hash(new_data));
+    file.delta_url = server.Url("/file.delta");
+    file.delta_base = base_path;
+    Downloader downloader(FastRetries());
+    REQUIRE(downloader.Download({file}));
+    CHECK(downloader.GetOutcomes()[0].patched);
+    CHECK(downloader.GetOutcomes()[0].delta_error.empty());
+    CHECK(ReadFile(path) == new_data);
+    CHECK(server.GetRequests().size() == 1);
+
+    // A delta for another base falls back to the full file
+    RemoveFiles(path);
+    std::ofstream(base_path, std::ios::binary) << "something else";
+    Downloader fallback(FastRetries());
+    REQUIRE(fallback.Download({file}));
+    CHECK(!fallback.GetOutcomes()[0].patched);
+    CHECK(fallback.GetOutcomes()[0].delta_error.find("different base") != std::string::npos);
+    CHECK(ReadFile(path) == new_data);
+    const auto requests = server.GetRequests();
+    REQUIRE(requests.size() == 3);
+    CHECK(requests[2].target == "/file");
+    CHECK(requests[2].GetHeader("range").empty());
+    RemoveFiles(path);
+    std::remove(base_path.c_str());
+}
+
+TEST(CancelStopsTheDownload) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request&) {
+        TestServer::Reply reply;
+        reply.data = "HTTP/1.1 200 OK\r\nContent-Length: 1000\r\n\r\npart";
+        reply.hang = true;
+        return reply;
+    }));
+    const std::string path = "cancel.test.bin";
+    RemoveFiles(path);
+
+    std::atomic<bool> cancel{false};
+    Downloader::Options options = FastRetries();
+    options.timeout_ms = 60 * 1000;
+    options.cancel = &cancel;
+    options.progress = [&cancel](int, const std::string&) { cancel = true; };
+    Downloader downloader(options);
+    CHECK(!downloader.Download({FileAt(server.Url("/file"), path)}));
+    CHECK(downloader.GetOutcomes()[0].attempts == 1);
+    CHECK(!FileExists(path));
+    RemoveFiles(path);
+}
+
+UNILANG_TEST_MAIN()
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace UniLang {
+namespace Test {
+
+/**
+ * @brief Minimal test harness for the core's unit tests
+ *
+ * Each test file defines cases with TEST(name), checks with CHECK and
+ * REQUIRE (which also ends the case), and runs them all with
+ * UNILANG_TEST_MAIN(). The executable's exit code is the ctest result.
+ */
+struct Case {
+    const char* name;
+    void (*function)();
+};
+
+inline std::vector<Case>& GetCases() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+inline int& GetFailureCount() {
+    static int failures = 0;
+    return failures;
+}
+
+struct Registrar {
+    Registrar(const char* name, void (*function)()) {
+        GetCases().push_back({name, function});
+    }
+};
+
+inline void Fail(const char* file, int line, const char* expression) {
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+    ++GetFailureCount();
+}
+
+inline int RunAll() {
+    int failed_cases = 0;
+    for (const Case& test : GetCases()) {
+        const int failures = GetFailureCount();
+        test.function();
+        const bool passed = GetFailureCount() == failures;
+        std::printf("[%s] %s\n", passed ? "PASS" : "FAIL", test.name);
+        failed_cases += passed ? 0 : 1;
+    }
+    std::printf("%zu cases, %d failed\n", GetCases().size(), failed_cases);
+    return failed_cases == 0 ? 0 : 1;
+}
+
+} // namespace Test
+} // namespace UniLang
+
+#define TEST(name)                                                                  \
+    static void name();                                                             \
+    static const ::UniLang::Test::Registrar name##_registrar(#name, name);          \
+    static void name()
+
+#define CHECK(condition)                                                            \
+    do {                                                                            \
+        if (!(condition)) {                                                         \
+            ::UniLang::Test::Fail(__FILE__, __LINE__, #condition);                  \
+        }                                                                           \
+    } while (0)
+
+#define REQUIRE(condition)                                                          \
+    do {                                                                            \
+        if (!(condition)) {                                                         \
+            ::UniLang::Test::Fail(__FILE__, __LINE__, #condition);                  \
+            return;                                                                 \
+        }                                                                           \
+    } while (0)
+
+#define UNILANG_TEST_MAIN()                                                         \
+    int main() {                                                                    \
+        return ::UniLang::Test::RunAll();                                           \
+    }
@@ -0,0 +1,244 @@
+#include "test_framework.h"
+#include "test_server.h"
+#include "http_client.h"
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace UniLang;
+using Test::TestServer;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+long long ElapsedMs(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
+
+TestServer::Reply Hang(const TestServer::Request&) {
+    TestServer::Reply reply;
+    reply.hang = true;
+    return reply;
+}
+
+} // namespace
+
+TEST(ParseUrlSplitsTheParts) {
+    HttpClient::Url url;
+    REQUIRE(HttpClient::ParseUrl("http://127.0.0.1:8080/repos/x?y=1", url));
+    CHECK(!url.https);
+    CHECK(url.host == "127.0.0.1");
+    CHECK(url.port == 8080);
+    CHECK(url.target == "/repos/x?y=1");
+
+    REQUIRE(HttpClient::ParseUrl("https://[::1]?q", url));
+    CHECK(url.https);
+    CHECK(url.host == "::1");
+    CHECK(url.port == 443);
+    CHECK(url.target == "/?q");
+
+    CHECK(!HttpClient::ParseUrl("ftp://host/", url));
+    CHECK(!HttpClient::ParseUrl("http://host:0/", url));
+    CHECK(!HttpClient::ParseUrl("http://:80/", url));
+}
+
+TEST(GetReadsStatusHeadersAndBody) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request& request) {
+        const int status = request.target == "/missing" ? 404 : 200;
+        return TestServer::Reply{TestServer::Response(status, "hello", "ETag: \"v1\"\r\n")};
+    }));
+    auto http = HttpClient::Create();
+
+    HttpClient::Request request;
+    request.url = server.Url("/release");
+    request.headers.emplace_back("If-None-Match", "\"v0\"");
+    HttpClient::Response response;
+    REQUIRE(http->Get(request, response));
+    CHECK(response.status == 200);
+    CHECK(response.body == "hello");
+    CHECK(response.GetHeader("ETAG") == "\"v1\"");
+
+    const auto requests = server.GetRequests();
+    REQUIRE(requests.size() == 1);
+    CHECK(requests[0].target == "/release");
+    CHECK(requests[0].GetHeader("if-none-match") == "\"v0\"");
+    CHECK(requests[0].GetHeader("user-agent") == HttpClient::USER_AGENT);
+
+    // Any status is an exchange; the caller decides what it means
+    request.url = server.Url("/missing");
+    REQUIRE(http->Get(request, response));
+    CHECK(response.status == 404);
+}
+
+TEST(ChunkedAndUnframedBodies) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request& request) {
+        if (request.target == "/chunked") {
+            return TestServer::Reply{"HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                     "5\r\nhello\r\n6; ext\r\n world\r\n0\r\nX-Trailer: 1\r\n\r\n"};
+        }
+        return TestServer::Reply{"HTTP/1.1 200 OK\r\n\r\nuntil close"};
+    }));
+    auto http = HttpClient::Create();
+    HttpClient::Request request;
+    HttpClient::Response response;
+
+    request.url = server.Url("/chunked");
+    REQUIRE(http->Get(request, response));
+    CHECK(response.body == "hello world");
+
+    request.url = server.Url("/unframed");
+    REQUIRE(http->Get(request, response));
+    CHECK(response.body == "until close");
+}
+
+TEST(RedirectsAreFollowedAndOnlyTheFinalBodyIsStreamed) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request& request) {
+        if (request.target == "/old") {
+            return TestServer::Reply{TestServer::Response(302, "moved", "Location: /assets/new\r\n")};
+        }
+        if (request.target == "/assets/new") {
+            return TestServer::Reply{TestServer::Response(307, "", "Location: final\r\n")};
+        }
+        return TestServer::Reply{TestServer::Response(200, "payload")};
+    }));
+    auto http = HttpClient::Create();
+
+    std::string streamed;
+    HttpClient::Request request;
+    request.url = server.Url("/old");
+    request.on_body = [&streamed](const HttpClient::Response& head, std::string_view data) {
+        CHECK(head.status == 200);
+        streamed.append(data);
+        return true;
+    };
+    HttpClient::Response response;
+    REQUIRE(http->Get(request, response));
+    CHECK(response.status == 200);
+    CHECK(response.body.empty());
+    CHECK(streamed == "payload");
+
+    const auto requests = server.GetRequests();
+    REQUIRE(requests.size() == 3);
+    CHECK(requests[2].target == "/assets/final");
+}
+
+TEST(TooManyRedirectsFail) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request&) {
+        return TestServer::Reply{TestServer::Response(301, "", "Location: /loop\r\n")};
+    }));
+    auto http = HttpClient::Create();
+    HttpClient::Request request;
+    request.url = server.Url("/loop");
+    HttpClient::Response response;
+    CHECK(!http->Get(request, response));
+    CHECK(server.GetRequests().size() == HttpClient::MAX_REDIRECTS + 1);
+}
+
+TEST(ShortBodyFailsAfterDeliveringWhatArrived) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request&) {
+        return TestServer::Reply{"HTTP/1.1 200 OK\r\nContent-Length: 10\r\n\r\n0123"};
+    }));
+    auto http = HttpClient::Create();
+
+    std::string streamed;
+    HttpClient::Request request;
+    request.url = server.Url("/file");
+    request.on_body = [&streamed](const HttpClient::Response&, std::string_view data) {
+        streamed.append(data);
+        return true;
+    };
+    HttpClient::Response response;
+    CHECK(!http->Get(request, response));
+    CHECK(streamed == "0123");
+    CHECK(!http->GetLastError().empty());
+}
+
+TEST(SinkCanAbortTheRequest) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request&) {
+        return TestServer::Reply{TestServer::Response(200, "0123456789")};
+    }));
+    auto http = HttpClient::Create();
+    HttpClient::Request request;
+    request.url = server.Url("/file");
+    request.on_body = [](const HttpClient::Response&, std::string_view) { return false; };
+    HttpClient::Response response;
+    CHECK(!http->Get(request, response));
+}
+
+TEST(SilentServerTimesOut) {
+    TestServer server;
+    REQUIRE(server.Start(Hang));
+    auto http = HttpClient::Create();
+    HttpClient::Request request;
+    request.url = server.Url("/slow");
+    request.timeout_ms = 200;
+    HttpClient::Response response;
+
+    const Clock::time_point start = Clock::now();
+    CHECK(!http->Get(request, response));
+    CHECK(http->GetLastError().find("timed out") != std::string::npos);
+    CHECK(ElapsedMs(start) < 200 + 10 * HttpClient::CANCEL_POLL_MS);
+}
+
+TEST(DeadlinesEndingBetweenChecksStillTimeOut) {
+    TestServer server;
+    REQUIRE(server.Start(Hang));
+    auto http = HttpClient::Create();
+    HttpClient::Response response;
+
+    // Deadlines that run out somewhere in connect, send or the first read
+    for (uint32_t timeout_ms = 1; timeout_ms <= 20; ++timeout_ms) {
+        HttpClient::Request request;
+        request.url = server.Url("/slow");
+        request.timeout_ms = timeout_ms;
+        const Clock::time_point start = Clock::now();
+        CHECK(!http->Get(request, response));
+        CHECK(ElapsedMs(start) < timeout_ms + 10 * HttpClient::CANCEL_POLL_MS);
+    }
+}
+
+TEST(NameResolutionIsBoundedByTheDeadline) {
+    // Fails fast where there is a resolver, times out where lookups hang
+    auto http = HttpClient::Create();
+    HttpClient::Request request;
+    request.url = "http://unilang-test.invalid/file";
+    request.timeout_ms = 300;
+    HttpClient::Response response;
+
+    const Clock::time_point start = Clock::now();
+    CHECK(!http->Get(request, response));
+    CHECK(ElapsedMs(start) < 300 + 10 * HttpClient::CANCEL_POLL_MS);
+}
+
+TEST(CancelAbortsABlockedRead) {
+    TestServer server;
+    REQUIRE(server.Start(Hang));
+    auto http = HttpClient::Create();
+    std::atomic<bool> cancel{false};
+    HttpClient::Request request;
+    request.url = server.Url("/slow");
+    request.timeout_ms = 60 * 1000;
+    request.cancel = &cancel;
+    HttpClient::Response response;
+
+    std::thread canceller([&cancel] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        cancel = true;
+    });
+    const Clock::time_point start = Clock::now();
+    CHECK(!http->Get(request, response));
+    const long long elapsed = ElapsedMs(start);
+    canceller.join();
+    CHECK(http->GetLastError().find("cancelled") != std::string::npos);
+    CHECK(elapsed < 100 + 10 * HttpClient::CANCEL_POLL_MS);
+}
+
+UNILANG_TEST_MAIN()
@@ -0,0 +1,189 @@
+#include "test_framework.h"
+#include "input_engine.h"
+#include "shortcuts_dict.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace UniLang;
+
+namespace {
+
+/**
+ * @brief Output handler that holds the worker inside the first Replace until released
+ */
+class StalledOutput {
+public:
+    void operator()(const EngineAction& action) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (action.type == EngineAction::Type::Replace) {
+            ++m_replacements;
+            if (m_replacements == 1) {
+                m_stalled = true;
+                m_changed.notify_all();
+                m_changed.wait(lock, [this] { return m_released; });
+            }
+        }
+    }
+
+    void WaitUntilStalled() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_changed.wait(lock, [this] { return m_stalled; });
+    }
+
+    void Release() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_released = true;
+        m_changed.notify_all();
+    }
+
+    int GetReplacementCount() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_replacements;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    bool m_stalled = false;
+    bool m_released = false;
+    int m_replacements = 0;
+};
+
+/**
+ * @brief Output handler that keeps the replacement of every Replace action
+ */
+class RecordedOutput {
+public:
+    void operator()(const EngineAction& action) {
+        if (action.type == EngineAction::Type::Replace) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_replacements.push_back(action.entry->replacement);
+        }
+    }
+
+    std::vector<std::string> GetReplacements() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_replacements;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::vector<std::string> m_replacements;
+};
+
+// Key-down and key-up of a typed character; returns whether the key-down was blocked
+bool Type(InputEngine& engine, char ch, uint32_t& time_ms) {
+    KeyEvent event;
+    event.vk = ch >= 'a' && ch <= 'z' ? static_cast<uint32_t>(ch - 'a' + 'A') : static_cast<uint32_t>(ch);
+    event.ch = static_cast<char16_t>(ch);
+    event.is_key_down = true;
+    event.time_ms = time_ms += 150;     // Human pace, so no burst detection
+    const bool blocked = engine.OnKeyEvent(event);
+    event.is_key_down = false;
+    engine.OnKeyEvent(event);
+    return blocked;
+}
+
+// Types a whole string
+void TypeText(InputEngine& engine, const std::string& text, uint32_t& time_ms) {
+    for (char ch : text) {
+        Type(engine, ch, time_ms);
+    }
+}
+
+} // namespace
+
+TEST(ReplacementAndReplayedKeyAreQueuedTogether) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(R"({"shortcuts": {}, "autocorrect": {"teh": "the"}})"));
+    InputEngine engine;
+    engine.SetDictionary(&dict);
+    StalledOutput output;
+    REQUIRE(engine.Start([&output](const EngineAction& action) { output(action); }));
+    uint32_t time_ms = 0;
+
+    // The first correction holds the worker; its replayed space stays queued
+    for (char ch : std::string("teh")) {
+        Type(engine, ch, time_ms);
+    }
+    CHECK(Type(engine, ' ', time_ms));
+    output.WaitUntilStalled();
+
+    // Fill the ring up to one free slot with held-back keys
+    const size_t held = InputEngine::QUEUE_CAPACITY - 1 - 1 - 4;
+    for (size_t i = 0; i < held; ++i) {
+        Type(engine, 'x', time_ms);
+    }
+    for (char ch : std::string(" teh")) {
+        Type(engine, ch, time_ms);
+    }
+
+    // No room for correction plus replay: neither is queued, the space goes through
+    CHECK(!Type(engine, ' ', time_ms));
+    CHECK(engine.GetStats().dropped == 1);
+
+    output.Release();
+    for (int i = 0; i < 200 && engine.GetStats().replays < InputEngine::QUEUE_CAPACITY - 1; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    engine.Stop();
+    CHECK(output.GetReplacementCount() == 1);
+    CHECK(engine.GetStats().replays == InputEngine::QUEUE_CAPACITY - 1);
+}
+
+TEST(CategoryMaskDecidesWhichReplacementsFire) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(R"({"shortcuts": {"greek": {"\\al": "α"}, "arrows": {"\\to": "→"}},
+                                    "autocorrect": {"teh": "the"}})"));
+    InputEngine engine;
+    engine.SetDictionary(&dict);
+    RecordedOutput output;
+    REQUIRE(engine.Start([&output](const EngineAction& action) { output(action); }));
+    uint32_t time_ms = 0;
+
+    TypeText(engine, " teh \\al \\to ", time_ms);
+
+    // Takes effect from the next key event, nothing is reloaded
+    engine.SetCategoryMask(dict.GetCategoryMask({"greek", "autocorrect"}));
+    TypeText(engine, " teh \\al \\to ", time_ms);
+
+    engine.SetCategoryMask(dict.GetCategoryMask({"arrows"}));
+    TypeText(engine, " teh \\al \\to ", time_ms);
+
+    engine.SetCategoryMask(ShortcutsDict::ALL_CATEGORIES);
+    TypeText(engine, "\\to ", time_ms);
+    engine.Stop();
+
+    const std::vector<std::string> expected = {"the", "α", "→", "→", "the", "α", "→"};
+    CHECK(output.GetReplacements() == expected);
+}
+
+TEST(NonDefaultTriggerKeyWorksEndToEnd) {
+    // What WinMain does with "trigger_key": "!" in the settings section
+    ShortcutsDict builtin;
+    REQUIRE(builtin.LoadFromFile(UNILANG_TEST_SHORTCUTS));
+    REQUIRE(builtin.SetTriggerKey("!"));
+
+    // A dictionary update builds a new dictionary; it keeps the trigger key
+    ShortcutsDict updated;
+    REQUIRE(updated.LoadFromDiff(builtin, ShortcutsDict::ComputeDiff(builtin, builtin)));
+
+    for (const ShortcutsDict* dict : {&builtin, &updated}) {
+        InputEngine engine;
+        engine.SetDictionary(dict);
+        RecordedOutput output;
+        REQUIRE(engine.Start([&output](const EngineAction& action) { output(action); }));
+        uint32_t time_ms = 0;
+        TypeText(engine, "!al \\al :smile: !rarrow ", time_ms);
+        engine.Stop();
+
+        const std::vector<std::string> expected = {"α", "😄", "→"};
+        CHECK(output.GetReplacements() == expected);
+    }
+}
+
+UNILANG_TEST_MAIN()
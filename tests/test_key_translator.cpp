@@ -0,0 +1,151 @@
+#include "test_framework.h"
+#include "key_translator.h"
+#include <memory>
+#include <thread>
+
+using namespace UniLang;
+
+namespace {
+
+// Virtual-key codes the tests press
+const uint32_t VK_A = 0x41;
+const uint32_t VK_1 = 0x31;
+const uint32_t VK_SHIFT = 0x10;
+const uint32_t VK_RSHIFT = 0xA1;
+const uint32_t VK_CAPITAL = 0x14;
+const uint32_t VK_RMENU = 0xA5;
+
+// A US-like layout: letters follow Shift xor Caps Lock, digits follow Shift only,
+// Ctrl produces nothing and AltGr (Ctrl+Alt) adds one symbol
+char16_t UsLayout(uint8_t vk, uint8_t mods) {
+    const bool shift = (mods & KeyTranslator::MOD_SHIFT) != 0;
+    const bool caps = (mods & KeyTranslator::MOD_CAPS) != 0;
+    const bool ctrl = (mods & KeyTranslator::MOD_CTRL) != 0;
+    const bool alt = (mods & KeyTranslator::MOD_ALT) != 0;
+    if (ctrl && alt) {
+        return vk == 'E' ? u'€' : 0;
+    }
+    if (ctrl || alt) {
+        return 0;
+    }
+    if (vk >= 'A' && vk <= 'Z') {
+        return static_cast<char16_t>(shift != caps ? vk : vk - 'A' + 'a');
+    }
+    if (vk == '1') {
+        return shift ? u'!' : u'1';
+    }
+    return 0;
+}
+
+// Every key gives the same character, so the tests can tell layouts apart
+KeyTranslator::TranslateFn Constant(char16_t ch) {
+    return [ch](uint8_t, uint8_t) { return ch; };
+}
+
+} // namespace
+
+TEST(NothingTranslatesWithoutALayout) {
+    KeyTranslator translator;
+    CHECK(translator.Translate(VK_A) == 0);
+    CHECK(!translator.SetActiveLayout(1));
+    CHECK(!translator.HasLayout(1));
+
+    translator.BuildLayout(1, UsLayout);
+    CHECK(translator.Translate(VK_A) == u'a');
+    CHECK(translator.Translate(0x100) == 0);
+}
+
+TEST(ModifiersSelectTheColumn) {
+    KeyTranslator translator;
+    translator.BuildLayout(1, UsLayout);
+
+    translator.OnKeyEvent(VK_SHIFT, true);
+    CHECK(translator.GetModifiers() == KeyTranslator::MOD_SHIFT);
+    CHECK(translator.Translate(VK_A) == u'A');
+    CHECK(translator.Translate(VK_1) == u'!');
+
+    // Either Shift key keeps Shift active until both are up
+    translator.OnKeyEvent(VK_RSHIFT, true);
+    translator.OnKeyEvent(VK_SHIFT, false);
+    CHECK(translator.Translate(VK_A) == u'A');
+    translator.OnKeyEvent(VK_RSHIFT, false);
+    CHECK(translator.Translate(VK_A) == u'a');
+
+    // Right Alt with Ctrl is AltGr
+    translator.SetModifierState(false, true, false, false);
+    translator.OnKeyEvent(VK_RMENU, true);
+    CHECK(translator.Translate('E') == u'€');
+    translator.OnKeyEvent(VK_RMENU, false);
+    CHECK(translator.Translate('E') == 0);
+    translator.SetModifierState(false, false, false, false);
+    CHECK(translator.GetModifiers() == 0);
+}
+
+TEST(CapsLockTogglesOncePerPress) {
+    KeyTranslator translator;
+    translator.BuildLayout(1, UsLayout);
+
+    // Holding the key autorepeats key-downs
+    translator.OnKeyEvent(VK_CAPITAL, true);
+    translator.OnKeyEvent(VK_CAPITAL, true);
+    translator.OnKeyEvent(VK_CAPITAL, true);
+    translator.OnKeyEvent(VK_CAPITAL, false);
+    CHECK(translator.GetModifiers() == KeyTranslator::MOD_CAPS);
+    CHECK(translator.Translate(VK_A) == u'A');
+    CHECK(translator.Translate(VK_1) == u'1');
+
+    translator.OnKeyEvent(VK_SHIFT, true);
+    CHECK(translator.Translate(VK_A) == u'a');
+    translator.OnKeyEvent(VK_SHIFT, false);
+
+    translator.OnKeyEvent(VK_CAPITAL, true);
+    translator.OnKeyEvent(VK_CAPITAL, false);
+    CHECK(translator.Translate(VK_A) == u'a');
+}
+
+TEST(LayoutsBuiltElsewhereAreAddedWithoutSwitching) {
+    KeyTranslator translator;
+    translator.BuildLayout(1, Constant(u'1'));
+
+    // Requested once until it arrives
+    CHECK(translator.RequestLayout(2));
+    CHECK(!translator.RequestLayout(2));
+    CHECK(!translator.RequestLayout(1));
+    CHECK(!translator.SetActiveLayout(2));
+
+    std::unique_ptr<KeyTranslator::LayoutTable> table;
+    std::thread worker([&table] { table = KeyTranslator::CreateLayout(2, Constant(u'2')); });
+    worker.join();
+    REQUIRE(table != nullptr);
+    translator.AddLayout(std::move(table));
+
+    // The active layout stays until the caller switches
+    CHECK(translator.HasLayout(2));
+    CHECK(!translator.RequestLayout(2));
+    CHECK(translator.Translate(VK_A) == u'1');
+    CHECK(translator.SetActiveLayout(2));
+    CHECK(translator.Translate(VK_A) == u'2');
+    CHECK(translator.SetActiveLayout(1));
+    CHECK(translator.Translate(VK_A) == u'1');
+}
+
+TEST(RebuiltLayoutReplacesTheActiveTable) {
+    KeyTranslator translator;
+    translator.BuildLayout(1, Constant(u'a'));
+    translator.BuildLayout(2, Constant(u'b'));
+    CHECK(translator.SetActiveLayout(1));
+
+    translator.AddLayout(KeyTranslator::CreateLayout(1, Constant(u'c')));
+    CHECK(translator.Translate(VK_A) == u'c');
+    translator.AddLayout(KeyTranslator::CreateLayout(2, Constant(u'd')));
+    CHECK(translator.Translate(VK_A) == u'c');
+    CHECK(translator.SetActiveLayout(2));
+    CHECK(translator.Translate(VK_A) == u'd');
+
+    // A request is settled once its layout is added
+    CHECK(translator.RequestLayout(3));
+    translator.AddLayout(KeyTranslator::CreateLayout(3, Constant(u'e')));
+    CHECK(!translator.RequestLayout(3));
+}
+
+UNILANG_TEST_MAIN()
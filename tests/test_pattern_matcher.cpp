@@ -0,0 +1,164 @@
+#include "test_framework.h"
+#include "pattern_matcher.h"
+#include "shortcuts_dict.h"
+#include <string>
+#include <vector>
+
+using namespace UniLang;
+
+namespace {
+
+const char* DICTIONARY = R"({
+    "shortcuts": {
+        "greek": {"\\al": "α", "\\be": "β", "\\alpha": "ALPHA"}
+    },
+    "rules": [{"before": "[0-9]", "match": "deg", "replace": "°"}],
+    "autocorrect": {"teh": "the"}
+})";
+
+std::vector<PatternMatcher::FeedMatch> FeedAll(PatternMatcher& matcher, std::string_view text,
+                                              const ShortcutsDict& dict,
+                                              uint64_t categories = ShortcutsDict::ALL_CATEGORIES) {
+    std::vector<PatternMatcher::FeedMatch> matches;
+    PatternMatcher::FeedMatch out[4];
+    while (!text.empty()) {
+        const PatternMatcher::FeedResult result = matcher.Feed(text, dict, out, 4, categories);
+        matches.insert(matches.end(), out, out + result.match_count);
+        text.remove_prefix(result.consumed);
+    }
+    return matches;
+}
+
+bool SameMatches(const std::vector<PatternMatcher::FeedMatch>& a, const std::vector<PatternMatcher::FeedMatch>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].position != b[i].position || a[i].length != b[i].length || a[i].entry_id != b[i].entry_id) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(FeedReportsStreamPositions) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    PatternMatcher matcher;
+
+    const auto matches = FeedAll(matcher, "x \\al y", dict);
+    REQUIRE(matches.size() == 1);
+    CHECK(matches[0].position == 2);
+    CHECK(matches[0].length == 4);      // "\al" and the space that triggered it
+    CHECK(matches[0].entry_id == dict.FindEntryId("\\al"));
+    CHECK(matcher.GetStreamPosition() == 7);
+}
+
+TEST(FeedPrefersTheWholeTypedName) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    PatternMatcher matcher;
+
+    const auto matches = FeedAll(matcher, "\\alpha ", dict);
+    REQUIRE(matches.size() == 1);
+    CHECK(matches[0].entry_id == dict.FindEntryId("\\alpha"));
+    CHECK(matches[0].length == 7);
+}
+
+TEST(FeedRunsRulesAndWords) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    PatternMatcher matcher;
+
+    const auto matches = FeedAll(matcher, "90deg teh cat", dict);
+    REQUIRE(matches.size() == 2);
+    CHECK(matches[0].position == 2);
+    CHECK(matches[0].length == 3);
+    CHECK(matches[0].entry_id == dict.GetRuleEntryId(0));
+    CHECK(matches[1].position == 6);
+    CHECK(matches[1].length == 3);      // The boundary is not part of a word match
+    CHECK(matches[1].entry_id == PatternMatcher::WORD_ENTRY_ID);
+}
+
+TEST(FeedReportsSymbolFamilies) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    PatternMatcher matcher;
+
+    const auto matches = FeedAll(matcher, "\\mathbb{R}", dict);
+    REQUIRE(matches.size() == 1);
+    CHECK(matches[0].position == 0);
+    CHECK(matches[0].length == 10);
+    CHECK(matches[0].entry_id == PatternMatcher::FAMILY_ENTRY_ID);
+}
+
+TEST(FeedResetsAtLineBreaks) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    PatternMatcher matcher;
+
+    // A newline is Enter, not a terminator: "\al" before it stays as typed
+    const auto matches = FeedAll(matcher, "a\\al\n\\be ", dict);
+    REQUIRE(matches.size() == 1);
+    CHECK(matches[0].position == 5);
+    CHECK(matches[0].entry_id == dict.FindEntryId("\\be"));
+}
+
+TEST(FeedInChunksFindsTheSameMatches) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    const std::string text = "x \\al y \\alpha 90deg, teh \\mathbb{R} \\be\n\\be end";
+
+    PatternMatcher whole;
+    const auto expected = FeedAll(whole, text, dict);
+    CHECK(expected.size() == 6);
+
+    // Every split point, then one byte at a time
+    for (size_t split = 1; split < text.size(); ++split) {
+        PatternMatcher matcher;
+        auto matches = FeedAll(matcher, std::string_view(text).substr(0, split), dict);
+        const auto rest = FeedAll(matcher, std::string_view(text).substr(split), dict);
+        matches.insert(matches.end(), rest.begin(), rest.end());
+        CHECK(SameMatches(matches, expected));
+    }
+    PatternMatcher bytewise;
+    std::vector<PatternMatcher::FeedMatch> matches;
+    for (char ch : text) {
+        const auto step = FeedAll(bytewise, std::string_view(&ch, 1), dict);
+        matches.insert(matches.end(), step.begin(), step.end());
+    }
+    CHECK(SameMatches(matches, expected));
+}
+
+TEST(FeedStopsWhenTheOutputIsFull) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    PatternMatcher matcher;
+    const std::string_view text = "\\al \\be \\al ";
+
+    PatternMatcher::FeedMatch out[1];
+    const PatternMatcher::FeedResult first = matcher.Feed(text, dict, out, 1, ShortcutsDict::ALL_CATEGORIES);
+    CHECK(first.match_count == 1);
+    CHECK(first.consumed == 4);
+    CHECK(matcher.GetStreamPosition() == 4);
+
+    const auto rest = FeedAll(matcher, text.substr(first.consumed), dict);
+    REQUIRE(rest.size() == 2);
+    CHECK(rest[0].position == 4);
+    CHECK(rest[1].position == 8);
+}
+
+TEST(FeedSkipsDisabledCategories) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    PatternMatcher matcher;
+
+    const uint64_t categories = dict.GetCategoryMask({"greek"});
+    const auto matches = FeedAll(matcher, "\\al 90deg ", dict, categories);
+    REQUIRE(matches.size() == 1);
+    CHECK(matches[0].entry_id == dict.GetRuleEntryId(0));
+}
+
+UNILANG_TEST_MAIN()
@@ -0,0 +1,127 @@
+#include "test_framework.h"
+#include "rule_set.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace UniLang;
+
+namespace {
+
+RuleSet::Rule MakeRule(const std::string& before, const std::string& match, const std::string& after,
+                       RuleSet::Context context = RuleSet::Context::Any) {
+    RuleSet::Rule rule;
+    rule.before = before;
+    rule.match = match;
+    rule.after = after;
+    rule.replacement = "<" + match + ">";
+    rule.context = context;
+    return rule;
+}
+
+// (offset of the byte that fired, rule), continuing like the matcher does after a replacement
+std::vector<std::pair<size_t, uint32_t>> Run(const RuleSet& rules, const std::string& text) {
+    std::vector<std::pair<size_t, uint32_t>> fired;
+    uint32_t state = RuleSet::START_STATE;
+    for (size_t i = 0; i < text.size(); ++i) {
+        state = rules.Step(state, static_cast<unsigned char>(text[i]));
+        const uint32_t rule = rules.GetFiringRule(state);
+        if (rule != RuleSet::NO_RULE) {
+            fired.emplace_back(i, rule);
+            state = RuleSet::GetResumeState(state);
+        }
+    }
+    return fired;
+}
+
+using Fired = std::vector<std::pair<size_t, uint32_t>>;
+
+} // namespace
+
+TEST(RuleFiresOnlyAfterItsLeftContext) {
+    RuleSet rules;
+    REQUIRE(rules.Compile({MakeRule("[0-9]", "deg", "")}));
+    CHECK(Run(rules, "90deg") == (Fired{{4, 0}}));
+    CHECK(Run(rules, "xdeg").empty());
+    CHECK(Run(rules, "90 deg").empty());
+    CHECK(rules.GetMatchLength(0) == 3);
+    CHECK(!rules.HasTrigger(0));
+}
+
+TEST(TriggerFollowsTheMatch) {
+    RuleSet rules;
+    REQUIRE(rules.Compile({MakeRule("^|\\s", "1/2", "\\s")}));
+    CHECK(rules.HasTrigger(0));
+    CHECK(rules.GetMatchLength(0) == 3);
+    CHECK(Run(rules, "1/2 ") == (Fired{{3, 0}}));
+    CHECK(Run(rules, "a 1/2\t") == (Fired{{5, 0}}));
+    CHECK(Run(rules, "11/2 ").empty());
+    CHECK(Run(rules, "1/2x").empty());
+    CHECK(rules.GetMaxLength() >= 4);
+}
+
+TEST(LineStartAnchor) {
+    RuleSet rules;
+    REQUIRE(rules.Compile({MakeRule("^", "--", "")}));
+    CHECK(Run(rules, "--") == (Fired{{1, 0}}));
+    CHECK(Run(rules, "a--").empty());
+    CHECK(Run(rules, "a\n--") == (Fired{{3, 0}}));
+}
+
+TEST(CodeSpansSelectTextOrCodeRules) {
+    RuleSet rules;
+    REQUIRE(rules.Compile({
+        MakeRule("", "->", "", RuleSet::Context::Text),
+        MakeRule("", "=>", "", RuleSet::Context::Code),
+    }));
+    CHECK(Run(rules, "a -> b") == (Fired{{3, 0}}));
+    CHECK(Run(rules, "`a -> b`").empty());
+    CHECK(Run(rules, "`a` -> b") == (Fired{{5, 0}}));
+    CHECK(Run(rules, "`x => y`") == (Fired{{4, 1}}));
+    CHECK(Run(rules, "x => y").empty());
+
+    // A line break closes an unterminated span
+    CHECK(Run(rules, "`open\n->") == (Fired{{7, 0}}));
+}
+
+TEST(EarliestRuleWinsTies) {
+    RuleSet rules;
+    REQUIRE(rules.Compile({MakeRule("", "ab", ""), MakeRule("", "ab", ""), MakeRule("", "b", "")}));
+    CHECK(Run(rules, "ab") == (Fired{{1, 0}}));
+    CHECK(Run(rules, "b") == (Fired{{0, 2}}));
+}
+
+TEST(ClassesGroupsAndAlternation) {
+    RuleSet rules;
+    REQUIRE(rules.Compile({MakeRule("(\\d|\\))\\s*", "x[0-9]", "")}));
+    CHECK(Run(rules, "3x4") == (Fired{{2, 0}}));
+    CHECK(Run(rules, "(a)   x9") == (Fired{{7, 0}}));
+    CHECK(Run(rules, "ax4").empty());
+    CHECK(rules.GetMatchLength(0) == 2);
+}
+
+TEST(ManyRulesShareOneTable) {
+    std::vector<RuleSet::Rule> list;
+    for (int i = 0; i < 200; ++i) {
+        list.push_back(MakeRule("\\s", "k" + std::to_string(i) + ";", ""));
+    }
+    RuleSet rules;
+    REQUIRE(rules.Compile(list));
+    CHECK(rules.GetRuleCount() == 200);
+    for (uint32_t i = 0; i < 200; i += 37) {
+        const std::string text = " k" + std::to_string(i) + ";";
+        CHECK(Run(rules, text) == (Fired{{text.size() - 1, i}}));
+    }
+    CHECK(Run(rules, " k200;").empty());
+}
+
+TEST(InvalidRulesAreRejected) {
+    RuleSet rules;
+    CHECK(!rules.Compile({MakeRule("", "a*", "")}));        // Not a fixed length
+    CHECK(!rules.GetLastError().empty());
+    CHECK(!rules.Compile({MakeRule("[0-9", "x", "")}));     // Unterminated class
+    CHECK(!rules.Compile({MakeRule("", "(ab", "")}));       // Unbalanced group
+    CHECK(!rules.Compile({MakeRule("", "", "")}));          // Nothing to replace
+}
+
+UNILANG_TEST_MAIN()
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace UniLang {
+namespace Test {
+
+/**
+ * @brief Loopback HTTP server for the update path tests (POSIX only)
+ *
+ * Listens on 127.0.0.1 at an ephemeral port and answers one connection
+ * at a time on its own thread. The handler maps each request to the raw
+ * bytes sent back, so a test can truncate a body, drop the connection or
+ * never answer at all. Every request is recorded for inspection.
+ */
+class TestServer {
+public:
+    struct Request {
+        std::string target;                                     // Path and query
+        std::vector<std::pair<std::string, std::string>> headers;  // Names in lowercase
+
+        std::string GetHeader(std::string_view name) const {
+            for (const auto& header : headers) {
+                if (header.first == name) {
+                    return header.second;
+                }
+            }
+            return std::string();
+        }
+    };
+
+    struct Reply {
+        std::string data;       // Sent as is, then the connection is closed
+        bool hang = false;      // Keep the connection open (after data) until the client hangs up
+    };
+
+    using Handler = std::function<Reply(const Request& request)>;
+
+    static const int POLL_MS = 10;
+
+    ~TestServer() { Stop(); }
+
+    /**
+     * @return false if the socket could not be set up
+     */
+    bool Start(Handler handler) {
+        m_handler = std::move(handler);
+        m_listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (m_listen_fd < 0) {
+            return false;
+        }
+        const int reuse = 1;
+        setsockopt(m_listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+        socklen_t size = sizeof(address);
+        if (bind(m_listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            listen(m_listen_fd, 8) != 0 ||
+            getsockname(m_listen_fd, reinterpret_cast<sockaddr*>(&address), &size) != 0) {
+            close(m_listen_fd);
+            m_listen_fd = -1;
+            return false;
+        }
+        m_port = ntohs(address.sin_port);
+        m_thread = std::thread(&TestServer::Serve, this);
+        return true;
+    }
+
+    void Stop() {
+        m_stop = true;
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+        if (m_listen_fd >= 0) {
+            close(m_listen_fd);
+            m_listen_fd = -1;
+        }
+    }
+
+    /**
+     * @brief URL of a path on this server ("/x" -> "http://127.0.0.1:<port>/x")
+     */
+    std::string Url(const std::string& path) const {
+        return "http://127.0.0.1:" + std::to_string(m_port) + path;
+    }
+
+    std::vector<Request> GetRequests() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_requests;
+    }
+
+    /**
+     * @brief Raw HTTP/1.1 response with a Content-Length for the body
+     */
+    static std::string Response(int status, const std::string& body, const std::string& headers = "") {
+        return "HTTP/1.1 " + std::to_string(status) + " Test\r\nContent-Length: " +
+               std::to_string(body.size()) + "\r\n" + headers + "Connection: close\r\n\r\n" + body;
+    }
+
+private:
+    void Serve() {
+        while (!m_stop) {
+            pollfd listen_fd = {m_listen_fd, POLLIN, 0};
+            if (poll(&listen_fd, 1, POLL_MS) <= 0) {
+                continue;
+            }
+            const int fd = accept(m_listen_fd, nullptr, nullptr);
+            if (fd < 0) {
+                continue;
+            }
+            Request request;
+            if (ReadRequest(fd, request)) {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_requests.push_back(request);
+                }
+                const Reply reply = m_handler(request);
+                SendAll(fd, reply.data);
+                if (reply.hang) {
+                    WaitForHangUp(fd);
+                }
+            }
+            close(fd);
+        }
+    }
+
+    bool ReadRequest(int fd, Request& request) {
+        std::string data;
+        size_t end;
+        while ((end = data.find("\r\n\r\n")) == std::string::npos) {
+            pollfd client = {fd, POLLIN, 0};
+            if (m_stop) {
+                return false;
+            }
+            if (poll(&client, 1, POLL_MS) <= 0) {
+                continue;
+            }
+            char chunk[4096];
+            const ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+            if (received <= 0) {
+                return false;
+            }
+            data.append(chunk, static_cast<size_t>(received));
+        }
+
+        // "GET /path HTTP/1.1", then "Name: value" lines
+        size_t line_end = data.find("\r\n");
+        const std::string line = data.substr(0, line_end);
+        const size_t first = line.find(' ');
+        const size_t second = line.find(' ', first + 1);
+        request.target = line.substr(first + 1, second - first - 1);
+        while (line_end < end) {
+            const size_t start = line_end + 2;
+            line_end = data.find("\r\n", start);
+            const std::string header = data.substr(start, line_end - start);
+            const size_t colon = header.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            std::string name = header.substr(0, colon);
+            for (char& ch : name) {
+                ch = static_cast<char>(std::tolower(static_cast<unsigned char>(ch)));
+            }
+            const size_t value = header.find_first_not_of(' ', colon + 1);
+            request.headers.emplace_back(name, value == std::string::npos ? "" : header.substr(value));
+        }
+        return true;
+    }
+
+    void WaitForHangUp(int fd) {
+        char chunk[256];
+        while (!m_stop) {
+            pollfd client = {fd, POLLIN, 0};
+            if (poll(&client, 1, POLL_MS) > 0 && recv(fd, chunk, sizeof(chunk), 0) <= 0) {
+                return;
+            }
+        }
+    }
+
+    static void SendAll(int fd, std::string_view data) {
+        while (!data.empty()) {
+            const ssize_t sent = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (sent <= 0) {
+                return;
+            }
+            data.remove_prefix(static_cast<size_t>(sent));
+        }
+    }
+
+    Handler m_handler;
+    int m_listen_fd = -1;
+    uint16_t m_port = 0;
+    std::thread m_thread;
+    std::atomic<bool> m_stop{false};
+    std::mutex m_mutex;
+    std::vector<Request> m_requests;    // Guarded by m_mutex
+};
+
+} // namespace Test
+} // namespace UniLang
@@ -0,0 +1,214 @@
+#include "test_framework.h"
+#include "settings_writer.h"
+#include <nlohmann/json.hpp>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace UniLang;
+using json = nlohmann::json;
+
+namespace {
+
+std::string Merge(std::string_view document, std::string_view value, std::string_view section = "settings") {
+    std::string merged;
+    return SettingsWriter::MergeSection(document, section, value, merged) ? merged : "<rejected>";
+}
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+
+bool FileExists(const std::string& path) {
+    return std::ifstream(path).good();
+}
+
+} // namespace
+
+TEST(MergeReplacesOnlyTheSection) {
+    const std::string document = "{\n  \"a\": 1,\n  \"settings\": {\"x\": 1},\n  \"b\": \"s\\\"}\"\n}\n";
+    CHECK(Merge(document, "{\n  \"x\": 2\n}") ==
+          "{\n  \"a\": 1,\n  \"settings\": {\n    \"x\": 2\n  },\n  \"b\": \"s\\\"}\"\n}\n");
+
+    // Nested members and longer names with the same prefix are left alone
+    CHECK(Merge("{\"settings\": [1, {\"settings\": 2}], \"settings2\": 3}", "0") ==
+          "{\"settings\": 0, \"settings2\": 3}");
+}
+
+TEST(MergeAddsAMissingSection) {
+    CHECK(Merge("{\"a\": 1}", "true") == "{\"a\": 1,\n  \"settings\": true}");
+    CHECK(Merge("{}", "1") == "{\n  \"settings\": 1\n}");
+    CHECK(Merge("", "{\n  \"y\": 1\n}") == "{\n  \"settings\": {\n    \"y\": 1\n  }\n}\n");
+
+    // Whatever surrounds the object stays
+    CHECK(Merge("  {  }  ", "1") == "  {\n  \"settings\": 1\n  }  ");
+}
+
+TEST(MergeRejectsWhatIsNotAJsonObject) {
+    CHECK(Merge("[1]", "1") == "<rejected>");
+    CHECK(Merge("{\"a\": }", "1") == "<rejected>");
+    CHECK(Merge("{\"a\": 1} x", "1") == "<rejected>");
+    CHECK(Merge("{\"a\": \"{\", \"settings\": 5 // c\n}", "1") == "<rejected>");
+    CHECK(Merge("{\"a\": \"unterminated}", "1") == "<rejected>");
+}
+
+TEST(WriteFileAtomicReplacesTheFile) {
+    const std::string path = "atomic.test.json";
+    std::string error;
+    REQUIRE(SettingsWriter::WriteFileAtomic(path, "first", error));
+    REQUIRE(SettingsWriter::WriteFileAtomic(path, "second", error));
+    CHECK(ReadFile(path) == "second");
+    CHECK(!FileExists(path + ".tmp"));
+    std::remove(path.c_str());
+
+    CHECK(!SettingsWriter::WriteFileAtomic("missing-directory/atomic.test.json", "data", error));
+    CHECK(!error.empty());
+}
+
+TEST(BurstOfPostsIsOneWrite) {
+    const std::string path = "burst.test.json";
+    std::remove(path.c_str());
+    SettingsWriter::Options options;
+    options.debounce_ms = 60 * 1000;
+    options.max_delay_ms = 60 * 1000;
+    SettingsWriter writer(options);
+
+    for (int i = 0; i < 100; ++i) {
+        writer.Post(path, "settings", std::to_string(i));
+    }
+    CHECK(!FileExists(path));
+    REQUIRE(writer.Flush());
+    CHECK(writer.GetStats().posts == 100);
+    CHECK(writer.GetStats().writes == 1);
+    CHECK(json::parse(ReadFile(path))["settings"] == 99);
+
+    // Nothing pending: Flush doesn't write again
+    REQUIRE(writer.Flush());
+    CHECK(writer.GetStats().writes == 1);
+    std::remove(path.c_str());
+}
+
+TEST(WriteHappensOnceChangesSettle) {
+    const std::string path = "settle.test.json";
+    std::remove(path.c_str());
+    SettingsWriter::Options options;
+    options.debounce_ms = 20;
+    SettingsWriter writer(options);
+
+    writer.Post(path, "settings", "{\"a\": 1}");
+    for (int i = 0; i < 400 && writer.GetStats().writes == 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    CHECK(writer.GetStats().writes == 1);
+    CHECK(json::parse(ReadFile(path))["settings"]["a"] == 1);
+    std::remove(path.c_str());
+}
+
+TEST(ConstantPostsStillWriteWithinTheMaxDelay) {
+    const std::string path = "steady.test.json";
+    std::remove(path.c_str());
+    SettingsWriter::Options options;
+    options.debounce_ms = 50;
+    options.max_delay_ms = 100;
+    SettingsWriter writer(options);
+
+    // Never quiet for 50 ms, so only the max delay can trigger a write
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(600);
+    for (int i = 0; std::chrono::steady_clock::now() < end; ++i) {
+        writer.Post(path, "settings", std::to_string(i));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    CHECK(writer.GetStats().writes >= 1);
+    CHECK(writer.GetStats().writes < writer.GetStats().posts / 4);
+    writer.Stop();
+    std::remove(path.c_str());
+}
+
+TEST(ConcurrentWritersKeepEverySection) {
+    const std::vector<std::string> paths = {"stress1.test.json", "stress2.test.json"};
+    for (const std::string& path : paths) {
+        std::string error;
+        REQUIRE(SettingsWriter::WriteFileAtomic(path, "{\n  \"keep\": [1, 2, 3]\n}\n", error));
+    }
+
+    SettingsWriter::Options options;
+    options.debounce_ms = 1;
+    options.max_delay_ms = 5;
+    SettingsWriter writer(options);
+    const int THREADS = 8;
+    const int POSTS = 300;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&writer, &paths, t] {
+            for (int i = 0; i < POSTS; ++i) {
+                writer.Post(paths[t % paths.size()], "t" + std::to_string(t), "{\"n\": " + std::to_string(i) + "}");
+                if (i % 50 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    // Flushes race the posts
+    for (int i = 0; i < 20; ++i) {
+        CHECK(writer.Flush());
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    REQUIRE(writer.Flush());
+
+    const SettingsWriter::Stats stats = writer.GetStats();
+    CHECK(stats.posts == THREADS * POSTS);
+    CHECK(stats.failures == 0);
+    CHECK(stats.writes < stats.posts);
+    for (size_t p = 0; p < paths.size(); ++p) {
+        const json document = json::parse(ReadFile(paths[p]));
+        CHECK(document["keep"] == json({1, 2, 3}));
+        for (int t = static_cast<int>(p); t < THREADS; t += static_cast<int>(paths.size())) {
+            CHECK(document["t" + std::to_string(t)]["n"] == POSTS - 1);
+        }
+        CHECK(!FileExists(paths[p] + ".tmp"));
+        std::remove(paths[p].c_str());
+    }
+}
+
+TEST(FailedWriteIsReportedByFlush) {
+    SettingsWriter writer;
+    writer.Post("missing-directory/settings.test.json", "settings", "1");
+    CHECK(!writer.Flush());
+    CHECK(!writer.GetLastError().empty());
+    CHECK(writer.GetStats().failures == 1);
+
+    // A document that isn't an object is not overwritten
+    const std::string path = "array.test.json";
+    std::string error;
+    REQUIRE(SettingsWriter::WriteFileAtomic(path, "[1]", error));
+    writer.Post(path, "settings", "1");
+    CHECK(!writer.Flush());
+    CHECK(ReadFile(path) == "[1]");
+    std::remove(path.c_str());
+
+    writer.Post("ok.test.json", "settings", "1");
+    CHECK(writer.Flush());
+    std::remove("ok.test.json");
+}
+
+TEST(PendingChangesAreWrittenOnDestruction) {
+    const std::string path = "shutdown.test.json";
+    std::remove(path.c_str());
+    {
+        SettingsWriter::Options options;
+        options.debounce_ms = 60 * 1000;
+        SettingsWriter writer(options);
+        writer.Post(path, "settings", "\"last\"");
+    }
+    CHECK(json::parse(ReadFile(path))["settings"] == "last");
+    std::remove(path.c_str());
+}
+
+UNILANG_TEST_MAIN()
@@ -0,0 +1,194 @@
+#include "test_framework.h"
+#include "shortcuts_dict.h"
+#include "text_converter.h"
+#include <string>
+
+using namespace UniLang;
+
+namespace {
+
+const char* V1 = R"({
+    "shortcuts": {
+        "greek": {"\\al": "α", "\\be": "β", "\\ga": "γ"},
+        "arrows": {"\\to": "→"},
+        "emoji": {"_grammar": {"opener": ":", "terminator": ":"}, "smile": "S"}
+    },
+    "autocorrect": {"teh": "the"}
+})";
+
+// \be changed, \to moved to "math", \ga removed, \de and :wink added
+const char* V2 = R"({
+    "shortcuts": {
+        "greek": {"\\al": "α", "\\be": "B", "\\de": "δ"},
+        "math": {"\\to": "→"},
+        "emoji": {"_grammar": {"opener": ":", "terminator": ":"}, "smile": "S", "wink": "W"}
+    },
+    "autocorrect": {"teh": "the"}
+})";
+
+std::string Convert(const ShortcutsDict& dict, const std::string& text) {
+    TextConverter converter(dict);
+    std::string out;
+    converter.Convert(text, out);
+    converter.Finish(out);
+    return out;
+}
+
+std::string CategoryOf(const ShortcutsDict& dict, const std::string& shortcut) {
+    const ShortcutsDict::Entry* entry = dict.FindEntry(shortcut);
+    return entry == nullptr ? "" : dict.GetCategoryName(entry->category);
+}
+
+} // namespace
+
+TEST(ContentHashIgnoresOrderButNotContent) {
+    ShortcutsDict a;
+    ShortcutsDict b;
+    ShortcutsDict c;
+    REQUIRE(a.LoadFromString(R"({"shortcuts": {"x": {"\\a": "1", "\\b": "2"}, "y": {"\\c": "3"}}})"));
+    REQUIRE(b.LoadFromString(R"({"shortcuts": {"y": {"\\c": "3"}, "x": {"\\b": "2", "\\a": "1"}}})"));
+    REQUIRE(c.LoadFromString(R"({"shortcuts": {"y": {"\\c": "3"}, "x": {"\\b": "2", "\\a": "one"}}})"));
+    CHECK(a.GetContentHash() == b.GetContentHash());
+    CHECK(a.GetContentHash() != c.GetContentHash());
+
+    // Rules and autocorrect are not part of it
+    ShortcutsDict d;
+    REQUIRE(d.LoadFromString(R"({"shortcuts": {"x": {"\\a": "1", "\\b": "2"}, "y": {"\\c": "3"}},
+                                 "autocorrect": {"teh": "the"}})"));
+    CHECK(a.GetContentHash() == d.GetContentHash());
+    CHECK(ShortcutsDict::FormatHash(0x12ab).size() == 16);
+    CHECK(ShortcutsDict::FormatHash(0x12ab) == "00000000000012ab");
+}
+
+TEST(ComputedDiffRoundTripsThroughJson) {
+    ShortcutsDict v1;
+    ShortcutsDict v2;
+    REQUIRE(v1.LoadFromString(V1));
+    REQUIRE(v2.LoadFromString(V2));
+
+    const ShortcutsDict::Diff diff = ShortcutsDict::ComputeDiff(v1, v2);
+    CHECK(diff.base_hash == v1.GetContentHash());
+    CHECK(diff.target_hash == v2.GetContentHash());
+    CHECK(diff.added.size() == 2);
+    CHECK(diff.changed.size() == 2);
+    REQUIRE(diff.removed.size() == 1);
+    CHECK(diff.removed[0] == "\\ga");
+
+    ShortcutsDict::Diff parsed;
+    REQUIRE(ShortcutsDict::ParseDiff(ShortcutsDict::DiffToJson(diff), parsed));
+    CHECK(parsed.base_hash == diff.base_hash);
+    CHECK(parsed.target_hash == diff.target_hash);
+    CHECK(ShortcutsDict::DiffToJson(parsed) == ShortcutsDict::DiffToJson(diff));
+
+    ShortcutsDict updated;
+    REQUIRE(updated.LoadFromDiff(v1, parsed));
+    CHECK(updated.GetContentHash() == v2.GetContentHash());
+    CHECK(updated.GetAllShortcuts() == v2.GetAllShortcuts());
+    CHECK(updated.FindReplacement("\\be") == std::string("B"));
+    CHECK(!updated.FindReplacement("\\ga"));
+    CHECK(CategoryOf(updated, "\\to") == "math");
+    CHECK(Convert(updated, "\\de :wink: teh ") == "δW the ");
+
+    // The base keeps serving as it was
+    CHECK(v1.FindReplacement("\\ga") == std::string("γ"));
+    CHECK(Convert(v1, "\\be ") == "β");
+
+    // Nothing to do between equal dictionaries
+    const ShortcutsDict::Diff none = ShortcutsDict::ComputeDiff(v2, updated);
+    CHECK(none.added.empty() && none.changed.empty() && none.removed.empty());
+}
+
+TEST(DiffOnlyAppliesToItsBase) {
+    ShortcutsDict v1;
+    ShortcutsDict v2;
+    REQUIRE(v1.LoadFromString(V1));
+    REQUIRE(v2.LoadFromString(V2));
+    const ShortcutsDict::Diff diff = ShortcutsDict::ComputeDiff(v1, v2);
+
+    // Applied twice, or to anything else, it fails and leaves the target as it was
+    ShortcutsDict target;
+    REQUIRE(target.LoadFromString(V2));
+    CHECK(!target.LoadFromDiff(v2, diff));
+    CHECK(target.GetContentHash() == v2.GetContentHash());
+
+    ShortcutsDict::Diff tampered = diff;
+    tampered.target_hash ^= 1;
+    CHECK(!target.LoadFromDiff(v1, tampered));
+    CHECK(target.GetContentHash() == v2.GetContentHash());
+
+    tampered = diff;
+    tampered.added[0].replacement = "forged";
+    CHECK(!target.LoadFromDiff(v1, tampered));
+
+    tampered = diff;
+    tampered.removed.push_back("\\missing");
+    CHECK(!target.LoadFromDiff(v1, tampered));
+    CHECK(Convert(target, "\\be ") == "B");
+}
+
+TEST(DiffCanUpdateTheDictionaryItCameFrom) {
+    ShortcutsDict dict;
+    ShortcutsDict v2;
+    REQUIRE(dict.LoadFromString(V1));
+    REQUIRE(v2.LoadFromString(V2));
+    REQUIRE(dict.LoadFromDiff(dict, ShortcutsDict::ComputeDiff(dict, v2)));
+    CHECK(dict.GetContentHash() == v2.GetContentHash());
+    CHECK(Convert(dict, "\\be :smile:") == "BS");
+}
+
+TEST(ChainedUpdatesPersistAsOneDiffFromTheBuiltIn) {
+    // What the app does: the built-in dictionary stays the base, and after
+    // each update the saved diff is recomputed from it
+    ShortcutsDict builtin;
+    ShortcutsDict v2;
+    ShortcutsDict v3;
+    REQUIRE(builtin.LoadFromString(V1));
+    REQUIRE(v2.LoadFromString(V2));
+    REQUIRE(v3.LoadFromString(R"({"shortcuts": {"greek": {"\\al": "A"}, "math": {"\\to": "→", "\\in": "∈"}}})"));
+
+    ShortcutsDict first;
+    REQUIRE(first.LoadFromDiff(builtin, ShortcutsDict::ComputeDiff(builtin, v2)));
+    ShortcutsDict second;
+    REQUIRE(second.LoadFromDiff(first, ShortcutsDict::ComputeDiff(v2, v3)));
+    const std::string saved = ShortcutsDict::DiffToJson(ShortcutsDict::ComputeDiff(builtin, second));
+
+    // Next start: built-in plus the one saved diff
+    ShortcutsDict restarted;
+    ShortcutsDict::Diff diff;
+    REQUIRE(ShortcutsDict::ParseDiff(saved, diff));
+    REQUIRE(restarted.LoadFromDiff(builtin, diff));
+    CHECK(restarted.GetContentHash() == v3.GetContentHash());
+    CHECK(Convert(restarted, "\\in \\al ") == "∈A");
+
+    // A diff saved against an intermediate version doesn't apply to the built-in
+    ShortcutsDict::Diff step;
+    REQUIRE(ShortcutsDict::ParseDiff(ShortcutsDict::DiffToJson(ShortcutsDict::ComputeDiff(v2, v3)), step));
+    CHECK(!restarted.LoadFromDiff(builtin, step));
+}
+
+TEST(MalformedDiffDocumentsAreRejected) {
+    ShortcutsDict::Diff diff;
+    CHECK(!ShortcutsDict::ParseDiff("", diff));
+    CHECK(!ShortcutsDict::ParseDiff("{}", diff));
+    CHECK(!ShortcutsDict::ParseDiff(R"({"base": "xyz", "target": "0000000000000001"})", diff));
+    CHECK(!ShortcutsDict::ParseDiff(R"({"base": "0000000000000001", "target": "0000000000000002",
+                                        "added": [{"shortcut": "\\a"}]})", diff));
+    CHECK(ShortcutsDict::ParseDiff(R"({"base": "0000000000000001", "target": "0000000000000002"})", diff));
+    CHECK(diff.base_hash == 1);
+    CHECK(diff.added.empty());
+}
+
+TEST(ShippedDictionaryDiffsToItself) {
+    ShortcutsDict shipped;
+    REQUIRE(shipped.LoadFromFile(UNILANG_TEST_SHORTCUTS));
+    CHECK(shipped.GetEntryCount() > 100);
+
+    const ShortcutsDict::Diff none = ShortcutsDict::ComputeDiff(shipped, shipped);
+    CHECK(none.added.empty() && none.changed.empty() && none.removed.empty());
+    ShortcutsDict copy;
+    REQUIRE(copy.LoadFromDiff(shipped, none));
+    CHECK(copy.GetContentHash() == shipped.GetContentHash());
+    CHECK(copy.GetEntryCount() == shipped.GetEntryCount());
+}
+
+UNILANG_TEST_MAIN()
@@ -0,0 +1,233 @@
+#include "test_framework.h"
+#include "pattern_matcher.h"
+#include "shortcuts_dict.h"
+#include "symbol_families.h"
+#include "text_converter.h"
+#include "unicode_utils.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace UniLang;
+
+namespace {
+
+const char* DICTIONARY = R"({
+    "shortcuts": {
+        "greek": {"\\al": "α", "\\bar": "BAR"}
+    }
+})";
+
+std::u32string CodePoints(std::string_view utf8) {
+    std::u32string result;
+    size_t pos = 0;
+    while (pos < utf8.size()) {
+        result.push_back(DecodeUtf8(utf8, pos));
+    }
+    return result;
+}
+
+std::u32string Expand(std::string_view key) {
+    std::string out;
+    return ExpandSymbolFamily(key, out) ? CodePoints(out) : U"<none>";
+}
+
+std::string Convert(const ShortcutsDict& dict, const std::string& text) {
+    TextConverter converter(dict);
+    std::string out;
+    converter.Convert(text, out);
+    converter.Finish(out);
+    return out;
+}
+
+// Reserved code points of the Mathematical Alphanumeric Symbols letters
+// (UnicodeData.txt): the letters that already existed in Letterlike Symbols
+const char32_t MATH_ALPHABET_HOLES[] = {
+    0x1D455, 0x1D49D, 0x1D4A0, 0x1D4A1, 0x1D4A3, 0x1D4A4, 0x1D4A7, 0x1D4A8, 0x1D4AD, 0x1D4BA, 0x1D4BC, 0x1D4C4,
+    0x1D506, 0x1D50B, 0x1D50C, 0x1D515, 0x1D51D, 0x1D53A, 0x1D53F, 0x1D545, 0x1D547, 0x1D548, 0x1D549, 0x1D551,
+};
+
+const char* ALPHABET_FAMILIES[] = {
+    "mathbf", "mathit", "boldsymbol", "bm", "mathbfit", "mathcal", "mathscr", "mathfrak", "mathbb",
+    "mathsf", "mathbfsf", "mathsfit", "mathtt", "bf", "bb", "cal", "frak",
+};
+
+} // namespace
+
+TEST(MathAlphabetsMatchTheUnicodeCharts) {
+    // Code points from the Unicode charts for U+1D400-1D7FF and U+2100-214F
+    CHECK(Expand("\\mathbf{A}") == U"\U0001D400");
+    CHECK(Expand("\\mathbf{z}") == U"\U0001D433");
+    CHECK(Expand("\\mathbf{09}") == U"\U0001D7CE\U0001D7D7");
+    CHECK(Expand("\\mathit{a}") == U"\U0001D44E");
+    CHECK(Expand("\\mathit{h}") == U"ℎ");                     // PLANCK CONSTANT
+    CHECK(Expand("\\boldsymbol{x}") == U"\U0001D499");
+    CHECK(Expand("\\mathcal{A}") == U"\U0001D49C");
+    CHECK(Expand("\\mathcal{BEFHILMR}") == U"ℬℰℱℋℐℒℳℛ");
+    CHECK(Expand("\\mathcal{ego}") == U"ℯℊℴ");
+    CHECK(Expand("\\mathcal{a}") == U"\U0001D4B6");
+    CHECK(Expand("\\mathfrak{A}") == U"\U0001D504");
+    CHECK(Expand("\\mathfrak{CHIRZ}") == U"ℭℌℑℜℨ");
+    CHECK(Expand("\\mathfrak{a}") == U"\U0001D51E");
+    CHECK(Expand("\\mathbb{A}") == U"\U0001D538");
+    CHECK(Expand("\\mathbb{CHNPQRZ}") == U"ℂℍℕℙℚℝℤ");
+    CHECK(Expand("\\mathbb{k1}") == U"\U0001D55C\U0001D7D9");
+    CHECK(Expand("\\mathsf{A0}") == U"\U0001D5A0\U0001D7E2");
+    CHECK(Expand("\\mathbfsf{a0}") == U"\U0001D5EE\U0001D7EC");
+    CHECK(Expand("\\mathsfit{Z}") == U"\U0001D621");
+    CHECK(Expand("\\mathtt{z9}") == U"\U0001D6A3\U0001D7FF");
+    CHECK(Expand("\\bb{R}") == Expand("\\mathbb{R}"));
+}
+
+TEST(MathAlphabetsNeverProduceReservedCodePoints) {
+    const std::string alnum = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    for (const char* name : ALPHABET_FAMILIES) {
+        const SymbolFamily* family = FindSymbolFamily(name);
+        REQUIRE(family != nullptr);
+        std::u32string seen;
+        for (char ch : alnum) {
+            std::string out;
+            if (!AppendSymbolFamilyChar(*family, static_cast<unsigned char>(ch), out)) {
+                continue;
+            }
+            const std::u32string cps = CodePoints(out);
+            REQUIRE(cps.size() == 1);
+            CHECK(std::find(std::begin(MATH_ALPHABET_HOLES), std::end(MATH_ALPHABET_HOLES), cps[0]) ==
+                  std::end(MATH_ALPHABET_HOLES));
+            CHECK(seen.find(cps[0]) == std::u32string::npos);      // No two letters share a form
+            seen.push_back(cps[0]);
+        }
+        CHECK(seen.size() >= 52);
+    }
+}
+
+TEST(GreekFollowsTheSameRuns) {
+    const SymbolFamily* bold = FindSymbolFamily("mathbf");
+    const SymbolFamily* italic = FindSymbolFamily("mathit");
+    REQUIRE(bold != nullptr && italic != nullptr);
+    std::string out;
+    CHECK(AppendSymbolFamilyChar(*bold, U'Α', out));       // GREEK CAPITAL LETTER ALPHA
+    CHECK(AppendSymbolFamilyChar(*bold, U'Ω', out));
+    CHECK(AppendSymbolFamilyChar(*bold, U'α', out));
+    CHECK(AppendSymbolFamilyChar(*italic, U'ω', out));
+    CHECK(CodePoints(out) == U"\U0001D6A8\U0001D6C0\U0001D6C2\U0001D714");
+
+    // Script has no Greek
+    CHECK(!AppendSymbolFamilyChar(*FindSymbolFamily("mathcal"), U'α', out));
+}
+
+TEST(AccentsPreferPrecomposedLetters) {
+    // NFC of letter + combining mark where Unicode has one
+    CHECK(Expand("\\hat{a}") == U"â");
+    CHECK(Expand("\\hat{J}") == U"Ĵ");
+    CHECK(Expand("\\check{c}") == U"č");
+    CHECK(Expand("\\check{j}") == U"ǰ");
+    CHECK(Expand("\\bar{y}") == U"ȳ");
+    CHECK(Expand("\\dot{I}") == U"İ");
+    CHECK(Expand("\\ddot{t}") == U"ẗ");
+    CHECK(Expand("\\tilde{n}") == U"ñ");
+    CHECK(Expand("\\grave{n}") == U"ǹ");
+    CHECK(Expand("\\acute{g}") == U"ǵ");
+    CHECK(Expand("\\breve{G}") == U"Ğ");
+
+    // Everything else gets the combining mark, one per character
+    CHECK(Expand("\\hat{b}") == U"b̂");
+    CHECK(Expand("\\vec{v}") == U"v⃗");
+    CHECK(Expand("\\overline{AB}") == U"A̅B̅");
+    CHECK(Expand("\\bar{x1}") == U"x̄1̄");
+}
+
+TEST(AccentTablesStayAligned) {
+    // A form is either one precomposed code point or letter + mark; a
+    // shifted exception table would show up as the wrong base letter
+    const char* accents[] = {"grave", "acute", "hat", "tilde", "bar", "breve", "dot", "ddot", "check"};
+    const std::string letters = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+    for (const char* name : accents) {
+        for (char letter : letters) {
+            const std::u32string form = Expand(std::string("\\") + name + "{" + letter + "}");
+            REQUIRE(form.size() == 1 || form.size() == 2);
+            if (form.size() == 2) {
+                CHECK(form[0] == static_cast<char32_t>(letter));
+            } else {
+                CHECK(form[0] >= 0xC0 && form[0] != static_cast<char32_t>(letter));
+            }
+        }
+    }
+}
+
+TEST(OnlyCompleteFamilyKeysExpand) {
+    CHECK(IsSymbolFamilyKey("\\mathbb{R}"));
+    CHECK(IsSymbolFamilyKey("\\hat{x}"));
+    CHECK(!IsSymbolFamilyKey("\\mathrm{R}"));      // Not a family
+    CHECK(!IsSymbolFamilyKey("\\mathbb{}"));
+    CHECK(!IsSymbolFamilyKey("\\mathbb{R"));
+    CHECK(!IsSymbolFamilyKey("\\mathbb{R!}"));
+    CHECK(!IsSymbolFamilyKey("\\mathcal{0}"));     // Script has no digits
+    CHECK(!IsSymbolFamilyKey("\\hat{ }"));
+    CHECK(!IsSymbolFamilyKey("mathbb{R}"));
+    CHECK(Expand("\\mathfrak{x-}") == U"<none>");
+
+    std::string out = "kept";
+    CHECK(!ExpandSymbolFamily("\\mathrm{R}", out));
+    CHECK(out == "kept");
+}
+
+TEST(FeedReportsEveryFamilyInAStream) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    const std::string text = "x\\in \\mathbb{R}, \\hat{x} \\mathrm{d} \\mathcal{0} \\al \\bar{y}";
+
+    // Small output buffer, so Feed also has to stop and resume
+    PatternMatcher matcher;
+    std::vector<PatternMatcher::FeedMatch> matches;
+    std::string_view rest = text;
+    PatternMatcher::FeedMatch out[2];
+    while (!rest.empty()) {
+        const PatternMatcher::FeedResult result = matcher.Feed(rest, dict, out, 2, ShortcutsDict::ALL_CATEGORIES);
+        matches.insert(matches.end(), out, out + result.match_count);
+        rest.remove_prefix(result.consumed);
+    }
+    CHECK(matcher.GetStreamPosition() == text.size());
+
+    // Families come back as FAMILY_ENTRY_ID over the bytes to expand
+    std::vector<std::string> keys;
+    for (const PatternMatcher::FeedMatch& match : matches) {
+        const std::string key = text.substr(match.position, match.length);
+        if (match.entry_id == PatternMatcher::FAMILY_ENTRY_ID) {
+            CHECK(IsSymbolFamilyKey(key));
+        } else {
+            CHECK(match.entry_id == dict.FindEntryId("\\al"));
+        }
+        keys.push_back(key);
+    }
+    CHECK(keys == std::vector<std::string>({"\\mathbb{R}", "\\hat{x}", "\\al ", "\\bar{y}"}));
+
+    // Chunked input finds the same families
+    for (size_t split = 1; split < text.size(); split += 3) {
+        PatternMatcher chunked;
+        size_t count = 0;
+        for (std::string_view part : {std::string_view(text).substr(0, split), std::string_view(text).substr(split)}) {
+            while (!part.empty()) {
+                const PatternMatcher::FeedResult result =
+                    chunked.Feed(part, dict, out, 2, ShortcutsDict::ALL_CATEGORIES);
+                for (size_t i = 0; i < result.match_count; ++i, ++count) {
+                    CHECK(count < matches.size() && out[i].position == matches[count].position &&
+                          out[i].entry_id == matches[count].entry_id);
+                }
+                part.remove_prefix(result.consumed);
+            }
+        }
+        CHECK(count == matches.size());
+    }
+}
+
+TEST(ConverterExpandsFamilies) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    CHECK(Convert(dict, "x \\in \\mathbb{R}, \\hat{x} \\mathrm{d}") == "x \\in ℝ, x̂ \\mathrm{d}");
+
+    // A dictionary entry named like a family still fires on its terminator
+    CHECK(Convert(dict, "\\bar \\bar{a}") == "BARā");
+}
+
+UNILANG_TEST_MAIN()
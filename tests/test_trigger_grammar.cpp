@@ -0,0 +1,100 @@
+#include "test_framework.h"
+#include "pattern_matcher.h"
+#include "shortcuts_dict.h"
+#include "text_converter.h"
+#include <string>
+
+using namespace UniLang;
+
+namespace {
+
+// LaTeX, emoji (":" name ":") and two snippet layers whose openers overlap (";" and ";;")
+const char* DICTIONARY = R"({
+    "shortcuts": {
+        "greek": {"\\al": "α"},
+        "emoji": {"_grammar": {"opener": ":", "terminator": ":"}, "smile": "S"},
+        "one": {"_grammar": {"opener": ";"}, "x": "X1"},
+        "two": {"_grammar": {"opener": ";;"}, "x": "X2", "addr": "ADDR"}
+    }
+})";
+
+std::string Convert(const ShortcutsDict& dict, const std::string& text) {
+    TextConverter converter(dict);
+    std::string out;
+    converter.Convert(text, out);
+    converter.Finish(out);
+    return out;
+}
+
+} // namespace
+
+TEST(EachGrammarFiresOnItsOwnTerminator) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    CHECK(Convert(dict, "\\al ") == "α");
+    CHECK(Convert(dict, ":smile:") == "S");
+    CHECK(Convert(dict, "a:smile: b") == "aS b");
+    CHECK(Convert(dict, ":smile ") == ":smile ");
+    CHECK(Convert(dict, ";;addr ") == "ADDR");
+    CHECK(Convert(dict, "time 10:30:") == "time 10:30:");
+}
+
+TEST(LongestTypedOpenerWins) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    CHECK(Convert(dict, ";x ") == "X1");
+    CHECK(Convert(dict, ";;x ") == "X2");
+    CHECK(Convert(dict, ";;;x ") == ";X2");
+}
+
+TEST(KeysKeepTheirPrefixAndShowTheTypedForm) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    CHECK(dict.FindEntryId(":smile") != ShortcutsDict::INVALID_ENTRY_ID);
+    CHECK(dict.FindEntryId(";;addr") != ShortcutsDict::INVALID_ENTRY_ID);
+    CHECK(dict.GetTypedForm(":smile") == ":smile:");
+    CHECK(dict.GetTypedForm(";;addr") == ";;addr");     // No terminator shown for whitespace
+}
+
+TEST(TriggerKeyReplacesTheLatexOpener) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    REQUIRE(dict.SetTriggerKey("!"));
+    CHECK(Convert(dict, "!al ") == "α");
+    CHECK(Convert(dict, "\\al ") == "\\al ");
+    CHECK(dict.FindEntryId("\\al") != ShortcutsDict::INVALID_ENTRY_ID);  // Keys are unchanged
+
+    // Empty, a letter, or another grammar's opener
+    CHECK(!dict.SetTriggerKey(""));
+    CHECK(!dict.SetTriggerKey("a"));
+    CHECK(!dict.SetTriggerKey(":"));
+    CHECK(!dict.SetTriggerKey(";;"));
+    CHECK(Convert(dict, "!al ") == "α");
+}
+
+TEST(NameFiresAfterBackspace) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(DICTIONARY));
+    PatternMatcher matcher;
+    PatternMatcher::MatchView match;
+    for (char ch : std::string("\\alx")) {
+        CHECK(!matcher.AddChar(ch, match, dict.GetGrammars()));
+    }
+    matcher.RemoveLastChar();
+    REQUIRE(matcher.AddChar(' ', match, dict.GetGrammars()));
+    CHECK(match.Key() == "\\al");
+    CHECK(match.length == 4);
+}
+
+TEST(ConflictingGrammarsAreRejected) {
+    ShortcutsDict dict;
+    CHECK(!dict.LoadFromString(R"({"shortcuts": {
+        "a": {"_grammar": {"opener": ":"}, "x": "1"},
+        "b": {"_grammar": {"opener": ":", "terminator": "!"}, "y": "2"}
+    }})"));
+    CHECK(!dict.LoadFromString(R"({"shortcuts": {
+        "a": {"_grammar": {"opener": ":", "terminator": "ab"}, "x": "1"}
+    }})"));
+}
+
+UNILANG_TEST_MAIN()
@@ -0,0 +1,186 @@
+#include "test_framework.h"
+#include "test_server.h"
+#include "update_manager.h"
+#include <atomic>
+#include <cstdio>
+#include <string>
+
+using namespace UniLang;
+using Test::TestServer;
+
+namespace {
+
+const char* RELEASE = R"({
+    "tag_name": "v1.2.0",
+    "body": "notes",
+    "assets": [
+        {"name": "UniLang.exe", "browser_download_url": "http://example/UniLang.exe", "size": 1000,
+         "digest": "sha256:ABCD"},
+        {"name": "UniLang.exe.1.0.0.delta", "browser_download_url": "http://example/from-1.0.0.delta"},
+        {"name": "UniLang.exe.0.9.0.delta", "browser_download_url": "http://example/from-0.9.0.delta"},
+        {"name": "shortcuts.json", "browser_download_url": "http://example/shortcuts.json", "size": 20},
+        {"name": "shortcuts.0123abcd.diff.json", "browser_download_url": "http://example/diff.json"}
+    ]
+})";
+
+const char* VALIDATORS = "ETag: \"r1\"\r\nLast-Modified: Mon, 01 Jan 2024 00:00:00 GMT\r\n";
+
+} // namespace
+
+TEST(ReleaseAssetsAreParsed) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request&) {
+        return TestServer::Reply{TestServer::Response(200, RELEASE)};
+    }));
+    auto http = HttpClient::Create();
+    UpdateManager manager(*http);
+    manager.SetApiUrl(server.Url(""));
+
+    const UpdateManager::VersionInfo info = manager.CheckForUpdates("owner", "repo", "1.0.0");
+    CHECK(manager.GetLastError().empty());
+    CHECK(manager.GetLastStatus() == 200);
+    CHECK(info.version == "v1.2.0");
+    CHECK(info.is_newer);
+    CHECK(info.release_notes == "notes");
+    CHECK(info.download_url == "http://example/UniLang.exe");
+    CHECK(info.download_sha256 == "ABCD");
+    CHECK(info.download_size == 1000);
+    CHECK(info.delta_url == "http://example/from-1.0.0.delta");
+    CHECK(info.shortcuts_url == "http://example/shortcuts.json");
+    CHECK(info.shortcuts_size == 20);
+    CHECK(info.shortcuts_diffs.size() == 1);
+    CHECK(info.shortcuts_diffs.count("0123abcd") == 1);
+
+    CHECK(!manager.CheckForUpdates("owner", "repo", "v1.2.0").is_newer);
+    CHECK(!manager.CheckForUpdates("owner", "repo", "1.10.0").is_newer);
+}
+
+TEST(UnchangedReleaseCostsA304) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request& request) {
+        if (request.GetHeader("if-none-match") == "\"r1\"") {
+            return TestServer::Reply{"HTTP/1.1 304 Not Modified\r\nETag: \"r1\"\r\n\r\n"};
+        }
+        return TestServer::Reply{TestServer::Response(200, RELEASE, VALIDATORS)};
+    }));
+    auto http = HttpClient::Create();
+    UpdateManager manager(*http);
+    manager.SetApiUrl(server.Url(""));
+
+    manager.CheckForUpdates("owner", "repo", "1.0.0");
+    REQUIRE(manager.GetCache().has_info);
+    CHECK(manager.GetCache().etag == "\"r1\"");
+
+    // Served from the cache, with is_newer recomputed for the running version
+    const UpdateManager::VersionInfo info = manager.CheckForUpdates("owner", "repo", "1.2.0");
+    CHECK(manager.GetLastStatus() == 304);
+    CHECK(manager.GetLastError().empty());
+    CHECK(info.version == "v1.2.0");
+    CHECK(info.download_size == 1000);
+    CHECK(!info.is_newer);
+
+    auto requests = server.GetRequests();
+    REQUIRE(requests.size() == 2);
+    CHECK(requests[0].GetHeader("if-none-match").empty());
+    CHECK(requests[1].GetHeader("if-modified-since") == "Mon, 01 Jan 2024 00:00:00 GMT");
+
+    // Validators only go back to the URL they came from
+    manager.CheckForUpdates("owner", "other", "1.0.0");
+    requests = server.GetRequests();
+    REQUIRE(requests.size() == 3);
+    CHECK(requests[2].GetHeader("if-none-match").empty());
+    CHECK(manager.GetLastStatus() == 200);
+}
+
+TEST(CacheSurvivesSaveAndLoad) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request& request) {
+        if (request.GetHeader("if-none-match") == "\"r1\"") {
+            return TestServer::Reply{"HTTP/1.1 304 Not Modified\r\n\r\n"};
+        }
+        return TestServer::Reply{TestServer::Response(200, RELEASE, VALIDATORS)};
+    }));
+    auto http = HttpClient::Create();
+    const std::string path = "update_cache.test.json";
+    {
+        UpdateManager manager(*http);
+        manager.SetApiUrl(server.Url(""));
+        manager.CheckForUpdates("owner", "repo", "1.0.0");
+        REQUIRE(UpdateManager::SaveCache(path, manager.GetCache()));
+    }
+
+    // A fresh run picks up the validators and the release they stand for
+    UpdateManager::CacheState cache;
+    REQUIRE(UpdateManager::LoadCache(path, cache));
+    std::remove(path.c_str());
+    CHECK(cache.has_info);
+    CHECK(cache.info.shortcuts_diffs.size() == 1);
+    UpdateManager manager(*http);
+    manager.SetApiUrl(server.Url(""));
+    manager.SetCache(cache);
+    const UpdateManager::VersionInfo info = manager.CheckForUpdates("owner", "repo", "1.0.0");
+    CHECK(manager.GetLastStatus() == 304);
+    CHECK(info.is_newer);
+    CHECK(info.delta_url == "http://example/from-1.0.0.delta");
+
+    CHECK(!UpdateManager::LoadCache("missing.test.json", cache));
+    CHECK(!cache.has_info);
+}
+
+TEST(FailedChecksBackOff) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request& request) {
+        if (request.target.find("/limited/") != std::string::npos) {
+            return TestServer::Reply{TestServer::Response(403, "{}", "X-RateLimit-Remaining: 0\r\nRetry-After: 7200\r\n")};
+        }
+        if (request.target.find("/broken/") != std::string::npos) {
+            return TestServer::Reply{TestServer::Response(200, "{not json")};
+        }
+        return TestServer::Reply{TestServer::Response(500, "")};
+    }));
+    auto http = HttpClient::Create();
+    UpdateManager manager(*http);
+    manager.SetApiUrl(server.Url(""));
+
+    manager.CheckForUpdates("owner", "repo", "1.0.0");
+    CHECK(manager.GetLastStatus() == 500);
+    CHECK(!manager.GetLastError().empty());
+    CHECK(manager.GetCache().failures == 1);
+    const int64_t now = UpdateManager::Now();
+    CHECK(manager.IsBackingOff(now));
+    CHECK(manager.GetCache().retry_after <= now + UpdateManager::BACKOFF_BASE_S);
+
+    manager.CheckForUpdates("limited", "repo", "1.0.0");
+    CHECK(manager.GetLastError().find("Rate limited") != std::string::npos);
+    CHECK(manager.GetCache().failures == 2);
+    CHECK(manager.GetCache().retry_after >= now + 7200);
+
+    manager.CheckForUpdates("broken", "repo", "1.0.0");
+    CHECK(!manager.GetLastError().empty());
+    CHECK(manager.GetCache().failures == 3);
+
+    // A cancelled check says nothing about the server
+    std::atomic<bool> cancel{true};
+    manager.CheckForUpdates("owner", "repo", "1.0.0", &cancel);
+    CHECK(manager.GetLastStatus() == 0);
+    CHECK(manager.GetCache().failures == 3);
+}
+
+TEST(SuccessResetsTheBackoff) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request& request) {
+        const int status = request.target.find("/down/") != std::string::npos ? 503 : 200;
+        return TestServer::Reply{TestServer::Response(status, RELEASE)};
+    }));
+    auto http = HttpClient::Create();
+    UpdateManager manager(*http);
+    manager.SetApiUrl(server.Url(""));
+
+    manager.CheckForUpdates("down", "repo", "1.0.0");
+    CHECK(manager.GetCache().failures == 1);
+    manager.CheckForUpdates("owner", "repo", "1.0.0");
+    CHECK(manager.GetCache().failures == 0);
+    CHECK(!manager.IsBackingOff(UpdateManager::Now()));
+}
+
+UNILANG_TEST_MAIN()
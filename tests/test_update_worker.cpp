@@ -0,0 +1,160 @@
+#include "test_framework.h"
+#include "test_server.h"
+#include "update_worker.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace UniLang;
+using Test::TestServer;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const char* RELEASE = R"({
+    "tag_name": "v9.0.0",
+    "body": "notes",
+    "assets": [{"name": "UniLang.exe", "browser_download_url": "http://127.0.0.1:1/UniLang.exe", "size": 3}]
+})";
+
+/**
+ * @brief Results handed over by the worker thread
+ */
+class Results {
+public:
+    void operator()(std::unique_ptr<UpdateWorker::Result> result) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_results.push_back(std::move(result));
+        m_arrived.notify_all();
+    }
+
+    std::unique_ptr<UpdateWorker::Result> Wait() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_arrived.wait_for(lock, std::chrono::seconds(5), [this] { return !m_results.empty(); })) {
+            return nullptr;
+        }
+        auto result = std::move(m_results.front());
+        m_results.pop_front();
+        return result;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_arrived;
+    std::deque<std::unique_ptr<UpdateWorker::Result>> m_results;
+};
+
+UpdateWorker::Config MakeConfig(const TestServer& server) {
+    UpdateWorker::Config config;
+    config.repo_owner = "owner";
+    config.repo_name = "repo";
+    config.current_version = "1.0.0";
+    config.api_url = server.Url("");
+    return config;
+}
+
+void WaitForRequests(TestServer& server, size_t count) {
+    for (int i = 0; i < 500 && server.GetRequests().size() < count; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+}
+
+TestServer::Reply Hang(const TestServer::Request&) {
+    TestServer::Reply reply;
+    reply.hang = true;
+    return reply;
+}
+
+} // namespace
+
+TEST(CheckResultIsHandedToTheHandler) {
+    TestServer server;
+    REQUIRE(server.Start([](const TestServer::Request&) {
+        return TestServer::Reply{TestServer::Response(200, RELEASE)};
+    }));
+    Results results;
+    UpdateWorker worker;
+    REQUIRE(worker.Start(HttpClient::Create(), MakeConfig(server), [&results](auto result) { results(std::move(result)); }));
+    REQUIRE(worker.QueueCheck(UpdateWorker::Mode::Interactive));
+
+    const auto result = results.Wait();
+    REQUIRE(result != nullptr);
+    CHECK(result->type == UpdateWorker::Result::Type::Check);
+    CHECK(result->error.empty());
+    CHECK(result->status == 200);
+    CHECK(!result->cancelled);
+    CHECK(result->info.version == "v9.0.0");
+    CHECK(result->info.is_newer);
+    CHECK(result->info.download_size == 3);
+    worker.Stop();
+
+    const auto requests = server.GetRequests();
+    REQUIRE(requests.size() == 1);
+    CHECK(requests[0].target == "/repos/owner/repo/releases/latest");
+}
+
+TEST(StopAbortsARunningCheckPromptly) {
+    TestServer server;
+    REQUIRE(server.Start(Hang));
+    Results results;
+    UpdateWorker worker;
+    REQUIRE(worker.Start(HttpClient::Create(), MakeConfig(server), [&results](auto result) { results(std::move(result)); }));
+    REQUIRE(worker.QueueCheck(UpdateWorker::Mode::Silent));
+    WaitForRequests(server, 1);
+    CHECK(worker.IsBusy());
+
+    const Clock::time_point start = Clock::now();
+    worker.Stop();
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+    CHECK(elapsed < 10 * HttpClient::CANCEL_POLL_MS);
+    CHECK(!worker.QueueCheck(UpdateWorker::Mode::Silent));
+
+    const auto result = results.Wait();
+    REQUIRE(result != nullptr);
+    CHECK(result->cancelled);
+}
+
+TEST(CancelDropsQueuedJobsAndKeepsRunning) {
+    std::atomic<bool> hang{true};
+    TestServer server;
+    REQUIRE(server.Start([&hang](const TestServer::Request& request) {
+        return hang ? Hang(request) : TestServer::Reply{TestServer::Response(200, RELEASE)};
+    }));
+    Results results;
+    UpdateWorker worker;
+    REQUIRE(worker.Start(HttpClient::Create(), MakeConfig(server), [&results](auto result) { results(std::move(result)); }));
+    REQUIRE(worker.QueueCheck(UpdateWorker::Mode::Silent));
+    WaitForRequests(server, 1);
+    UpdateWorker::Download download;
+    download.url = server.Url("/UniLang.exe");
+    download.path = "UniLang.exe.test";
+    REQUIRE(worker.QueueDownload({download}, UpdateWorker::Mode::Interactive));
+
+    hang = false;
+    worker.Cancel();
+    auto result = results.Wait();
+    REQUIRE(result != nullptr);
+    CHECK(result->type == UpdateWorker::Result::Type::Check);
+    CHECK(result->cancelled);
+
+    // The queued download is gone; the next check goes out as usual
+    REQUIRE(worker.QueueCheck(UpdateWorker::Mode::Interactive));
+    result = results.Wait();
+    REQUIRE(result != nullptr);
+    CHECK(result->type == UpdateWorker::Result::Type::Check);
+    CHECK(!result->cancelled);
+    CHECK(result->info.version == "v9.0.0");
+    worker.Stop();
+
+    const auto requests = server.GetRequests();
+    REQUIRE(requests.size() == 2);
+    CHECK(requests[1].target == "/repos/owner/repo/releases/latest");
+}
+
+UNILANG_TEST_MAIN()
@@ -0,0 +1,122 @@
+#include "test_framework.h"
+#include "shortcuts_dict.h"
+#include "text_converter.h"
+#include "word_automaton.h"
+#include <string>
+#include <vector>
+
+using namespace UniLang;
+
+namespace {
+
+std::string Correct(const WordAutomaton& words, const std::string& word) {
+    std::string out;
+    return words.Correct(word, out) ? out : "-";
+}
+
+std::string Convert(const ShortcutsDict& dict, const std::string& text) {
+    TextConverter converter(dict);
+    std::string out;
+    converter.Convert(text, out);
+    converter.Finish(out);
+    return out;
+}
+
+} // namespace
+
+TEST(FindsEveryTypoAndNothingElse) {
+    std::vector<WordAutomaton::Pair> pairs;
+    for (int i = 0; i < 500; ++i) {
+        // Shared prefixes and suffixes: "aab", "aba", ...
+        std::string typo;
+        for (int n = i; typo.size() < 4; n /= 3) {
+            typo += static_cast<char>('a' + n % 3);
+        }
+        pairs.emplace_back(typo + "x", typo);
+    }
+    WordAutomaton words;
+    REQUIRE(words.Build(pairs));
+    CHECK(words.GetWordCount() == 81);      // 3^4 distinct typos; later pairs won
+    for (const auto& pair : pairs) {
+        const uint32_t index = words.Find(pair.first);
+        REQUIRE(index != WordAutomaton::NO_WORD);
+        CHECK(words.GetCorrection(index) == pair.second);
+    }
+    CHECK(words.Find("aaa") == WordAutomaton::NO_WORD);
+    CHECK(words.Find("aaax") == WordAutomaton::NO_WORD);
+    CHECK(words.Find("aaaaxx") == WordAutomaton::NO_WORD);
+    CHECK(words.GetStateCount() < 81 * 5);
+}
+
+TEST(CorrectionKeepsTheTypedCase) {
+    WordAutomaton words;
+    REQUIRE(words.Build({{"teh", "the"}, {"dont", "don't"}, {"recieve", "receive"}}));
+    CHECK(Correct(words, "teh") == "the");
+    CHECK(Correct(words, "Teh") == "The");
+    CHECK(Correct(words, "TEH") == "THE");
+    CHECK(Correct(words, "tEh") == "-");
+    CHECK(Correct(words, "DONT") == "DON'T");
+    CHECK(Correct(words, "the") == "-");
+}
+
+TEST(LaterPairWins) {
+    WordAutomaton words;
+    REQUIRE(words.Build({{"teh", "the"}, {"TEH", "tea"}}));
+    CHECK(words.GetWordCount() == 1);
+    CHECK(Correct(words, "teh") == "tea");
+}
+
+TEST(InvalidPairsAreRejected) {
+    WordAutomaton words;
+    CHECK(!words.Build({{"te h", "the"}}));
+    CHECK(!words.GetLastError().empty());
+    CHECK(!words.Build({{"'tis", "it is"}}));
+    CHECK(!words.Build({{"teh", ""}}));
+    CHECK(!words.Build({{std::string(WordAutomaton::MAX_WORD_LENGTH + 1, 'a'), "a"}}));
+    CHECK(words.Empty());
+}
+
+TEST(ParseWordListSkipsWhatCannotBeCorrected) {
+    std::vector<WordAutomaton::Pair> pairs;
+    const size_t skipped = WordAutomaton::ParseWordList(
+        "# comment\n"
+        "teh->the\n"
+        "\n"
+        "recieve\treceive\r\n"
+        "abotu->about, abbot\n"
+        "e-mail->email\n"
+        "no separator\n", pairs);
+    CHECK(skipped == 3);
+    REQUIRE(pairs.size() == 2);
+    CHECK(pairs[0] == WordAutomaton::Pair("teh", "the"));
+    CHECK(pairs[1] == WordAutomaton::Pair("recieve", "receive"));
+}
+
+TEST(DictionaryCorrectsWordsAtTheirBoundary) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(R"({"shortcuts": {}, "autocorrect": {"teh": "the", "adn": "and"}})"));
+    CHECK(Convert(dict, "Teh cat adn teh dog.") == "The cat and the dog.");
+    CHECK(Convert(dict, "tehx adnteh") == "tehx adnteh");
+}
+
+TEST(FailedReloadKeepsTheLoadedDictionary) {
+    ShortcutsDict dict;
+    REQUIRE(dict.LoadFromString(R"({
+        "shortcuts": {"greek": {"\\al": "α"}},
+        "rules": [{"before": "[0-9]", "match": "deg", "replace": "°"}],
+        "autocorrect": {"teh": "the"}
+    })"));
+
+    // Valid shortcuts and rules, then a bad autocorrect pair
+    CHECK(!dict.LoadFromString(R"({
+        "shortcuts": {"greek": {"\\be": "β", "\\ga": "γ"}},
+        "rules": [],
+        "autocorrect": {"te h": "the"}
+    })"));
+    CHECK(dict.GetAllShortcuts().size() == 1);
+    CHECK(dict.GetRules().GetRuleCount() == 1);
+    CHECK(dict.GetWords().GetWordCount() == 1);
+    CHECK(Convert(dict, "\\al 90deg teh ") == "α90° the ");     // The shortcut consumes its space
+}
+
+UNILANG_TEST_MAIN()
@@ -0,0 +1,465 @@
+// unilang-convert: apply UniLang shortcuts to text files
+//
+// Usage: unilang-convert [-d shortcuts.json] [-o output] [--stats] [input]
+//        unilang-convert [-d shortcuts.json] -r DIR [-j N] [--ext .md,.txt] [--dry-run]
+//
+// Reads `input` (memory-mapped where possible) or stdin, and writes the text
+// with every shortcut replaced, exactly as typing it with UniLang enabled
+// would. Works as a stdin -> stdout filter when no files are given.
+//
+// With -r, converts every file under DIR in place on all cores and prints a
+// JSON summary of the edits. With --latex, converts LaTeX math ($\frac{1}{2}$,
+// \sum_{i=1}^{n}, ...) to Unicode instead of applying typed shortcuts. With
+// --reverse, turns symbols back into shortcut text (α ≤ ∑ -> \al \leq \sum).
+// With -a, also fixes the typos of a word list (teh -> the). With --disable,
+// leaves the shortcuts of some dictionary categories alone. With --trace, writes
+// a Chrome trace of dictionary loading and conversion (builds with
+// -DUNILANG_TRACING=ON only).
+
+#include "batch_converter.h"
+#include "math_converter.h"
+#include "reverse_converter.h"
+#include "shortcuts_dict.h"
+#include "text_converter.h"
+#include "trace.h"
+
+#include <cerrno>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifndef UNILANG_DEFAULT_SHORTCUTS
+#define UNILANG_DEFAULT_SHORTCUTS "shortcuts.json"
+#endif
+
+namespace {
+
+constexpr size_t CHUNK_SIZE = 1 << 20;  // Converted and written 1 MiB at a time
+
+struct Options {
+    std::string dict_path = UNILANG_DEFAULT_SHORTCUTS;
+    std::string input_path;     // Empty or "-" means stdin
+    std::string output_path;    // Empty or "-" means stdout
+    bool stats = false;
+    bool latex = false;         // Convert LaTeX math instead of shortcuts
+    bool latex_all = false;     // The whole input is math, not just $...$ spans
+    bool reverse = false;       // Symbols back to shortcuts
+    std::string trigger_key;    // Typed before LaTeX shortcuts; empty keeps "\\"
+    std::string word_list;      // Autocorrect typo list; empty uses the dictionary's only
+    std::vector<std::string> disabled_categories;
+    std::string trace_path;     // Chrome trace output; empty records nothing
+
+    // Tree mode
+    std::string tree_root;
+    std::string summary_path;   // Empty or "-" means stdout
+    UniLang::BatchConverter::Options batch;
+};
+
+void PrintUsage() {
+    std::fprintf(stderr,
+        "Usage: unilang-convert [options] [input]\n"
+        "\n"
+        "Replace UniLang shortcuts (\\al, x^2, ...) in a text file.\n"
+        "Reads stdin and writes stdout when no files are given.\n"
+        "\n"
+        "Options:\n"
+        "  -d, --dict FILE     shortcuts.json to use (default: %s)\n"
+        "  -o, --output FILE   write to FILE instead of stdout\n"
+        "  -t, --trigger KEY   key typed before LaTeX shortcuts instead of \\ (e.g. ;)\n"
+        "  -a, --autocorrect FILE\n"
+        "                      also fix the typos in FILE (typo->correction lines)\n"
+        "      --disable LIST  leave these categories alone, e.g. superscript,urls\n"
+        "                      (shortcuts.json categories, rules, autocorrect, symbol_families)\n"
+        "      --stats         print size, replacements and throughput to stderr\n"
+        "      --latex         convert LaTeX math in $...$, $$...$$, \\(...\\), \\[...\\] to Unicode\n"
+        "      --latex-all     treat the whole input as LaTeX math\n"
+        "      --reverse       turn symbols back into shortcuts (for ASCII-only systems)\n"
+        "      --trace FILE    write a Chrome trace (chrome://tracing) of the run to FILE\n"
+        "  -h, --help          show this help\n"
+        "\n"
+        "Tree mode (files are converted in place):\n"
+        "  -r, --tree DIR      convert every file under DIR\n"
+        "  -j, --jobs N        worker threads (default: all cores)\n"
+        "      --ext LIST      only files with these extensions, e.g. .md,.txt\n"
+        "      --split-mb N    split files larger than N MiB across workers (default: 8)\n"
+        "      --dry-run       report edits without writing files\n"
+        "      --summary FILE  write the JSON summary to FILE instead of stdout\n",
+        UNILANG_DEFAULT_SHORTCUTS);
+}
+
+void SplitList(const std::string& list, std::vector<std::string>& items) {
+    size_t start = 0;
+    while (start <= list.size()) {
+        const size_t comma = std::min(list.find(',', start), list.size());
+        if (comma > start) {
+            items.push_back(list.substr(start, comma - start));
+        }
+        start = comma + 1;
+    }
+}
+
+bool ParseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "-d" || arg == "--dict") && i + 1 < argc) {
+            options.dict_path = argv[++i];
+        } else if ((arg == "-o" || arg == "--output") && i + 1 < argc) {
+            options.output_path = argv[++i];
+        } else if ((arg == "-t" || arg == "--trigger") && i + 1 < argc) {
+            options.trigger_key = argv[++i];
+        } else if ((arg == "-a" || arg == "--autocorrect") && i + 1 < argc) {
+            options.word_list = argv[++i];
+        } else if (arg == "--disable" && i + 1 < argc) {
+            SplitList(argv[++i], options.disabled_categories);
+        } else if (arg == "--stats") {
+            options.stats = true;
+        } else if (arg == "--latex") {
+            options.latex = true;
+        } else if (arg == "--latex-all") {
+            options.latex = true;
+            options.latex_all = true;
+        } else if (arg == "--reverse") {
+            options.reverse = true;
+        } else if (arg == "--trace" && i + 1 < argc) {
+            options.trace_path = argv[++i];
+        } else if ((arg == "-r" || arg == "--tree") && i + 1 < argc) {
+            options.tree_root = argv[++i];
+        } else if ((arg == "-j" || arg == "--jobs") && i + 1 < argc) {
+            options.batch.threads = std::strtoul(argv[++i], nullptr, 10);
+        } else if (arg == "--ext" && i + 1 < argc) {
+            SplitList(argv[++i], options.batch.extensions);
+        } else if (arg == "--split-mb" && i + 1 < argc) {
+            options.batch.split_size = std::strtoul(argv[++i], nullptr, 10) << 20;
+        } else if (arg == "--dry-run") {
+            options.batch.dry_run = true;
+        } else if (arg == "--summary" && i + 1 < argc) {
+            options.summary_path = argv[++i];
+        } else if (arg == "-h" || arg == "--help") {
+            PrintUsage();
+            std::exit(0);
+        } else if (arg.size() > 1 && arg[0] == '-') {
+            std::fprintf(stderr, "unilang-convert: unknown option '%s'\n", arg.c_str());
+            return false;
+        } else if (options.input_path.empty()) {
+            options.input_path = arg;
+        } else {
+            std::fprintf(stderr, "unilang-convert: only one input file is supported\n");
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Output sink that writes converted chunks and tracks failures
+ */
+class Writer {
+public:
+    explicit Writer(FILE* file) : m_file(file) {
+        m_buffer.reserve(CHUNK_SIZE + CHUNK_SIZE / 4);
+    }
+
+    std::string& Buffer() { return m_buffer; }
+
+    bool Flush() {
+        if (!m_buffer.empty() &&
+            std::fwrite(m_buffer.data(), 1, m_buffer.size(), m_file) != m_buffer.size()) {
+            return false;
+        }
+        m_written += m_buffer.size();
+        m_buffer.clear();
+        return true;
+    }
+
+    uint64_t GetWritten() const { return m_written; }
+
+private:
+    FILE* m_file;
+    std::string m_buffer;
+    uint64_t m_written = 0;
+};
+
+/**
+ * @brief Shortcut, LaTeX math or reverse conversion behind one interface
+ */
+class ChunkConverter {
+public:
+    ChunkConverter(const UniLang::ShortcutsDict& dict, const Options& options)
+        : m_mode(options.reverse ? Mode::Reverse : options.latex ? Mode::Latex : Mode::Shortcuts)
+        , m_text(dict)
+        , m_math(dict, UniLang::MathConverter::Options{!options.latex_all})
+        , m_reverse(dict, m_index) {
+        m_text.SetCategoryMask(options.batch.categories);
+        if (m_mode == Mode::Reverse) {
+            m_index.Build(dict);
+        }
+    }
+
+    void Convert(std::string_view chunk, std::string& out) {
+        switch (m_mode) {
+        case Mode::Shortcuts: m_text.Convert(chunk, out); break;
+        case Mode::Latex: m_math.Convert(chunk, out); break;
+        case Mode::Reverse: m_reverse.Convert(chunk, out); break;
+        }
+    }
+
+    void Finish(std::string& out) {
+        switch (m_mode) {
+        case Mode::Shortcuts: m_text.Finish(out); break;
+        case Mode::Latex: m_math.Finish(out); break;
+        case Mode::Reverse: m_reverse.Finish(out); break;
+        }
+    }
+
+    void PrintStats(uint64_t bytes, uint64_t written, double seconds) const {
+        const uint64_t count = m_mode == Mode::Latex ? m_math.GetSpanCount()
+                             : m_mode == Mode::Reverse ? m_reverse.GetReplacementCount()
+                             : m_text.GetReplacementCount();
+        std::fprintf(stderr, "%llu bytes in, %llu bytes out, %llu %s, %.3f s, %.1f MB/s\n",
+                     static_cast<unsigned long long>(bytes),
+                     static_cast<unsigned long long>(written),
+                     static_cast<unsigned long long>(count),
+                     m_mode == Mode::Latex ? "math spans" : "replacements",
+                     seconds, seconds > 0 ? bytes / seconds / 1e6 : 0.0);
+    }
+
+private:
+    enum class Mode { Shortcuts, Latex, Reverse };
+
+    Mode m_mode;
+    UniLang::TextConverter m_text;
+    UniLang::MathConverter m_math;
+    UniLang::ReverseIndex m_index;
+    UniLang::ReverseConverter m_reverse;
+};
+
+bool ConvertChunk(ChunkConverter& converter, const char* data, size_t size, Writer& writer) {
+    converter.Convert(std::string_view(data, size), writer.Buffer());
+    return writer.Flush();
+}
+
+#ifndef _WIN32
+/**
+ * @brief Convert a regular file through a read-only mapping
+ * @return false if the file can't be mapped (caller falls back to reading)
+ */
+bool ConvertMapped(int fd, ChunkConverter& converter, Writer& writer, bool& ok, uint64_t& bytes) {
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0) {
+        return false;
+    }
+
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    const char* data = static_cast<const char*>(mapping);
+    ok = true;
+    for (size_t offset = 0; ok && offset < size; offset += CHUNK_SIZE) {
+        const size_t length = size - offset < CHUNK_SIZE ? size - offset : CHUNK_SIZE;
+        ok = ConvertChunk(converter, data + offset, length, writer);
+    }
+    bytes = size;
+
+    munmap(mapping, size);
+    return true;
+}
+#endif
+
+bool ConvertStream(FILE* input, ChunkConverter& converter, Writer& writer, uint64_t& bytes) {
+    std::string chunk(CHUNK_SIZE, '\0');
+    size_t length;
+    while ((length = std::fread(&chunk[0], 1, chunk.size(), input)) > 0) {
+        bytes += length;
+        if (!ConvertChunk(converter, chunk.data(), length, writer)) {
+            return false;
+        }
+    }
+    return !std::ferror(input);
+}
+
+int ConvertTree(const Options& options, const UniLang::ShortcutsDict& dict) {
+    UniLang::BatchConverter converter(dict, options.batch);
+    UniLang::BatchConverter::Summary summary;
+    if (!converter.ConvertTree(options.tree_root, summary)) {
+        std::fprintf(stderr, "unilang-convert: %s\n", converter.GetLastError().c_str());
+        return 1;
+    }
+
+    const std::string json = UniLang::BatchConverter::SummaryToJson(summary) + "\n";
+    const bool to_stdout = options.summary_path.empty() || options.summary_path == "-";
+    FILE* output = to_stdout ? stdout : std::fopen(options.summary_path.c_str(), "wb");
+    if (!output) {
+        std::fprintf(stderr, "unilang-convert: cannot create '%s': %s\n", options.summary_path.c_str(), std::strerror(errno));
+        return 1;
+    }
+    std::fwrite(json.data(), 1, json.size(), output);
+    if (!to_stdout) {
+        std::fclose(output);
+    }
+
+    if (options.stats) {
+        std::fprintf(stderr, "%llu files, %llu changed, %llu replacements, %llu bytes, %zu threads, %.3f s, %.1f MB/s\n",
+                     static_cast<unsigned long long>(summary.files_scanned),
+                     static_cast<unsigned long long>(summary.files_changed),
+                     static_cast<unsigned long long>(summary.replacements),
+                     static_cast<unsigned long long>(summary.bytes_in),
+                     summary.threads, summary.seconds,
+                     summary.seconds > 0 ? summary.bytes_in / summary.seconds / 1e6 : 0.0);
+    }
+
+    for (const UniLang::BatchConverter::FileResult& file : summary.files) {
+        if (!file.error.empty()) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+} // namespace
+
+bool WriteTrace(const std::string& path) {
+    const std::string trace = UniLang::Tracer::ToChromeJson();
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file || std::fwrite(trace.data(), 1, trace.size(), file) != trace.size() || std::fclose(file) != 0) {
+        std::fprintf(stderr, "unilang-convert: cannot write '%s'\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+int Run(Options& options) {
+    UniLang::ShortcutsDict dict;
+    if (!options.trigger_key.empty() && !dict.SetTriggerKey(options.trigger_key)) {
+        std::fprintf(stderr, "unilang-convert: %s\n", dict.GetGrammars().GetLastError().c_str());
+        return 2;
+    }
+    if (!dict.LoadFromFile(options.dict_path)) {
+        std::fprintf(stderr, "unilang-convert: failed to load shortcuts from '%s'\n", options.dict_path.c_str());
+        return 1;
+    }
+    if (!options.word_list.empty()) {
+        const auto start = std::chrono::steady_clock::now();
+        if (!dict.LoadWordList(options.word_list)) {
+            std::fprintf(stderr, "unilang-convert: failed to load word list from '%s'\n", options.word_list.c_str());
+            return 1;
+        }
+        if (options.stats) {
+            const UniLang::WordAutomaton& words = dict.GetWords();
+            std::fprintf(stderr, "autocorrect: %zu words, %zu states, %zu transitions, %.1f KiB, built in %.1f ms\n",
+                         words.GetWordCount(), words.GetStateCount(), words.GetTransitionCount(),
+                         words.GetMemoryBytes() / 1024.0,
+                         std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+    }
+
+    for (const std::string& name : options.disabled_categories) {
+        if (dict.FindCategory(name) == UniLang::ShortcutsDict::NO_CATEGORY) {
+            std::fprintf(stderr, "unilang-convert: unknown category '%s'\n", name.c_str());
+            return 2;
+        }
+    }
+    options.batch.categories = dict.GetCategoryMask(options.disabled_categories);
+
+    if (!options.tree_root.empty()) {
+        if (options.latex || options.reverse) {
+            std::fprintf(stderr, "unilang-convert: --latex and --reverse are not supported in tree mode\n");
+            return 2;
+        }
+        return ConvertTree(options, dict);
+    }
+
+    const bool from_stdin = options.input_path.empty() || options.input_path == "-";
+    FILE* input = from_stdin ? stdin : std::fopen(options.input_path.c_str(), "rb");
+    if (!input) {
+        std::fprintf(stderr, "unilang-convert: cannot open '%s': %s\n", options.input_path.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    const bool to_stdout = options.output_path.empty() || options.output_path == "-";
+    FILE* output = to_stdout ? stdout : std::fopen(options.output_path.c_str(), "wb");
+    if (!output) {
+        std::fprintf(stderr, "unilang-convert: cannot create '%s': %s\n", options.output_path.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+#ifdef _WIN32
+    // Replacements are UTF-8 bytes; keep the CRT from translating line endings
+    _setmode(_fileno(input), _O_BINARY);
+    _setmode(_fileno(output), _O_BINARY);
+#endif
+
+    const auto start = std::chrono::steady_clock::now();
+
+    ChunkConverter converter(dict, options);
+    Writer writer(output);
+    uint64_t bytes = 0;
+    bool ok = false;
+
+#ifndef _WIN32
+    if (!ConvertMapped(fileno(input), converter, writer, ok, bytes))
+#endif
+    {
+        ok = ConvertStream(input, converter, writer, bytes);
+    }
+
+    if (ok) {
+        converter.Finish(writer.Buffer());
+        ok = writer.Flush() && std::fflush(output) == 0;
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!from_stdin) {
+        std::fclose(input);
+    }
+    if (!to_stdout && std::fclose(output) != 0) {
+        ok = false;
+    }
+
+    if (!ok) {
+        std::fprintf(stderr, "unilang-convert: I/O error while converting\n");
+        return 1;
+    }
+
+    if (options.stats) {
+        converter.PrintStats(bytes, writer.GetWritten(), seconds);
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseArgs(argc, argv, options)) {
+        PrintUsage();
+        return 2;
+    }
+    if (!options.trace_path.empty() && !UniLang::Tracer::IsCompiledIn()) {
+        std::fprintf(stderr, "unilang-convert: --trace needs a build with -DUNILANG_TRACING=ON\n");
+        return 2;
+    }
+
+    UNILANG_TRACE_THREAD("main");
+    const int status = Run(options);
+    if (!options.trace_path.empty() && !WriteTrace(options.trace_path)) {
+        return status != 0 ? status : 1;
+    }
+    return status;
+}
@@ -0,0 +1,166 @@
+// unilang-delta: build and apply binary deltas between UniLang releases
+//
+// Usage: unilang-delta create OLD NEW DELTA
+//        unilang-delta apply OLD DELTA NEW
+//        unilang-delta diff OLD.json NEW.json DIFF.json
+//
+// `create` writes a delta that turns OLD into NEW (publish it as the release
+// asset "UniLang.exe.<old version>.delta"). `apply` rebuilds NEW from OLD and
+// DELTA, feeding the delta in 64 KiB pieces exactly as the updater does while
+// it downloads. `diff` writes the shortcut changes between two shortcuts.json
+// files (publish it as "shortcuts.<old hash>.diff.json"; the hash is printed).
+// All print sizes and timings to stderr.
+
+#include "binary_delta.h"
+#include "shortcuts_dict.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+namespace {
+
+constexpr size_t FEED_SIZE = 64 * 1024;
+
+void PrintUsage() {
+    std::fprintf(stderr,
+        "Usage: unilang-delta create OLD NEW DELTA\n"
+        "       unilang-delta apply OLD DELTA NEW\n"
+        "       unilang-delta diff OLD.json NEW.json DIFF.json\n"
+        "\n"
+        "Build or apply a binary delta between two releases of a file,\n"
+        "or diff two shortcuts dictionaries.\n");
+}
+
+bool ReadWholeFile(const char* path, std::string& data) {
+    FILE* file = std::fopen(path, "rb");
+    if (!file) {
+        std::fprintf(stderr, "unilang-delta: cannot open '%s'\n", path);
+        return false;
+    }
+    data.clear();
+    char buffer[FEED_SIZE];
+    size_t size;
+    while ((size = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.append(buffer, size);
+    }
+    const bool ok = !std::ferror(file);
+    std::fclose(file);
+    if (!ok) {
+        std::fprintf(stderr, "unilang-delta: cannot read '%s'\n", path);
+    }
+    return ok;
+}
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int Create(const char* old_path, const char* new_path, const char* delta_path) {
+    std::string old_data, new_data;
+    if (!ReadWholeFile(old_path, old_data) || !ReadWholeFile(new_path, new_data)) {
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::string delta = UniLang::BinaryDelta::Create(old_data, new_data);
+    const double elapsed = MillisecondsSince(start);
+
+    FILE* output = std::fopen(delta_path, "wb");
+    if (!output || std::fwrite(delta.data(), 1, delta.size(), output) != delta.size() || std::fclose(output) != 0) {
+        std::fprintf(stderr, "unilang-delta: cannot write '%s'\n", delta_path);
+        return 1;
+    }
+
+    std::fprintf(stderr, "old %zu bytes, new %zu bytes, delta %zu bytes (%.1f%% of new), created in %.0f ms\n",
+                 old_data.size(), new_data.size(), delta.size(),
+                 new_data.empty() ? 0.0 : 100.0 * delta.size() / new_data.size(), elapsed);
+    return 0;
+}
+
+int Apply(const char* old_path, const char* delta_path, const char* new_path) {
+    std::string old_data, delta;
+    if (!ReadWholeFile(old_path, old_data) || !ReadWholeFile(delta_path, delta)) {
+        return 1;
+    }
+    FILE* output = std::fopen(new_path, "wb");
+    if (!output) {
+        std::fprintf(stderr, "unilang-delta: cannot write '%s'\n", new_path);
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    UniLang::DeltaApplier applier(old_data, [output](std::string_view data) {
+        return std::fwrite(data.data(), 1, data.size(), output) == data.size();
+    });
+    bool ok = true;
+    for (size_t pos = 0; ok && pos < delta.size(); pos += FEED_SIZE) {
+        ok = applier.Feed(std::string_view(delta).substr(pos, FEED_SIZE));
+    }
+    ok = ok && applier.Finish();
+    const double elapsed = MillisecondsSince(start);
+
+    if (std::fclose(output) != 0) {
+        ok = false;
+    }
+    if (!ok) {
+        std::fprintf(stderr, "unilang-delta: %s\n",
+                     applier.GetLastError().empty() ? "cannot write the new file" : applier.GetLastError().c_str());
+        std::remove(new_path);
+        return 1;
+    }
+
+    std::fprintf(stderr, "applied %zu-byte delta: %llu bytes written and verified in %.0f ms\n",
+                 delta.size(), static_cast<unsigned long long>(applier.GetOutputSize()), elapsed);
+    return 0;
+}
+
+int Diff(const char* old_path, const char* new_path, const char* diff_path) {
+    UniLang::ShortcutsDict old_dict, new_dict;
+    if (!old_dict.LoadFromFile(old_path)) {
+        std::fprintf(stderr, "unilang-delta: cannot load shortcuts from '%s'\n", old_path);
+        return 1;
+    }
+    if (!new_dict.LoadFromFile(new_path)) {
+        std::fprintf(stderr, "unilang-delta: cannot load shortcuts from '%s'\n", new_path);
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const UniLang::ShortcutsDict::Diff diff = UniLang::ShortcutsDict::ComputeDiff(old_dict, new_dict);
+    const std::string text = UniLang::ShortcutsDict::DiffToJson(diff);
+    const double elapsed = MillisecondsSince(start);
+
+    FILE* output = std::fopen(diff_path, "wb");
+    if (!output || std::fwrite(text.data(), 1, text.size(), output) != text.size() || std::fclose(output) != 0) {
+        std::fprintf(stderr, "unilang-delta: cannot write '%s'\n", diff_path);
+        return 1;
+    }
+
+    std::fprintf(stderr, "%zu added, %zu changed, %zu removed (%zu bytes) in %.1f ms\n"
+                 "publish as shortcuts.%s.diff.json\n",
+                 diff.added.size(), diff.changed.size(), diff.removed.size(), text.size(), elapsed,
+                 UniLang::ShortcutsDict::FormatHash(diff.base_hash).c_str());
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 5) {
+        PrintUsage();
+        return 2;
+    }
+    if (std::strcmp(argv[1], "create") == 0) {
+        return Create(argv[2], argv[3], argv[4]);
+    }
+    if (std::strcmp(argv[1], "apply") == 0) {
+        return Apply(argv[2], argv[3], argv[4]);
+    }
+    if (std::strcmp(argv[1], "diff") == 0) {
+        return Diff(argv[2], argv[3], argv[4]);
+    }
+    PrintUsage();
+    return 2;
+}
@@ -0,0 +1,118 @@
+// unilang-flight: decode a flight recorder dump (config\flight_recorder.bin)
+//
+// Usage: unilang-flight DUMP
+//
+// Prints one line per recorded key-down decision, oldest first: time before
+// the dump, gap to the previous decision, key class, decision, flags,
+// matcher buffer length, backspaces and UTF-16 units of queued output, and
+// how long the hook took. A summary of decisions follows.
+
+#include "flight_recorder.h"
+#include "metrics.h"
+
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <string>
+
+namespace {
+
+using UniLang::FlightRecorder;
+
+void PrintUsage() {
+    std::fprintf(stderr,
+        "Usage: unilang-flight DUMP\n"
+        "\n"
+        "Decode a flight recorder dump saved by \"Save Diagnostics\".\n");
+}
+
+bool ReadWholeFile(const char* path, std::string& data) {
+    FILE* file = std::fopen(path, "rb");
+    if (!file) {
+        std::fprintf(stderr, "unilang-flight: cannot open '%s'\n", path);
+        return false;
+    }
+    data.clear();
+    char buffer[64 * 1024];
+    size_t size;
+    while ((size = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.append(buffer, size);
+    }
+    const bool ok = !std::ferror(file);
+    std::fclose(file);
+    if (!ok) {
+        std::fprintf(stderr, "unilang-flight: cannot read '%s'\n", path);
+    }
+    return ok;
+}
+
+std::string FormatFlags(uint8_t flags) {
+    static const struct { uint8_t flag; char letter; } FLAGS[] = {
+        {FlightRecorder::FLAG_BLOCKED, 'B'},
+        {FlightRecorder::FLAG_OUTPUT_PENDING, 'P'},
+        {FlightRecorder::FLAG_CONTEXT_SWITCH, 'C'},
+        {FlightRecorder::FLAG_SUPERSCRIPT, '^'},
+        {FlightRecorder::FLAG_SUBSCRIPT, '_'},
+        {FlightRecorder::FLAG_LATEX, 'L'},
+    };
+    std::string text;
+    for (const auto& entry : FLAGS) {
+        text += (flags & entry.flag) ? entry.letter : '.';
+    }
+    return text;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc != 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    std::string data;
+    if (!ReadWholeFile(argv[1], data)) {
+        return 1;
+    }
+    FlightRecorder::Dump dump;
+    if (!FlightRecorder::Parse(data, dump)) {
+        std::fprintf(stderr, "unilang-flight: '%s' is not a flight recorder dump\n", argv[1]);
+        return 1;
+    }
+
+    const std::time_t dump_time = static_cast<std::time_t>(dump.dump_unix_ms / 1000);
+    char dump_time_text[32] = "?";
+    if (const std::tm* utc = std::gmtime(&dump_time)) {
+        std::strftime(dump_time_text, sizeof(dump_time_text), "%Y-%m-%d %H:%M:%S", utc);
+    }
+    std::printf("Dumped %s UTC, %zu of %llu decisions, %.3f ns per tick\n", dump_time_text, dump.records.size(),
+                static_cast<unsigned long long>(dump.total), dump.ns_per_tick);
+    std::printf("Flags: B blocked, P output pending, C context switch, ^ superscript, _ subscript, L LaTeX\n\n");
+    std::printf("%8s %12s %10s  %-13s %-10s %-6s %4s %4s %5s %10s\n",
+                "#", "before dump", "gap", "key", "decision", "flags", "buf", "bs", "out", "hook");
+
+    std::map<std::string, uint64_t> decisions;
+    uint64_t index = dump.total - dump.records.size();
+    uint64_t previous_ticks = 0;
+    for (const FlightRecorder::Record& record : dump.records) {
+        const double before_s = static_cast<double>(dump.dump_ticks - record.ticks) * dump.ns_per_tick / 1e9;
+        const double gap_ms = previous_ticks == 0
+            ? 0.0 : static_cast<double>(record.ticks - previous_ticks) * dump.ns_per_tick / 1e6;
+        const double hook_ns = static_cast<double>(UniLang::LatencyHistogram::BucketHighestValue(record.latency_bucket)) *
+                               dump.ns_per_tick;
+        previous_ticks = record.ticks;
+
+        std::printf("%8llu %10.3f s %7.1f ms  %-13s %-10s %-6s %4u %4u %5u %7.0f ns\n",
+                    static_cast<unsigned long long>(index++), before_s, gap_ms,
+                    FlightRecorder::GetEventName(record.event), FlightRecorder::GetDecisionName(record.decision),
+                    FormatFlags(record.flags).c_str(), record.buffer_length, record.backspaces,
+                    record.output_length, hook_ns);
+        ++decisions[FlightRecorder::GetDecisionName(record.decision)];
+    }
+
+    std::printf("\n");
+    for (const auto& [decision, count] : decisions) {
+        std::printf("%-10s %llu\n", decision.c_str(), static_cast<unsigned long long>(count));
+    }
+    return 0;
+}